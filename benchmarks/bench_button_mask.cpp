@@ -0,0 +1,91 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "button_mask.h"
+
+
+namespace
+{
+    struct Report
+    {
+        BYTE                            buttons[k_max_buttons];
+    };
+
+    // A sequence of button reports in which few buttons change between
+    // consecutive reports, as is typical for a polled device.
+    std::vector<Report> make_reports(size_t count)
+    {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<size_t> button(0, k_max_buttons - 1);
+
+        std::vector<Report> reports(count);
+        Report current = {};
+        for(auto& report : reports)
+        {
+            current.buttons[button(rng)] ^= 0x80;
+            report = current;
+        }
+        return reports;
+    }
+}
+
+
+TEST_CASE("button change detection", "[button_mask][benchmark]")
+{
+    const auto reports = make_reports(1024);
+
+    // Detection as done before ButtonMask: one compare per button byte
+    // against an array of flags.
+    BENCHMARK("per button compare")
+    {
+        std::array<bool, k_max_buttons + 1> state = {};
+        size_t changes = 0;
+        for(auto const& report : reports)
+        {
+            for(size_t i=0; i<k_max_buttons; ++i)
+            {
+                const bool is_pressed = (report.buttons[i] & 0x80) != 0;
+                if(state[i + 1] != is_pressed)
+                {
+                    state[i + 1] = is_pressed;
+                    ++changes;
+                }
+            }
+        }
+        return changes;
+    };
+
+    auto run_masked = [&reports](auto pack) {
+        ButtonMask state;
+        size_t changes = 0;
+        for(auto const& report : reports)
+        {
+            const auto pressed = pack(report.buttons);
+            for_each_button(pressed ^ state, [&](size_t) { ++changes; });
+            state = pressed;
+        }
+        return changes;
+    };
+
+    BENCHMARK("mask, scalar")
+    {
+        return run_masked(pack_buttons_scalar);
+    };
+
+#if defined(DILL_HAS_SSE2)
+    BENCHMARK("mask, SSE2")
+    {
+        return run_masked(pack_buttons_sse2);
+    };
+#endif
+
+#if defined(DILL_HAS_AVX2)
+    BENCHMARK("mask, AVX2")
+    {
+        return run_masked(pack_buttons_avx2);
+    };
+#endif
+}
@@ -0,0 +1,211 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "axis_mapping.h"
+#include "device_slot_table.h"
+#include "device_state_table.h"
+#include "offset_decoder.h"
+#include "state_diff.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    const std::array<DWORD, 8> k_summary_offsets = {
+        DIJOFS_X, DIJOFS_Y, DIJOFS_Z, DIJOFS_RX,
+        DIJOFS_RY, DIJOFS_RZ, DIJOFS_SLIDER(0), DIJOFS_SLIDER(1)
+    };
+    const std::array<DWORD, 4> k_hat_offsets = {
+        DIJOFS_POV(0), DIJOFS_POV(1), DIJOFS_POV(2), DIJOFS_POV(3)
+    };
+
+    // A drain's worth of events cycling through every input type.
+    std::vector<JoystickInputData> make_events(GUID const& guid)
+    {
+        std::vector<JoystickInputData> events(64);
+        for(size_t i=0; i<events.size(); ++i)
+        {
+            auto& evt = events[i];
+            evt.device_guid = guid;
+            evt.value = static_cast<LONG>(i * 512);
+            switch(i % 4)
+            {
+                case 0:
+                case 1:
+                    evt.input_type = JoystickInputType::Axis;
+                    evt.input_index = static_cast<UINT8>(1 + i % 8);
+                    break;
+                case 2:
+                    evt.input_type = JoystickInputType::Button;
+                    evt.input_index = static_cast<UINT8>(1 + i % 32);
+                    evt.value = (i / 4) % 2;
+                    break;
+                default:
+                    evt.input_type = JoystickInputType::Hat;
+                    evt.input_index = 1;
+                    evt.value = 9000;
+                    break;
+            }
+        }
+        return events;
+    }
+}
+
+
+TEST_CASE("buffered event offset decoding", "[decode][benchmark]")
+{
+    BENCHMARK("axis_index_for_offset, 8 axes")
+    {
+        DWORD sum = 0;
+        for(auto offset : k_summary_offsets)
+        {
+            sum += axis_index_for_offset(offset);
+        }
+        return sum;
+    };
+
+    // The offsets are compile-time constants, copies behind a clobber keep
+    // the compiler from folding the inlined table lookups away.
+    auto axis_offsets = k_summary_offsets;
+    auto hat_offsets = k_hat_offsets;
+    BENCHMARK("decode_offset, 8 axes")
+    {
+        Catch::Benchmark::keep_memory(&axis_offsets);
+        DWORD sum = 0;
+        for(auto offset : axis_offsets)
+        {
+            sum += decode_offset(offset).input_index;
+        }
+        return sum;
+    };
+
+    BENCHMARK("decode_offset, 4 hats")
+    {
+        Catch::Benchmark::keep_memory(&hat_offsets);
+        DWORD sum = 0;
+        for(auto offset : hat_offsets)
+        {
+            sum += decode_offset(offset).input_index;
+        }
+        return sum;
+    };
+
+    // Lookups decode_joystick_input_event used before the offset table,
+    // kept as the reference the table is measured against.
+    BENCHMARK("find_if over axis offsets, 8 axes")
+    {
+        DWORD sum = 0;
+        for(auto offset : k_summary_offsets)
+        {
+            const auto it = std::find(
+                k_summary_offsets.cbegin(),
+                k_summary_offsets.cend(),
+                offset
+            );
+            sum += static_cast<DWORD>(it - k_summary_offsets.cbegin()) + 1;
+        }
+        return sum;
+    };
+
+    static std::unordered_map<DWORD, int> hat_id_lookup =
+    {
+        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[0]), 1},
+        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[1]), 2},
+        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[2]), 3},
+        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[3]), 4}
+    };
+    BENCHMARK("hat_id_lookup, 4 hats")
+    {
+        int sum = 0;
+        for(auto offset : k_hat_offsets)
+        {
+            sum += hat_id_lookup[offset];
+        }
+        return sum;
+    };
+}
+
+TEST_CASE("device state updates", "[decode][benchmark]")
+{
+    const GUID guid = make_guid(1);
+    const auto events = make_events(guid);
+
+    DeviceState plain;
+    BENCHMARK("apply 64 events")
+    {
+        for(auto const& evt : events)
+        {
+            apply_input_event(plain, evt);
+        }
+        return plain.axis[1];
+    };
+
+    DeviceSlotTable slots;
+    DeviceStateTable table;
+    const auto slot = slots.acquire(guid);
+    table.add(slots.ref(slot), guid);
+    BENCHMARK("apply 64 events, seqlock publish")
+    {
+        table.update(slot, [&events](DeviceState& state) {
+            for(auto const& evt : events)
+            {
+                apply_input_event(state, evt);
+            }
+        });
+        return slot;
+    };
+}
+
+TEST_CASE("GUID hashing", "[decode][benchmark]")
+{
+    std::vector<GUID> guids;
+    std::unordered_map<GUID, uint32_t> map;
+    for(DWORD i=0; i<k_max_devices; ++i)
+    {
+        guids.push_back(make_guid(i + 1));
+        map[guids.back()] = i;
+    }
+
+    // Looks up the most recently added devices, the worst case of the
+    // slot table's scan.
+    const size_t first = guids.size() - 8;
+    BENCHMARK("std::hash<GUID>, 8 GUIDs")
+    {
+        size_t sum = 0;
+        for(size_t i=first; i<guids.size(); ++i)
+        {
+            sum += std::hash<GUID>()(guids[i]);
+        }
+        return sum;
+    };
+
+    BENCHMARK("unordered_map<GUID> find, 8 of 64 GUIDs")
+    {
+        uint32_t sum = 0;
+        for(size_t i=first; i<guids.size(); ++i)
+        {
+            sum += map.find(guids[i])->second;
+        }
+        return sum;
+    };
+
+    DeviceSlotTable slots;
+    for(auto const& guid : guids)
+    {
+        slots.acquire(guid);
+    }
+    BENCHMARK("DeviceSlotTable::find, 8 of 64 GUIDs")
+    {
+        uint32_t sum = 0;
+        for(size_t i=first; i<guids.size(); ++i)
+        {
+            sum += slots.find(guids[i]);
+        }
+        return sum;
+    };
+}
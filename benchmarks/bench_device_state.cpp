@@ -0,0 +1,207 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "device_state_table.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    const size_t k_device_count = 8;
+
+    // State storage as it was prior to DeviceStateTable: a single mutex
+    // guarding a map from GUID to DeviceState.
+    struct MutexStateStore
+    {
+        std::mutex                      mutex;
+        std::unordered_map<GUID, DeviceState> state;
+
+        LONG get_axis(GUID const& guid, DWORD index)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = state.find(guid);
+            return it == state.end() ? 0 : it->second.axis[index];
+        }
+
+        void set_axis(GUID const& guid, DWORD index, LONG value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            state[guid].axis[index] = value;
+        }
+    };
+
+    struct SeqlockStateStore
+    {
+        std::mutex                      writer_mutex;
+        DeviceSlotTable                 slots;
+        DeviceStateTable                state;
+
+        LONG get_axis(GUID const& guid, DWORD index)
+        {
+            DeviceState result;
+            return state.load(guid, result) ? result.axis[index] : 0;
+        }
+
+        void set_axis(GUID const& guid, DWORD index, LONG value)
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            state.update(slots.find(guid), [index, value](DeviceState& current) {
+                current.axis[index] = value;
+            });
+        }
+    };
+
+    // Measures get_axis on the calling thread while one writer thread keeps
+    // updating every device and reader_count - 1 threads keep reading.
+    template<typename Store>
+    void measure_contended_reads(
+        Catch::Benchmark::Chronometer   meter,
+        Store&                          store,
+        size_t                          reader_count
+    )
+    {
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        threads.emplace_back([&store, &done]() {
+            LONG value = 0;
+            while(!done.load(std::memory_order_relaxed))
+            {
+                for(DWORD i=0; i<k_device_count; ++i)
+                {
+                    store.set_axis(make_guid(i + 1), 1 + value % 8, value);
+                }
+                ++value;
+            }
+        });
+        for(size_t i=1; i<reader_count; ++i)
+        {
+            threads.emplace_back([&store, &done]() {
+                LONG sink = 0;
+                while(!done.load(std::memory_order_relaxed))
+                {
+                    for(DWORD i=0; i<k_device_count; ++i)
+                    {
+                        sink += store.get_axis(make_guid(i + 1), 1);
+                    }
+                }
+                (void)sink;
+            });
+        }
+
+        const GUID guid = make_guid(k_device_count);
+        meter.measure([&store, &guid] { return store.get_axis(guid, 3); });
+
+        done = true;
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+
+TEST_CASE("get_axis under reader contention", "[device_state][benchmark]")
+{
+    MutexStateStore mutex_store;
+    SeqlockStateStore seqlock_store;
+    for(DWORD i=0; i<k_device_count; ++i)
+    {
+        mutex_store.state[make_guid(i + 1)] = DeviceState();
+        const auto slot = seqlock_store.slots.acquire(make_guid(i + 1));
+        seqlock_store.state.add(seqlock_store.slots.ref(slot), make_guid(i + 1));
+    }
+
+    for(size_t readers : {1, 2, 4})
+    {
+        const auto suffix = std::to_string(readers) + " reader(s), 1 writer";
+
+        BENCHMARK_ADVANCED("mutex, " + suffix)(
+            Catch::Benchmark::Chronometer meter
+        )
+        {
+            measure_contended_reads(meter, mutex_store, readers);
+        };
+
+        BENCHMARK_ADVANCED("seqlock, " + suffix)(
+            Catch::Benchmark::Chronometer meter
+        )
+        {
+            measure_contended_reads(meter, seqlock_store, readers);
+        };
+    }
+}
+
+TEST_CASE("state lookup by GUID and by handle", "[device_state][benchmark]")
+{
+    DeviceSlotTable slots;
+    DeviceStateTable state;
+    for(DWORD i=0; i<k_device_count; ++i)
+    {
+        const auto slot = slots.acquire(make_guid(i + 1));
+        state.add(slots.ref(slot), make_guid(i + 1));
+    }
+
+    // The last device is the worst case of the GUID scan.
+    const GUID guid = make_guid(k_device_count);
+    const uint32_t handle = encode_device_handle(
+        slots.ref(slots.find(guid))
+    );
+
+    BENCHMARK("by GUID")
+    {
+        DeviceState result;
+        return state.load(guid, result) ? result.axis[3] : 0;
+    };
+
+    BENCHMARK("by handle")
+    {
+        DeviceState result;
+        return state.load(decode_device_handle(handle), result)
+            ? result.axis[3] : 0;
+    };
+}
+
+TEST_CASE("full device state per query", "[device_state][benchmark]")
+{
+    DeviceSlotTable slots;
+    DeviceStateTable state;
+    for(DWORD i=0; i<k_device_count; ++i)
+    {
+        const auto slot = slots.acquire(make_guid(i + 1));
+        state.add(slots.ref(slot), make_guid(i + 1));
+    }
+    const GUID guid = make_guid(k_device_count);
+
+    // What get_axis/get_button/get_hat amount to when rendering a device.
+    BENCHMARK("140 single input reads")
+    {
+        LONG sink = 0;
+        DeviceState result;
+        for(size_t i=1; i<=8; ++i)
+        {
+            sink += state.load(guid, result) ? result.axis[i] : 0;
+        }
+        for(size_t i=1; i<=128; ++i)
+        {
+            sink += state.load(guid, result) ? result.button.test(i) : 0;
+        }
+        for(size_t i=1; i<=4; ++i)
+        {
+            sink += state.load(guid, result) ? result.hat[i] : 0;
+        }
+        return sink;
+    };
+
+    BENCHMARK("one snapshot")
+    {
+        DillDeviceSnapshot snapshot;
+        state.snapshot(guid, snapshot);
+        return snapshot.version;
+    };
+}
@@ -0,0 +1,117 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "event_ring.h"
+
+
+namespace
+{
+    // Mirrors the size of JoystickInputData without depending on windows.h.
+    struct BenchEvent
+    {
+        uint8_t                         device_guid[16];
+        uint8_t                         input_type;
+        uint8_t                         input_index;
+        int32_t                         value;
+    };
+
+    // Pushes event_count events while a reader thread drains the ring and
+    // returns the number of events the reader received.
+    uint64_t run_producer_consumer(
+        EventRing<BenchEvent>&          ring,
+        uint32_t                        event_count
+    )
+    {
+        std::atomic<bool> done{false};
+        uint64_t received = 0;
+        std::thread reader([&ring, &done, &received]() {
+            BenchEvent events[64];
+            for(;;)
+            {
+                const bool finished = done.load(std::memory_order_acquire);
+                const size_t count = ring.pop(events, 64);
+                received += count;
+                if(count == 0 && finished)
+                {
+                    break;
+                }
+            }
+        });
+
+        BenchEvent evt{};
+        for(uint32_t i=0; i<event_count; ++i)
+        {
+            evt.value = static_cast<int32_t>(i);
+            ring.push(evt);
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        return received;
+    }
+}
+
+
+TEST_CASE("event ring single thread push/pop", "[event_ring][benchmark]")
+{
+    EventRing<BenchEvent> ring(1024, RingOverflowPolicy::DropNewest);
+    BenchEvent events[64];
+
+    BENCHMARK("push 64 + pop 64")
+    {
+        BenchEvent evt{};
+        for(int32_t i=0; i<64; ++i)
+        {
+            evt.value = i;
+            ring.push(evt);
+        }
+        return ring.pop(events, 64);
+    };
+}
+
+TEST_CASE("event ring overflow handling", "[event_ring][benchmark]")
+{
+    EventRing<BenchEvent> drop_newest(64, RingOverflowPolicy::DropNewest);
+    EventRing<BenchEvent> drop_oldest(64, RingOverflowPolicy::DropOldest);
+    BenchEvent evt{};
+    for(int i=0; i<64; ++i)
+    {
+        drop_newest.push(evt);
+        drop_oldest.push(evt);
+    }
+
+    BENCHMARK("push into full ring, drop newest")
+    {
+        return drop_newest.push(evt);
+    };
+    BENCHMARK("push into full ring, drop oldest")
+    {
+        return drop_oldest.push(evt);
+    };
+}
+
+TEST_CASE("event ring producer/consumer throughput", "[event_ring][benchmark]")
+{
+    const uint32_t event_count = 1 << 16;
+
+    BENCHMARK_ADVANCED("65536 events, one reader, drop newest")(
+        Catch::Benchmark::Chronometer meter
+    )
+    {
+        EventRing<BenchEvent> ring(4096, RingOverflowPolicy::DropNewest);
+        meter.measure([&ring, event_count] {
+            return run_producer_consumer(ring, event_count);
+        });
+    };
+
+    BENCHMARK_ADVANCED("65536 events, one reader, drop oldest")(
+        Catch::Benchmark::Chronometer meter
+    )
+    {
+        EventRing<BenchEvent> ring(4096, RingOverflowPolicy::DropOldest);
+        meter.measure([&ring, event_count] {
+            return run_producer_consumer(ring, event_count);
+        });
+    };
+}
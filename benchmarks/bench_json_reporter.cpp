@@ -0,0 +1,140 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+
+
+namespace
+{
+    std::string escape(std::string const& text)
+    {
+        std::string result;
+        for(char c : text)
+        {
+            if(c == '"' || c == '\\')
+            {
+                result += '\\';
+                result += c;
+            }
+            else if(static_cast<unsigned char>(c) < 0x20)
+            {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                result += buffer;
+            }
+            else
+            {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    // Number of events processed per run, taken from benchmark names of the
+    // form "<count> events, ...", 0 for other benchmarks.
+    unsigned long long event_count(std::string const& name)
+    {
+        char* end = nullptr;
+        const auto count = std::strtoull(name.c_str(), &end, 10);
+        if(end == name.c_str() || std::string(end).rfind(" events", 0) != 0)
+        {
+            return 0;
+        }
+        return count;
+    }
+
+
+    /**
+     * \brief Catch2 reporter writing benchmark results as JSON.
+     *
+     * Catch2's own JSON reporter omits benchmark results. This one writes
+     * a single document with one entry per benchmark, in nanoseconds per
+     * run, which benchmarks/compare_bench.py compares against a baseline:
+     *
+     *     dill_bench --reporter dill-json::out=results.json
+     */
+    class BenchJsonReporter : public Catch::StreamingReporterBase
+    {
+    public:
+        explicit BenchJsonReporter(Catch::ReporterConfig&& config)
+            :   StreamingReporterBase(CATCH_MOVE(config))
+        {
+            m_preferences.shouldReportAllAssertions = false;
+        }
+
+        static std::string getDescription()
+        {
+            return "Writes benchmark results as JSON for compare_bench.py";
+        }
+
+        void testRunStarting(Catch::TestRunInfo const& info) override
+        {
+            StreamingReporterBase::testRunStarting(info);
+            m_stream << "{\n  \"version\": 1,\n  \"benchmarks\": [";
+        }
+
+        void benchmarkEnded(Catch::BenchmarkStats<> const& stats) override
+        {
+            const auto& name = stats.info.name;
+            const double mean = stats.mean.point.count();
+
+            char numbers[256];
+            std::snprintf(
+                numbers,
+                sizeof(numbers),
+                "\"mean_ns\": %.3f, \"mean_low_ns\": %.3f, "
+                "\"mean_high_ns\": %.3f, \"std_dev_ns\": %.3f, "
+                "\"samples\": %u, \"iterations\": %d",
+                mean,
+                stats.mean.lower_bound.count(),
+                stats.mean.upper_bound.count(),
+                stats.standardDeviation.point.count(),
+                stats.info.samples,
+                stats.info.iterations
+            );
+
+            m_stream << (m_first ? "\n" : ",\n")
+                << "    {\"test_case\": \""
+                << escape(currentTestCaseInfo->name)
+                << "\", \"name\": \"" << escape(name) << "\", " << numbers;
+            const auto events = event_count(name);
+            if(events > 0 && mean > 0.0)
+            {
+                std::snprintf(
+                    numbers,
+                    sizeof(numbers),
+                    ", \"events_per_second\": %.0f",
+                    events * 1e9 / mean
+                );
+                m_stream << numbers;
+            }
+            m_stream << "}";
+            m_first = false;
+        }
+
+        void benchmarkFailed(Catch::StringRef error) override
+        {
+            m_stream << (m_first ? "\n" : ",\n")
+                << "    {\"test_case\": \""
+                << escape(currentTestCaseInfo->name)
+                << "\", \"error\": \"" << escape(std::string(error))
+                << "\"}";
+            m_first = false;
+        }
+
+        void testRunEnded(Catch::TestRunStats const& stats) override
+        {
+            StreamingReporterBase::testRunEnded(stats);
+            m_stream << "\n  ]\n}\n";
+            m_stream.flush();
+        }
+
+    private:
+        bool                            m_first = true;
+    };
+}
+
+
+CATCH_REGISTER_REPORTER("dill-json", BenchJsonReporter)
@@ -0,0 +1,254 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <limits>
+#include <thread>
+
+#include "input_pipeline.h"
+#include "replay_source.h"
+#include "synthetic_source.h"
+
+
+namespace
+{
+    std::atomic<uint64_t> g_sink{0};
+
+    void count_event(JoystickInputData evt)
+    {
+        g_sink.fetch_add(evt.value, std::memory_order_relaxed);
+    }
+
+    void count_batch(JoystickInputData const* events, size_t count)
+    {
+        g_sink.fetch_add(count + events[0].value, std::memory_order_relaxed);
+    }
+
+    void count_batch_ex(JoystickInputEventEx const* events, size_t count)
+    {
+        g_sink.fetch_add(count + events[0].data.value, std::memory_order_relaxed);
+    }
+
+    // Four devices generating as fast as possible, every advance hands
+    // 4 * 16 batches of 64 events to the pipeline.
+    SyntheticConfig make_config(SyntheticPattern pattern)
+    {
+        SyntheticConfig config;
+        config.device_count = 4;
+        config.events_per_second = 0.0;
+        config.batch_size = 64;
+        config.pattern = pattern;
+        return config;
+    }
+}
+
+
+TEST_CASE("pipeline throughput by consumer", "[pipeline][benchmark]")
+{
+    const auto config = make_config(SyntheticPattern::Sweep);
+
+    SyntheticSource bare_source(config);
+    InputPipeline bare;
+    BENCHMARK("4096 events, no consumer")
+    {
+        return bare_source.advance(bare, std::chrono::nanoseconds(0));
+    };
+
+    SyntheticSource event_source(config);
+    InputPipeline per_event;
+    per_event.dispatcher().set_event_callback(&count_event);
+    BENCHMARK("4096 events, per-event callback")
+    {
+        return event_source.advance(per_event, std::chrono::nanoseconds(0));
+    };
+
+    SyntheticSource batch_source(config);
+    InputPipeline batch;
+    batch.dispatcher().set_batch_callback(&count_batch);
+    BENCHMARK("4096 events, batch callback")
+    {
+        return batch_source.advance(batch, std::chrono::nanoseconds(0));
+    };
+
+    SyntheticSource ex_source(config);
+    InputPipeline batch_ex;
+    batch_ex.dispatcher().set_event_ex_callback(&count_batch_ex);
+    BENCHMARK("4096 events, extended callback")
+    {
+        return ex_source.advance(batch_ex, std::chrono::nanoseconds(0));
+    };
+}
+
+TEST_CASE("pipeline throughput by pattern", "[pipeline][benchmark]")
+{
+    for(auto pattern : {SyntheticPattern::Random, SyntheticPattern::Jitter})
+    {
+        SyntheticSource source(make_config(pattern));
+        InputPipeline pipeline;
+        BENCHMARK(
+            pattern == SyntheticPattern::Random
+                ? "4096 events, random pattern"
+                : "4096 events, jitter pattern"
+        )
+        {
+            return source.advance(pipeline, std::chrono::nanoseconds(0));
+        };
+    }
+}
+
+TEST_CASE("pipeline with coalescing", "[pipeline][benchmark]")
+{
+    // Jitter only moves the eight axes, coalescing leaves eight events of
+    // each batch of 64.
+    const auto config = make_config(SyntheticPattern::Jitter);
+    for(bool coalescing : {false, true})
+    {
+        SyntheticSource source(config);
+        InputPipeline pipeline;
+        pipeline.dispatcher().set_event_callback(&count_event);
+        pipeline.dispatcher().set_coalescing(coalescing);
+        BENCHMARK(
+            coalescing
+                ? "4096 jitter events, per-event callback, coalescing"
+                : "4096 jitter events, per-event callback"
+        )
+        {
+            return source.advance(pipeline, std::chrono::nanoseconds(0));
+        };
+    }
+}
+
+TEST_CASE("pipeline with subscriptions", "[pipeline][benchmark]")
+{
+    // Each device is subscribed to its first axis only, the state is still
+    // updated from every event.
+    const auto config = make_config(SyntheticPattern::Sweep);
+    SyntheticSource source(config);
+    InputPipeline pipeline;
+    pipeline.dispatcher().set_event_callback(&count_event);
+    source.advance(pipeline, std::chrono::nanoseconds(0));
+    const uint64_t first_axis[2] = {0x1, 0};
+    const uint64_t none[2] = {0, 0};
+    for(size_t i=0; i<config.device_count; ++i)
+    {
+        const auto guid = SyntheticSource::device_guid(i);
+        pipeline.set_subscription(guid, k_subscribe_axes, first_axis);
+        pipeline.set_subscription(
+            guid,
+            k_subscribe_buttons | k_subscribe_hats,
+            none
+        );
+    }
+    BENCHMARK("4096 events, per-event callback, one axis subscribed")
+    {
+        return source.advance(pipeline, std::chrono::nanoseconds(0));
+    };
+}
+
+TEST_CASE("pipeline with an event ring", "[pipeline][benchmark]")
+{
+    const auto config = make_config(SyntheticPattern::Sweep);
+
+    // Nobody reads, every push beyond the capacity overflows.
+    for(auto policy : {RingOverflowPolicy::DropOldest, RingOverflowPolicy::DropNewest})
+    {
+        SyntheticSource source(config);
+        InputPipeline pipeline;
+        pipeline.dispatcher().configure_ring(1024, policy);
+        BENCHMARK(
+            policy == RingOverflowPolicy::DropOldest
+                ? "4096 events, full ring, drop oldest"
+                : "4096 events, full ring, drop newest"
+        )
+        {
+            return source.advance(pipeline, std::chrono::nanoseconds(0));
+        };
+    }
+
+    // A reader thread drains the ring concurrently.
+    SyntheticSource source(config);
+    InputPipeline pipeline;
+    pipeline.dispatcher().configure_ring(1024, RingOverflowPolicy::DropOldest);
+    std::atomic<bool> done{false};
+    std::thread reader([&pipeline, &done]() {
+        JoystickInputEventEx events[256];
+        while(!done.load(std::memory_order_relaxed))
+        {
+            pipeline.dispatcher().read_events_ex(events, 256);
+        }
+    });
+    BENCHMARK("4096 events, ring with concurrent reader")
+    {
+        return source.advance(pipeline, std::chrono::nanoseconds(0));
+    };
+    done = true;
+    reader.join();
+}
+
+TEST_CASE("pipeline with a dispatch thread", "[pipeline][benchmark]")
+{
+    // Cost on the producing thread of handing the events over, the batch
+    // callback runs concurrently on the dispatch thread.
+    const auto config = make_config(SyntheticPattern::Sweep);
+    for(auto policy : {DispatchPolicy::Block, DispatchPolicy::DropOldest})
+    {
+        SyntheticSource source(config);
+        InputPipeline pipeline;
+        pipeline.dispatcher().set_batch_callback(&count_batch);
+        pipeline.dispatcher().configure_thread(4096, policy);
+        pipeline.dispatcher().start();
+        BENCHMARK(
+            policy == DispatchPolicy::Block
+                ? "4096 events, dispatch thread, block"
+                : "4096 events, dispatch thread, drop oldest"
+        )
+        {
+            return source.advance(pipeline, std::chrono::nanoseconds(0));
+        };
+        pipeline.dispatcher().stop();
+    }
+}
+
+TEST_CASE("pipeline recording and replay", "[pipeline][benchmark]")
+{
+    const auto path = (
+        std::filesystem::temp_directory_path() / "dill_bench_recording.bin"
+    ).string();
+    const auto config = make_config(SyntheticPattern::Sweep);
+
+    {
+        SyntheticSource source(config);
+        InputPipeline pipeline;
+        pipeline.start_recording(path);
+        BENCHMARK("4096 events, recording")
+        {
+            return source.advance(pipeline, std::chrono::nanoseconds(0));
+        };
+        pipeline.stop_recording();
+    }
+
+    // Replays a fixed recording of 65536 events per run.
+    {
+        SyntheticSource source(config);
+        InputPipeline pipeline;
+        pipeline.start_recording(path);
+        for(int i=0; i<16; ++i)
+        {
+            source.advance(pipeline, std::chrono::nanoseconds(0));
+        }
+        pipeline.stop_recording();
+    }
+    ReplayConfig replay;
+    replay.mode = ReplayMode::AsFastAsPossible;
+    BENCHMARK("65536 events, replay as fast as possible")
+    {
+        ReplaySource source(path, replay);
+        InputPipeline pipeline;
+        while(!source.finished())
+        {
+            source.advance(pipeline, std::chrono::nanoseconds::max());
+        }
+        return source.replayed();
+    };
+    std::filesystem::remove(path);
+}
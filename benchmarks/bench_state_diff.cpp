@@ -0,0 +1,128 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <random>
+#include <vector>
+
+#include "axis_mapping.h"
+#include "state_diff.h"
+
+
+namespace
+{
+    DeviceSummary make_summary()
+    {
+        DeviceSummary info;
+        build_axis_map(
+            {
+                DIJOFS_X, DIJOFS_Y, DIJOFS_Z, DIJOFS_RX, DIJOFS_RY, DIJOFS_RZ,
+                DIJOFS_SLIDER(0), DIJOFS_SLIDER(1)
+            },
+            info.axis_count,
+            info.axis_map
+        );
+        info.button_count = 128;
+        info.hat_count = 4;
+        return info;
+    }
+
+    // A sequence of polled reports resembling a recording of a device at
+    // 1 kHz: the device is idle for all but roughly one in idle_ratio
+    // reports, in which an axis moves or a button toggles.
+    std::vector<DIJOYSTATE2> make_reports(size_t count, size_t idle_ratio)
+    {
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<size_t> pick(0, idle_ratio - 1);
+        std::uniform_int_distribution<size_t> button(0, 127);
+        std::uniform_int_distribution<LONG> value(0, 65535);
+
+        DIJOYSTATE2 current = {};
+        for(auto& pov : current.rgdwPOV)
+        {
+            pov = 0xFFFFFFFF;
+        }
+
+        std::vector<DIJOYSTATE2> reports(count);
+        for(auto& report : reports)
+        {
+            if(pick(rng) == 0)
+            {
+                if(pick(rng) % 2 == 0)
+                {
+                    current.lX = value(rng);
+                }
+                else
+                {
+                    current.rgbButtons[button(rng)] ^= 0x80;
+                }
+            }
+            report = current;
+        }
+        return reports;
+    }
+
+    // Processes reports the way poll_device does, optionally skipping
+    // reports identical to the previous one.
+    size_t process(
+        std::vector<DIJOYSTATE2> const& reports,
+        DeviceSummary const&            info,
+        bool                            filter_reports
+    )
+    {
+        DeviceState state;
+        ReportFilter filter;
+        std::vector<JoystickInputData> events;
+        size_t event_count = 0;
+        for(auto const& report : reports)
+        {
+            if(filter_reports && !filter.changed(report))
+            {
+                continue;
+            }
+            events.clear();
+            diff_joystate(report, info, state, events);
+            event_count += events.size();
+        }
+        return event_count;
+    }
+}
+
+
+TEST_CASE("polled report processing", "[state_diff][benchmark]")
+{
+    const auto info = make_summary();
+
+    for(size_t idle_ratio : {1, 20, 1000})
+    {
+        const auto reports = make_reports(1000, idle_ratio);
+        const auto suffix = ", 1/" + std::to_string(idle_ratio) + " changed";
+
+        BENCHMARK("full diff" + suffix)
+        {
+            return process(reports, info, false);
+        };
+
+        BENCHMARK("filtered diff" + suffix)
+        {
+            return process(reports, info, true);
+        };
+    }
+
+    DIJOYSTATE2 lhs = {};
+    DIJOYSTATE2 rhs = {};
+    BENCHMARK("report compare, scalar")
+    {
+        return joystate_equal_scalar(lhs, rhs);
+    };
+#if defined(DILL_HAS_SSE2)
+    BENCHMARK("report compare, SSE2")
+    {
+        return joystate_equal_sse2(lhs, rhs);
+    };
+#endif
+#if defined(DILL_HAS_AVX2)
+    BENCHMARK("report compare, AVX2")
+    {
+        return joystate_equal_avx2(lhs, rhs);
+    };
+#endif
+}
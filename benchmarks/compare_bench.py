@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Compares two dill_bench JSON result files and flags regressions.
+
+Results are produced with
+
+    dill_bench --reporter dill-json::out=results.json
+
+A benchmark counts as regressed when its mean grew by more than the
+threshold and the confidence intervals of both runs do not overlap, so
+noise on a busy machine does not fail the comparison on its own. Exits with
+status 1 if any benchmark regressed, failed in the current run or is
+missing from it.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Returns the measured benchmarks and the errors of failed ones."""
+    with open(path, encoding="utf-8") as handle:
+        document = json.load(handle)
+    results = {}
+    errors = {}
+    for entry in document.get("benchmarks", []):
+        key = (entry["test_case"], entry["name"])
+        if "error" in entry:
+            errors[key] = entry["error"]
+        elif "mean_ns" in entry:
+            results[key] = entry
+    return results, errors
+
+
+def format_ns(value):
+    if value >= 1e6:
+        return "{:.2f} ms".format(value / 1e6)
+    if value >= 1e3:
+        return "{:.2f} us".format(value / 1e3)
+    return "{:.1f} ns".format(value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="results of the reference build")
+    parser.add_argument("current", help="results of the build under test")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=10.0,
+        help="percentage a mean may grow before it counts as regressed"
+    )
+    args = parser.parse_args()
+
+    baseline, baseline_errors = load(args.baseline)
+    current, current_errors = load(args.current)
+
+    regressions = 0
+    failures = 0
+    rows = []
+    keys = set(baseline) | set(baseline_errors) | set(current) | \
+        set(current_errors)
+    for key in sorted(keys):
+        old = baseline.get(key)
+        new = current.get(key)
+        label = "{} / {}".format(*key)
+        if key in current_errors:
+            rows.append((label, "", "", "FAILED: " + current_errors[key]))
+            failures += 1
+            continue
+        if new is None:
+            # Benchmarks dropped from the run would otherwise hide their
+            # regressions.
+            if old is not None:
+                rows.append((label, "", "", "MISSING from current"))
+                failures += 1
+            else:
+                rows.append((label, "", "", "failed in baseline"))
+            continue
+        if old is None:
+            rows.append((label, "", "", "only in current"))
+            continue
+
+        change = (new["mean_ns"] - old["mean_ns"]) / old["mean_ns"] * 100.0
+        status = ""
+        if change > args.threshold and \
+                new["mean_low_ns"] > old["mean_high_ns"]:
+            status = "REGRESSED"
+            regressions += 1
+        elif change < -args.threshold and \
+                new["mean_high_ns"] < old["mean_low_ns"]:
+            status = "improved"
+        rows.append((
+            label,
+            format_ns(old["mean_ns"]),
+            format_ns(new["mean_ns"]),
+            "{:+.1f}% {}".format(change, status).rstrip()
+        ))
+
+    width = max([len(row[0]) for row in rows] + [9])
+    print("{:<{w}}  {:>10}  {:>10}  {}".format(
+        "benchmark", "baseline", "current", "change", w=width
+    ))
+    for row in rows:
+        print("{:<{w}}  {:>10}  {:>10}  {}".format(*row, w=width))
+
+    if failures > 0:
+        print("\n{} benchmark(s) failed or missing in the current run".format(
+            failures
+        ))
+    if regressions > 0:
+        print("\n{} benchmark(s) regressed by more than {}%".format(
+            regressions, args.threshold
+        ))
+    return 1 if failures > 0 or regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
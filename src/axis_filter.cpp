@@ -0,0 +1,143 @@
+#include "axis_filter.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+
+AxisFilter::AxisFilter()
+{
+    reset();
+}
+
+bool AxisFilter::configure(
+    DWORD                               axis_index,
+    AxisFilterConfig const&             config,
+    LONG                                current
+)
+{
+    if(axis_index == 0 || axis_index >= m_axes.size() ||
+       config.min_delta < 0 || config.deadzone < 0 || config.hysteresis < 0)
+    {
+        return false;
+    }
+
+    auto& axis = m_axes[axis_index];
+    axis.config = config;
+    axis.enabled = config.min_delta > 1 || config.deadzone > 0 ||
+        config.hysteresis > 0;
+    axis.in_deadzone = config.deadzone > 0 &&
+        std::llabs(current) <= config.deadzone;
+    axis.reported = axis.in_deadzone ? 0 : current;
+    axis.direction = 0;
+
+    m_active = std::any_of(
+        m_axes.begin(),
+        m_axes.end(),
+        [](Axis const& a) { return a.enabled; }
+    );
+    return true;
+}
+
+AxisFilterConfig AxisFilter::config(DWORD axis_index) const
+{
+    if(axis_index == 0 || axis_index >= m_axes.size())
+    {
+        return AxisFilterConfig{};
+    }
+    return m_axes[axis_index].config;
+}
+
+bool AxisFilter::active() const
+{
+    return m_active;
+}
+
+void AxisFilter::reset()
+{
+    m_axes.fill(Axis{});
+    m_active = false;
+}
+
+bool AxisFilter::apply(JoystickInputData& evt)
+{
+    if(evt.input_type != JoystickInputType::Axis ||
+       evt.input_index == 0 || evt.input_index >= m_axes.size())
+    {
+        return true;
+    }
+    auto& axis = m_axes[evt.input_index];
+    if(!axis.enabled)
+    {
+        return true;
+    }
+    auto const& config = axis.config;
+    const int64_t value = evt.value;
+
+    if(config.deadzone > 0)
+    {
+        const int64_t edge = axis.in_deadzone
+            ? static_cast<int64_t>(config.deadzone) + config.hysteresis
+            : config.deadzone;
+        if(std::llabs(value) <= edge)
+        {
+            // Entering the deadzone reports the center once.
+            const bool report = !axis.in_deadzone && axis.reported != 0;
+            axis.in_deadzone = true;
+            axis.reported = 0;
+            axis.direction = 0;
+            evt.value = 0;
+            return report;
+        }
+        if(axis.in_deadzone)
+        {
+            axis.in_deadzone = false;
+            axis.reported = evt.value;
+            axis.direction = value > 0 ? 1 : -1;
+            return true;
+        }
+    }
+
+    const int64_t delta = value - axis.reported;
+    if(delta == 0)
+    {
+        return false;
+    }
+    const int8_t direction = delta > 0 ? 1 : -1;
+    int64_t required = std::max<LONG>(config.min_delta, 1);
+    if(axis.direction != 0 && direction != axis.direction)
+    {
+        required += config.hysteresis;
+    }
+    if(std::llabs(delta) < required)
+    {
+        return false;
+    }
+
+    axis.reported = evt.value;
+    axis.direction = direction;
+    return true;
+}
+
+size_t AxisFilter::filter(std::vector<JoystickInputEventEx>& events)
+{
+    if(!m_active)
+    {
+        return 0;
+    }
+
+    size_t out = 0;
+    for(size_t i=0; i<events.size(); ++i)
+    {
+        if(apply(events[i].data))
+        {
+            if(out != i)
+            {
+                events[out] = events[i];
+            }
+            ++out;
+        }
+    }
+    const size_t removed = events.size() - out;
+    events.resize(out);
+    return removed;
+}
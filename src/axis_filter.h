@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "dill_types.h"
+
+
+/**
+ * \brief Thresholds deciding which changes of an axis produce events.
+ *
+ * All thresholds are in axis counts, a configuration of all zeros lets
+ * every change through.
+ */
+struct AxisFilterConfig
+{
+    //! Smallest distance from the last reported value that produces an
+    //! event, 0 or 1 report every change.
+    LONG                                min_delta;
+    //! Values within this distance of the center are reported as 0, once,
+    //! 0 disables the deadzone.
+    LONG                                deadzone;
+    //! Additional distance needed to reverse the direction of travel and to
+    //! leave the deadzone, keeps a value oscillating around a threshold
+    //! from producing events.
+    LONG                                hysteresis;
+};
+
+
+/**
+ * \brief Suppresses axis events caused by noise.
+ *
+ * Holds the configuration and the last reported value of every axis of a
+ * device, so deciding on an event takes a handful of integer operations.
+ * Only affects which events are delivered, device state is always updated
+ * from every event. Not thread-safe, in DILL it lives in the device's data
+ * store record.
+ */
+class AxisFilter
+{
+public:
+    AxisFilter();
+
+    /**
+     * \brief Sets the filter of an axis.
+     *
+     * \param axis_index 1-based index of the axis
+     * \param config thresholds to apply from now on
+     * \param current current value of the axis, the reference for the
+     *        next change
+     * \return true if the filter was set, false if the axis index or a
+     *         threshold is out of range
+     */
+    bool configure(
+        DWORD                           axis_index,
+        AxisFilterConfig const&         config,
+        LONG                            current
+    );
+
+    /**
+     * \brief Returns the filter of an axis.
+     *
+     * \param axis_index 1-based index of the axis
+     * \return thresholds applied to the axis, all zero if it is unfiltered
+     */
+    AxisFilterConfig config(DWORD axis_index) const;
+
+    /**
+     * \brief Returns whether any axis is filtered.
+     *
+     * \return true if at least one axis has a non-zero threshold
+     */
+    bool active() const;
+
+    /**
+     * \brief Removes the filters of all axes.
+     */
+    void reset();
+
+    /**
+     * \brief Decides whether an event is reported.
+     *
+     * \param evt event to check, an axis value within the deadzone is
+     *        replaced with 0
+     * \return true if the event is to be reported, false otherwise
+     */
+    bool apply(JoystickInputData& evt);
+
+    /**
+     * \brief Removes the events that are not to be reported.
+     *
+     * \param events events of the device, filtered in place
+     * \return number of removed events
+     */
+    size_t filter(std::vector<JoystickInputEventEx>& events);
+
+private:
+    struct Axis
+    {
+        AxisFilterConfig                config;
+        //! Last value reported by an event.
+        LONG                            reported;
+        //! Direction of the last reported change, -1, 0 or 1.
+        int8_t                          direction;
+        bool                            in_deadzone;
+        //! Whether any threshold is set.
+        bool                            enabled;
+    };
+
+    // Index 0 is unused, matching DeviceState.
+    std::array<Axis, k_max_axes + 1>    m_axes;
+    bool                                m_active;
+};
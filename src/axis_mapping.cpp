@@ -1,80 +1,87 @@
 #include "axis_mapping.h"
 
 #include <algorithm>
-#include <array>
+
+#include "offset_decoder.h"
 
 namespace
 {
-    struct AxisDIOffset
+    // Fills axis_map with the detected axes up to max_axis_index, in
+    // axis_index order.
+    void fill_axis_map(
+        std::vector<AxisOffset> const&  detected_offsets,
+        DWORD                           max_axis_index,
+        DWORD&                          axis_count,
+        AxisMap*                        axis_map
+    )
     {
-        DWORD                            axis_index;
-        AxisOffset                       offset;
-    };
+        axis_count = 0;
+        for(DWORD i=0; i<max_axis_index; ++i)
+        {
+            axis_map[i] = {0, 0};
+        }
 
-    // Mapping from linear axis index to the DIJOYSTATE2 offset.
-    const std::array<AxisDIOffset, 8> g_axis_di_offset_lookup =
-    {{
-        {1, DIJOFS_X},
-        {2, DIJOFS_Y},
-        {3, DIJOFS_Z},
-        {4, DIJOFS_RX},
-        {5, DIJOFS_RY},
-        {6, DIJOFS_RZ},
-        {7, DIJOFS_SLIDER(0)},
-        {8, DIJOFS_SLIDER(1)},
-    }};
+        for(DWORD i=0; i<max_axis_index; ++i)
+        {
+            const bool detected = std::find(
+                detected_offsets.cbegin(),
+                detected_offsets.cend(),
+                k_axis_offsets[i]
+            ) != detected_offsets.cend();
+
+            if(detected)
+            {
+                axis_map[axis_count] = {axis_count + 1, i + 1};
+                ++axis_count;
+            }
+        }
+    }
 }
 
 DWORD axis_index_for_offset(AxisOffset offset)
 {
-    const auto it = std::find_if(
-        g_axis_di_offset_lookup.cbegin(),
-        g_axis_di_offset_lookup.cend(),
-        [offset](AxisDIOffset const& slot) { return slot.offset == offset; }
-    );
-    return it != g_axis_di_offset_lookup.cend()
-        ? it->axis_index
+    const auto decoded = decode_offset(offset);
+    return decoded.input_type == JoystickInputType::Axis
+        ? decoded.input_index
         : static_cast<DWORD>(-1);
 }
 
 AxisOffset offset_for_axis_index(DWORD axis_index)
 {
-    const auto it = std::find_if(
-        g_axis_di_offset_lookup.cbegin(),
-        g_axis_di_offset_lookup.cend(),
-        [axis_index](AxisDIOffset const& slot) {
-            return slot.axis_index == axis_index;
-        }
-    );
-    return it != g_axis_di_offset_lookup.cend()
-        ? it->offset
+    return axis_index >= 1 && axis_index <= k_axis_offsets.size()
+        ? k_axis_offsets[axis_index - 1]
         : static_cast<AxisOffset>(-1);
 }
 
 void build_axis_map(
     std::vector<AxisOffset> const&      detected_offsets,
     DWORD&                              axis_count,
-    AxisMap                             (&axis_map)[8]
+    AxisMap                             (&axis_map)[k_summary_axes]
 )
 {
-    axis_count = 0;
-    for(auto& entry : axis_map)
-    {
-        entry = {0, 0};
-    }
+    fill_axis_map(detected_offsets, k_summary_axes, axis_count, axis_map);
+}
 
-    for(auto const& slot : g_axis_di_offset_lookup)
-    {
-        const bool detected = std::find(
-            detected_offsets.cbegin(),
-            detected_offsets.cend(),
-            slot.offset
-        ) != detected_offsets.cend();
+void build_axis_map(
+    std::vector<AxisOffset> const&      detected_offsets,
+    DWORD&                              axis_count,
+    AxisMap                             (&axis_map)[k_max_axes]
+)
+{
+    fill_axis_map(detected_offsets, k_max_axes, axis_count, axis_map);
+}
 
-        if(detected)
-        {
-            axis_map[axis_count] = {axis_count + 1, slot.axis_index};
-            ++axis_count;
-        }
-    }
+DeviceSummaryEx extend_device_summary(DeviceSummary const& info)
+{
+    DeviceSummaryEx result = {};
+    result.struct_size = sizeof(DeviceSummaryEx);
+    result.version = k_device_summary_ex_version;
+    result.summary = info;
+    result.axis_count = std::min<DWORD>(info.axis_count, k_summary_axes);
+    std::copy(
+        info.axis_map,
+        info.axis_map + result.axis_count,
+        result.axis_map
+    );
+    return result;
 }
@@ -0,0 +1,68 @@
+#include "button_mask.h"
+
+#if defined(DILL_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(DILL_HAS_AVX2)
+#include <immintrin.h>
+#endif
+
+
+ButtonMask pack_buttons(BYTE const (&buttons)[k_max_buttons])
+{
+#if defined(DILL_HAS_AVX2)
+    return pack_buttons_avx2(buttons);
+#elif defined(DILL_HAS_SSE2)
+    return pack_buttons_sse2(buttons);
+#else
+    return pack_buttons_scalar(buttons);
+#endif
+}
+
+ButtonMask pack_buttons_scalar(BYTE const (&buttons)[k_max_buttons])
+{
+    ButtonMask mask;
+    for(size_t i=0; i<k_max_buttons; ++i)
+    {
+        mask.bits[i / 64] |= uint64_t(buttons[i] >> 7) << (i % 64);
+    }
+    return mask;
+}
+
+#if defined(DILL_HAS_SSE2)
+ButtonMask pack_buttons_sse2(BYTE const (&buttons)[k_max_buttons])
+{
+    // movemask gathers the high bit of each byte, which is exactly the
+    // pressed flag, 16 buttons at a time.
+    ButtonMask mask;
+    for(size_t i=0; i<k_max_buttons; i+=16)
+    {
+        const auto bytes = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(buttons + i)
+        );
+        const auto bits = static_cast<uint64_t>(
+            static_cast<uint16_t>(_mm_movemask_epi8(bytes))
+        );
+        mask.bits[i / 64] |= bits << (i % 64);
+    }
+    return mask;
+}
+#endif
+
+#if defined(DILL_HAS_AVX2)
+ButtonMask pack_buttons_avx2(BYTE const (&buttons)[k_max_buttons])
+{
+    ButtonMask mask;
+    for(size_t i=0; i<k_max_buttons; i+=32)
+    {
+        const auto bytes = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const*>(buttons + i)
+        );
+        const auto bits = static_cast<uint64_t>(
+            static_cast<uint32_t>(_mm256_movemask_epi8(bytes))
+        );
+        mask.bits[i / 64] |= bits << (i % 64);
+    }
+    return mask;
+}
+#endif
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Instruction sets available to the button packing routines, determined by
+// the compiler's target settings, see DILL_ENABLE_AVX2 in CMakeLists.txt.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DILL_HAS_SSE2 1
+#endif
+#if defined(__AVX2__)
+#define DILL_HAS_AVX2 1
+#endif
+
+
+//! Number of buttons a DIJOYSTATE2 report holds.
+constexpr size_t k_max_buttons = 128;
+
+
+/**
+ * \brief State of all buttons of a device packed into 128 bits.
+ *
+ * Buttons are 1-based like all other inputs, bit N-1 holds the state of
+ * button N counting from the lowest bit of the first word.
+ */
+struct ButtonMask
+{
+    std::array<uint64_t, 2>             bits = {0, 0};
+
+    /**
+     * \brief Returns a mask with the first count buttons set.
+     *
+     * \param count number of buttons to set, clamped to k_max_buttons
+     * \return mask with buttons 1 to count set
+     */
+    static ButtonMask first(size_t count)
+    {
+        ButtonMask mask;
+        for(size_t word=0; word<mask.bits.size(); ++word)
+        {
+            const size_t bits = count > word * 64 ? count - word * 64 : 0;
+            mask.bits[word] = bits >= 64 ? ~uint64_t(0)
+                : (uint64_t(1) << bits) - 1;
+        }
+        return mask;
+    }
+
+    /**
+     * \brief Returns whether a button is pressed.
+     *
+     * \param button 1-based index of the button
+     * \return true if the button is pressed, false otherwise
+     */
+    bool test(size_t button) const
+    {
+        return (bits[(button - 1) / 64] >> ((button - 1) % 64)) & 1;
+    }
+
+    /**
+     * \brief Sets the state of a button.
+     *
+     * \param button 1-based index of the button
+     * \param pressed new state of the button
+     */
+    void set(size_t button, bool pressed)
+    {
+        const uint64_t bit = uint64_t(1) << ((button - 1) % 64);
+        auto& word = bits[(button - 1) / 64];
+        word = pressed ? word | bit : word & ~bit;
+    }
+
+    /**
+     * \brief Returns whether any button is set.
+     *
+     * \return true if at least one button is set, false otherwise
+     */
+    bool any() const
+    {
+        return (bits[0] | bits[1]) != 0;
+    }
+
+    ButtonMask operator^(ButtonMask const& other) const
+    {
+        return {{bits[0] ^ other.bits[0], bits[1] ^ other.bits[1]}};
+    }
+
+    ButtonMask operator&(ButtonMask const& other) const
+    {
+        return {{bits[0] & other.bits[0], bits[1] & other.bits[1]}};
+    }
+
+    bool operator==(ButtonMask const& other) const
+    {
+        return bits == other.bits;
+    }
+
+    bool operator!=(ButtonMask const& other) const
+    {
+        return bits != other.bits;
+    }
+};
+
+
+/**
+ * \brief Packs the button bytes of a DIJOYSTATE2 report into a mask.
+ *
+ * A button counts as pressed if the high bit of its byte is set. Uses the
+ * widest instruction set available to the build.
+ *
+ * \param buttons the rgbButtons member of a DIJOYSTATE2 report
+ * \return mask of the pressed buttons
+ */
+ButtonMask pack_buttons(BYTE const (&buttons)[k_max_buttons]);
+
+/**
+ * \brief Portable implementation of pack_buttons.
+ */
+ButtonMask pack_buttons_scalar(BYTE const (&buttons)[k_max_buttons]);
+
+#if defined(DILL_HAS_SSE2)
+/**
+ * \brief SSE2 implementation of pack_buttons.
+ */
+ButtonMask pack_buttons_sse2(BYTE const (&buttons)[k_max_buttons]);
+#endif
+
+#if defined(DILL_HAS_AVX2)
+/**
+ * \brief AVX2 implementation of pack_buttons.
+ */
+ButtonMask pack_buttons_avx2(BYTE const (&buttons)[k_max_buttons]);
+#endif
+
+/**
+ * \brief Invokes a callable for every button set in a mask.
+ *
+ * Only visits set bits, so the cost depends on the number of set buttons
+ * rather than the number of buttons.
+ *
+ * \param mask buttons to visit
+ * \param fn callable invoked with the 1-based index of every set button in
+ *        increasing order
+ */
+template<typename Fn>
+void for_each_button(ButtonMask const& mask, Fn&& fn)
+{
+    for(size_t word=0; word<mask.bits.size(); ++word)
+    {
+        uint64_t bits = mask.bits[word];
+        while(bits != 0)
+        {
+#if defined(_MSC_VER) && defined(_M_X64)
+            unsigned long bit;
+            _BitScanForward64(&bit, bits);
+#elif defined(_MSC_VER)
+            unsigned long bit;
+            if(!_BitScanForward(&bit, static_cast<unsigned long>(bits)))
+            {
+                _BitScanForward(&bit, static_cast<unsigned long>(bits >> 32));
+                bit += 32;
+            }
+#else
+            const auto bit = __builtin_ctzll(bits);
+#endif
+            fn(word * 64 + bit + 1);
+            bits &= bits - 1;
+        }
+    }
+}
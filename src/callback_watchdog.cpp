@@ -0,0 +1,157 @@
+#include "callback_watchdog.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "event_timing.h"
+
+
+namespace
+{
+    // Bounds of the interval at which the monitor samples the stamp.
+    const uint64_t k_min_interval_ns = 1000000;
+    const uint64_t k_max_interval_ns = 250000000;
+}
+
+
+CallbackWatchdog::~CallbackWatchdog()
+{
+    stop();
+}
+
+void CallbackWatchdog::configure(uint64_t budget_ns, CallbackStallHook hook)
+{
+    m_budget_ns = budget_ns;
+    m_hook = hook;
+}
+
+void CallbackWatchdog::start()
+{
+    if(m_active || m_budget_ns == 0)
+    {
+        return;
+    }
+
+    m_stopping = false;
+    m_current = Stamp{};
+    m_stamp.store(m_current);
+    m_thread = std::thread(&CallbackWatchdog::monitor_main, this);
+    m_active = true;
+}
+
+void CallbackWatchdog::stop()
+{
+    if(!m_active)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+    m_active = false;
+}
+
+void CallbackWatchdog::enter(uint64_t start_ns, JoystickInputData const& evt)
+{
+    m_current.entered_ns = start_ns;
+    m_current.stall = CallbackStall{};
+    m_current.stall.device_guid = evt.device_guid;
+    m_current.stall.input_type = evt.input_type;
+    m_current.stall.input_index = evt.input_index;
+    m_stamp.store(m_current);
+}
+
+void CallbackWatchdog::enter(
+    uint64_t                            start_ns,
+    GUID const&                         guid,
+    DeviceActionType                    action
+)
+{
+    m_current.entered_ns = start_ns;
+    m_current.stall = CallbackStall{};
+    m_current.stall.device_guid = guid;
+    m_current.stall.action = action;
+    m_stamp.store(m_current);
+}
+
+void CallbackWatchdog::update(JoystickInputData const& evt)
+{
+    m_current.stall.input_type = evt.input_type;
+    m_current.stall.input_index = evt.input_index;
+    m_stamp.store(m_current);
+}
+
+void CallbackWatchdog::leave(uint64_t end_ns)
+{
+    const uint64_t elapsed = end_ns > m_current.entered_ns
+        ? end_ns - m_current.entered_ns
+        : 0;
+    m_current.entered_ns = 0;
+    m_stamp.store(m_current);
+
+    if(elapsed > m_budget_ns.load(std::memory_order_relaxed))
+    {
+        increment(m_overruns);
+    }
+    if(elapsed > m_max_callback_ns.load(std::memory_order_relaxed))
+    {
+        m_max_callback_ns.store(elapsed, std::memory_order_relaxed);
+    }
+}
+
+WatchdogStats CallbackWatchdog::stats() const
+{
+    WatchdogStats result;
+    result.budget_ns = m_budget_ns.load(std::memory_order_relaxed);
+    result.overruns = m_overruns.load(std::memory_order_relaxed);
+    result.stalls = m_stalls.load(std::memory_order_relaxed);
+    result.max_callback_ns = m_max_callback_ns.load(
+        std::memory_order_relaxed
+    );
+    result.last_stall = m_last_stall.load();
+    return result;
+}
+
+void CallbackWatchdog::monitor_main()
+{
+    const uint64_t budget = m_budget_ns.load(std::memory_order_relaxed);
+    const auto interval = std::chrono::nanoseconds(std::min(
+        std::max(budget / 4, k_min_interval_ns),
+        k_max_interval_ns
+    ));
+
+    // Start time of the last flagged delivery, per-event updates of a
+    // delivery keep its start time and are flagged only once.
+    uint64_t flagged_ns = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(!m_wakeup.wait_for(lock, interval, [this] { return m_stopping; }))
+    {
+        const Stamp stamp = m_stamp.load();
+        if(stamp.entered_ns == 0 || stamp.entered_ns == flagged_ns)
+        {
+            continue;
+        }
+        const uint64_t now = monotonic_time_ns();
+        if(now < stamp.entered_ns || now - stamp.entered_ns <= budget)
+        {
+            continue;
+        }
+
+        flagged_ns = stamp.entered_ns;
+        CallbackStall stall = stamp.stall;
+        stall.elapsed_ns = now - stamp.entered_ns;
+        increment(m_stalls);
+        m_last_stall.store(stall);
+        if(m_hook != nullptr)
+        {
+            // The hook may take its time, do not hold up stop() meanwhile.
+            lock.unlock();
+            m_hook(&stall);
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "dill_types.h"
+#include "seqlock.h"
+
+
+/**
+ * \brief Callback delivery that exceeded the watchdog's budget.
+ */
+struct CallbackStall
+{
+    //! Device whose input or change was being delivered.
+    GUID                                device_guid;
+    //! Type of the event being delivered, 0 for device changes.
+    JoystickInputType                   input_type;
+    //! Index of the event being delivered, 0 for device changes.
+    UINT8                               input_index;
+    //! Change being delivered, 0 for input events.
+    DeviceActionType                    action;
+    //! Time spent in the callback when the stall was detected.
+    uint64_t                            elapsed_ns;
+};
+
+/**
+ * \brief Function invoked by the watchdog's monitor thread for every
+ *        callback exceeding the budget, while the callback still runs.
+ */
+typedef void (*CallbackStallHook)(CallbackStall const*);
+
+/**
+ * \brief Counters describing callbacks exceeding the watchdog's budget.
+ */
+struct WatchdogStats
+{
+    //! Budget a single callback delivery may take, 0 if disabled.
+    uint64_t                            budget_ns;
+    //! Number of deliveries that returned after exceeding the budget.
+    uint64_t                            overruns;
+    //! Number of deliveries flagged by the monitor while still running.
+    uint64_t                            stalls;
+    //! Longest delivery observed while the watchdog was running.
+    uint64_t                            max_callback_ns;
+    //! Most recent stall flagged by the monitor, all zero if none.
+    CallbackStall                       last_stall;
+};
+
+
+/**
+ * \brief Detects client callbacks holding up the delivering thread.
+ *
+ * The delivering thread stamps the start of every callback delivery and
+ * the event being handed over into a seqlock, which costs a few relaxed
+ * stores and no locking. A monitor thread samples the stamp several times
+ * per budget and flags a delivery running longer than the budget once,
+ * counting it and invoking the stall hook while the callback is still
+ * blocked. Independently, every delivery exceeding the budget is counted
+ * as an overrun when it returns.
+ */
+class CallbackWatchdog
+{
+public:
+    CallbackWatchdog() = default;
+    CallbackWatchdog(CallbackWatchdog const&) = delete;
+    CallbackWatchdog& operator=(CallbackWatchdog const&) = delete;
+    ~CallbackWatchdog();
+
+    /**
+     * \brief Sets the budget and hook used by the next start().
+     *
+     * Must not be called between start() and stop().
+     *
+     * \param budget_ns time a delivery may take, 0 disables the watchdog
+     * \param hook function invoked on stalls, may be nullptr
+     */
+    void configure(uint64_t budget_ns, CallbackStallHook hook);
+
+    /**
+     * \brief Starts the monitor thread, if a budget is configured.
+     *
+     * Must neither race with the stamping functions nor with stop().
+     */
+    void start();
+
+    /**
+     * \brief Stops the monitor thread.
+     *
+     * Must neither race with the stamping functions nor with start().
+     */
+    void stop();
+
+    /**
+     * \brief Returns whether deliveries have to be stamped.
+     *
+     * \return true between start() and stop() with a budget configured
+     */
+    bool active() const
+    {
+        return m_active;
+    }
+
+    /**
+     * \brief Stamps the start of an input callback delivery.
+     *
+     * \param start_ns time at which the delivery started
+     * \param evt first event handed to the callback
+     */
+    void enter(uint64_t start_ns, JoystickInputData const& evt);
+
+    /**
+     * \brief Stamps the start of a device change callback delivery.
+     *
+     * \param start_ns time at which the delivery started
+     * \param guid GUID of the changed device
+     * \param action how the device changed
+     */
+    void enter(uint64_t start_ns, GUID const& guid, DeviceActionType action);
+
+    /**
+     * \brief Replaces the event of the running delivery.
+     *
+     * Used when one delivery invokes a callback once per event.
+     *
+     * \param evt event handed to the callback next
+     */
+    void update(JoystickInputData const& evt);
+
+    /**
+     * \brief Stamps the end of the running delivery.
+     *
+     * \param end_ns time at which the delivery returned
+     */
+    void leave(uint64_t end_ns);
+
+    /**
+     * \brief Returns the counters of the watchdog.
+     *
+     * \return counters accumulated over every start() and stop()
+     */
+    WatchdogStats stats() const;
+
+private:
+    //! Delivery in progress, entered_ns is 0 while none is.
+    struct Stamp
+    {
+        uint64_t                        entered_ns;
+        CallbackStall                   stall;
+    };
+
+    using Counter = std::atomic<uint64_t>;
+
+    static void increment(Counter& counter)
+    {
+        counter.store(
+            counter.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed
+        );
+    }
+
+    void monitor_main();
+
+    std::atomic<uint64_t>               m_budget_ns{0};
+    CallbackStallHook                   m_hook = nullptr;
+    bool                                m_active = false;
+    //! Written by the delivering thread only.
+    Seqlock<Stamp>                      m_stamp;
+    Stamp                               m_current{};
+    Counter                             m_overruns{0};
+    Counter                             m_max_callback_ns{0};
+    //! Written by the monitor thread only.
+    Counter                             m_stalls{0};
+    Seqlock<CallbackStall>              m_last_stall;
+    std::thread                         m_thread;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_wakeup;
+    bool                                m_stopping = false;
+};
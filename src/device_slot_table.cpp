@@ -0,0 +1,137 @@
+#include "device_slot_table.h"
+
+#include <algorithm>
+#include <functional>
+
+
+static_assert(k_max_devices < 0xFF, "Slots must fit the device handle");
+
+uint32_t encode_device_handle(SlotRef ref)
+{
+    return (ref.generation << 8) | ((ref.slot + 1) & 0xFF);
+}
+
+SlotRef decode_device_handle(uint32_t handle)
+{
+    const uint32_t slot = handle & 0xFF;
+    if(slot == 0)
+    {
+        return {k_invalid_slot, 0};
+    }
+    return {slot - 1, handle >> 8};
+}
+
+
+DeviceSlotTable::DeviceSlotTable()
+{
+    m_guids.fill(GUID{});
+    m_generations.fill(1);
+    m_in_use.fill(false);
+    m_active.reserve(k_max_devices);
+    clear();
+}
+
+uint32_t DeviceSlotTable::acquire(GUID const& guid)
+{
+    const auto it = m_index.find(guid);
+    if(it != m_index.end())
+    {
+        return it->second;
+    }
+    if(m_free.empty())
+    {
+        return k_invalid_slot;
+    }
+
+    const uint32_t slot = m_free.back();
+    m_free.pop_back();
+    m_index.emplace(guid, slot);
+    m_guids[slot] = guid;
+    m_in_use[slot] = true;
+    m_active.push_back(slot);
+    return slot;
+}
+
+uint32_t DeviceSlotTable::release(GUID const& guid)
+{
+    const auto it = m_index.find(guid);
+    if(it == m_index.end())
+    {
+        return k_invalid_slot;
+    }
+
+    const uint32_t slot = it->second;
+    m_index.erase(it);
+    m_guids[slot] = GUID{};
+    m_in_use[slot] = false;
+    advance_generation(slot);
+    m_active.erase(std::find(m_active.begin(), m_active.end(), slot));
+
+    // Keep handing out the lowest free slot so slot indices stay dense.
+    m_free.insert(
+        std::upper_bound(
+            m_free.begin(),
+            m_free.end(),
+            slot,
+            std::greater<uint32_t>()
+        ),
+        slot
+    );
+    return slot;
+}
+
+void DeviceSlotTable::clear()
+{
+    for(auto slot : m_active)
+    {
+        m_guids[slot] = GUID{};
+        m_in_use[slot] = false;
+        advance_generation(slot);
+    }
+    m_index.clear();
+    m_active.clear();
+
+    m_free.clear();
+    for(uint32_t slot=k_max_devices; slot>0; --slot)
+    {
+        m_free.push_back(slot - 1);
+    }
+}
+
+uint32_t DeviceSlotTable::find(GUID const& guid) const
+{
+    const auto it = m_index.find(guid);
+    return it != m_index.end() ? it->second : k_invalid_slot;
+}
+
+GUID const& DeviceSlotTable::guid(uint32_t slot) const
+{
+    return m_guids[slot];
+}
+
+SlotRef DeviceSlotTable::ref(uint32_t slot) const
+{
+    return {slot, m_generations[slot]};
+}
+
+bool DeviceSlotTable::is_current(SlotRef ref) const
+{
+    return ref.slot < k_max_devices &&
+        m_in_use[ref.slot] &&
+        m_generations[ref.slot] == ref.generation;
+}
+
+std::vector<uint32_t> const& DeviceSlotTable::active() const
+{
+    return m_active;
+}
+
+size_t DeviceSlotTable::size() const
+{
+    return m_active.size();
+}
+
+void DeviceSlotTable::advance_generation(uint32_t slot)
+{
+    m_generations[slot] = m_generations[slot] % k_max_generation + 1;
+}
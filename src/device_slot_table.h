@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "dill_types.h"
+
+
+//! Maximum number of devices that can be connected at the same time.
+constexpr size_t k_max_devices = 64;
+
+//! Slot value indicating that a device has no slot.
+constexpr uint32_t k_invalid_slot = static_cast<uint32_t>(-1);
+
+//! Device handle value that never refers to a device.
+constexpr uint32_t k_invalid_device_handle = 0;
+
+//! Largest slot generation, generations wrap around to 1 after it.
+constexpr uint32_t k_max_generation = 0x00FFFFFF;
+
+
+/**
+ * \brief Refers to a slot as occupied by one particular device.
+ *
+ * A slot's generation changes every time it is released, which makes
+ * references held across a disconnect detectably stale even when the slot
+ * has since been reused by another device. Generations range from 1 to
+ * k_max_generation, 0 never names a live slot.
+ */
+struct SlotRef
+{
+    uint32_t                            slot;
+    uint32_t                            generation;
+};
+
+inline bool operator==(SlotRef const& lhs, SlotRef const& rhs)
+{
+    return lhs.slot == rhs.slot && lhs.generation == rhs.generation;
+}
+
+inline bool operator!=(SlotRef const& lhs, SlotRef const& rhs)
+{
+    return !(lhs == rhs);
+}
+
+/**
+ * \brief Encodes a slot reference as an opaque device handle.
+ *
+ * The slot is stored in the low 8 bits offset by one and the generation in
+ * the high 24 bits, so that no valid reference encodes to
+ * k_invalid_device_handle.
+ *
+ * \param ref reference to encode
+ * \return device handle representing the reference
+ */
+uint32_t encode_device_handle(SlotRef ref);
+
+/**
+ * \brief Decodes a device handle into a slot reference.
+ *
+ * \param handle device handle to decode
+ * \return reference named by the handle, invalid handles decode to a
+ *         reference no slot ever matches
+ */
+SlotRef decode_device_handle(uint32_t handle);
+
+
+/**
+ * \brief Assigns each connected device a small, stable slot index.
+ *
+ * All per-device data is kept in arrays indexed by slot, so that a single
+ * GUID lookup resolves every piece of information about a device. Slots
+ * stay assigned for as long as the device is connected and are reused
+ * once it disconnects.
+ *
+ * Not thread-safe, in DILL it is only accessed while holding
+ * g_data_store_mutex.
+ */
+class DeviceSlotTable
+{
+public:
+    DeviceSlotTable();
+
+    /**
+     * \brief Assigns a slot to a device.
+     *
+     * \param guid GUID of the device
+     * \return the device's slot, which is its existing one if it already
+     *         had one, or k_invalid_slot if all slots are in use
+     */
+    uint32_t acquire(GUID const& guid);
+
+    /**
+     * \brief Releases the slot of a device.
+     *
+     * \param guid GUID of the device
+     * \return the released slot or k_invalid_slot if the device had none
+     */
+    uint32_t release(GUID const& guid);
+
+    /**
+     * \brief Releases all slots.
+     */
+    void clear();
+
+    /**
+     * \brief Returns the slot of a device.
+     *
+     * \param guid GUID of the device
+     * \return the device's slot or k_invalid_slot if it has none
+     */
+    uint32_t find(GUID const& guid) const;
+
+    /**
+     * \brief Returns the GUID of the device occupying a slot.
+     *
+     * \param slot slot to query, must be in use
+     * \return GUID of the device in the slot
+     */
+    GUID const& guid(uint32_t slot) const;
+
+    /**
+     * \brief Returns a reference to a slot's current occupant.
+     *
+     * \param slot slot to reference
+     * \return reference to the slot at its current generation
+     */
+    SlotRef ref(uint32_t slot) const;
+
+    /**
+     * \brief Checks whether a reference still names the slot's occupant.
+     *
+     * \param ref reference to check
+     * \return true if the slot is in use at the referenced generation
+     */
+    bool is_current(SlotRef ref) const;
+
+    /**
+     * \brief Returns the slots in use, in the order they were acquired.
+     *
+     * \return slots of all connected devices
+     */
+    std::vector<uint32_t> const& active() const;
+
+    /**
+     * \brief Returns the number of slots in use.
+     *
+     * \return number of connected devices
+     */
+    size_t size() const;
+
+private:
+    void advance_generation(uint32_t slot);
+
+    std::unordered_map<GUID, uint32_t>  m_index;
+    std::array<GUID, k_max_devices>     m_guids;
+    std::array<uint32_t, k_max_devices> m_generations;
+    std::array<bool, k_max_devices>     m_in_use;
+    std::vector<uint32_t>               m_active;
+    //! Unused slots, the lowest index is at the back.
+    std::vector<uint32_t>               m_free;
+};
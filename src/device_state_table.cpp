@@ -0,0 +1,155 @@
+#include "device_state_table.h"
+
+#include <cstring>
+
+
+void DeviceStateTable::split_key(GUID const& guid, uint64_t (&key)[2])
+{
+    static_assert(sizeof(GUID) == sizeof(key), "Unexpected GUID size");
+    memcpy(key, &guid, sizeof(GUID));
+}
+
+void DeviceStateTable::to_snapshot(
+    Record const&                       record,
+    DillDeviceSnapshot&                 snapshot
+)
+{
+    snapshot.device_guid = record.guid;
+    snapshot.version = record.version;
+    snapshot.button_mask[0] = record.state.button.bits[0];
+    snapshot.button_mask[1] = record.state.button.bits[1];
+    memcpy(snapshot.axis, record.state.axis.data(), sizeof(snapshot.axis));
+    memcpy(snapshot.hat, record.state.hat.data(), sizeof(snapshot.hat));
+}
+
+void DeviceStateTable::add(SlotRef ref, GUID const& guid)
+{
+    const uint32_t slot = ref.slot;
+    if(slot >= m_block_count.load(std::memory_order_relaxed))
+    {
+        m_block_count.store(slot + 1, std::memory_order_release);
+    }
+
+    // Publish the record before the key, so that a reader matching the key
+    // finds the device's state rather than the previous occupant's.
+    auto& block = m_blocks[slot];
+    m_written[slot] = {guid, ref.generation, ++m_version, DeviceState()};
+    block.record.store(m_written[slot]);
+
+    uint64_t key[2];
+    split_key(guid, key);
+    block.key[0].store(key[0], std::memory_order_release);
+    block.key[1].store(key[1], std::memory_order_release);
+}
+
+void DeviceStateTable::remove(uint32_t slot)
+{
+    auto& block = m_blocks[slot];
+    block.key[0].store(0, std::memory_order_release);
+    block.key[1].store(0, std::memory_order_release);
+    m_written[slot] = {GUID{}, 0, ++m_version, DeviceState()};
+    block.record.store(m_written[slot]);
+}
+
+void DeviceStateTable::clear()
+{
+    const size_t block_count = m_block_count.load(std::memory_order_relaxed);
+    for(size_t slot=0; slot<block_count; ++slot)
+    {
+        remove(static_cast<uint32_t>(slot));
+    }
+}
+
+bool DeviceStateTable::load(GUID const& guid, DeviceState& state) const
+{
+    Record record;
+    if(!find_record(guid, record))
+    {
+        return false;
+    }
+    state = record.state;
+    return true;
+}
+
+bool DeviceStateTable::load(SlotRef ref, DeviceState& state) const
+{
+    Record record;
+    if(!find_record(ref, record))
+    {
+        return false;
+    }
+    state = record.state;
+    return true;
+}
+
+bool DeviceStateTable::snapshot(
+    GUID const&                         guid,
+    DillDeviceSnapshot&                 snapshot
+) const
+{
+    Record record;
+    if(!find_record(guid, record))
+    {
+        return false;
+    }
+    to_snapshot(record, snapshot);
+    return true;
+}
+
+bool DeviceStateTable::snapshot(
+    SlotRef                             ref,
+    DillDeviceSnapshot&                 snapshot
+) const
+{
+    Record record;
+    if(!find_record(ref, record))
+    {
+        return false;
+    }
+    to_snapshot(record, snapshot);
+    return true;
+}
+
+bool DeviceStateTable::find_record(GUID const& guid, Record& record) const
+{
+    uint64_t key[2];
+    split_key(guid, key);
+    if(key[0] == 0 && key[1] == 0)
+    {
+        return false;
+    }
+
+    const size_t block_count = m_block_count.load(std::memory_order_acquire);
+    for(size_t i=0; i<block_count; ++i)
+    {
+        auto const& block = m_blocks[i];
+        if(block.key[0].load(std::memory_order_acquire) != key[0] ||
+           block.key[1].load(std::memory_order_acquire) != key[1])
+        {
+            continue;
+        }
+
+        // The block may have been reassigned after the key comparison, the
+        // GUID stored alongside the state settles which device it holds.
+        record = block.record.load();
+        if(record.guid == guid)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DeviceStateTable::find_record(SlotRef ref, Record& record) const
+{
+    if(ref.generation == 0 ||
+       ref.slot >= m_block_count.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    // The generation is published together with the state, so a match
+    // guarantees the copy belongs to the referenced occupant of the slot.
+    record = m_blocks[ref.slot].record.load();
+    return record.generation == ref.generation;
+}
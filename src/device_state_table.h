@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "device_slot_table.h"
+#include "dill_types.h"
+#include "seqlock.h"
+
+
+/**
+ * \brief Holds the last known state of every device.
+ *
+ * Each device's state lives in the fixed-layout block of its slot, see
+ * DeviceSlotTable, guarded by its own Seqlock. This lets any thread read it
+ * without taking a lock and without delaying the writer. Readers locate a
+ * device by scanning the GUIDs of the blocks in use, which is cheap for the
+ * handful of devices DILL handles.
+ *
+ * All modifying methods must be serialized by the caller, in DILL they are
+ * only called while holding g_data_store_mutex. load() may be called from
+ * any thread at any time.
+ */
+class DeviceStateTable
+{
+public:
+    DeviceStateTable() = default;
+    DeviceStateTable(DeviceStateTable const&) = delete;
+    DeviceStateTable& operator=(DeviceStateTable const&) = delete;
+
+    /**
+     * \brief Starts tracking the state of a device.
+     *
+     * The slot's state is reset to the default DeviceState.
+     *
+     * \param ref slot assigned to the device at its current generation
+     * \param guid GUID of the device
+     */
+    void add(SlotRef ref, GUID const& guid);
+
+    /**
+     * \brief Stops tracking the state of a device.
+     *
+     * \param slot slot of the device to remove
+     */
+    void remove(uint32_t slot);
+
+    /**
+     * \brief Stops tracking the state of all devices.
+     */
+    void clear();
+
+    /**
+     * \brief Modifies the state of a device.
+     *
+     * The modified state becomes visible to readers as a whole once fn
+     * returns, so several inputs can be updated in a single publication.
+     *
+     * \param slot slot of the device to modify
+     * \param fn callable invoked with a DeviceState& to modify
+     */
+    template<typename Fn>
+    void update(uint32_t slot, Fn&& fn)
+    {
+        auto& record = m_written[slot];
+        fn(record.state);
+        record.version = ++m_version;
+        m_blocks[slot].record.store(record);
+    }
+
+    /**
+     * \brief Returns a consistent copy of a device's state.
+     *
+     * Safe to call from any thread without holding any lock.
+     *
+     * \param guid GUID of the device to query
+     * \param state set to the device's current state if it is tracked
+     * \return true if the device is tracked, false otherwise
+     */
+    bool load(GUID const& guid, DeviceState& state) const;
+
+    /**
+     * \brief Returns a consistent copy of a device's state by slot.
+     *
+     * Avoids the GUID scan of load(GUID const&, DeviceState&). Safe to call
+     * from any thread without holding any lock.
+     *
+     * \param ref slot and generation the device was added with
+     * \param state set to the device's current state if the slot is still
+     *        occupied at the referenced generation
+     * \return true if the reference is current, false otherwise
+     */
+    bool load(SlotRef ref, DeviceState& state) const;
+
+    /**
+     * \brief Returns a consistent snapshot of a device's state.
+     *
+     * Safe to call from any thread without holding any lock.
+     *
+     * \param guid GUID of the device to query
+     * \param snapshot set to the device's current state if it is tracked
+     * \return true if the device is tracked, false otherwise
+     */
+    bool snapshot(GUID const& guid, DillDeviceSnapshot& snapshot) const;
+
+    /**
+     * \brief Returns a consistent snapshot of a device's state by slot.
+     *
+     * Safe to call from any thread without holding any lock.
+     *
+     * \param ref slot and generation the device was added with
+     * \param snapshot set to the device's current state if the slot is
+     *        still occupied at the referenced generation
+     * \return true if the reference is current, false otherwise
+     */
+    bool snapshot(SlotRef ref, DillDeviceSnapshot& snapshot) const;
+
+private:
+    struct Record
+    {
+        GUID                            guid;
+        //! Generation of the slot, 0 while the block is unused.
+        uint32_t                        generation;
+        //! Value of m_version when the record was last stored.
+        uint64_t                        version;
+        DeviceState                     state;
+    };
+
+    struct Block
+    {
+        // GUID of the device using this block split into two words, all
+        // zero while the block is unused. Lets readers skip other devices'
+        // blocks without a full Seqlock read.
+        std::atomic<uint64_t>           key[2] = {{0}, {0}};
+        Seqlock<Record>                 record;
+    };
+
+    static void split_key(GUID const& guid, uint64_t (&key)[2]);
+    static void to_snapshot(Record const& record, DillDeviceSnapshot& snapshot);
+
+    bool find_record(GUID const& guid, Record& record) const;
+    bool find_record(SlotRef ref, Record& record) const;
+
+    std::array<Block, k_max_devices>    m_blocks;
+    //! Last record stored in each block, only accessed by the writer. Lets
+    //! update() modify the state without reading it back from the Seqlock.
+    std::array<Record, k_max_devices>   m_written = {};
+    //! One past the highest slot ever used, bounds the reader scan.
+    std::atomic<size_t>                 m_block_count{0};
+    //! Number of records stored so far, only accessed by the writer.
+    uint64_t                            m_version = 0;
+};
@@ -0,0 +1,206 @@
+#include "device_store.h"
+
+#include <algorithm>
+
+#include "state_diff.h"
+
+
+namespace
+{
+    bool is_extended_axis(JoystickInputEventEx const& evt)
+    {
+        return evt.data.input_type == JoystickInputType::Axis &&
+            evt.data.input_index > k_summary_axes;
+    }
+}
+
+
+DeviceStore::DeviceStore(
+    std::mutex&                         mutex,
+    InputMetrics&                       metrics,
+    InputRecorder&                      recorder,
+    InputDispatcher&                    dispatcher
+)
+    :   m_mutex(mutex)
+      , m_metrics(metrics)
+      , m_recorder(recorder)
+      , m_dispatcher(dispatcher)
+      , m_extended_axes(true)
+{
+    m_info.fill(DeviceSummaryEx{});
+}
+
+uint32_t DeviceStore::add(DeviceSummaryEx const& info)
+{
+    const auto slot = m_slots.acquire(info.summary.device_guid);
+    if(slot == k_invalid_slot)
+    {
+        return k_invalid_slot;
+    }
+
+    m_info[slot] = info;
+    m_state.add(m_slots.ref(slot), info.summary.device_guid);
+    m_axis_filter[slot].reset();
+    m_subscription[slot].reset();
+    m_metrics.reset(slot);
+    m_recorder.device_added(info);
+    return slot;
+}
+
+uint32_t DeviceStore::remove(GUID const& guid, DeviceSummary& info)
+{
+    // Releasing the slot bumps its generation, which invalidates any
+    // reference still held to it.
+    const auto slot = m_slots.release(guid);
+    if(slot == k_invalid_slot)
+    {
+        return k_invalid_slot;
+    }
+
+    info = m_info[slot].summary;
+    m_info[slot] = DeviceSummaryEx{};
+    m_state.remove(slot);
+    m_recorder.device_removed(guid);
+    return slot;
+}
+
+void DeviceStore::clear()
+{
+    m_info.fill(DeviceSummaryEx{});
+    m_state.clear();
+    m_slots.clear();
+}
+
+DeviceSlotTable const& DeviceStore::slots() const
+{
+    return m_slots;
+}
+
+DeviceSummaryEx const& DeviceStore::info(uint32_t slot) const
+{
+    return m_info[slot];
+}
+
+DeviceStateTable const& DeviceStore::state() const
+{
+    return m_state;
+}
+
+bool DeviceStore::set_axis_filter(
+    uint32_t                            slot,
+    DWORD                               axis_index,
+    AxisFilterConfig const&             config
+)
+{
+    // Filter relative to the current value so the next event is judged
+    // against what the application last saw.
+    DeviceState state;
+    m_state.load(m_slots.ref(slot), state);
+    const LONG current = axis_index < state.axis.size()
+        ? state.axis[axis_index] : 0;
+    return m_axis_filter[slot].configure(axis_index, config, current);
+}
+
+bool DeviceStore::set_subscription(
+    uint32_t                            slot,
+    DWORD                               type_mask,
+    uint64_t const*                     index_bitset
+)
+{
+    return m_subscription[slot].set(type_mask, index_bitset);
+}
+
+void DeviceStore::set_extended_axes(bool delivered)
+{
+    m_extended_axes = delivered;
+}
+
+bool DeviceStore::start_recording(std::string const& path)
+{
+    if(!m_recorder.open(path))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<DeviceSummaryEx> devices;
+    for(auto slot : m_slots.active())
+    {
+        devices.push_back(m_info[slot]);
+    }
+    m_recorder.start(devices);
+    return true;
+}
+
+void DeviceStore::input_events(
+    GUID const&                         guid,
+    std::vector<JoystickInputEventEx> const& events
+)
+{
+    if(events.empty())
+    {
+        return;
+    }
+
+    uint32_t slot = k_invalid_slot;
+    std::vector<JoystickInputEventEx> const* delivered = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        slot = m_slots.find(guid);
+        if(slot == k_invalid_slot)
+        {
+            return;
+        }
+        m_state.update(slot, [&events](DeviceState& state) {
+            for(auto const& evt : events)
+            {
+                apply_input_event(state, evt.data);
+            }
+        });
+        delivered = &publish(slot, events);
+    }
+    deliver(slot, *delivered);
+}
+
+std::vector<JoystickInputEventEx> const& DeviceStore::publish(
+    uint32_t                            slot,
+    std::vector<JoystickInputEventEx> const& events
+)
+{
+    m_metrics.record_drain(slot, events.size());
+    m_recorder.input_events(events);
+
+    // Filtering only affects delivery, the state and the recording hold
+    // every change.
+    const bool drop_extended = !m_extended_axes &&
+        std::any_of(events.begin(), events.end(), is_extended_axis);
+    if(m_subscription[slot].all() && !m_axis_filter[slot].active() &&
+       !drop_extended)
+    {
+        return events;
+    }
+    m_filtered.assign(events.begin(), events.end());
+    if(drop_extended)
+    {
+        m_filtered.erase(
+            std::remove_if(
+                m_filtered.begin(),
+                m_filtered.end(),
+                is_extended_axis
+            ),
+            m_filtered.end()
+        );
+    }
+    m_subscription[slot].filter(m_filtered);
+    m_axis_filter[slot].filter(m_filtered);
+    return m_filtered;
+}
+
+void DeviceStore::deliver(
+    uint32_t                            slot,
+    std::vector<JoystickInputEventEx> const& events
+)
+{
+    m_metrics.add(slot, DeviceCounter::EventsEmitted, events.size());
+    m_dispatcher.dispatch(events);
+}
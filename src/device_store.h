@@ -0,0 +1,246 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "axis_filter.h"
+#include "device_slot_table.h"
+#include "device_state_table.h"
+#include "dill_types.h"
+#include "input_dispatcher.h"
+#include "input_metrics.h"
+#include "input_recorder.h"
+#include "input_subscription.h"
+
+
+/**
+ * \brief Tracks devices and carries their input from state to delivery.
+ *
+ * Holds the slot of every device together with its description, state,
+ * subscription and axis filter, and implements the steps every batch of
+ * input takes: the state is updated in a single publication, the batch is
+ * recorded unfiltered, counted and filtered, and what remains is handed
+ * to the InputDispatcher without holding any lock. Both DILL's DirectInput
+ * event loop and InputPipeline keep their devices in a DeviceStore.
+ *
+ * The lock is owned by the store's user, which guards its own per-device
+ * data with it as well. Methods documented as requiring the lock must be
+ * called while holding it, input_events and start_recording take it
+ * themselves. Devices are added and removed, and input_events called, by a
+ * single producer thread. The state table may be read from any thread.
+ */
+class DeviceStore
+{
+public:
+    /**
+     * \brief Creates an empty store.
+     *
+     * \param mutex lock guarding the store
+     * \param metrics per-device counters, reset for every added device
+     * \param recorder recorder receiving device changes and input
+     * \param dispatcher dispatcher delivering input to the client
+     */
+    DeviceStore(
+        std::mutex&                     mutex,
+        InputMetrics&                   metrics,
+        InputRecorder&                  recorder,
+        InputDispatcher&                dispatcher
+    );
+    DeviceStore(DeviceStore const&) = delete;
+    DeviceStore& operator=(DeviceStore const&) = delete;
+
+    /**
+     * \brief Assigns a slot to a newly connected device.
+     *
+     * Resets the device's state, filters and counters and records the
+     * connection. Requires the lock.
+     *
+     * \param info description of the device
+     * \return slot of the device, k_invalid_slot if all slots are in use
+     */
+    uint32_t add(DeviceSummaryEx const& info);
+
+    /**
+     * \brief Releases the slot of a disconnected device.
+     *
+     * Records the disconnection. Requires the lock.
+     *
+     * \param guid GUID of the device
+     * \param info set to the description of the device if it had a slot
+     * \return the released slot or k_invalid_slot if the device had none
+     */
+    uint32_t remove(GUID const& guid, DeviceSummary& info);
+
+    /**
+     * \brief Releases every slot without recording anything.
+     *
+     * Requires the lock.
+     */
+    void clear();
+
+    /**
+     * \brief Returns the slot assignment of the devices.
+     *
+     * Requires the lock.
+     *
+     * \return slot table of the store
+     */
+    DeviceSlotTable const& slots() const;
+
+    /**
+     * \brief Returns the description of the device in a slot.
+     *
+     * Requires the lock.
+     *
+     * \param slot slot of the device, must be in use
+     * \return extended description of the device
+     */
+    DeviceSummaryEx const& info(uint32_t slot) const;
+
+    /**
+     * \brief Returns the state of every device.
+     *
+     * Reading it does not require the lock.
+     *
+     * \return state table of the store
+     */
+    DeviceStateTable const& state() const;
+
+    /**
+     * \brief Suppresses axis events of a device caused by noise.
+     *
+     * The filter is relative to the axis' current value. Requires the lock.
+     *
+     * \param slot slot of the device, must be in use
+     * \param axis_index 1-based index of the axis to filter
+     * \param config thresholds in axis counts, all zeros remove the filter
+     * \return true if the filter was set, false if the arguments are out
+     *         of range
+     */
+    bool set_axis_filter(
+        uint32_t                        slot,
+        DWORD                           axis_index,
+        AxisFilterConfig const&         config
+    );
+
+    /**
+     * \brief Selects the inputs of a device whose events are delivered.
+     *
+     * Requires the lock.
+     *
+     * \param slot slot of the device, must be in use
+     * \param type_mask input types whose subscription is replaced
+     * \param index_bitset two words with bit N-1 selecting input N,
+     *        nullptr selects every input
+     * \return true if the subscription was set, false if the type mask is
+     *         invalid
+     */
+    bool set_subscription(
+        uint32_t                        slot,
+        DWORD                           type_mask,
+        uint64_t const*                 index_bitset
+    );
+
+    /**
+     * \brief Selects whether events of the axes with axis_index 9-32 are
+     *        delivered.
+     *
+     * Like filters this only affects delivery, such events always update
+     * the state and are recorded. Initially they are delivered. Requires
+     * the lock.
+     *
+     * \param delivered true to deliver the events of every axis, false to
+     *        only deliver those of axes 1-8
+     */
+    void set_extended_axes(bool delivered);
+
+    /**
+     * \brief Opens a recording and starts it with the current devices.
+     *
+     * Taking the lock orders the start with add and remove, so every
+     * device is recorded as connected exactly once.
+     *
+     * \param path path of the recording file to create
+     * \return true if recording started, false if the file could not be
+     *         created or a recording is already open
+     */
+    bool start_recording(std::string const& path);
+
+    /**
+     * \brief Applies a batch of input to a device's state and delivers it.
+     *
+     * Under the lock update is invoked with the device's state, which it
+     * brings up to date with the batch, filling events first if the batch
+     * is derived from the state. The events are then recorded, counted and
+     * filtered, and the remaining ones are dispatched after releasing the
+     * lock. Only called by the producer thread.
+     *
+     * \param slot slot of the device, must be in use
+     * \param events events of the batch, read once update returned
+     * \param update callable taking the device's DeviceState
+     */
+    template<typename Update>
+    void input_events(
+        uint32_t                        slot,
+        std::vector<JoystickInputEventEx> const& events,
+        Update const&                   update
+    );
+
+    /**
+     * \brief Applies a batch of decoded input events and delivers them.
+     *
+     * Events of a device without a slot are ignored. Only called by the
+     * producer thread.
+     *
+     * \param guid GUID of the device the events belong to
+     * \param events events of the batch, in the order they occurred
+     */
+    void input_events(
+        GUID const&                     guid,
+        std::vector<JoystickInputEventEx> const& events
+    );
+
+private:
+    std::vector<JoystickInputEventEx> const& publish(
+        uint32_t                        slot,
+        std::vector<JoystickInputEventEx> const& events
+    );
+    void deliver(
+        uint32_t                        slot,
+        std::vector<JoystickInputEventEx> const& events
+    );
+
+    std::mutex&                         m_mutex;
+    InputMetrics&                       m_metrics;
+    InputRecorder&                      m_recorder;
+    InputDispatcher&                    m_dispatcher;
+    DeviceSlotTable                     m_slots;
+    std::array<DeviceSummaryEx, k_max_devices> m_info;
+    DeviceStateTable                    m_state;
+    std::array<AxisFilter, k_max_devices> m_axis_filter;
+    std::array<InputSubscription, k_max_devices> m_subscription;
+    //! Whether events of the axes with axis_index 9-32 are delivered.
+    bool                                m_extended_axes;
+    //! Events left after filtering, only used by the producer thread.
+    std::vector<JoystickInputEventEx>   m_filtered;
+};
+
+
+template<typename Update>
+void DeviceStore::input_events(
+    uint32_t                            slot,
+    std::vector<JoystickInputEventEx> const& events,
+    Update const&                       update
+)
+{
+    std::vector<JoystickInputEventEx> const* delivered = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_state.update(slot, update);
+        delivered = &publish(slot, events);
+    }
+    deliver(slot, *delivered);
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -13,6 +14,14 @@
 #include <objbase.h>
 
 #include "axis_mapping.h"
+#include "device_slot_table.h"
+#include "device_store.h"
+#include "event_timing.h"
+#include "input_dispatcher.h"
+#include "offset_decoder.h"
+#include "poll_scheduler.h"
+#include "state_diff.h"
+#include "trace_ring.h"
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/sinks/rotating_file_sink.h"
@@ -40,13 +49,83 @@ LPDIRECTINPUT8 g_direct_input = nullptr;
 // Size of the device object read buffer.
 static const int g_buffer_size = 64;
 
-// Storage for device data, access guarded by g_data_store_mutex.
+/**
+ * \brief Holds the DirectInput specific information about devices.
+ *
+ * Every array is indexed by the slot the DeviceStore assigns to a device,
+ * which also holds the device's description, state and filters, so one
+ * GUID lookup resolves all of a device's data.
+ */
+struct DeviceDataStore
+{
+    //! DirectInput device instance.
+    std::array<LPDIRECTINPUTDEVICE8, k_max_devices> device;
+    //! Indicates if a device requires buffered treatment.
+    std::array<bool, k_max_devices> is_buffered;
+    //! Flag indicating if a device is fully operational.
+    std::array<bool, k_max_devices> is_ready;
+    //! Device notification event used with SetEventNotification.
+    std::array<HANDLE, k_max_devices> event_handle;
+    //! Shortest interval between two polls of a polled device.
+    std::array<std::chrono::microseconds, k_max_devices> min_poll_interval;
+    //! Last report of a polled device, only accessed by the event loop
+    //! thread and thus not guarded by the lock.
+    std::array<ReportFilter, k_max_devices> last_report;
+};
+
+// DirectInput specific device data, access guarded by g_data_store_mutex.
 static DeviceDataStore g_data_store;
 static std::mutex g_data_store_mutex;
 
-// Callback handles, provided by client code and called from the event thread.
-std::atomic<JoystickInputEventCallback> g_event_callback{nullptr};
-std::atomic<DeviceChangeCallback> g_device_change_callback{nullptr};
+// Whether the events of axes with axis_index 9-32 are delivered, only
+// changed while not running and handed to g_store by init(). Their values
+// are always tracked.
+static std::atomic<bool> g_extended_axes{false};
+
+// Callbacks, the optional pull-mode event ring and dispatch thread, the
+// ring and thread are only (re)configured while not running.
+static InputDispatcher g_dispatcher;
+
+// Counters of the event loop and every device, only modified by the loop.
+static InputMetrics g_metrics;
+
+// Records device changes and input events while a recording is running.
+static InputRecorder g_recorder;
+
+// Slots, descriptions, state and filters of the devices, guarded by
+// g_data_store_mutex together with g_data_store.
+static DeviceStore g_store(
+    g_data_store_mutex,
+    g_metrics,
+    g_recorder,
+    g_dispatcher
+);
+
+// Latencies of the event loop's stages, only recorded into by the loop.
+// Callback latencies are tracked by the dispatcher.
+static LatencyHistogram g_report_latency;
+static LatencyHistogram g_decode_latency;
+static LatencyHistogram g_state_latency;
+static std::atomic<bool> g_latency_logging{false};
+
+// Client hook forwarded to by on_callback_stall().
+static std::atomic<CallbackStallHook> g_stall_hook{nullptr};
+
+#if defined(DILL_ENABLE_TRACE)
+// Number of spans retained by g_trace, about 3.5MB.
+static const size_t k_trace_capacity = 65536;
+// Most recent spans of the event loop and callbacks.
+static TraceRing g_trace(k_trace_capacity);
+#endif
+// Path the trace is written to on shutdown, empty if none.
+static std::string g_shutdown_trace_path;
+static std::mutex g_shutdown_trace_mutex;
+
+// Events decoded during the current drain or polling tick. Only touched by
+// the event loop thread and reused to avoid per-wakeup allocations.
+static std::vector<JoystickInputEventEx> g_input_events;
+// Changes found in the current polled report, before timestamping.
+static std::vector<JoystickInputData> g_polled_changes;
 
 // Handle for window and device notification messages.
 static HWND g_hwnd = nullptr;
@@ -90,31 +169,32 @@ namespace
     struct AxisEnumContext
     {
         LPDIRECTINPUTDEVICE8        device;
-        DWORD                       slider_count;
         std::vector<AxisOffset>     detected_offsets;
     };
 
-    // Lookup table for axis GUID to axis_index.
-    const std::unordered_map<GUID, DWORD> g_axis_guid_lookup =
+    // Current time of the clock driving the PollScheduler.
+    std::chrono::microseconds poll_clock_now()
     {
-        {GUID_XAxis,  1},
-        {GUID_YAxis,  2},
-        {GUID_ZAxis,  3},
-        {GUID_RxAxis, 4},
-        {GUID_RyAxis, 5},
-        {GUID_RzAxis, 6},
-    };
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        );
+    }
 
-    // Resolves axis_index to its DIJOYSTATE2 offset, logging and returning
-    // false if axis_index does not name a known axis.
-    bool try_get_axis_offset(DWORD axis_index, AxisOffset& out_offset)
+    // Copies as much of info as the client's struct, whose size it set in
+    // struct_size, has room for.
+    bool copy_summary_ex(DeviceSummaryEx const& info, DeviceSummaryEx* out)
     {
-        out_offset = offset_for_axis_index(axis_index);
-        if(out_offset == static_cast<AxisOffset>(-1))
+        if(out == nullptr || out->struct_size < 2 * sizeof(uint32_t))
         {
-            logger->error("No DIJOYSTATE2 offset for axis_index {}", axis_index);
+            logger->error("No valid DeviceSummaryEx provided");
             return false;
         }
+        const auto size = std::min<uint32_t>(
+            out->struct_size,
+            sizeof(DeviceSummaryEx)
+        );
+        memcpy(out, &info, size);
+        out->struct_size = size;
         return true;
     }
 
@@ -161,6 +241,23 @@ namespace
         }
     };
 
+    // Stops the dispatcher's thread and watchdog unless dismiss() is called
+    // first. Used by init() so that a failure after g_dispatcher.start(),
+    // including std::thread's constructor throwing, leaves no thread
+    // running that the next init() would start again.
+    struct DispatcherGuard
+    {
+        bool dismissed = false;
+        void dismiss() { dismissed = true; }
+        ~DispatcherGuard()
+        {
+            if(!dismissed)
+            {
+                g_dispatcher.stop();
+            }
+        }
+    };
+
     // Explicitly brackets COM apartment lifetime on the event loop thread.
     // DirectInput8Create/EnumDevices use COM interfaces; without an explicit
     // CoInitializeEx/CoUninitialize pair, a fresh apartment gets implicitly
@@ -183,13 +280,6 @@ namespace
 }
 
 
-DeviceState::DeviceState()
-    :   axis(9, 0)
-      , button(129, false)
-      , hat(5, -1)
-{}
-
-
 std::string error_to_string(DWORD error_code)
 {
     static const std::unordered_map<DWORD, std::string> lut{
@@ -306,82 +396,58 @@ LRESULT window_proc(
     return 0;
 }
 
-void emit_joystick_input_event(DIDEVICEOBJECTDATA const& data, GUID const& guid)
+bool decode_joystick_input_event(
+    DIDEVICEOBJECTDATA const&           data,
+    GUID const&                         guid,
+    JoystickInputData&                  evt
+)
 {
-    JoystickInputData evt;
     evt.device_guid = guid;
 
-    static std::unordered_map<DWORD, int> hat_id_lookup =
-    {
-        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[0]), 1},
-        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[1]), 2},
-        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[2]), 3},
-        {FIELD_OFFSET(DIJOYSTATE2, rgdwPOV[3]), 4}
-    };
-
-    // Figure out the event's input type based on the DIJOYSTATE2 data
-    // structure's offset.
-    if(data.dwOfs < FIELD_OFFSET(DIJOYSTATE2, rgdwPOV))
-    {
-        const DWORD axis_index = axis_index_for_offset(data.dwOfs);
-        if(axis_index == 0 || axis_index > 8)
-        {
-            logger->error(
-                "{}: Received axis event for unrecognized offset {}",
-                guid_to_string(guid),
-                data.dwOfs
-            );
-            return;
-        }
-
-        evt.input_type = JoystickInputType::Axis;
-        evt.input_index = static_cast<UINT8>(axis_index);
-        evt.value = data.dwData;
-        {
-            std::lock_guard<std::mutex> lock(g_data_store_mutex);
-            g_data_store.state[guid].axis[evt.input_index] = evt.value;
-        }
-    }
-    else if(data.dwOfs < FIELD_OFFSET(DIJOYSTATE2, rgbButtons))
-    {
-        evt.input_type = JoystickInputType::Hat;
-        evt.input_index = hat_id_lookup[data.dwOfs];
-        evt.value = data.dwData;
-        {
-            std::lock_guard<std::mutex> lock(g_data_store_mutex);
-            g_data_store.state[guid].hat[evt.input_index] = evt.value;
-        }
-    }
-    else if(data.dwOfs < FIELD_OFFSET(DIJOYSTATE2, lVX))
-    {
-        evt.input_type = JoystickInputType::Button;
-        evt.input_index = static_cast<UINT8>(
-            data.dwOfs - FIELD_OFFSET(DIJOYSTATE2, rgbButtons) + 1
-        );
-        evt.value = (data.dwData & 0x0080) == 0 ? 0 : 1;
-        {
-            std::lock_guard<std::mutex> lock(g_data_store_mutex);
-            g_data_store.state[guid].button[evt.input_index] =
-                evt.value == 0 ? false : true;
-        }
-    }
-    else
-    {
-        logger->warn(
-            "{}: Unexpected type of input event occurred",
-            guid_to_string(guid)
-        );
+    // Single table load resolving the input type and index from the
+    // event's DIJOYSTATE2 offset.
+    const auto decoded = decode_offset(data.dwOfs);
+    switch(decoded.input_type)
+    {
+        case JoystickInputType::Axis:
+        case JoystickInputType::Hat:
+            evt.value = data.dwData;
+            break;
+        case JoystickInputType::Button:
+            evt.value = (data.dwData & 0x0080) == 0 ? 0 : 1;
+            break;
+        default:
+            if(data.dwOfs < FIELD_OFFSET(DIJOYSTATE2, rgdwPOV))
+            {
+                logger->error(
+                    "{}: Received axis event for unrecognized offset {}",
+                    guid_to_string(guid),
+                    data.dwOfs
+                );
+            }
+            else
+            {
+                logger->warn(
+                    "{}: Unexpected type of input event occurred",
+                    guid_to_string(guid)
+                );
+            }
+            return false;
     }
+    evt.input_type = decoded.input_type;
+    evt.input_index = decoded.input_index;
 
-    auto callback = g_event_callback.load();
-    if(callback != nullptr)
-    {
-        callback(evt);
-    }
+    return true;
 }
 
-void process_buffered_events(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
+void process_buffered_events(
+    LPDIRECTINPUTDEVICE8                instance,
+    GUID const&                         guid,
+    uint32_t                            slot
+)
 {
+    DILL_TRACE_SCOPE(&g_trace, ProcessBufferedEvents, guid);
+
     // Poll device to get things going.
     auto result = instance->Poll();
     if(FAILED(result))
@@ -392,10 +458,17 @@ void process_buffered_events(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
             error_to_string(result)
         );
 
+        g_metrics.add(slot, DeviceCounter::PollFailures);
+        g_metrics.add(slot, DeviceCounter::ReacquireAttempts);
         instance->Acquire();
         instance->Poll();
     }
 
+    // Decode the entire drain first, so that the device state is updated
+    // under a single lock acquisition and the client receives one batch
+    // per wakeup.
+    g_input_events.clear();
+
     // Retrieve buffered data.
     DIDEVICEOBJECTDATA device_data[g_buffer_size];
     DWORD object_count = g_buffer_size;
@@ -407,17 +480,32 @@ void process_buffered_events(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
             &object_count,
             0
         );
+        const uint64_t receive_time = monotonic_time_ns();
         if(SUCCEEDED(result))
         {
-            if(object_count > 0)
+            // Report timestamps use the GetTickCount clock, unsigned
+            // arithmetic handles its wraparound.
+            const DWORD receive_tick = GetTickCount();
+            for(size_t i=0; i<object_count; ++i)
             {
-                for(size_t i=0; i<object_count; ++i)
+                g_report_latency.record(
+                    uint64_t(receive_tick - device_data[i].dwTimeStamp) *
+                    1000000
+                );
+                JoystickInputData evt;
+                if(decode_joystick_input_event(device_data[i], guid, evt))
                 {
-                    emit_joystick_input_event(device_data[i], guid);
+                    g_input_events.push_back(make_input_event_ex(
+                        evt,
+                        device_data[i].dwTimeStamp,
+                        device_data[i].dwSequence,
+                        receive_time
+                    ));
                 }
             }
             if(result == DI_BUFFEROVERFLOW)
             {
+                g_metrics.add(slot, DeviceCounter::BufferOverflows);
                 logger->error(
                     "{}: {}",
                     guid_to_string(guid),
@@ -433,11 +521,13 @@ void process_buffered_events(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
                 error_to_string(result)
             );
             object_count = 0;
+            g_metrics.add(slot, DeviceCounter::PollFailures);
 
             // If this failure arose due to buffered reading not being possible
             // revert the device to polled mode.
             if(result == DIERR_NOTBUFFERED)
             {
+                g_metrics.add(slot, DeviceCounter::NotBufferedDemotions);
                 logger->error(
                     "{} Failed reading device in buffered mode, falling back "
                     "to polling, {}",
@@ -450,13 +540,9 @@ void process_buffered_events(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
                 HANDLE old_event = nullptr;
                 {
                     std::lock_guard<std::mutex> lock(g_data_store_mutex);
-                    g_data_store.is_buffered[guid] = false;
-                    const auto it = g_data_store.event_handles.find(guid);
-                    if(it != g_data_store.event_handles.end())
-                    {
-                        old_event = it->second;
-                        g_data_store.event_handles.erase(it);
-                    }
+                    g_data_store.is_buffered[slot] = false;
+                    old_event = g_data_store.event_handle[slot];
+                    g_data_store.event_handle[slot] = nullptr;
                 }
                 // Resetthe handle and force a refresh of all handles.
                 if(old_event != nullptr)
@@ -468,10 +554,31 @@ void process_buffered_events(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
             }
         }
     }
+
+    if(g_input_events.empty())
+    {
+        return;
+    }
+    const uint64_t origin = g_input_events.front().receive_time_ns;
+    g_decode_latency.record(monotonic_time_ns() - origin);
+
+    g_store.input_events(slot, g_input_events, [origin](DeviceState& state) {
+        for(auto const& evt : g_input_events)
+        {
+            apply_input_event(state, evt.data);
+        }
+        g_state_latency.record(monotonic_time_ns() - origin);
+    });
 }
 
-void poll_device(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
+bool poll_device(
+    LPDIRECTINPUTDEVICE8                instance,
+    GUID const&                         guid,
+    uint32_t                            slot
+)
 {
+    DILL_TRACE_SCOPE(&g_trace, PollDevice, guid);
+
     // Poll device to update internal state.
     auto result = instance->Poll();
     if(FAILED(result))
@@ -482,6 +589,8 @@ void poll_device(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
             error_to_string(result)
         );
 
+        g_metrics.add(slot, DeviceCounter::PollFailures);
+        g_metrics.add(slot, DeviceCounter::ReacquireAttempts);
         instance->Acquire();
         instance->Poll();
     }
@@ -496,126 +605,64 @@ void poll_device(LPDIRECTINPUTDEVICE8 instance, GUID const& guid)
             guid_to_string(guid),
             error_to_string(result)
         );
-        return;
+        g_metrics.add(slot, DeviceCounter::PollFailures);
+        return false;
     }
+    const uint64_t receive_time = monotonic_time_ns();
 
-    // Gather changed values while acquiring the lock once, then emit callbacks
-    // afterward without the lock.
-    auto callback = g_event_callback.load();
-    std::vector<JoystickInputData> change_events;
-
+    // Idle devices keep returning the same report, skip those without
+    // taking the lock.
+    if(!g_data_store.last_report[slot].changed(state))
     {
-        std::lock_guard<std::mutex> lock(g_data_store_mutex);
-
-        // Detect axis state changes.
-        for(size_t i=0; i<g_data_store.cache[guid].axis_count; ++i)
-        {
-            auto axis_index = g_data_store.cache[guid].axis_map[i].axis_index;
-            AxisOffset offset;
-            if(!try_get_axis_offset(axis_index, offset))
-            {
-                continue;
-            }
-            LONG value = *reinterpret_cast<LONG const*>(
-                reinterpret_cast<char const*>(&state) + offset
-            );
-
-            if(g_data_store.state[guid].axis[axis_index] != value)
-            {
-                g_data_store.state[guid].axis[axis_index] = value;
-
-                JoystickInputData evt;
-                evt.device_guid = guid;
-                evt.input_type = JoystickInputType::Axis;
-                evt.input_index = static_cast<UINT8>(axis_index);
-                evt.value = value;
-                change_events.push_back(evt);
-            }
-        }
-
-        // Detect button state changes.
-        for(size_t i=0; i<g_data_store.cache[guid].button_count; ++i)
-        {
-            auto is_pressed = (state.rgbButtons[i] & 0x0080) == 0 ? false : true;
-            if(g_data_store.state[guid].button[i+1] != is_pressed)
-            {
-                g_data_store.state[guid].button[i+1] = is_pressed;
-
-                JoystickInputData evt;
-                evt.device_guid = guid;
-                evt.input_type = JoystickInputType::Button;
-                evt.input_index = static_cast<UINT8>(i + 1);
-                evt.value = is_pressed;
-                change_events.push_back(evt);
-            }
-        }
-
-        // Detect hat state changes.
-        for(size_t i=0; i<g_data_store.cache[guid].hat_count; ++i)
-        {
-            LONG direction = state.rgdwPOV[i];
-            if(direction < 0 || direction > 36000)
-            {
-                direction = -1;
-            }
-            if(g_data_store.state[guid].hat[i+1] != direction)
-            {
-                g_data_store.state[guid].hat[i+1] = direction;
-
-                JoystickInputData evt;
-                evt.device_guid = guid;
-                evt.input_type = JoystickInputType::Hat;
-                evt.input_index = static_cast<UINT8>(i+1);
-                evt.value = direction;
-                change_events.push_back(evt);
-            }
-        }
+        return false;
     }
 
-    // Emit events via the callback in quick succession without the lock.
-    if(callback != nullptr)
-    {
-        for(auto const& evt : change_events)
-        {
-            callback(evt);
-        }
-    }
+    // Gather changed values while acquiring the lock once, the store emits
+    // callbacks afterward without the lock.
+    g_polled_changes.clear();
+    g_input_events.clear();
+
+    g_store.input_events(slot, g_input_events, [&](DeviceState& current) {
+        diff_joystate(state, g_store.info(slot), current, g_polled_changes);
+        // Polled reports are decoded while updating the state, both
+        // stages complete at the same time.
+        const uint64_t state_latency = monotonic_time_ns() - receive_time;
+        g_decode_latency.record(state_latency);
+        g_state_latency.record(state_latency);
+        append_polled_events(g_polled_changes, receive_time, g_input_events);
+    });
+    return true;
 }
 
 void rebuild_wait_handles(
     std::array<HANDLE, k_max_wait_handles>& handles,
     DWORD&                              handle_count,
-    std::vector<GUID>&                  handle_guids,
-    bool&                               periodic_service_needed
+    std::vector<SlotRef>&               handle_slots,
+    PollScheduler&                      poll_scheduler
 )
 {
-    // Create a copy of the mapping between GUID and HANDLE for each buffered
-    // device before processing this without a lock.
-    std::vector<std::pair<GUID, HANDLE>> buffered_snapshot;
-    bool any_polled = false;
+    DILL_TRACE_SCOPE(&g_trace, RebuildWaitHandles, GUID{});
+    g_metrics.add(LoopCounter::WaitHandleRebuilds);
+    std::lock_guard<std::mutex> lock(g_data_store_mutex);
+
+    std::vector<PolledDevice> polled_devices;
+    handle_slots.clear();
+    handle_count = k_control_handle_count;
+    for(auto slot : g_store.slots().active())
     {
-        std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        for(auto const& [guid, buffered] : g_data_store.is_buffered)
+        if(!g_data_store.is_buffered[slot])
         {
-            if(buffered)
-            {
-                const auto it = g_data_store.event_handles.find(guid);
-                if(it != g_data_store.event_handles.end())
-                {
-                    buffered_snapshot.emplace_back(guid, it->second);
-                }
-            }
-            else
-            {
-                any_polled = true;
-            }
+            polled_devices.push_back({
+                g_store.slots().ref(slot),
+                g_data_store.min_poll_interval[slot]
+            });
+            continue;
+        }
+        if(g_data_store.event_handle[slot] == nullptr)
+        {
+            continue;
         }
-    }
 
-    handle_guids.clear();
-    handle_count = k_control_handle_count;
-    for(auto const& [guid, event] : buffered_snapshot)
-    {
         // If more devices are connected than we support, log an error message
         // and ignore it.
         if(handle_count >= k_max_wait_handles)
@@ -623,16 +670,67 @@ void rebuild_wait_handles(
             logger->error(
                 "{}: more buffered devices than the {} supported wait "
                 "slots; this device will be ignored.",
-                guid_to_string(guid),
+                guid_to_string(g_store.slots().guid(slot)),
                 k_max_wait_handles - k_control_handle_count
             );
             continue;
         }
-        handles[handle_count] = event;
-        handle_guids.push_back(guid);
+        handles[handle_count] = g_data_store.event_handle[slot];
+        handle_slots.push_back(g_store.slots().ref(slot));
         ++handle_count;
     }
-    periodic_service_needed = any_polled;
+    poll_scheduler.sync(polled_devices, poll_clock_now());
+}
+
+void poll_due_devices(PollScheduler& poll_scheduler)
+{
+    if(poll_scheduler.empty())
+    {
+        return;
+    }
+
+    // Reused across wakeups, which can happen every 1ms, so that steady
+    // state polling doesn't reallocate on every iteration.
+    struct PollTarget
+    {
+        SlotRef                         ref;
+        GUID                            guid;
+        LPDIRECTINPUTDEVICE8            device;
+    };
+    static std::vector<SlotRef> due;
+    static std::vector<PollTarget> to_poll;
+
+    poll_scheduler.due(poll_clock_now(), due);
+    if(due.empty())
+    {
+        return;
+    }
+
+    to_poll.clear();
+    {
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        for(auto const& ref : due)
+        {
+            if(g_store.slots().is_current(ref) &&
+               g_data_store.is_ready[ref.slot])
+            {
+                to_poll.push_back({
+                    ref,
+                    g_store.slots().guid(ref.slot),
+                    g_data_store.device[ref.slot]
+                });
+            }
+        }
+    }
+    for(auto const& target : to_poll)
+    {
+        const bool changed = poll_device(
+            target.device,
+            target.guid,
+            target.ref.slot
+        );
+        poll_scheduler.record(target.ref, changed, poll_clock_now());
+    }
 }
 
 void event_loop_main()
@@ -661,28 +759,37 @@ void event_loop_main()
         SetEvent(g_startup_done_event);
 
         std::array<HANDLE, k_max_wait_handles> handles;
-        std::vector<GUID> handle_guids;
+        std::vector<SlotRef> handle_slots;
         DWORD handle_count = k_control_handle_count;
-        bool periodic_needed = false;
+        PollScheduler poll_scheduler;
         handles[0] = g_quit_event;
         handles[1] = g_rebuild_event;
         handles[2] = g_hotplug_event;
-        rebuild_wait_handles(handles, handle_count, handle_guids, periodic_needed);
-
-        // Reused across WAIT_TIMEOUT ticks (which can fire every 1ms) so
-        // steady-state polling doesn't reallocate on every iteration.
-        std::vector<std::pair<GUID, LPDIRECTINPUTDEVICE8>> to_poll;
+        rebuild_wait_handles(handles, handle_count, handle_slots, poll_scheduler);
 
         for(;;)
         {
-            DWORD timeout = periodic_needed ? 1 : INFINITE;
-            DWORD wait_result = MsgWaitForMultipleObjectsEx(
-                handle_count,
-                handles.data(),
-                timeout,
-                QS_ALLINPUT,
-                MWMO_INPUTAVAILABLE
-            );
+            // Sleep until the next polled-fallback device is due, rounded up
+            // to the millisecond resolution of the wait.
+            DWORD timeout = INFINITE;
+            if(!poll_scheduler.empty())
+            {
+                const auto wait = poll_scheduler.time_until_next(
+                    poll_clock_now()
+                );
+                timeout = static_cast<DWORD>((wait.count() + 999) / 1000);
+            }
+            DWORD wait_result;
+            {
+                DILL_TRACE_SCOPE(&g_trace, Wait, GUID{});
+                wait_result = MsgWaitForMultipleObjectsEx(
+                    handle_count,
+                    handles.data(),
+                    timeout,
+                    QS_ALLINPUT,
+                    MWMO_INPUTAVAILABLE
+                );
+            }
 
             // Quit requested.
             if(wait_result == WAIT_OBJECT_0)
@@ -692,12 +799,13 @@ void event_loop_main()
             // Rebuild the wait array, typically due to device hotplug.
             else if(wait_result == WAIT_OBJECT_0 + 1)
             {
+                g_metrics.add(LoopCounter::RebuildWakeups);
                 ResetEvent(g_rebuild_event);
                 rebuild_wait_handles(
                     handles,
                     handle_count,
-                    handle_guids,
-                    periodic_needed
+                    handle_slots,
+                    poll_scheduler
                 );
             }
             // Hotplug notification deferred by on_device_change().
@@ -705,6 +813,7 @@ void event_loop_main()
             {
                 // Run the blocking enumeration of devices here in the main
                 // event loop.
+                g_metrics.add(LoopCounter::HotplugWakeups);
                 ResetEvent(g_hotplug_event);
                 enumerate_devices();
 
@@ -713,8 +822,8 @@ void event_loop_main()
                 rebuild_wait_handles(
                     handles,
                     handle_count,
-                    handle_guids,
-                    periodic_needed
+                    handle_slots,
+                    poll_scheduler
                 );
             }
             else if(
@@ -723,25 +832,30 @@ void event_loop_main()
             )
             {
                 // A single buffered device signaled.
-                size_t slot = wait_result - WAIT_OBJECT_0;
-                GUID guid = handle_guids[slot - k_control_handle_count];
+                g_metrics.add(LoopCounter::DeviceWakeups);
+                size_t index = wait_result - WAIT_OBJECT_0;
+                auto const& ref = handle_slots[index - k_control_handle_count];
+                GUID guid{};
                 LPDIRECTINPUTDEVICE8 device = nullptr;
                 {
+                    // The slot may have been released or reused since the
+                    // wait array was built, only use it if it is current.
                     std::lock_guard<std::mutex> lock(g_data_store_mutex);
-                    const auto it = g_data_store.device_map.find(guid);
-                    if(it != g_data_store.device_map.end())
+                    if(g_store.slots().is_current(ref))
                     {
-                        device = it->second;
+                        guid = g_store.slots().guid(ref.slot);
+                        device = g_data_store.device[ref.slot];
                     }
                 }
                 if(device != nullptr)
                 {
-                    process_buffered_events(device, guid);
+                    process_buffered_events(device, guid, ref.slot);
                 }
             }
             else if(wait_result == WAIT_OBJECT_0 + handle_count)
             {
                 // Window message queue has input, e.g. WM_DEVICECHANGE.
+                g_metrics.add(LoopCounter::MessageWakeups);
                 MSG msg;
                 while(PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
                 {
@@ -751,26 +865,8 @@ void event_loop_main()
             }
             else if(wait_result == WAIT_TIMEOUT)
             {
-                // Process polled-fallback devices.
-                to_poll.clear();
-                {
-                    std::lock_guard<std::mutex> lock(g_data_store_mutex);
-                    for(auto& [guid, device] : g_data_store.device_map)
-                    {
-                        if(!g_data_store.is_ready[guid])
-                        {
-                            continue;
-                        }
-                        if(!g_data_store.is_buffered[guid])
-                        {
-                            to_poll.emplace_back(guid, device);
-                        }
-                    }
-                }
-                for(auto& [guid, device] : to_poll)
-                {
-                    poll_device(device, guid);
-                }
+                // A polled-fallback device is due, serviced below.
+                g_metrics.add(LoopCounter::PollWakeups);
             }
             else
             {
@@ -780,6 +876,10 @@ void event_loop_main()
                 );
                 break;
             }
+
+            // Polled-fallback devices are serviced after every wakeup, as
+            // busy buffered devices may keep the wait from timing out.
+            poll_due_devices(poll_scheduler);
         }
     }
     catch(std::exception const& e)
@@ -841,37 +941,19 @@ BOOL CALLBACK enumerate_axis_objects(
 {
     AxisEnumContext* ctx = reinterpret_cast<AxisEnumContext*>(pvRef);
 
-    if(lpddoi->guidType == GUID_Slider)
+    // With the c_dfDIJoystick2 data format set the object's offset names
+    // the axis, which also tells the velocity, acceleration and force
+    // variants of an axis apart, as they share its guidType.
+    if(decode_offset(lpddoi->dwOfs).input_type == JoystickInputType::Axis)
     {
-        // There should only ever be two sliders, any more will be logged and
-        // ignored.
-        if (ctx->slider_count < 2)
-        {
-            AxisOffset offset;
-            if(try_get_axis_offset(7 + ctx->slider_count, offset))
-            {
-                ctx->detected_offsets.push_back(offset);
-            }
-            ++ctx->slider_count;
-        }
-        else
-        {
-            logger->warn(
-                "More than two sliders detected, ignoring additional ones.")
-            ;
-        }
+        ctx->detected_offsets.push_back(lpddoi->dwOfs);
     }
     else
     {
-        const auto it = g_axis_guid_lookup.find(lpddoi->guidType);
-        if(it != g_axis_guid_lookup.end())
-        {
-            AxisOffset offset;
-            if(try_get_axis_offset(it->second, offset))
-            {
-                ctx->detected_offsets.push_back(offset);
-            }
-        }
+        logger->warn(
+            "Ignoring axis object at unrecognized offset {}",
+            lpddoi->dwOfs
+        );
     }
 
     DIPROPRANGE range;
@@ -897,12 +979,6 @@ BOOL CALLBACK enumerate_axis_objects(
 
 void initialize_device(GUID guid, std::string name)
 {
-    // Prevent any operations on this device until initialization is done.
-    {
-        std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        g_data_store.is_ready[guid] = false;
-    }
-
     // Create joystick device.
     LPDIRECTINPUTDEVICE8 device = nullptr;
     auto result = g_direct_input->CreateDevice(
@@ -1024,8 +1100,12 @@ void initialize_device(GUID guid, std::string name)
         );
     }
 
-    // Create device summary report.
-    DeviceSummary info;
+    // Create device summary report, info is the compatibility view of the
+    // extended summary.
+    DeviceSummaryEx info_ex = {};
+    info_ex.struct_size = sizeof(DeviceSummaryEx);
+    info_ex.version = k_device_summary_ex_version;
+    DeviceSummary& info = info_ex.summary;
     info.device_guid = guid;
     info.vendor_id = get_vendor_id(device, guid);
     info.product_id = get_product_id(device, guid);
@@ -1036,27 +1116,32 @@ void initialize_device(GUID guid, std::string name)
     // in the same pass.
     AxisEnumContext axis_ctx;
     axis_ctx.device = device;
-    axis_ctx.slider_count = 0;
     device->EnumObjects(enumerate_axis_objects, &axis_ctx, DIDFT_AXIS);
 
     build_axis_map(axis_ctx.detected_offsets, info.axis_count, info.axis_map);
+    build_axis_map(
+        axis_ctx.detected_offsets,
+        info_ex.axis_count,
+        info_ex.axis_map
+    );
 
-    if(capabilities.dwAxes > 8)
+    if(capabilities.dwAxes > k_max_axes)
     {
         logger->error(
-            "{} {}: Reports more than 8 axes, {}",
+            "{} {}: Reports more than {} axes, {}",
             info.name,
             guid_to_string(info.device_guid),
+            k_max_axes,
             capabilities.dwAxes
         );
     }
-    if(info.axis_count != capabilities.dwAxes)
+    if(info_ex.axis_count != capabilities.dwAxes)
     {
         logger->warn(
             "{} {}: Axis count mismatch, enumerated={} capabilities={}",
             info.name,
             guid_to_string(info.device_guid),
-            info.axis_count,
+            info_ex.axis_count,
             capabilities.dwAxes
         );
     }
@@ -1068,55 +1153,65 @@ void initialize_device(GUID guid, std::string name)
     logger->info("Device summary: {} {}", info.name,guid_to_string(guid));
     logger->info(
         "Axis={} Buttons={} Hats={}",
-        info.axis_count,
+        info_ex.axis_count,
         info.button_count,
         info.hat_count
     );
     logger->info("Axis map");
-    for(auto const& entry : info.axis_map)
+    for(DWORD i=0; i<info_ex.axis_count; ++i)
     {
-        logger->info("  linear={} id={}", entry.linear_index, entry.axis_index);
+        logger->info(
+            "  linear={} id={}",
+            info_ex.axis_map[i].linear_index,
+            info_ex.axis_map[i].axis_index
+        );
     }
 
 
     // Write everything gathered above into the data store in one section.
+    // The device is not ready until the connection has been announced, which
+    // prevents any operations on it until initialization is done.
+    uint32_t slot = k_invalid_slot;
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        g_data_store.device_map[guid] = device;
-        g_data_store.is_buffered[guid] = buffered;
-        if(new_event != nullptr)
+        slot = g_store.add(info_ex);
+        if(slot != k_invalid_slot)
         {
-            g_data_store.event_handles[guid] = new_event;
+            g_data_store.device[slot] = device;
+            g_data_store.is_buffered[slot] = buffered;
+            g_data_store.event_handle[slot] = new_event;
+            g_data_store.is_ready[slot] = false;
+            g_data_store.last_report[slot].reset();
+            g_data_store.min_poll_interval[slot] = std::chrono::microseconds(0);
         }
-
-        if(
-            std::find(
-                g_data_store.active_guids.begin(),
-                g_data_store.active_guids.end(),
-                guid
-            ) == g_data_store.active_guids.end()
-        )
+    }
+    if(slot == k_invalid_slot)
+    {
+        logger->error(
+            "{}: More than {} devices connected, this device will be ignored",
+            guid_to_string(guid),
+            k_max_devices
+        );
+        device->SetEventNotification(nullptr);
+        device->Unacquire();
+        device->Release();
+        if(new_event != nullptr)
         {
-            g_data_store.active_guids.push_back(guid);
+            CloseHandle(new_event);
         }
-
-        g_data_store.cache[guid] = info;
+        return;
     }
 
     if(new_event != nullptr)
     {
         SetEvent(g_rebuild_event);
     }
-    auto device_change_callback = g_device_change_callback.load();
-    if(device_change_callback != nullptr)
-    {
-        device_change_callback(info, DeviceActionType::Connected);
-    }
+    g_dispatcher.device_changed(info, DeviceActionType::Connected);
 
     // Allow operating on the device.
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        g_data_store.is_ready[guid] = true;
+        g_data_store.is_ready[slot] = true;
     }
 }
 
@@ -1132,8 +1227,7 @@ BOOL CALLBACK handle_device_cb(LPCDIDEVICEINSTANCE instance, LPVOID data)
     // left alone.
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        if(g_data_store.device_map.find(instance->guidInstance) !=
-           g_data_store.device_map.end())
+        if(g_store.slots().find(instance->guidInstance) != k_invalid_slot)
         {
             return DIENUM_CONTINUE;
         }
@@ -1156,6 +1250,9 @@ BOOL CALLBACK handle_device_cb(LPCDIDEVICEINSTANCE instance, LPVOID data)
 
 void enumerate_devices()
 {
+    DILL_TRACE_SCOPE(&g_trace, EnumerateDevices, GUID{});
+    g_metrics.add(LoopCounter::HotplugEnumerations);
+
     // Register with the DirectInput system, creating an instance to
     // interface with it.
     if(g_direct_input == nullptr)
@@ -1196,8 +1293,9 @@ void enumerate_devices()
     std::vector<GUID> guid_to_remove;
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        for(auto const& [guid, device] : g_data_store.device_map)
+        for(auto slot : g_store.slots().active())
         {
+            auto const& guid = g_store.slots().guid(slot);
             if(current_devices.find(guid) == current_devices.end())
             {
                 guid_to_remove.push_back(guid);
@@ -1215,51 +1313,25 @@ void enumerate_devices()
         DeviceSummary di;
         {
             std::lock_guard<std::mutex> lock(g_data_store_mutex);
-            auto device_it = g_data_store.device_map.find(guid);
-            if(device_it != g_data_store.device_map.end())
-            {
-                device = device_it->second;
-                g_data_store.device_map.erase(device_it);
-            }
 
-            auto event_it = g_data_store.event_handles.find(guid);
-            if(event_it != g_data_store.event_handles.end())
+            // Releasing the slot bumps its generation, which invalidates any
+            // reference the event loop still holds to it.
+            const auto slot = g_store.remove(guid, di);
+            if(slot != k_invalid_slot)
             {
-                event_handle = event_it->second;
-                g_data_store.event_handles.erase(event_it);
-            }
+                device = g_data_store.device[slot];
+                event_handle = g_data_store.event_handle[slot];
 
-            // Emit DeviceInformation, copy existing device data if we know
-            // about the device and have an existing record, otherwise
-            // return an empty shell.
-            auto cache_it = g_data_store.cache.find(guid);
-            if(cache_it != g_data_store.cache.end())
-            {
-                di = cache_it->second;
+                g_data_store.device[slot] = nullptr;
+                g_data_store.event_handle[slot] = nullptr;
+                g_data_store.is_buffered[slot] = false;
+                g_data_store.is_ready[slot] = false;
             }
             else
             {
                 di.device_guid = guid;
                 strcpy_s(di.name, MAX_PATH, "Unknown");
             }
-
-            // Drop every remaining per-device entries so a guid that never
-            // reconnects doesn't linger in these maps indefinitely.
-            g_data_store.cache.erase(guid);
-            g_data_store.state.erase(guid);
-            g_data_store.is_ready.erase(guid);
-            g_data_store.is_buffered.erase(guid);
-
-            // Remove guid from list of active ones.
-            const auto it = std::find(
-                g_data_store.active_guids.begin(),
-                g_data_store.active_guids.end(),
-                guid
-            );
-            if(it != g_data_store.active_guids.end())
-            {
-                g_data_store.active_guids.erase(it);
-            }
         }
 
         if(device != nullptr)
@@ -1274,11 +1346,7 @@ void enumerate_devices()
             any_buffered_removed = true;
         }
 
-        auto device_change_callback = g_device_change_callback.load();
-        if(device_change_callback != nullptr)
-        {
-            device_change_callback(di, DeviceActionType::Disconnected);
-        }
+        g_dispatcher.device_changed(di, DeviceActionType::Disconnected);
     }
 
     if(any_buffered_removed && g_rebuild_event != nullptr)
@@ -1287,6 +1355,76 @@ void enumerate_devices()
     }
 }
 
+void log_latencies()
+{
+    auto log = [](std::string const& name, LatencySummary const& summary) {
+        logger->info(
+            "Latency {}: count={} min={}ns mean={}ns p50={}ns p90={}ns "
+            "p99={}ns p99.9={}ns max={}ns",
+            name,
+            summary.count,
+            summary.min_ns,
+            summary.mean_ns,
+            summary.p50_ns,
+            summary.p90_ns,
+            summary.p99_ns,
+            summary.p999_ns,
+            summary.max_ns
+        );
+    };
+
+    log("report", g_report_latency.summary());
+    log("decode", g_decode_latency.summary());
+    log("state update", g_state_latency.summary());
+    log(
+        "callback entry",
+        g_dispatcher.callback_latency(LatencyStage::CallbackEntry)
+    );
+    log(
+        "callback exit",
+        g_dispatcher.callback_latency(LatencyStage::CallbackExit)
+    );
+
+    std::lock_guard<std::mutex> lock(g_data_store_mutex);
+    for(auto slot : g_store.slots().active())
+    {
+        const GUID guid = g_store.slots().guid(slot);
+        LatencySummary summary;
+        if(g_dispatcher.device_latency(guid, summary))
+        {
+            log(guid_to_string(guid), summary);
+        }
+    }
+}
+
+void on_callback_stall(CallbackStall const* stall)
+{
+    if(stall->action != DeviceActionType{})
+    {
+        logger->warn(
+            "{}: Device change callback stalled for {}us",
+            guid_to_string(stall->device_guid),
+            stall->elapsed_ns / 1000
+        );
+    }
+    else
+    {
+        logger->warn(
+            "{}: Input callback stalled for {}us on input type {} index {}",
+            guid_to_string(stall->device_guid),
+            stall->elapsed_ns / 1000,
+            static_cast<int>(stall->input_type),
+            static_cast<int>(stall->input_index)
+        );
+    }
+
+    auto hook = g_stall_hook.load();
+    if(hook != nullptr)
+    {
+        hook(stall);
+    }
+}
+
 BOOL init()
 {
     try
@@ -1322,6 +1460,18 @@ BOOL init()
             return FALSE;
         }
 
+        {
+            std::lock_guard<std::mutex> lock(g_data_store_mutex);
+            g_store.set_extended_axes(g_extended_axes);
+        }
+
+        // Started first so that the bootstrap enumeration's device changes
+        // can already be queued.
+#if defined(DILL_ENABLE_TRACE)
+        g_dispatcher.set_trace_ring(&g_trace);
+#endif
+        g_dispatcher.start();
+        DispatcherGuard dispatcher_guard;
         g_loop.thread = std::thread(event_loop_main);
 
         // Block until the event loop thread has completed the startup sequence.
@@ -1339,6 +1489,7 @@ BOOL init()
             return FALSE;
         }
 
+        dispatcher_guard.dismiss();
         control_event_guard.dismiss();
         return TRUE;
     }
@@ -1379,29 +1530,41 @@ BOOL shutdown()
         {
             g_loop.thread.join();
         }
-
-        // Cohesive cleanup of all device/event handles.
+        g_dispatcher.stop();
+        g_recorder.close();
+        if(g_latency_logging)
+        {
+            log_latencies();
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_shutdown_trace_mutex);
+            if(!g_shutdown_trace_path.empty())
+            {
+                dill_write_trace(g_shutdown_trace_path.c_str());
+            }
+        }
+
+        // Cohesive cleanup of all device/event handles.
         std::vector<LPDIRECTINPUTDEVICE8> devices_to_release;
         std::vector<HANDLE> events_to_close;
         {
             std::lock_guard<std::mutex> lock(g_data_store_mutex);
-            devices_to_release.reserve(g_data_store.device_map.size());
-            for(auto& [guid, device] : g_data_store.device_map)
+            devices_to_release.reserve(g_store.slots().size());
+            events_to_close.reserve(g_store.slots().size());
+            for(auto slot : g_store.slots().active())
             {
-                devices_to_release.push_back(device);
-            }
-            events_to_close.reserve(g_data_store.event_handles.size());
-            for(auto& [guid, event] : g_data_store.event_handles)
-            {
-                events_to_close.push_back(event);
+                devices_to_release.push_back(g_data_store.device[slot]);
+                if(g_data_store.event_handle[slot] != nullptr)
+                {
+                    events_to_close.push_back(g_data_store.event_handle[slot]);
+                }
             }
-            g_data_store.device_map.clear();
-            g_data_store.event_handles.clear();
-            g_data_store.is_buffered.clear();
-            g_data_store.cache.clear();
-            g_data_store.state.clear();
-            g_data_store.is_ready.clear();
-            g_data_store.active_guids.clear();
+            g_data_store.device.fill(nullptr);
+            g_data_store.event_handle.fill(nullptr);
+            g_data_store.is_buffered.fill(false);
+            g_data_store.is_ready.fill(false);
+            g_data_store.min_poll_interval.fill(std::chrono::microseconds(0));
+            g_store.clear();
         }
         for(auto device : devices_to_release)
         {
@@ -1454,13 +1617,316 @@ BOOL shutdown()
 void set_input_event_callback(JoystickInputEventCallback cb)
 {
     logger->info("Setting event callback");
-    g_event_callback = cb;
+    g_dispatcher.set_event_callback(cb);
 }
 
 void set_device_change_callback(DeviceChangeCallback cb)
 {
     logger->info("Setting device change callback");
-    g_device_change_callback = cb;
+    g_dispatcher.set_device_change_callback(cb);
+}
+
+void set_input_batch_callback(JoystickInputBatchCallback cb)
+{
+    logger->info("Setting batched event callback");
+    g_dispatcher.set_batch_callback(cb);
+}
+
+void set_input_event_ex_callback(JoystickInputEventExCallback cb)
+{
+    logger->info("Setting extended event callback");
+    g_dispatcher.set_event_ex_callback(cb);
+}
+
+BOOL dill_configure_event_ring(size_t capacity, RingOverflowPolicy policy)
+{
+    if(g_running)
+    {
+        logger->error("Event ring can only be configured while not running");
+        return FALSE;
+    }
+    if(policy != RingOverflowPolicy::DropOldest &&
+       policy != RingOverflowPolicy::DropNewest)
+    {
+        logger->error(
+            "Invalid event ring overflow policy {}",
+            static_cast<int>(policy)
+        );
+        return FALSE;
+    }
+
+    try
+    {
+        g_dispatcher.configure_ring(capacity, policy);
+        if(capacity == 0)
+        {
+            logger->info("Disabling event ring");
+        }
+        else
+        {
+            logger->info(
+                "Configured event ring with {} slots",
+                g_dispatcher.ring_capacity()
+            );
+        }
+        return TRUE;
+    }
+    catch(std::exception const& e)
+    {
+        logger->error("Failed to configure event ring: {}", e.what());
+        return FALSE;
+    }
+}
+
+size_t dill_read_events(JoystickInputData* out, size_t max)
+{
+    return g_dispatcher.read_events(out, max);
+}
+
+size_t dill_read_events_ex(JoystickInputEventEx* out, size_t max)
+{
+    return g_dispatcher.read_events_ex(out, max);
+}
+
+uint64_t dill_get_time_ns()
+{
+    return monotonic_time_ns();
+}
+
+EventRingStats dill_get_event_ring_stats()
+{
+    return g_dispatcher.ring_stats();
+}
+
+void dill_set_coalescing(BOOL enabled)
+{
+    logger->info("{} event coalescing", enabled ? "Enabling" : "Disabling");
+    g_dispatcher.set_coalescing(enabled != FALSE);
+}
+
+CoalescingStats dill_get_coalescing_stats()
+{
+    return g_dispatcher.coalescing_stats();
+}
+
+BOOL dill_configure_dispatch_thread(size_t capacity, DispatchPolicy policy)
+{
+    if(g_running)
+    {
+        logger->error(
+            "Dispatch thread can only be configured while not running"
+        );
+        return FALSE;
+    }
+    if(policy != DispatchPolicy::Block &&
+       policy != DispatchPolicy::DropOldest &&
+       policy != DispatchPolicy::CoalesceAxis)
+    {
+        logger->error(
+            "Invalid dispatch queue policy {}",
+            static_cast<int>(policy)
+        );
+        return FALSE;
+    }
+
+    g_dispatcher.configure_thread(capacity, policy);
+    if(capacity == 0)
+    {
+        logger->info("Disabling dispatch thread");
+    }
+    else
+    {
+        logger->info("Configured dispatch thread with {} slots", capacity);
+    }
+    return TRUE;
+}
+
+DispatchQueueStats dill_get_dispatch_stats()
+{
+    return g_dispatcher.queue_stats();
+}
+
+BOOL dill_configure_watchdog(uint64_t budget_ns, CallbackStallHook hook)
+{
+    if(g_running)
+    {
+        logger->error(
+            "Callback watchdog can only be configured while not running"
+        );
+        return FALSE;
+    }
+
+    g_stall_hook = hook;
+    g_dispatcher.configure_watchdog(budget_ns, &on_callback_stall);
+    if(budget_ns == 0)
+    {
+        logger->info("Disabling callback watchdog");
+    }
+    else
+    {
+        logger->info(
+            "Configured callback watchdog with a budget of {}us",
+            budget_ns / 1000
+        );
+    }
+    return TRUE;
+}
+
+WatchdogStats dill_get_watchdog_stats()
+{
+    return g_dispatcher.watchdog_stats();
+}
+
+BOOL dill_write_trace(const char* path)
+{
+    if(path == nullptr)
+    {
+        return FALSE;
+    }
+
+#if defined(DILL_ENABLE_TRACE)
+    try
+    {
+        std::FILE* file = std::fopen(path, "w");
+        if(file == nullptr)
+        {
+            logger->error("Failed to open trace file {}", path);
+            return FALSE;
+        }
+        const bool written = g_trace.write_chrome_trace(file);
+        std::fclose(file);
+        if(!written)
+        {
+            logger->error("Failed to write trace file {}", path);
+            return FALSE;
+        }
+        logger->info("Wrote trace to {}", path);
+        return TRUE;
+    }
+    catch(...)
+    {
+        return FALSE;
+    }
+#else
+    logger->warn("Tracing is not enabled in this build of DILL");
+    return FALSE;
+#endif
+}
+
+BOOL dill_set_shutdown_trace(const char* path)
+{
+#if defined(DILL_ENABLE_TRACE)
+    std::lock_guard<std::mutex> lock(g_shutdown_trace_mutex);
+    g_shutdown_trace_path = path != nullptr ? path : "";
+    return TRUE;
+#else
+    logger->warn("Tracing is not enabled in this build of DILL");
+    return FALSE;
+#endif
+}
+
+BOOL dill_get_latency(LatencyStage stage, LatencySummary* summary)
+{
+    if(summary == nullptr)
+    {
+        return FALSE;
+    }
+
+    switch(stage)
+    {
+        case LatencyStage::Report:
+            *summary = g_report_latency.summary();
+            return TRUE;
+        case LatencyStage::Decode:
+            *summary = g_decode_latency.summary();
+            return TRUE;
+        case LatencyStage::StateUpdate:
+            *summary = g_state_latency.summary();
+            return TRUE;
+        case LatencyStage::CallbackEntry:
+        case LatencyStage::CallbackExit:
+            *summary = g_dispatcher.callback_latency(stage);
+            return TRUE;
+        default:
+            logger->error(
+                "Invalid latency stage {}",
+                static_cast<int>(stage)
+            );
+            return FALSE;
+    }
+}
+
+BOOL dill_get_device_latency(GUID guid, LatencySummary* summary)
+{
+    if(summary == nullptr)
+    {
+        return FALSE;
+    }
+    return g_dispatcher.device_latency(guid, *summary) ? TRUE : FALSE;
+}
+
+void dill_set_latency_logging(BOOL enabled)
+{
+    g_latency_logging = enabled != FALSE;
+}
+
+BOOL dill_set_extended_axes(BOOL enabled)
+{
+    if(g_running)
+    {
+        logger->error("Extended axes can only be changed while not running");
+        return FALSE;
+    }
+
+    g_extended_axes = enabled != FALSE;
+    logger->info(
+        "{} extended axes",
+        enabled != FALSE ? "Enabling" : "Disabling"
+    );
+    return TRUE;
+}
+
+BOOL dill_start_recording(const char* path)
+{
+    if(path == nullptr)
+    {
+        return FALSE;
+    }
+
+    try
+    {
+        if(!g_store.start_recording(path))
+        {
+            logger->error("Failed to open recording {}", path);
+            return FALSE;
+        }
+        logger->info("Recording input to {}", path);
+        return TRUE;
+    }
+    catch(std::exception const& e)
+    {
+        logger->error("Failed to start recording: {}", e.what());
+        g_recorder.close();
+        return FALSE;
+    }
+}
+
+void dill_stop_recording()
+{
+    g_recorder.close();
+    const auto stats = g_recorder.stats();
+    logger->info(
+        "Recording stopped, {} bytes written, {} records dropped, "
+        "{} inputs of unrecorded devices",
+        stats.bytes_written,
+        stats.dropped,
+        stats.rejected
+    );
+}
+
+RecorderStats dill_get_recording_stats()
+{
+    return g_recorder.stats();
 }
 
 DeviceSummary get_device_information_by_index(size_t index)
@@ -1468,7 +1934,8 @@ DeviceSummary get_device_information_by_index(size_t index)
     try
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        if(index < 0 || index >= g_data_store.active_guids.size())
+        auto const& active = g_store.slots().active();
+        if(index < 0 || index >= active.size())
         {
             logger->warn(
                 "Attempting to retireve device summary for invalid index {}",
@@ -1476,13 +1943,7 @@ DeviceSummary get_device_information_by_index(size_t index)
             );
             return DeviceSummary();
         }
-        auto guid = g_data_store.active_guids[index];
-        const auto it = g_data_store.cache.find(guid);
-        if(it == g_data_store.cache.end())
-        {
-            return DeviceSummary();
-        }
-        return it->second;
+        return g_store.info(active[index]).summary;
     }
     catch(...)
     {
@@ -1495,8 +1956,8 @@ DeviceSummary get_device_information_by_guid(GUID guid)
     try
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        const auto it = g_data_store.cache.find(guid);
-        if(it == g_data_store.cache.end())
+        const auto slot = g_store.slots().find(guid);
+        if(slot == k_invalid_slot)
         {
             logger->warn(
                 "Attempting to retireve device summary for invalid GUID {}",
@@ -1504,7 +1965,7 @@ DeviceSummary get_device_information_by_guid(GUID guid)
             );
             return DeviceSummary();
         }
-        return it->second;
+        return g_store.info(slot).summary;
     }
     catch(...)
     {
@@ -1512,13 +1973,35 @@ DeviceSummary get_device_information_by_guid(GUID guid)
     }
 }
 
+bool get_device_information_ex_by_guid(GUID guid, DeviceSummaryEx* info)
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        const auto slot = g_store.slots().find(guid);
+        if(slot == k_invalid_slot)
+        {
+            logger->warn(
+                "Attempting to retireve device summary for invalid GUID {}",
+                guid_to_string(guid)
+            );
+            return false;
+        }
+        return copy_summary_ex(g_store.info(slot), info);
+    }
+    catch(...)
+    {
+        return false;
+    }
+}
+
 
 size_t get_device_count()
 {
     try
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        return g_data_store.active_guids.size();
+        return g_store.slots().size();
     }
     catch(...)
     {
@@ -1531,14 +2014,7 @@ bool device_exists(GUID guid)
     try
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        for(auto const& dev_guid : g_data_store.active_guids)
-        {
-            if(dev_guid == guid)
-            {
-                return true;
-            }
-        }
-        return false;
+        return g_store.slots().find(guid) != k_invalid_slot;
     }
     catch(...)
     {
@@ -1548,7 +2024,7 @@ bool device_exists(GUID guid)
 
 LONG get_axis(GUID guid, DWORD index)
 {
-    if(index < 1 || index > 8)
+    if(index < 1 || index > k_max_axes)
     {
         logger->error(
             "{}: Requested invalid axis index {}",
@@ -1558,20 +2034,13 @@ LONG get_axis(GUID guid, DWORD index)
         return 0;
     }
 
-    try
-    {
-        std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        const auto it = g_data_store.state.find(guid);
-        if(it == g_data_store.state.end())
-        {
-            return 0;
-        }
-        return it->second.axis[index];
-    }
-    catch(...)
+    // Reads the seqlock protected state without taking g_data_store_mutex.
+    DeviceState state;
+    if(!g_store.state().load(guid, state))
     {
         return 0;
     }
+    return state.axis[index];
 }
 
 bool get_button(GUID guid, DWORD index)
@@ -1586,20 +2055,13 @@ bool get_button(GUID guid, DWORD index)
         return false;
     }
 
-    try
-    {
-        std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        const auto it = g_data_store.state.find(guid);
-        if(it == g_data_store.state.end())
-        {
-            return false;
-        }
-        return it->second.button[index];
-    }
-    catch(...)
+    // Reads the seqlock protected state without taking g_data_store_mutex.
+    DeviceState state;
+    if(!g_store.state().load(guid, state))
     {
         return false;
     }
+    return state.button.test(index);
 }
 
 LONG get_hat(GUID guid, DWORD index)
@@ -1614,20 +2076,359 @@ LONG get_hat(GUID guid, DWORD index)
         return -1;
     }
 
+    // Reads the seqlock protected state without taking g_data_store_mutex.
+    DeviceState state;
+    if(!g_store.state().load(guid, state))
+    {
+        return -1;
+    }
+    return state.hat[index];
+}
+
+bool get_device_state(GUID guid, DillDeviceSnapshot* snapshot)
+{
+    if(snapshot == nullptr)
+    {
+        logger->error("{}: No snapshot provided", guid_to_string(guid));
+        return false;
+    }
+
+    // Reads the seqlock protected state without taking g_data_store_mutex.
+    return g_store.state().snapshot(guid, *snapshot);
+}
+
+size_t get_all_device_states(DillDeviceSnapshot* snapshots, size_t max)
+{
+    if(snapshots == nullptr)
+    {
+        return 0;
+    }
+
+    try
+    {
+        // All state writers hold the mutex, holding it here yields a
+        // consistent view across all devices.
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        size_t count = 0;
+        for(auto slot : g_store.slots().active())
+        {
+            if(count == max)
+            {
+                break;
+            }
+            if(g_store.state().snapshot(
+                g_store.slots().ref(slot),
+                snapshots[count]
+            ))
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+    catch(...)
+    {
+        return 0;
+    }
+}
+
+size_t dill_get_metrics(LoopMetrics* loop, DeviceMetrics* devices, size_t max)
+{
+    if(loop != nullptr)
+    {
+        const auto callbacks = g_dispatcher.callback_stats();
+        *loop = g_metrics.loop();
+        loop->callback_invocations = callbacks.invocations;
+        loop->callback_time_ns = callbacks.total_time_ns;
+        loop->callback_overruns = g_dispatcher.watchdog_stats().overruns;
+    }
+    if(devices == nullptr)
+    {
+        return 0;
+    }
+
+    try
+    {
+        // The lock only guards the slot assignment, the counters are read
+        // without synchronizing with the event loop.
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        size_t count = 0;
+        for(auto slot : g_store.slots().active())
+        {
+            if(count == max)
+            {
+                break;
+            }
+            devices[count++] = g_metrics.device(
+                slot,
+                g_store.slots().guid(slot)
+            );
+        }
+        return count;
+    }
+    catch(...)
+    {
+        return 0;
+    }
+}
+
+BOOL dill_set_max_poll_rate(GUID guid, DWORD max_rate_hz)
+{
+    try
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_data_store_mutex);
+            const auto slot = g_store.slots().find(guid);
+            if(slot == k_invalid_slot)
+            {
+                logger->warn(
+                    "Attempting to set poll rate of invalid GUID {}",
+                    guid_to_string(guid)
+                );
+                return FALSE;
+            }
+            g_data_store.min_poll_interval[slot] = max_rate_hz == 0
+                ? std::chrono::microseconds(0)
+                : std::chrono::microseconds(1000000 / max_rate_hz);
+        }
+
+        // The event loop picks up the new rate when rebuilding its handles.
+        if(g_rebuild_event != nullptr)
+        {
+            SetEvent(g_rebuild_event);
+        }
+        return TRUE;
+    }
+    catch(...)
+    {
+        return FALSE;
+    }
+}
+
+BOOL dill_set_axis_filter(
+    GUID guid,
+    DWORD axis_index,
+    AxisFilterConfig config
+)
+{
     try
     {
         std::lock_guard<std::mutex> lock(g_data_store_mutex);
-        const auto it = g_data_store.state.find(guid);
-        if(it == g_data_store.state.end())
+        const auto slot = g_store.slots().find(guid);
+        if(slot == k_invalid_slot)
         {
-            return -1;
+            logger->warn(
+                "Attempting to set axis filter of invalid GUID {}",
+                guid_to_string(guid)
+            );
+            return FALSE;
+        }
+
+        if(!g_store.set_axis_filter(slot, axis_index, config))
+        {
+            logger->error(
+                "{}: Invalid axis filter for axis {}",
+                guid_to_string(guid),
+                axis_index
+            );
+            return FALSE;
         }
-        return it->second.hat[index];
+        return TRUE;
     }
     catch(...)
+    {
+        return FALSE;
+    }
+}
+
+BOOL dill_set_subscription(
+    GUID guid,
+    DWORD type_mask,
+    uint64_t const* index_bitset
+)
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        const auto slot = g_store.slots().find(guid);
+        if(slot == k_invalid_slot)
+        {
+            logger->warn(
+                "Attempting to set subscription of invalid GUID {}",
+                guid_to_string(guid)
+            );
+            return FALSE;
+        }
+        if(!g_store.set_subscription(slot, type_mask, index_bitset))
+        {
+            logger->error(
+                "{}: Invalid subscription type mask {:#x}",
+                guid_to_string(guid),
+                type_mask
+            );
+            return FALSE;
+        }
+        return TRUE;
+    }
+    catch(...)
+    {
+        return FALSE;
+    }
+}
+
+uint32_t dill_open_device(GUID guid)
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        const auto slot = g_store.slots().find(guid);
+        if(slot == k_invalid_slot)
+        {
+            logger->warn(
+                "Attempting to open invalid GUID {}",
+                guid_to_string(guid)
+            );
+            return k_invalid_device_handle;
+        }
+        return encode_device_handle(g_store.slots().ref(slot));
+    }
+    catch(...)
+    {
+        return k_invalid_device_handle;
+    }
+}
+
+bool device_exists_by_handle(uint32_t handle)
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        return g_store.slots().is_current(decode_device_handle(handle));
+    }
+    catch(...)
+    {
+        return false;
+    }
+}
+
+DeviceSummary get_device_information_by_handle(uint32_t handle)
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        const auto ref = decode_device_handle(handle);
+        if(!g_store.slots().is_current(ref))
+        {
+            logger->warn(
+                "Attempting to retireve device summary for stale handle {:#x}",
+                handle
+            );
+            return DeviceSummary();
+        }
+        return g_store.info(ref.slot).summary;
+    }
+    catch(...)
+    {
+        return DeviceSummary();
+    }
+}
+
+bool get_device_information_ex_by_handle(
+    uint32_t                            handle,
+    DeviceSummaryEx*                    info
+)
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(g_data_store_mutex);
+        const auto ref = decode_device_handle(handle);
+        if(!g_store.slots().is_current(ref))
+        {
+            logger->warn(
+                "Attempting to retireve device summary for stale handle {:#x}",
+                handle
+            );
+            return false;
+        }
+        return copy_summary_ex(g_store.info(ref.slot), info);
+    }
+    catch(...)
+    {
+        return false;
+    }
+}
+
+LONG get_axis_by_handle(uint32_t handle, DWORD index)
+{
+    if(index < 1 || index > k_max_axes)
+    {
+        logger->error(
+            "{:#x}: Requested invalid axis index {}",
+            handle,
+            index
+        );
+        return 0;
+    }
+
+    // Stale handles are rejected by the generation stored with the state,
+    // neither the GUID scan nor g_data_store_mutex are needed.
+    DeviceState state;
+    if(!g_store.state().load(decode_device_handle(handle), state))
+    {
+        return 0;
+    }
+    return state.axis[index];
+}
+
+bool get_button_by_handle(uint32_t handle, DWORD index)
+{
+    if(index < 1 || index > 128)
+    {
+        logger->error(
+            "{:#x}: Requested invalid button index {}",
+            handle,
+            index
+        );
+        return false;
+    }
+
+    DeviceState state;
+    if(!g_store.state().load(decode_device_handle(handle), state))
+    {
+        return false;
+    }
+    return state.button.test(index);
+}
+
+LONG get_hat_by_handle(uint32_t handle, DWORD index)
+{
+    if(index < 1 || index > 4)
+    {
+        logger->error(
+            "{:#x}: Requested invalid hat index {}",
+            handle,
+            index
+        );
+        return -1;
+    }
+
+    DeviceState state;
+    if(!g_store.state().load(decode_device_handle(handle), state))
     {
         return -1;
     }
+    return state.hat[index];
+}
+
+bool get_device_state_by_handle(uint32_t handle, DillDeviceSnapshot* snapshot)
+{
+    if(snapshot == nullptr)
+    {
+        logger->error("{:#x}: No snapshot provided", handle);
+        return false;
+    }
+
+    return g_store.state().snapshot(decode_device_handle(handle), *snapshot);
 }
 
 DWORD get_vendor_id(LPDIRECTINPUTDEVICE8 device, GUID guid)
@@ -14,135 +14,20 @@
 #include <unordered_map>
 #include <vector>
 
-#define FMT_UNICODE 0
-
-namespace std
-{
-    template<> struct hash<GUID>
-    {
-        /**
-         * \brief Hash computation for GUID instances.
-         *
-         * This has is intended for use with std::unordered_map and as such
-         * is not required to maintain the uniqueness of the GUID.
-         *
-         * \param guid GUID instance to compute the hash of
-         * \return hash value for the provided GUID instance
-         */
-        std::size_t operator()(GUID const& guid) const
-        {
-            return std::hash<DWORD>()(
-                guid.Data1 ^
-                ((guid.Data2 << 16) | guid.Data3) ^
-                *(DWORD*)(guid.Data4) ^
-                *(DWORD*)(guid.Data4 + 4)
-            );
-        }
-    };
-}
-
-/**
- * \brief Physical input types available on joysticks.
- */
-enum class JoystickInputType : UINT8
-{
-    Axis = 1,
-    Button = 2,
-    Hat = 3
-};
-
-/**
- * \brief Device state change types.
- */
-enum class DeviceActionType : UINT8
-{
-    Connected = 1,
-    Disconnected = 2
-};
-
-/**
- * \brief Joystick input event data.
- *
- * Stores information about a single joystick input event.
- */
-struct JoystickInputData
-{
-    GUID                                device_guid;
-    JoystickInputType                   input_type;
-    // In case of an axis this is the axis_index and not the linear_index.
-    UINT8                               input_index;
-    LONG                                value;
-};
+#include "axis_filter.h"
+#include "callback_watchdog.h"
+#include "dill_types.h"
+#include "dispatch_queue.h"
+#include "event_coalescing.h"
+#include "event_ring.h"
+#include "input_metrics.h"
+#include "input_recorder.h"
+#include "latency_histogram.h"
 
-/**
- * \brief Stores axis information.
- *
- * Stores the linear and axis index of a single axis.
- */
-struct AxisMap
-{
-    DWORD                               linear_index;
-    DWORD                               axis_index;
-};
-
-/**
- * \brief Holds information about the configuration of a single
- *        joystick device.
- *
- * All data required to handle future data from the particular
- * joystick device.
- */
-struct DeviceSummary
-{
-    GUID                                device_guid;
-    DWORD                               vendor_id;
-    DWORD                               product_id;
-    DWORD                               joystick_id;
-    char                                name[MAX_PATH];
-    DWORD                               axis_count;
-    DWORD                               button_count;
-    DWORD                               hat_count;
-    AxisMap                             axis_map[8];
-};
+#define FMT_UNICODE 0
 
-/**
- * \brief Represents the current state of a device.
- */
-struct DeviceState
-{
-    DeviceState();
-
-    std::vector<LONG>                   axis;
-    std::vector<bool>                   button;
-    std::vector<LONG>                   hat;
-};
-
-/**
- * \brief Holds information about devices and their state.
- */
-struct DeviceDataStore
-{
-    //! Maps from GUID to DirectInput device instance.
-    std::unordered_map<GUID, LPDIRECTINPUTDEVICE8> device_map;
-    //! Indicates if a device requires buffered treatment.
-    std::unordered_map<GUID, bool> is_buffered;
-    //! Caches DeviceSummary for devices.
-    std::unordered_map<GUID, DeviceSummary> cache;
-    //! Last known state of the device.
-    std::unordered_map<GUID, DeviceState> state;
-    //! Flag indicating if a device is fully operational.
-    std::unordered_map<GUID, bool> is_ready;
-    //! List of all active GUIDs.
-    std::vector<GUID> active_guids;
-    //! Device notification event used with SetEventNotification.
-    std::unordered_map<GUID, HANDLE> event_handles;
-};
-
-
-//! Callback for joystick value change events.
-typedef void (*JoystickInputEventCallback)(JoystickInputData);
-//! Callback for device change events.
-typedef void (*DeviceChangeCallback)(DeviceSummary, DeviceActionType);
+class PollScheduler;
+struct SlotRef;
 
 
 /**
@@ -188,14 +73,17 @@ LRESULT window_proc(
 );
 
 /**
- * \brief Aggregates the data about a single DirectInput message event.
+ * \brief Decodes the data about a single DirectInput message event.
  *
  * \param data message content holding information about the event
  * \param guid identifier of the device who caused the event
+ * \param evt populated with the decoded event
+ * \return true if the event was decoded, false if its offset is unknown
  */
-void emit_joystick_input_event(
+bool decode_joystick_input_event(
     DIDEVICEOBJECTDATA const&           data,
-    GUID const&                         guid
+    GUID const&                         guid,
+    JoystickInputData&                  evt
 );
 
 /**
@@ -203,8 +91,27 @@ void emit_joystick_input_event(
  *
  * \param instance device instance holding the information
  * \param guid identifier of the device being updated
+ * \param slot data store slot of the device being updated
  */
-void process_buffered_events(LPDIRECTINPUTDEVICE8 instance, GUID const& guid);
+void process_buffered_events(
+    LPDIRECTINPUTDEVICE8                instance,
+    GUID const&                         guid,
+    uint32_t                            slot
+);
+
+/**
+ * \brief Polls a device that does not support buffered reading.
+ *
+ * \param instance device instance to poll
+ * \param guid identifier of the device being updated
+ * \param slot data store slot of the device being updated
+ * \return true if the device's report changed since the last poll
+ */
+bool poll_device(
+    LPDIRECTINPUTDEVICE8                instance,
+    GUID const&                         guid,
+    uint32_t                            slot
+);
 
 /**
  * \brief Main event processing loop.
@@ -226,17 +133,23 @@ constexpr DWORD k_control_handle_count = 3;
  *
  * \param handles MsgWaitForMultipleObjectsEx handle array
  * \param handle_count number of handle entries
- * \param handle_guids list of device GUIDs
- * \param periodic_service_needed set to true if a polled-fallback device
- *        exists
+ * \param handle_slots data store slots of the devices owning the handles
+ * \param poll_scheduler synchronized with the polled-fallback devices
  */
 void rebuild_wait_handles(
     std::array<HANDLE, k_max_wait_handles>& handles,
     DWORD&                              handle_count,
-    std::vector<GUID>&                  handle_guids,
-    bool&                               periodic_service_needed
+    std::vector<SlotRef>&               handle_slots,
+    PollScheduler&                      poll_scheduler
 );
 
+/**
+ * \brief Polls every polled-fallback device that is due.
+ *
+ * \param poll_scheduler scheduler deciding which devices are due
+ */
+void poll_due_devices(PollScheduler& poll_scheduler);
+
 /**
  * \brief Creates the "window" infrastructure needed to receive messages.
  */
@@ -260,6 +173,20 @@ BOOL CALLBACK enumerate_axis_objects(
  */
 void enumerate_devices();
 
+/**
+ * \brief Writes the latency distributions of every stage and device to the
+ *        log.
+ */
+void log_latencies();
+
+/**
+ * \brief Logs a callback exceeding the watchdog's budget and forwards it to
+ *        the client's stall hook.
+ *
+ * \param stall the delivery exceeding the budget
+ */
+void on_callback_stall(CallbackStall const* stall);
+
 /**
  * \brief Performs device initialization.
  *
@@ -323,6 +250,241 @@ extern "C"
     __declspec(dllexport)
     void set_input_event_callback(JoystickInputEventCallback cb);
 
+    /**
+     * \brief Sets the callback for batched input events.
+     *
+     * While set, this callback replaces the per-event callback and receives
+     * every event decoded from a single device wakeup as one contiguous
+     * array. The array is only valid for the duration of the call.
+     *
+     * \param cb callback to use from now on, nullptr reverts to per-event
+     *        delivery
+     */
+    __declspec(dllexport)
+    void set_input_batch_callback(JoystickInputBatchCallback cb);
+
+    /**
+     * \brief Sets the callback for timestamped input events.
+     *
+     * While set, this callback replaces the batch and per-event callbacks
+     * and receives every event decoded from a single device wakeup as one
+     * contiguous array of JoystickInputEventEx, which adds DirectInput's
+     * timestamp and sequence number as well as the time DILL read the
+     * event. The array is only valid for the duration of the call.
+     *
+     * \param cb callback to use from now on, nullptr reverts to the
+     *        JoystickInputData callbacks
+     */
+    __declspec(dllexport)
+    void set_input_event_ex_callback(JoystickInputEventExCallback cb);
+
+    /**
+     * \brief Configures the pull-mode event ring.
+     *
+     * Once configured, every input event is additionally stored in a
+     * bounded ring from which any thread can read via dill_read_events.
+     * Callbacks continue to be invoked if set. Can only be called while the
+     * library is not running and must not race with dill_read_events.
+     *
+     * \param capacity minimum number of events the ring holds, 0 disables
+     *        the ring
+     * \param policy which event to drop when the ring is full
+     * \return TRUE if the ring was configured, FALSE if the library is
+     *         running, the policy is invalid or the ring could not be
+     *         created, e.g. as the capacity exceeds half of SIZE_MAX
+     */
+    __declspec(dllexport)
+    BOOL dill_configure_event_ring(size_t capacity, RingOverflowPolicy policy);
+
+    /**
+     * \brief Reads pending input events from the event ring.
+     *
+     * Never blocks and is safe to call from any number of threads.
+     *
+     * \param out array receiving the events, oldest first
+     * \param max maximum number of events to write to out
+     * \return number of events written to out, 0 if the ring is empty or
+     *         not configured
+     */
+    __declspec(dllexport)
+    size_t dill_read_events(JoystickInputData* out, size_t max);
+
+    /**
+     * \brief Reads pending timestamped input events from the event ring.
+     *
+     * Same as dill_read_events but retains the timing information of each
+     * event. Both functions consume from the same ring.
+     *
+     * \param out array receiving the events, oldest first
+     * \param max maximum number of events to write to out
+     * \return number of events written to out, 0 if the ring is empty or
+     *         not configured
+     */
+    __declspec(dllexport)
+    size_t dill_read_events_ex(JoystickInputEventEx* out, size_t max);
+
+    /**
+     * \brief Returns the current time of the clock used for receive
+     *        timestamps.
+     *
+     * Allows clients to measure the delay between DILL reading an event
+     * and its consumption.
+     *
+     * \return current time in nanoseconds of a monotonic clock
+     */
+    __declspec(dllexport)
+    uint64_t dill_get_time_ns();
+
+    /**
+     * \brief Returns the counters of the event ring.
+     *
+     * \return counters of the event ring, all zero if it is not configured
+     */
+    __declspec(dllexport)
+    EventRingStats dill_get_event_ring_stats();
+
+    /**
+     * \brief Enables or disables coalescing of axis and hat events.
+     *
+     * While enabled, of several updates of the same axis or hat read in a
+     * single device wakeup only the last one is delivered, to callbacks
+     * and the event ring alike. Button events are never coalesced, so no
+     * press or release is lost. Queried state is unaffected. Disabled by
+     * default.
+     *
+     * \param enabled TRUE to coalesce events, FALSE to deliver each one
+     */
+    __declspec(dllexport)
+    void dill_set_coalescing(BOOL enabled);
+
+    /**
+     * \brief Returns the counters of event coalescing.
+     *
+     * \return number of events seen and removed while coalescing
+     */
+    __declspec(dllexport)
+    CoalescingStats dill_get_coalescing_stats();
+
+    /**
+     * \brief Configures a dedicated thread invoking the callbacks.
+     *
+     * By default callbacks run on the event loop thread, so a slow callback
+     * delays input draining and hotplug processing. With a dispatch thread
+     * the event loop only queues events and device changes, which a
+     * separate thread hands to the callbacks and the event ring in the
+     * order they occurred. Can only be called while the library is not
+     * running.
+     *
+     * \param capacity number of input events queued for the thread, 0
+     *        invokes the callbacks on the event loop thread
+     * \param policy behaviour when events arrive while the queue is full
+     * \return TRUE if the thread was configured, FALSE otherwise
+     */
+    __declspec(dllexport)
+    BOOL dill_configure_dispatch_thread(
+        size_t capacity,
+        DispatchPolicy policy
+    );
+
+    /**
+     * \brief Returns the counters of the dispatch thread's queue.
+     *
+     * \return queue depth, losses and latency of the current or last
+     *         dispatch thread, all zero if none has been used
+     */
+    __declspec(dllexport)
+    DispatchQueueStats dill_get_dispatch_stats();
+
+    /**
+     * \brief Configures a watchdog flagging callbacks that take too long.
+     *
+     * A callback running on the event loop thread stops input draining
+     * while it runs, letting DirectInput's buffers overflow. The watchdog
+     * checks from a thread of its own whether a callback delivery exceeds
+     * the budget, logs it together with the device and event being
+     * delivered, and invokes the hook while the callback still runs.
+     * Deliveries exceeding the budget are counted in
+     * LoopMetrics::callback_overruns. Can only be called while the library
+     * is not running.
+     *
+     * \param budget_ns time a single callback delivery may take, 0
+     *        disables the watchdog
+     * \param hook function invoked from the watchdog's thread for every
+     *        delivery exceeding the budget, may be nullptr
+     * \return TRUE if the watchdog was configured, FALSE otherwise
+     */
+    __declspec(dllexport)
+    BOOL dill_configure_watchdog(uint64_t budget_ns, CallbackStallHook hook);
+
+    /**
+     * \brief Returns the counters of the callback watchdog.
+     *
+     * \return overruns, stalls and the most recent stall, all zero if the
+     *         watchdog has never run
+     */
+    __declspec(dllexport)
+    WatchdogStats dill_get_watchdog_stats();
+
+    /**
+     * \brief Writes the recent event loop and callback activity to a file.
+     *
+     * Builds configured with DILL_ENABLE_TRACE record a span for every
+     * wait, device enumeration, wait handle rebuild, device drain or poll
+     * and callback invocation into a fixed size ring, retaining the most
+     * recent 65536. The file uses the Chrome trace event JSON format, which
+     * chrome://tracing and Perfetto display as a timeline.
+     *
+     * \param path path of the file to write
+     * \return TRUE if the trace was written, FALSE if tracing is not
+     *         enabled in this build or the file could not be written
+     */
+    __declspec(dllexport)
+    BOOL dill_write_trace(const char* path);
+
+    /**
+     * \brief Sets a file the trace is written to on shutdown.
+     *
+     * \param path path of the file written by shutdown, nullptr or an
+     *        empty string writes none
+     * \return TRUE if the path was set, FALSE if tracing is not enabled in
+     *         this build
+     */
+    __declspec(dllexport)
+    BOOL dill_set_shutdown_trace(const char* path);
+
+    /**
+     * \brief Starts recording device changes and input events to a file.
+     *
+     * The recording begins with every device connected at this moment and
+     * then captures each connection, disconnection and decoded input event
+     * in the format documented in input_recording.h. Files are written by
+     * a background thread, input delivery never waits for them. Records
+     * the writer cannot keep up with are dropped and noted in the file.
+     *
+     * \param path path of the file to create, replaced if it exists
+     * \return TRUE if recording started, FALSE if the file could not be
+     *         created or a recording is already running
+     */
+    __declspec(dllexport)
+    BOOL dill_start_recording(const char* path);
+
+    /**
+     * \brief Stops recording and closes the recording file.
+     *
+     * Blocks until every pending record has been written. Also happens as
+     * part of shutdown.
+     */
+    __declspec(dllexport)
+    void dill_stop_recording();
+
+    /**
+     * \brief Returns the counters of the recorder.
+     *
+     * \return counters of the recorder
+     */
+    __declspec(dllexport)
+    RecorderStats dill_get_recording_stats();
+
     /**
      * \brief Sets the callback for device change events.
      *
@@ -343,6 +505,22 @@ extern "C"
     __declspec(dllexport)
     DeviceSummary get_device_information_by_guid(GUID guid);
 
+    /**
+     * \brief Returns the extended summary, describing every axis, of the
+     *        device with the provided GUID.
+     *
+     * The caller sets info->struct_size to the size of its DeviceSummaryEx,
+     * DILL writes no more than that and sets struct_size to the size of the
+     * fields written.
+     *
+     * \param guid GUID of the device to query
+     * \param info receives the extended summary of the device
+     * \return true if the summary was written, false if no such device is
+     *         connected or info is invalid
+     */
+    __declspec(dllexport)
+    bool get_device_information_ex_by_guid(GUID guid, DeviceSummaryEx* info);
+
     /**
      * \brief Returns the number of available devices.
      *
@@ -358,10 +536,12 @@ extern "C"
      * \brief Returns the current axis value.
      *
      * The provided index is an "axis_index", i.e. not the linear enumeration
-     * but the index specifying a particular axis with gaps.
+     * but the index specifying a particular axis with gaps. The axes with
+     * axis_index 9-32 are tracked whether or not their events are
+     * delivered, see dill_set_extended_axes.
      *
      * \param guid GUID of the device to query
-     * \param index axis index to query
+     * \param index axis index to query (1-32)
      * \return current axis value of the provided device and axis
      */
     __declspec(dllexport)
@@ -386,4 +566,269 @@ extern "C"
      */
     __declspec(dllexport)
     LONG get_hat(GUID guid, DWORD index);
+
+    /**
+     * \brief Returns the state of all inputs of a device at once.
+     *
+     * \param guid GUID of the device to query
+     * \param snapshot receives the device's state
+     * \return true if the device exists and snapshot was filled, false
+     *         otherwise
+     */
+    __declspec(dllexport)
+    bool get_device_state(GUID guid, DillDeviceSnapshot* snapshot);
+
+    /**
+     * \brief Returns the state of all inputs of every device at once.
+     *
+     * The snapshots are taken while no device state is being modified and
+     * thus form one consistent view across devices. Devices are reported in
+     * the order of get_device_information_by_index.
+     *
+     * \param snapshots array receiving one snapshot per device
+     * \param max maximum number of snapshots to write, get_device_count
+     *        gives the number needed
+     * \return number of snapshots written
+     */
+    __declspec(dllexport)
+    size_t get_all_device_states(DillDeviceSnapshot* snapshots, size_t max);
+
+    /**
+     * \brief Returns the counters of the event loop and every device.
+     *
+     * Reads relaxed atomic counters without waiting for the event loop,
+     * cheap enough to be called periodically while input is flowing.
+     * Device counters start at zero when a device connects, loop counters
+     * accumulate from the first init.
+     *
+     * \param loop receives the event loop counters, may be nullptr
+     * \param devices array receiving the counters of one device each, may
+     *        be nullptr
+     * \param max maximum number of device entries to write,
+     *        get_device_count gives the number needed
+     * \return number of device entries written
+     */
+    __declspec(dllexport)
+    size_t dill_get_metrics(
+        LoopMetrics* loop,
+        DeviceMetrics* devices,
+        size_t max
+    );
+
+    /**
+     * \brief Returns the latency distribution of a stage of the input path.
+     *
+     * Latencies are recorded into fixed size histograms from the first
+     * init onward, reading them does not wait for the event loop.
+     *
+     * \param stage stage of the input path to query
+     * \param summary receives the distribution of the stage's latencies
+     * \return TRUE if the summary was written, FALSE if the stage is
+     *         invalid or no summary was provided
+     */
+    __declspec(dllexport)
+    BOOL dill_get_latency(LatencyStage stage, LatencySummary* summary);
+
+    /**
+     * \brief Returns the latency until the input callbacks of a device
+     *        returned.
+     *
+     * Measured like LatencyStage::CallbackExit, starting anew whenever
+     * the device connects.
+     *
+     * \param guid GUID of the device to query
+     * \param summary receives the distribution of the device's latencies
+     * \return TRUE if the summary was written, FALSE if no such device is
+     *         connected or no summary was provided
+     */
+    __declspec(dllexport)
+    BOOL dill_get_device_latency(GUID guid, LatencySummary* summary);
+
+    /**
+     * \brief Enables writing the latency distributions to the debug log on
+     *        shutdown.
+     *
+     * \param enabled TRUE to log the latencies on shutdown
+     */
+    __declspec(dllexport)
+    void dill_set_latency_logging(BOOL enabled);
+
+    /**
+     * \brief Enables the velocity, acceleration and force axes and sliders.
+     *
+     * DeviceSummary and the input events of existing clients only cover
+     * the axes with axis_index 1-8. Once enabled, input events also cover
+     * the axes with axis_index 9-32, which DeviceSummaryEx describes.
+     * get_axis and the device state report their values either way. Can
+     * only be called while the library is not running.
+     *
+     * \param enabled TRUE to deliver the events of every axis, FALSE for
+     *        axes 1-8 only
+     * \return TRUE if the setting was changed, FALSE otherwise
+     */
+    __declspec(dllexport)
+    BOOL dill_set_extended_axes(BOOL enabled);
+
+    /**
+     * \brief Limits how often a device without buffered input is polled.
+     *
+     * Devices that do not support buffered input are polled at up to
+     * 1000 Hz while in use and less often while idle. The limit applies
+     * until the device disconnects and has no effect on buffered devices.
+     *
+     * \param guid GUID of the device to limit
+     * \param max_rate_hz maximum number of polls per second, 0 removes the
+     *        limit
+     * \return TRUE if the limit was set, FALSE if no such device exists
+     */
+    __declspec(dllexport)
+    BOOL dill_set_max_poll_rate(GUID guid, DWORD max_rate_hz);
+
+    /**
+     * \brief Suppresses axis events caused by noise.
+     *
+     * Changes smaller than the configured thresholds do not invoke the
+     * input callback, values within the deadzone are reported as 0. The
+     * axis state returned by get_axis and the device snapshots keeps
+     * tracking every change. The filter applies until the device
+     * disconnects, a configuration of all zeros removes it.
+     *
+     * \param guid GUID of the device to filter
+     * \param axis_index 1-based index of the axis to filter
+     * \param config thresholds in axis counts
+     * \return TRUE if the filter was set, FALSE if no such device exists or
+     *         the arguments are out of range
+     */
+    __declspec(dllexport)
+    BOOL dill_set_axis_filter(
+        GUID guid,
+        DWORD axis_index,
+        AxisFilterConfig config
+    );
+
+    /**
+     * \brief Selects the inputs of a device whose events are delivered.
+     *
+     * Events of unsubscribed inputs reach neither the callbacks nor the
+     * event ring, while device state queries and recordings still see
+     * them. Initially every input is subscribed. Each call replaces the
+     * subscription of the selected input types only, so axes, buttons and
+     * hats can be subscribed to with separate calls. The subscription
+     * applies until the device disconnects.
+     *
+     * \param guid GUID of the device to subscribe to
+     * \param type_mask combination of k_subscribe_axes,
+     *        k_subscribe_buttons and k_subscribe_hats
+     * \param index_bitset two 64 bit words with bit N-1 selecting input N,
+     *        nullptr subscribes to every input of the selected types
+     * \return TRUE if the subscription was set, FALSE if no such device
+     *         exists or the type mask is invalid
+     */
+    __declspec(dllexport)
+    BOOL dill_set_subscription(
+        GUID guid,
+        DWORD type_mask,
+        uint64_t const* index_bitset
+    );
+
+    /**
+     * \brief Returns a handle through which a device can be queried.
+     *
+     * Querying a device by handle avoids passing and looking up its GUID on
+     * every call. A handle stays valid for as long as the device remains
+     * connected. Once it disconnects the handle becomes stale, even if the
+     * same device reconnects, in which case a new handle has to be opened.
+     * Handles carry a 24 bit generation of their slot that wraps around to
+     * 1, so a stale handle only becomes valid again, for whichever device
+     * then occupies the slot, after 16777215 further disconnects on that
+     * slot.
+     *
+     * \param guid GUID of the device to open
+     * \return handle of the device, k_invalid_device_handle if no device
+     *         with the given GUID is connected
+     */
+    __declspec(dllexport)
+    uint32_t dill_open_device(GUID guid);
+
+    /**
+     * \brief Returns whether a device handle still refers to its device.
+     *
+     * \param handle handle obtained from dill_open_device
+     * \return true if the device is still connected, false otherwise
+     */
+    __declspec(dllexport)
+    bool device_exists_by_handle(uint32_t handle);
+
+    /**
+     * \brief Returns the DeviceSummary of the device with the given handle.
+     *
+     * \param handle handle obtained from dill_open_device
+     * \return DeviceSummary of the device, an empty one if the handle is
+     *         stale
+     */
+    __declspec(dllexport)
+    DeviceSummary get_device_information_by_handle(uint32_t handle);
+
+    /**
+     * \brief Returns the extended summary of the device with the given
+     *        handle.
+     *
+     * Fills info like get_device_information_ex_by_guid.
+     *
+     * \param handle handle obtained from dill_open_device
+     * \param info receives the extended summary of the device
+     * \return true if the summary was written, false if the handle is stale
+     *         or info is invalid
+     */
+    __declspec(dllexport)
+    bool get_device_information_ex_by_handle(
+        uint32_t                        handle,
+        DeviceSummaryEx*                info
+    );
+
+    /**
+     * \brief Returns the current axis value.
+     *
+     * \param handle handle obtained from dill_open_device
+     * \param index axis index to query (1-32)
+     * \return current axis value of the provided device and axis, 0 if the
+     *         handle is stale
+     */
+    __declspec(dllexport)
+    LONG get_axis_by_handle(uint32_t handle, DWORD index);
+
+    /**
+     * \brief Returns the state of a button on a given device.
+     *
+     * \param handle handle obtained from dill_open_device
+     * \param index 1-based button index (1-128)
+     * \return current state of the queried button, false if the handle is
+     *         stale
+     */
+    __declspec(dllexport)
+    bool get_button_by_handle(uint32_t handle, DWORD index);
+
+    /**
+     * \brief Returns the state of a hat on a given device.
+     *
+     * \param handle handle obtained from dill_open_device
+     * \param index 1-based hat index (1-4)
+     * \return current state of the queried hat, -1 if the handle is stale
+     */
+    __declspec(dllexport)
+    LONG get_hat_by_handle(uint32_t handle, DWORD index);
+
+    /**
+     * \brief Returns the state of all inputs of a device at once.
+     *
+     * \param handle handle obtained from dill_open_device
+     * \param snapshot receives the device's state
+     * \return true if the handle is valid and snapshot was filled, false
+     *         otherwise
+     */
+    __declspec(dllexport)
+    bool get_device_state_by_handle(
+        uint32_t                        handle,
+        DillDeviceSnapshot*             snapshot
+    );
 }
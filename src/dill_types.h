@@ -0,0 +1,259 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#include "button_mask.h"
+#include "platform.h"
+
+
+/**
+ * \brief Computes a 64 bit hash of a GUID.
+ *
+ * Mixes both halves of the GUID through the splitmix64 finalizer, so that
+ * every bit of the GUID affects every bit of the hash. GUIDs of devices of
+ * the same model tend to differ in only a few bits, which a plain XOR fold
+ * maps onto the same or neighbouring buckets.
+ *
+ * \param guid GUID instance to compute the hash of
+ * \return hash value for the provided GUID instance
+ */
+inline uint64_t hash_guid(GUID const& guid)
+{
+    auto mix = [](uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    };
+
+    uint64_t words[2];
+    static_assert(sizeof(GUID) == sizeof(words), "Unexpected GUID size");
+    memcpy(words, &guid, sizeof(GUID));
+    return mix(words[0] ^ mix(words[1] + 0x9E3779B97F4A7C15ULL));
+}
+
+namespace std
+{
+    template<> struct hash<GUID>
+    {
+        /**
+         * \brief Hash computation for GUID instances.
+         *
+         * This has is intended for use with std::unordered_map and as such
+         * is not required to maintain the uniqueness of the GUID.
+         *
+         * \param guid GUID instance to compute the hash of
+         * \return hash value for the provided GUID instance
+         */
+        std::size_t operator()(GUID const& guid) const
+        {
+            return static_cast<std::size_t>(hash_guid(guid));
+        }
+    };
+}
+
+//! Number of axes of a DIJOYSTATE2 report, the largest axis_index.
+constexpr size_t k_max_axes = 32;
+//! Number of axes described by DeviceSummary and DillDeviceSnapshot,
+//! X, Y, Z, Rx, Ry, Rz and the two sliders.
+constexpr size_t k_summary_axes = 8;
+
+//! Selects the axes of a device in a subscription's type mask.
+constexpr DWORD k_subscribe_axes = 0x1;
+//! Selects the buttons of a device in a subscription's type mask.
+constexpr DWORD k_subscribe_buttons = 0x2;
+//! Selects the hats of a device in a subscription's type mask.
+constexpr DWORD k_subscribe_hats = 0x4;
+
+/**
+ * \brief Physical input types available on joysticks.
+ */
+enum class JoystickInputType : UINT8
+{
+    Axis = 1,
+    Button = 2,
+    Hat = 3
+};
+
+/**
+ * \brief Device state change types.
+ */
+enum class DeviceActionType : UINT8
+{
+    Connected = 1,
+    Disconnected = 2
+};
+
+/**
+ * \brief Joystick input event data.
+ *
+ * Stores information about a single joystick input event.
+ */
+struct JoystickInputData
+{
+    GUID                                device_guid;
+    JoystickInputType                   input_type;
+    // In case of an axis this is the axis_index and not the linear_index.
+    UINT8                               input_index;
+    LONG                                value;
+};
+
+//! Layout version of JoystickInputEventEx produced by this build of DILL.
+constexpr uint32_t k_input_event_ex_version = 1;
+
+/**
+ * \brief Joystick input event data with timing information.
+ *
+ * Extends JoystickInputData, which keeps its layout for existing clients.
+ * Later versions only ever append fields, clients can rely on the fields
+ * covered by struct_size.
+ */
+struct JoystickInputEventEx
+{
+    //! sizeof(JoystickInputEventEx) of the DILL build producing the event.
+    uint32_t                            struct_size;
+    //! k_input_event_ex_version of the DILL build producing the event.
+    uint32_t                            version;
+    JoystickInputData                   data;
+    //! DIDEVICEOBJECTDATA::dwTimeStamp in milliseconds of the system tick
+    //! count, 0 for events of polled devices.
+    DWORD                               source_timestamp;
+    //! DIDEVICEOBJECTDATA::dwSequence, ordering events across devices,
+    //! 0 for events of polled devices.
+    DWORD                               source_sequence;
+    //! Time at which DILL read the event from DirectInput, in nanoseconds
+    //! of the monotonic clock returned by dill_get_time_ns.
+    uint64_t                            receive_time_ns;
+};
+
+static_assert(
+    std::is_trivially_copyable<JoystickInputEventEx>::value &&
+    std::is_standard_layout<JoystickInputEventEx>::value,
+    "JoystickInputEventEx has to remain plain data"
+);
+
+/**
+ * \brief Stores axis information.
+ *
+ * Stores the linear and axis index of a single axis.
+ */
+struct AxisMap
+{
+    DWORD                               linear_index;
+    DWORD                               axis_index;
+};
+
+/**
+ * \brief Holds information about the configuration of a single
+ *        joystick device.
+ *
+ * All data required to handle future data from the particular
+ * joystick device.
+ */
+struct DeviceSummary
+{
+    GUID                                device_guid;
+    DWORD                               vendor_id;
+    DWORD                               product_id;
+    DWORD                               joystick_id;
+    char                                name[MAX_PATH];
+    DWORD                               axis_count;
+    DWORD                               button_count;
+    DWORD                               hat_count;
+    AxisMap                             axis_map[k_summary_axes];
+};
+
+//! Layout version of DeviceSummaryEx produced by this build of DILL.
+constexpr uint32_t k_device_summary_ex_version = 1;
+
+/**
+ * \brief Holds information about the configuration of a single joystick
+ *        device, including every axis it reports.
+ *
+ * DeviceSummary, kept as is for existing clients, only describes the axes
+ * with axis_index 1-8. This adds the velocity, acceleration and force axes
+ * and sliders of DIJOYSTATE2, axis_index 9-32 in report order. Later
+ * versions only ever append fields, clients can rely on the fields covered
+ * by struct_size.
+ */
+struct DeviceSummaryEx
+{
+    //! Size of the fields filled by DILL, at most sizeof(DeviceSummaryEx).
+    uint32_t                            struct_size;
+    //! k_device_summary_ex_version of the DILL build filling the struct.
+    uint32_t                            version;
+    //! Compatibility view holding the axes with axis_index 1-8.
+    DeviceSummary                       summary;
+    //! Number of entries of axis_map, covering all axes of the device.
+    DWORD                               axis_count;
+    AxisMap                             axis_map[k_max_axes];
+};
+
+static_assert(
+    std::is_trivially_copyable<DeviceSummaryEx>::value &&
+    std::is_standard_layout<DeviceSummaryEx>::value,
+    "DeviceSummaryEx has to remain plain data"
+);
+
+//! Callback for joystick value change events.
+typedef void (*JoystickInputEventCallback)(JoystickInputData);
+//! Callback for all joystick value change events of a single device wakeup.
+typedef void (*JoystickInputBatchCallback)(JoystickInputData const*, size_t);
+//! Callback for all timestamped input events of a single device wakeup.
+typedef void (*JoystickInputEventExCallback)(
+    JoystickInputEventEx const*,
+    size_t
+);
+//! Callback for device change events.
+typedef void (*DeviceChangeCallback)(DeviceSummary, DeviceActionType);
+
+/**
+ * \brief Represents the current state of a device.
+ */
+struct DeviceState
+{
+    DeviceState()
+    {
+        axis.fill(0);
+        hat.fill(-1);
+    }
+
+    // All inputs are stored 1-based, index 0 is unused.
+    std::array<LONG, k_max_axes + 1>    axis;
+    ButtonMask                          button;
+    std::array<LONG, 5>                 hat;
+};
+
+/**
+ * \brief Complete state of a device at one point in time.
+ *
+ * Plain data meant to be filled by a single call into DILL, see
+ * get_device_state. Inputs are 1-based like in DeviceState.
+ */
+struct DillDeviceSnapshot
+{
+    GUID                                device_guid;
+    //! Increases with every change of any device's state, equal versions
+    //! of the same device imply identical state.
+    uint64_t                            version;
+    //! Bit N-1 of the mask, counting from the lowest bit of the first
+    //! word, is set while button N is pressed, see ButtonMask.
+    uint64_t                            button_mask[2];
+    //! Values of the axes with axis_index 1-8, index 0 is unused. The
+    //! remaining axes are read with get_axis.
+    LONG                                axis[k_summary_axes + 1];
+    //! Hat directions, -1 if centered, index 0 is unused.
+    LONG                                hat[5];
+};
+static_assert(
+    std::is_trivially_copyable<DillDeviceSnapshot>::value &&
+    std::is_standard_layout<DillDeviceSnapshot>::value,
+    "DillDeviceSnapshot has to remain plain data"
+);
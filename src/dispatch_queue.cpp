@@ -0,0 +1,184 @@
+#include "dispatch_queue.h"
+
+#include <algorithm>
+
+#include "event_timing.h"
+
+
+DispatchQueue::DispatchQueue(size_t capacity, DispatchPolicy policy)
+    :   m_policy(policy)
+      , m_entries(std::max<size_t>(capacity, 1))
+{
+    m_stats.capacity = m_entries.size();
+}
+
+void DispatchQueue::push(std::vector<JoystickInputEventEx> const& events)
+{
+    if(events.empty())
+    {
+        return;
+    }
+
+    const uint64_t now = monotonic_time_ns();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for(auto const& evt : events)
+    {
+        bool queued = false;
+        while(!queued)
+        {
+            if(m_closed)
+            {
+                m_stats.dropped += 1;
+                queued = true;
+            }
+            else if(m_tail - m_head < m_entries.size())
+            {
+                entry(m_tail) = Entry{evt, now};
+                m_tail += 1;
+                m_stats.enqueued += 1;
+                queued = true;
+            }
+            else if(m_policy == DispatchPolicy::DropOldest)
+            {
+                m_head += 1;
+                m_stats.dropped += 1;
+            }
+            else if(m_policy == DispatchPolicy::CoalesceAxis && coalesce(evt))
+            {
+                m_stats.coalesced += 1;
+                queued = true;
+            }
+            else
+            {
+                m_stats.blocked += 1;
+                m_not_empty.notify_one();
+                m_not_full.wait(lock);
+            }
+        }
+    }
+    m_stats.max_depth = std::max(m_stats.max_depth, m_tail - m_head);
+    lock.unlock();
+    m_not_empty.notify_one();
+}
+
+void DispatchQueue::push(DeviceSummary const& info, DeviceActionType action)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_closed)
+        {
+            return;
+        }
+        m_changes.push_back(
+            DeviceChange{info, action, m_tail, monotonic_time_ns()}
+        );
+    }
+    m_not_empty.notify_one();
+}
+
+bool DispatchQueue::pop(DispatchBatch& batch)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_empty.wait(lock, [this] {
+        return m_closed || m_head != m_tail || !m_changes.empty();
+    });
+
+    // A device change is due once every event queued before it is taken.
+    if(!m_changes.empty() && m_changes.front().position <= m_head)
+    {
+        auto const& change = m_changes.front();
+        batch.is_device_change = true;
+        batch.events.clear();
+        batch.device = change.info;
+        batch.action = change.action;
+        record_latency(change.enqueue_ns);
+        m_stats.device_changes += 1;
+        m_changes.pop_front();
+        return true;
+    }
+    if(m_head == m_tail)
+    {
+        return false;
+    }
+
+    const uint64_t limit = m_changes.empty()
+        ? m_tail
+        : m_changes.front().position;
+    const GUID guid = entry(m_head).event.data.device_guid;
+    record_latency(entry(m_head).enqueue_ns);
+    batch.is_device_change = false;
+    batch.events.clear();
+    while(m_head < limit && entry(m_head).event.data.device_guid == guid)
+    {
+        batch.events.push_back(entry(m_head).event);
+        m_head += 1;
+    }
+    m_stats.delivered += batch.events.size();
+
+    lock.unlock();
+    m_not_full.notify_one();
+    return true;
+}
+
+void DispatchQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+}
+
+DispatchQueueStats DispatchQueue::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto result = m_stats;
+    result.depth = m_tail - m_head;
+    return result;
+}
+
+DispatchQueue::Entry& DispatchQueue::entry(uint64_t position)
+{
+    return m_entries[position % m_entries.size()];
+}
+
+bool DispatchQueue::coalesce(JoystickInputEventEx const& evt)
+{
+    if(evt.data.input_type != JoystickInputType::Axis)
+    {
+        return false;
+    }
+
+    // Only events queued after the latest device change may be replaced,
+    // the change has to stay between the events it separates.
+    const uint64_t first = m_changes.empty()
+        ? m_head
+        : std::max(m_head, m_changes.back().position);
+    for(uint64_t position=m_tail; position-- > first;)
+    {
+        auto& pending = entry(position).event;
+        if(pending.data.input_type == JoystickInputType::Axis &&
+           pending.data.input_index == evt.data.input_index &&
+           pending.data.device_guid == evt.data.device_guid)
+        {
+            // Keeps the enqueue time so the latency covers the wait of
+            // the slot.
+            pending = evt;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DispatchQueue::record_latency(uint64_t enqueue_ns)
+{
+    const uint64_t now = monotonic_time_ns();
+    if(now > enqueue_ns)
+    {
+        m_stats.max_latency_ns = std::max(
+            m_stats.max_latency_ns,
+            now - enqueue_ns
+        );
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "dill_types.h"
+
+
+/**
+ * \brief Behaviour of a DispatchQueue when events arrive while it is full.
+ */
+enum class DispatchPolicy : uint8_t
+{
+    //! Waits until the dispatch thread has made room, losing nothing.
+    Block = 1,
+    //! Discards the oldest pending input event.
+    DropOldest = 2,
+    //! Overwrites the pending event of the same axis with the new value,
+    //! waits like Block for button and hat events.
+    CoalesceAxis = 3
+};
+
+/**
+ * \brief Counters describing the activity of a DispatchQueue.
+ */
+struct DispatchQueueStats
+{
+    //! Number of input events the queue holds.
+    uint64_t                            capacity;
+    //! Number of input events currently pending.
+    uint64_t                            depth;
+    //! Largest number of input events that were pending at once.
+    uint64_t                            max_depth;
+    //! Number of input events accepted.
+    uint64_t                            enqueued;
+    //! Number of input events handed to the dispatch thread.
+    uint64_t                            delivered;
+    //! Number of pending input events discarded by DropOldest.
+    uint64_t                            dropped;
+    //! Number of input events merged into a pending one by CoalesceAxis.
+    uint64_t                            coalesced;
+    //! Number of times the producer waited for room.
+    uint64_t                            blocked;
+    //! Number of device changes handed to the dispatch thread.
+    uint64_t                            device_changes;
+    //! Longest time an event or device change was pending, in nanoseconds.
+    uint64_t                            max_latency_ns;
+};
+
+/**
+ * \brief Work item taken from a DispatchQueue.
+ */
+struct DispatchBatch
+{
+    //! Whether the item is a device change rather than input events.
+    bool                                is_device_change;
+    //! Events of a single device, in the order they were queued.
+    std::vector<JoystickInputEventEx>   events;
+    //! Device that changed, if is_device_change is set.
+    DeviceSummary                       device;
+    //! How the device changed, if is_device_change is set.
+    DeviceActionType                    action;
+};
+
+
+/**
+ * \brief Bounded queue handing input events and device changes from the
+ *        event loop to a dispatch thread.
+ *
+ * Input events count towards the capacity and are subject to the
+ * DispatchPolicy. Device changes are rare, never dropped and do not count
+ * towards the capacity. Both are taken out in the order they were queued,
+ * so a device's connection precedes its events and its disconnection
+ * follows them. The queue is guarded by a mutex, the dispatch thread and a
+ * producer under the Block policy sleep on condition variables.
+ */
+class DispatchQueue
+{
+public:
+    /**
+     * \brief Creates a new queue.
+     *
+     * \param capacity number of input events the queue holds, at least 1
+     * \param policy behaviour when events arrive while the queue is full
+     */
+    DispatchQueue(size_t capacity, DispatchPolicy policy);
+    DispatchQueue(DispatchQueue const&) = delete;
+    DispatchQueue& operator=(DispatchQueue const&) = delete;
+
+    /**
+     * \brief Queues the events of a single device wakeup.
+     *
+     * May wait for the dispatch thread depending on the policy. Events
+     * arriving after close() are dropped.
+     *
+     * \param events events to queue, in the order they occurred
+     */
+    void push(std::vector<JoystickInputEventEx> const& events);
+
+    /**
+     * \brief Queues a device change behind all previously queued events.
+     *
+     * \param info description of the device
+     * \param action how the device changed
+     */
+    void push(DeviceSummary const& info, DeviceActionType action);
+
+    /**
+     * \brief Takes the next work item, waiting until there is one.
+     *
+     * Consecutive events of the same device are taken together.
+     *
+     * \param batch receives the work item, its event vector is reused
+     * \return true if an item was taken, false if the queue is closed and
+     *         empty
+     */
+    bool pop(DispatchBatch& batch);
+
+    /**
+     * \brief Closes the queue.
+     *
+     * Wakes a waiting producer, whose remaining events are dropped, and
+     * lets pop() return false once the pending items are taken.
+     */
+    void close();
+
+    /**
+     * \brief Returns the counters of the queue.
+     *
+     * \return counters of the queue
+     */
+    DispatchQueueStats stats() const;
+
+private:
+    struct Entry
+    {
+        JoystickInputEventEx            event;
+        uint64_t                        enqueue_ns;
+    };
+
+    struct DeviceChange
+    {
+        DeviceSummary                   info;
+        DeviceActionType                action;
+        //! Position of the first event queued after the change.
+        uint64_t                        position;
+        uint64_t                        enqueue_ns;
+    };
+
+    Entry& entry(uint64_t position);
+    bool coalesce(JoystickInputEventEx const& evt);
+    void record_latency(uint64_t enqueue_ns);
+
+    const DispatchPolicy                m_policy;
+    mutable std::mutex                  m_mutex;
+    std::condition_variable             m_not_empty;
+    std::condition_variable             m_not_full;
+    //! Circular storage of the input events, indexed by position.
+    std::vector<Entry>                  m_entries;
+    //! Positions of the oldest pending and the next queued event, they
+    //! only ever grow.
+    uint64_t                            m_head = 0;
+    uint64_t                            m_tail = 0;
+    std::deque<DeviceChange>            m_changes;
+    bool                                m_closed = false;
+    DispatchQueueStats                  m_stats{};
+};
@@ -0,0 +1,804 @@
+#include "evdev_source.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <system_error>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "event_timing.h"
+
+
+namespace
+{
+    // Maximum number of ready descriptors handled per epoll_wait.
+    const int k_max_ready = 16;
+
+    // Number of records read from a device at once.
+    const size_t k_read_batch_size = 64;
+
+    // DILL axis_index of the six main axes, indexed by ABS_* code.
+    const std::array<UINT8, ABS_RZ + 1> k_main_axes = {1, 2, 3, 4, 5, 6};
+
+    // Axis codes mapped onto the two sliders, in increasing code order.
+    const std::array<uint16_t, 6> k_slider_codes = {
+        ABS_THROTTLE, ABS_RUDDER, ABS_WHEEL, ABS_GAS, ABS_BRAKE, ABS_MISC
+    };
+
+    const UINT8 k_first_slider = 7;
+    const UINT8 k_last_slider = 8;
+
+    const size_t k_max_hats = 4;
+
+    // Number of unsigned longs holding one bit per code up to max_code.
+    constexpr size_t bit_words(size_t max_code)
+    {
+        return max_code / (8 * sizeof(unsigned long)) + 1;
+    }
+
+    bool test_bit(unsigned long const* bits, size_t bit)
+    {
+        const size_t word_bits = 8 * sizeof(unsigned long);
+        return (bits[bit / word_bits] >> (bit % word_bits)) & 1;
+    }
+
+    bool is_hat_code(uint16_t code)
+    {
+        return code >= ABS_HAT0X && code < ABS_HAT0X + 2 * k_max_hats;
+    }
+
+    // Scales a value of the given range onto [-32768, 32767].
+    LONG scale_axis(int32_t value, int32_t minimum, int32_t maximum)
+    {
+        if(maximum <= minimum)
+        {
+            return 0;
+        }
+        const int64_t clamped = std::min<int64_t>(
+            std::max<int64_t>(value, minimum),
+            maximum
+        );
+        return static_cast<LONG>(
+            (clamped - minimum) * 65535 / (int64_t(maximum) - minimum) - 32768
+        );
+    }
+
+    // Converts the sign of a hat's x and y components into a POV direction.
+    LONG hat_direction(int32_t x, int32_t y)
+    {
+        static const LONG directions[3][3] = {
+            // x < 0, x == 0, x > 0
+            {31500,     0,  4500},  // y < 0
+            {27000,    -1,  9000},  // y == 0
+            {22500, 18000, 13500}   // y > 0
+        };
+        const auto column = x < 0 ? 0 : (x == 0 ? 1 : 2);
+        const auto row = y < 0 ? 0 : (y == 0 ? 1 : 2);
+        return directions[row][column];
+    }
+
+    // 64 bit FNV-1a hash of a string, stable across runs.
+    uint64_t hash_string(std::string const& text)
+    {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for(unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 0x100000001B3ULL;
+        }
+        return hash;
+    }
+
+    // Current time in the format of record timestamps, the kernel stamps
+    // records with CLOCK_REALTIME unless asked for another clock.
+    DWORD current_timestamp()
+    {
+        timespec now{};
+        clock_gettime(CLOCK_REALTIME, &now);
+        return static_cast<DWORD>(
+            uint64_t(now.tv_sec) * 1000 + uint64_t(now.tv_nsec) / 1000000
+        );
+    }
+
+    bool set_nonblocking(int fd)
+    {
+        const int flags = fcntl(fd, F_GETFL);
+        return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+}
+
+
+struct EvdevSource::Device
+{
+    int                                 fd = -1;
+    //! Path of the device node, empty for descriptors added directly.
+    std::string                         path;
+    DeviceSummary                       info;
+    //! Whether the sink has been told about the device.
+    bool                                announced = false;
+    //! Whether the sink accepted the device.
+    bool                                tracked = false;
+    //! Whether events are skipped after the kernel dropped some.
+    bool                                dropping = false;
+
+    //! DILL axis_index of each ABS_* code, 0 if unmapped.
+    std::array<UINT8, ABS_CNT>          axis_index{};
+    //! Range of each mapped ABS_* code, including hats.
+    std::array<EvdevAbsAxis, ABS_CNT>   range{};
+    //! DILL button index of each key code, 0 if unmapped.
+    std::array<UINT8, KEY_CNT>          button_index{};
+    //! Last x and y component of each hat.
+    std::array<int32_t, 2 * k_max_hats> hat_components{};
+    //! Values last reported to the sink.
+    DeviceState                         state;
+    //! Events read but not yet handed to the sink.
+    std::vector<JoystickInputEventEx>   events;
+    //! Start of a record split across reads, completed by the next read.
+    std::array<char, sizeof(input_event)> partial{};
+    //! Number of bytes of the split record held in partial.
+    size_t                              partial_size = 0;
+};
+
+
+EvdevSource::EvdevSource()
+{
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(m_epoll_fd == -1)
+    {
+        throw std::system_error(errno, std::generic_category(), "epoll_create1");
+    }
+
+    m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(m_wake_fd == -1)
+    {
+        const int error = errno;
+        close(m_epoll_fd);
+        throw std::system_error(error, std::generic_category(), "eventfd");
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = &m_wake_fd;
+    if(epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &event) == -1)
+    {
+        const int error = errno;
+        close(m_wake_fd);
+        close(m_epoll_fd);
+        throw std::system_error(error, std::generic_category(), "epoll_ctl");
+    }
+}
+
+EvdevSource::~EvdevSource()
+{
+    for(auto const& device : m_devices)
+    {
+        close(device->fd);
+    }
+    if(m_inotify_fd != -1)
+    {
+        close(m_inotify_fd);
+    }
+    close(m_wake_fd);
+    close(m_epoll_fd);
+}
+
+size_t EvdevSource::add_directory(std::string const& directory)
+{
+    m_directory = directory;
+
+    // Watch before scanning so that no device appearing in between is
+    // missed. Devices are often only readable once udev has adjusted their
+    // permissions, hence IN_ATTRIB.
+    if(m_inotify_fd == -1)
+    {
+        m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(m_inotify_fd != -1)
+        {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = &m_inotify_fd;
+            epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_inotify_fd, &event);
+        }
+    }
+    if(m_inotify_fd != -1)
+    {
+        inotify_add_watch(m_inotify_fd, directory.c_str(), IN_CREATE | IN_ATTRIB);
+    }
+
+    DIR* dir = opendir(directory.c_str());
+    if(dir == nullptr)
+    {
+        return 0;
+    }
+
+    std::vector<std::string> paths;
+    while(auto entry = readdir(dir))
+    {
+        if(strncmp(entry->d_name, "event", 5) == 0)
+        {
+            paths.push_back(directory + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(paths.begin(), paths.end());
+    size_t count = 0;
+    for(auto const& path : paths)
+    {
+        count += open_device(path) ? 1 : 0;
+    }
+    return count;
+}
+
+bool EvdevSource::add_device(int fd, EvdevCapabilities const& capabilities)
+{
+    if(!set_nonblocking(fd))
+    {
+        close(fd);
+        return false;
+    }
+
+    auto device = std::make_unique<Device>();
+    device->fd = fd;
+
+    auto& info = device->info;
+    info = DeviceSummary{};
+    info.device_guid = capabilities.guid;
+    info.vendor_id = capabilities.vendor_id;
+    info.product_id = capabilities.product_id;
+    strncpy(info.name, capabilities.name.c_str(), MAX_PATH - 1);
+
+    // Map the axes, main axes keep their fixed index while sliders are
+    // assigned in increasing code order.
+    auto abs_axes = capabilities.abs_axes;
+    std::sort(
+        abs_axes.begin(),
+        abs_axes.end(),
+        [](EvdevAbsAxis const& lhs, EvdevAbsAxis const& rhs) {
+            return lhs.code < rhs.code;
+        }
+    );
+    UINT8 next_slider = k_first_slider;
+    for(auto const& axis : abs_axes)
+    {
+        if(axis.code >= ABS_CNT)
+        {
+            continue;
+        }
+        device->range[axis.code] = axis;
+
+        if(is_hat_code(axis.code))
+        {
+            info.hat_count = std::max<DWORD>(
+                info.hat_count,
+                (axis.code - ABS_HAT0X) / 2 + 1
+            );
+            continue;
+        }
+
+        UINT8 axis_index = 0;
+        if(axis.code < k_main_axes.size())
+        {
+            axis_index = k_main_axes[axis.code];
+        }
+        else if(std::find(
+                    k_slider_codes.begin(),
+                    k_slider_codes.end(),
+                    axis.code
+                ) != k_slider_codes.end() &&
+                next_slider <= k_last_slider)
+        {
+            axis_index = next_slider++;
+        }
+        if(axis_index == 0 || info.axis_count >= 8)
+        {
+            continue;
+        }
+
+        device->axis_index[axis.code] = axis_index;
+        info.axis_map[info.axis_count].linear_index = info.axis_count + 1;
+        info.axis_map[info.axis_count].axis_index = axis_index;
+        ++info.axis_count;
+    }
+
+    auto keys = capabilities.keys;
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    for(auto code : keys)
+    {
+        if(code >= KEY_CNT || info.button_count >= k_max_buttons)
+        {
+            continue;
+        }
+        device->button_index[code] = static_cast<UINT8>(++info.button_count);
+    }
+
+    // Start from the device's current values rather than all zeros, the
+    // resulting events are handed over once the device is announced.
+    resync_device(*device, current_timestamp(), monotonic_time_ns());
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = device.get();
+    if(epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+    {
+        close(fd);
+        return false;
+    }
+    m_devices.push_back(std::move(device));
+    return true;
+}
+
+bool EvdevSource::query_capabilities(
+    int                                 fd,
+    std::string const&                  path,
+    EvdevCapabilities&                  capabilities
+)
+{
+    unsigned long abs_bits[bit_words(ABS_MAX)] = {};
+    unsigned long key_bits[bit_words(KEY_MAX)] = {};
+    input_id id{};
+    if(ioctl(fd, EVIOCGID, &id) < 0 ||
+       ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs_bits)), abs_bits) < 0 ||
+       ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) < 0)
+    {
+        return false;
+    }
+
+    // Only consider devices looking like joysticks or gamepads, following
+    // the kernel's joydev driver: an X axis or a joystick button, but no
+    // touchpads and touchscreens (BTN_TOUCH), tablets (BTN_DIGI) or
+    // accelerometers. Kernels without EVIOCGPROP report no properties.
+    unsigned long prop_bits[bit_words(INPUT_PROP_MAX)] = {};
+    (void)ioctl(fd, EVIOCGPROP(sizeof(prop_bits)), prop_bits);
+    bool is_joystick = test_bit(abs_bits, ABS_X);
+    for(size_t code=BTN_JOYSTICK; code<BTN_DIGI; ++code)
+    {
+        is_joystick |= test_bit(key_bits, code);
+    }
+    if(!is_joystick ||
+       test_bit(key_bits, BTN_TOUCH) ||
+       test_bit(key_bits, BTN_DIGI) ||
+       test_bit(prop_bits, INPUT_PROP_ACCELEROMETER))
+    {
+        return false;
+    }
+
+    capabilities = EvdevCapabilities{};
+    capabilities.vendor_id = id.vendor;
+    capabilities.product_id = id.product;
+
+    char text[MAX_PATH] = {};
+    if(ioctl(fd, EVIOCGNAME(sizeof(text) - 1), text) >= 0)
+    {
+        capabilities.name = text;
+    }
+
+    // Identify the node by its device's serial number, the port it is
+    // connected to and its name, so that it keeps its GUID across
+    // reconnects. The nodes of one physical device, such as a gamepad's
+    // touchpad and motion sensor nodes, share serial number and port but
+    // not their name. Nodes lacking both fall back to their path.
+    std::string uniq;
+    memset(text, 0, sizeof(text));
+    if(ioctl(fd, EVIOCGUNIQ(sizeof(text) - 1), text) >= 0)
+    {
+        uniq = text;
+    }
+    std::string phys;
+    memset(text, 0, sizeof(text));
+    if(ioctl(fd, EVIOCGPHYS(sizeof(text) - 1), text) >= 0)
+    {
+        phys = text;
+    }
+    std::string identity = uniq + '\n' + phys + '\n' + capabilities.name;
+    if(uniq.empty() && phys.empty())
+    {
+        identity += '\n' + path;
+    }
+    const uint64_t identity_hash = hash_string(identity);
+    capabilities.guid.Data1 = (DWORD(id.vendor) << 16) | id.product;
+    capabilities.guid.Data2 = id.bustype;
+    capabilities.guid.Data3 = id.version;
+    memcpy(capabilities.guid.Data4, &identity_hash, sizeof(identity_hash));
+
+    for(uint16_t code=0; code<ABS_CNT; ++code)
+    {
+        input_absinfo absinfo{};
+        if(test_bit(abs_bits, code) &&
+           ioctl(fd, EVIOCGABS(code), &absinfo) >= 0)
+        {
+            capabilities.abs_axes.push_back(
+                {code, absinfo.minimum, absinfo.maximum}
+            );
+        }
+    }
+    for(uint16_t code=BTN_MISC; code<KEY_CNT; ++code)
+    {
+        if(test_bit(key_bits, code))
+        {
+            capabilities.keys.push_back(code);
+        }
+    }
+    return true;
+}
+
+bool EvdevSource::process(InputSink& sink, std::chrono::milliseconds timeout)
+{
+    announce_devices(sink);
+
+    epoll_event ready[k_max_ready];
+    const int count = epoll_wait(
+        m_epoll_fd,
+        ready,
+        k_max_ready,
+        static_cast<int>(timeout.count())
+    );
+    if(count == -1)
+    {
+        return errno == EINTR;
+    }
+
+    for(int i=0; i<count; ++i)
+    {
+        if(ready[i].data.ptr == &m_wake_fd)
+        {
+            uint64_t value;
+            while(read(m_wake_fd, &value, sizeof(value)) > 0)
+            {
+            }
+            continue;
+        }
+        if(ready[i].data.ptr == &m_inotify_fd)
+        {
+            process_hotplug();
+            continue;
+        }
+
+        // Read whatever is still pending before dropping a device that
+        // hung up.
+        auto device = static_cast<Device*>(ready[i].data.ptr);
+        const bool is_alive = read_device(*device) &&
+            (ready[i].events & (EPOLLHUP | EPOLLERR)) == 0;
+        if(device->tracked && !device->events.empty())
+        {
+            sink.input_events(device->info.device_guid, device->events);
+        }
+        device->events.clear();
+        if(!is_alive)
+        {
+            // A device is reported at most once per epoll_wait, so removing
+            // it leaves the remaining ready entries valid.
+            remove_device(sink, device);
+        }
+    }
+
+    announce_devices(sink);
+    return true;
+}
+
+void EvdevSource::wake()
+{
+    const uint64_t value = 1;
+    (void)write(m_wake_fd, &value, sizeof(value));
+}
+
+bool EvdevSource::open_device(std::string const& path)
+{
+    for(auto const& device : m_devices)
+    {
+        if(device->path == path)
+        {
+            return false;
+        }
+    }
+
+    const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if(fd == -1)
+    {
+        return false;
+    }
+    EvdevCapabilities capabilities;
+    if(!query_capabilities(fd, path, capabilities))
+    {
+        close(fd);
+        return false;
+    }
+    if(!add_device(fd, capabilities))
+    {
+        return false;
+    }
+    m_devices.back()->path = path;
+    return true;
+}
+
+bool EvdevSource::read_device(Device& device)
+{
+    input_event records[k_read_batch_size];
+    char* const buffer = reinterpret_cast<char*>(records);
+    for(;;)
+    {
+        // Device nodes only return whole records, other descriptors such
+        // as pipes may split one across reads. Its start is kept and put
+        // in front of the bytes read next.
+        std::memcpy(buffer, device.partial.data(), device.partial_size);
+        const size_t capacity = sizeof(records) - device.partial_size;
+        const ssize_t size = read(
+            device.fd,
+            buffer + device.partial_size,
+            capacity
+        );
+        if(size == -1)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if(size == 0)
+        {
+            return false;
+        }
+
+        const uint64_t receive_time = monotonic_time_ns();
+        const size_t available = device.partial_size + size;
+        const size_t record_count = available / sizeof(input_event);
+        device.partial_size = available % sizeof(input_event);
+        std::memcpy(
+            device.partial.data(),
+            buffer + record_count * sizeof(input_event),
+            device.partial_size
+        );
+        for(size_t i=0; i<record_count; ++i)
+        {
+            auto const& record = records[i];
+            const DWORD timestamp = static_cast<DWORD>(
+                uint64_t(record.input_event_sec) * 1000 +
+                uint64_t(record.input_event_usec) / 1000
+            );
+
+            // After SYN_DROPPED the kernel lost events, skip everything up
+            // to the next report as it is incomplete and then query the
+            // current state instead.
+            if(record.type == EV_SYN && record.code == SYN_DROPPED)
+            {
+                device.dropping = true;
+            }
+            else if(record.type == EV_SYN && record.code == SYN_REPORT)
+            {
+                if(device.dropping)
+                {
+                    device.dropping = false;
+                    resync_device(device, timestamp, receive_time);
+                }
+            }
+            else if(device.dropping)
+            {
+                continue;
+            }
+            else if(record.type == EV_ABS)
+            {
+                apply_abs(
+                    device,
+                    record.code,
+                    record.value,
+                    timestamp,
+                    receive_time
+                );
+            }
+            else if(record.type == EV_KEY)
+            {
+                apply_key(
+                    device,
+                    record.code,
+                    record.value,
+                    timestamp,
+                    receive_time
+                );
+            }
+        }
+
+        if(static_cast<size_t>(size) < capacity)
+        {
+            return true;
+        }
+    }
+}
+
+void EvdevSource::resync_device(
+    Device&                             device,
+    DWORD                               timestamp,
+    uint64_t                            receive_time
+)
+{
+    // Descriptors other than device nodes, e.g. pipes, cannot be queried.
+    unsigned long key_bits[bit_words(KEY_MAX)] = {};
+    if(ioctl(device.fd, EVIOCGKEY(sizeof(key_bits)), key_bits) >= 0)
+    {
+        for(uint16_t code=0; code<KEY_CNT; ++code)
+        {
+            if(device.button_index[code] != 0)
+            {
+                const int32_t value = test_bit(key_bits, code) ? 1 : 0;
+                apply_key(device, code, value, timestamp, receive_time);
+            }
+        }
+    }
+    for(uint16_t code=0; code<ABS_CNT; ++code)
+    {
+        if(device.axis_index[code] == 0 && !is_hat_code(code))
+        {
+            continue;
+        }
+        input_absinfo absinfo{};
+        if(ioctl(device.fd, EVIOCGABS(code), &absinfo) >= 0)
+        {
+            apply_abs(device, code, absinfo.value, timestamp, receive_time);
+        }
+    }
+}
+
+void EvdevSource::apply_abs(
+    Device&                             device,
+    uint16_t                            code,
+    int32_t                             value,
+    DWORD                               timestamp,
+    uint64_t                            receive_time
+)
+{
+    if(code >= ABS_CNT)
+    {
+        return;
+    }
+
+    JoystickInputData evt;
+    evt.device_guid = device.info.device_guid;
+    if(is_hat_code(code))
+    {
+        const size_t component = code - ABS_HAT0X;
+        const size_t hat = component / 2 + 1;
+        if(hat > device.info.hat_count)
+        {
+            return;
+        }
+        device.hat_components[component] = value;
+        evt.input_type = JoystickInputType::Hat;
+        evt.input_index = static_cast<UINT8>(hat);
+        evt.value = hat_direction(
+            device.hat_components[2 * (hat - 1)],
+            device.hat_components[2 * (hat - 1) + 1]
+        );
+        if(device.state.hat[hat] == evt.value)
+        {
+            return;
+        }
+        device.state.hat[hat] = evt.value;
+    }
+    else
+    {
+        const auto axis_index = device.axis_index[code];
+        if(axis_index == 0)
+        {
+            return;
+        }
+        auto const& range = device.range[code];
+        evt.input_type = JoystickInputType::Axis;
+        evt.input_index = axis_index;
+        evt.value = scale_axis(value, range.minimum, range.maximum);
+        if(device.state.axis[axis_index] == evt.value)
+        {
+            return;
+        }
+        device.state.axis[axis_index] = evt.value;
+    }
+
+    device.events.push_back(
+        make_input_event_ex(evt, timestamp, ++m_sequence, receive_time)
+    );
+}
+
+void EvdevSource::apply_key(
+    Device&                             device,
+    uint16_t                            code,
+    int32_t                             value,
+    DWORD                               timestamp,
+    uint64_t                            receive_time
+)
+{
+    // Value 2 marks autorepeat, which does not change the state.
+    if(code >= KEY_CNT || device.button_index[code] == 0 || value == 2)
+    {
+        return;
+    }
+
+    const auto button = device.button_index[code];
+    const bool is_pressed = value != 0;
+    if(device.state.button.test(button) == is_pressed)
+    {
+        return;
+    }
+    device.state.button.set(button, is_pressed);
+
+    JoystickInputData evt;
+    evt.device_guid = device.info.device_guid;
+    evt.input_type = JoystickInputType::Button;
+    evt.input_index = button;
+    evt.value = is_pressed;
+    device.events.push_back(
+        make_input_event_ex(evt, timestamp, ++m_sequence, receive_time)
+    );
+}
+
+void EvdevSource::process_hotplug()
+{
+    alignas(inotify_event) char buffer[4096];
+    for(;;)
+    {
+        const ssize_t size = read(m_inotify_fd, buffer, sizeof(buffer));
+        if(size <= 0)
+        {
+            return;
+        }
+        for(ssize_t offset=0; offset<size; )
+        {
+            auto const* event =
+                reinterpret_cast<inotify_event const*>(buffer + offset);
+            if(event->len > 0 && strncmp(event->name, "event", 5) == 0)
+            {
+                open_device(m_directory + "/" + event->name);
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+void EvdevSource::announce_devices(InputSink& sink)
+{
+    for(auto const& device : m_devices)
+    {
+        if(!device->announced)
+        {
+            device->announced = true;
+            device->tracked = sink.device_added(device->info);
+            if(device->tracked && !device->events.empty())
+            {
+                sink.input_events(device->info.device_guid, device->events);
+            }
+            device->events.clear();
+        }
+    }
+}
+
+void EvdevSource::remove_device(InputSink& sink, Device* device)
+{
+    auto it = std::find_if(
+        m_devices.begin(),
+        m_devices.end(),
+        [device](std::unique_ptr<Device> const& entry) {
+            return entry.get() == device;
+        }
+    );
+    if(it == m_devices.end())
+    {
+        return;
+    }
+
+    if(device->tracked)
+    {
+        sink.device_removed(device->info.device_guid);
+    }
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, device->fd, nullptr);
+    close(device->fd);
+    m_devices.erase(it);
+}
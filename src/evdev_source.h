@@ -0,0 +1,154 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dill_types.h"
+#include "input_source.h"
+
+
+/**
+ * \brief Code and value range of an absolute axis of an evdev device.
+ */
+struct EvdevAbsAxis
+{
+    //! ABS_* code of the axis.
+    uint16_t                            code;
+    int32_t                             minimum;
+    int32_t                             maximum;
+};
+
+/**
+ * \brief Describes an evdev device and the inputs it reports.
+ */
+struct EvdevCapabilities
+{
+    GUID                                guid;
+    std::string                         name;
+    DWORD                               vendor_id;
+    DWORD                               product_id;
+    //! Absolute axes reported by the device, including ABS_HAT* codes.
+    std::vector<EvdevAbsAxis>           abs_axes;
+    //! KEY_* and BTN_* codes reported by the device.
+    std::vector<uint16_t>               keys;
+};
+
+
+/**
+ * \brief InputSource reading Linux evdev devices.
+ *
+ * Waits on all devices with a single epoll instance and reads their
+ * struct input_event records in batches. Inputs are mapped onto DILL's
+ * model as follows:
+ *  - ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY and ABS_RZ are axes 1 to 6, the
+ *    first two of ABS_THROTTLE, ABS_RUDDER, ABS_WHEEL, ABS_GAS, ABS_BRAKE
+ *    and ABS_MISC are the slider axes 7 and 8. Values are scaled from the
+ *    axis' range onto the [-32768, 32767] range DILL uses for DirectInput.
+ *  - Each ABS_HAT<n>X / ABS_HAT<n>Y pair forms hat n + 1, reported in
+ *    hundredths of degrees like DirectInput's POV values.
+ *  - Key codes are buttons 1 to 128 in increasing code order.
+ *
+ * Source timestamps are the kernel's event time in milliseconds, truncated
+ * to 32 bits, and sequence numbers count the events of all devices.
+ *
+ * Devices are added either from a directory such as /dev/input, which is
+ * then watched for new devices, or as an already open file descriptor with
+ * explicitly described capabilities. The current values of a device's keys
+ * and axes are queried when it is added and reported right after it.
+ * Devices disappear once reading them fails or their descriptor reaches
+ * end of file.
+ *
+ * Devices must only be added while process is not running concurrently.
+ */
+class EvdevSource : public InputSource
+{
+public:
+    /**
+     * \brief Creates a source without any devices.
+     *
+     * \throws std::system_error if the epoll instance cannot be created
+     */
+    EvdevSource();
+    ~EvdevSource() override;
+    EvdevSource(EvdevSource const&) = delete;
+    EvdevSource& operator=(EvdevSource const&) = delete;
+
+    /**
+     * \brief Adds all joysticks in a directory and watches it for new ones.
+     *
+     * \param directory directory holding evdev device nodes
+     * \return number of devices added
+     */
+    size_t add_directory(std::string const& directory = "/dev/input");
+
+    /**
+     * \brief Adds a device from an open file descriptor.
+     *
+     * The descriptor is switched to non-blocking mode and closed by the
+     * source once the device is removed. It may refer to anything yielding
+     * struct input_event records, e.g. a pipe in tests. Records split
+     * across reads are reassembled.
+     *
+     * \param fd file descriptor to read from, owned by the source
+     * \param capabilities description of the device
+     * \return true if the device was added, false if fd was closed
+     */
+    bool add_device(int fd, EvdevCapabilities const& capabilities);
+
+    /**
+     * \brief Queries the capabilities of an evdev device node.
+     *
+     * \param fd file descriptor of the opened device node
+     * \param path path of the device node, identifies devices lacking a
+     *        unique id
+     * \param capabilities set to the device's capabilities
+     * \return true if the device is a joystick, false otherwise
+     */
+    static bool query_capabilities(
+        int                             fd,
+        std::string const&              path,
+        EvdevCapabilities&              capabilities
+    );
+
+    bool process(InputSink& sink, std::chrono::milliseconds timeout) override;
+    void wake() override;
+
+private:
+    struct Device;
+
+    bool open_device(std::string const& path);
+    bool read_device(Device& device);
+    void resync_device(
+        Device&                         device,
+        DWORD                           timestamp,
+        uint64_t                        receive_time
+    );
+    void apply_abs(
+        Device&                         device,
+        uint16_t                        code,
+        int32_t                         value,
+        DWORD                           timestamp,
+        uint64_t                        receive_time
+    );
+    void apply_key(
+        Device&                         device,
+        uint16_t                        code,
+        int32_t                         value,
+        DWORD                           timestamp,
+        uint64_t                        receive_time
+    );
+    void process_hotplug();
+    void announce_devices(InputSink& sink);
+    void remove_device(InputSink& sink, Device* device);
+
+    int                                 m_epoll_fd = -1;
+    int                                 m_wake_fd = -1;
+    int                                 m_inotify_fd = -1;
+    std::string                         m_directory;
+    std::vector<std::unique_ptr<Device>> m_devices;
+    //! Sequence number of the last event read from any device.
+    DWORD                               m_sequence = 0;
+};
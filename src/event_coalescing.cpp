@@ -0,0 +1,54 @@
+#include "event_coalescing.h"
+
+#include <bitset>
+
+
+CoalescingStats coalesce_input_events(
+    std::vector<JoystickInputEventEx>&  events
+)
+{
+    CoalescingStats stats{};
+    stats.received = events.size();
+    if(events.size() < 2)
+    {
+        return stats;
+    }
+
+    // Walk backwards so the first occurrence seen of an input is its last
+    // one, moving kept events towards the end to preserve their order.
+    const GUID guid = events.front().data.device_guid;
+    std::bitset<256> axis_seen;
+    std::bitset<256> hat_seen;
+    size_t out = events.size();
+    for(size_t i=events.size(); i-- > 0;)
+    {
+        auto const& evt = events[i].data;
+        bool keep = true;
+        if(evt.device_guid == guid)
+        {
+            if(evt.input_type == JoystickInputType::Axis)
+            {
+                keep = !axis_seen.test(evt.input_index);
+                axis_seen.set(evt.input_index);
+                stats.coalesced_axis += keep ? 0 : 1;
+            }
+            else if(evt.input_type == JoystickInputType::Hat)
+            {
+                keep = !hat_seen.test(evt.input_index);
+                hat_seen.set(evt.input_index);
+                stats.coalesced_hat += keep ? 0 : 1;
+            }
+        }
+
+        if(keep)
+        {
+            --out;
+            if(out != i)
+            {
+                events[out] = events[i];
+            }
+        }
+    }
+    events.erase(events.begin(), events.begin() + out);
+    return stats;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "dill_types.h"
+
+
+/**
+ * \brief Counters describing the effect of event coalescing.
+ */
+struct CoalescingStats
+{
+    //! Number of events seen while coalescing was enabled.
+    uint64_t                            received;
+    //! Number of axis events dropped in favour of a later value.
+    uint64_t                            coalesced_axis;
+    //! Number of hat events dropped in favour of a later value.
+    uint64_t                            coalesced_hat;
+};
+
+
+/**
+ * \brief Removes axis and hat events superseded within a batch.
+ *
+ * Of several events of the same axis or hat only the last one is kept, at
+ * its position in the batch. Button events are never removed, so every
+ * press and release survives. Only events of the batch's first device are
+ * coalesced, which covers batches of a single device wakeup.
+ *
+ * \param events events of a single device wakeup, coalesced in place
+ * \return number of events received and removed
+ */
+CoalescingStats coalesce_input_events(
+    std::vector<JoystickInputEventEx>&  events
+);
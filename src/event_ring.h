@@ -0,0 +1,291 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+
+/**
+ * \brief Behaviour of an EventRing when an event is pushed while it is full.
+ */
+enum class RingOverflowPolicy : uint8_t
+{
+    //! Discards the oldest unread event to make room for the new one.
+    DropOldest = 1,
+    //! Discards the event being pushed, keeping the unread ones.
+    DropNewest = 2
+};
+
+/**
+ * \brief Counters describing the activity of an EventRing.
+ */
+struct EventRingStats
+{
+    //! Number of slots in the ring.
+    uint64_t                            capacity;
+    //! Number of events accepted by push().
+    uint64_t                            pushed;
+    //! Number of events handed to readers by pop().
+    uint64_t                            read;
+    //! Number of pushes that found the ring full.
+    uint64_t                            overflows;
+    //! Number of unread events discarded to make room for newer ones.
+    uint64_t                            dropped_oldest;
+    //! Number of pushed events discarded because the ring was full.
+    uint64_t                            dropped_newest;
+};
+
+
+/**
+ * \brief Bounded lock-free event queue with a single producer.
+ *
+ * Events are pushed by a single producer thread and may be popped from any
+ * number of threads concurrently. Each slot carries a sequence number which
+ * hands ownership of the slot back and forth between the producer and the
+ * readers, so neither side ever blocks the other.
+ *
+ * When the ring is full the configured RingOverflowPolicy decides which
+ * event is lost. Under DropOldest the producer discards the oldest unread
+ * event itself, acting as a reader. Should a reader be in the middle of
+ * consuming the very slot needed, the producer does not wait for it and
+ * drops the new event instead.
+ *
+ * \tparam T trivially copyable event type
+ */
+template<typename T>
+class EventRing
+{
+    static_assert(
+        std::is_trivially_copyable<T>::value,
+        "EventRing requires a trivially copyable event type"
+    );
+
+public:
+    //! Largest capacity a ring can be asked for, the largest power of two
+    //! a size_t holds.
+    static constexpr size_t k_max_capacity =
+        (std::numeric_limits<size_t>::max() >> 1) + 1;
+
+    /**
+     * \brief Creates a new ring.
+     *
+     * \param capacity minimum number of events the ring can hold, rounded
+     *        up to the next power of two
+     * \param policy behaviour when pushing into a full ring
+     * \throws std::length_error if capacity exceeds k_max_capacity
+     */
+    EventRing(size_t capacity, RingOverflowPolicy policy)
+        :   m_capacity(round_up_capacity(capacity))
+          , m_mask(m_capacity - 1)
+          , m_policy(policy)
+          , m_slots(new Slot[m_capacity])
+    {
+        for(size_t i=0; i<m_capacity; ++i)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    EventRing(EventRing const&) = delete;
+    EventRing& operator=(EventRing const&) = delete;
+
+    /**
+     * \brief Adds an event to the ring.
+     *
+     * Must only be called from the single producer thread.
+     *
+     * \param value event to add
+     * \return true if the event was stored, false if it was dropped
+     */
+    bool push(T const& value)
+    {
+        if(try_push(value))
+        {
+            return true;
+        }
+
+        m_overflows.fetch_add(1, std::memory_order_relaxed);
+        if(m_policy == RingOverflowPolicy::DropOldest)
+        {
+            T discarded;
+            if(try_pop(discarded))
+            {
+                m_dropped_oldest.fetch_add(1, std::memory_order_relaxed);
+                if(try_push(value))
+                {
+                    return true;
+                }
+            }
+        }
+
+        m_dropped_newest.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * \brief Returns whether the next push stores its event.
+     *
+     * Must only be called from the single producer thread. Readers only
+     * ever free slots, so the answer holds until the producer pushes.
+     *
+     * \return true if the ring has a free slot, false if it is full
+     */
+    bool can_push() const
+    {
+        const size_t pos = m_write_pos.load(std::memory_order_relaxed);
+        return m_slots[pos & m_mask].sequence.load(
+            std::memory_order_acquire
+        ) == pos;
+    }
+
+    /**
+     * \brief Removes up to max events from the ring.
+     *
+     * Safe to call from any number of threads concurrently.
+     *
+     * \param out array receiving the events in the order they were pushed
+     * \param max maximum number of events to write to out
+     * \return number of events written to out
+     */
+    size_t pop(T* out, size_t max)
+    {
+        size_t count = 0;
+        while(count < max && try_pop(out[count]))
+        {
+            ++count;
+        }
+        if(count > 0)
+        {
+            m_read.fetch_add(count, std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    /**
+     * \brief Returns the number of slots in the ring.
+     *
+     * \return ring capacity
+     */
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    /**
+     * \brief Returns a snapshot of the ring's counters.
+     *
+     * Each counter is read atomically, the set of counters as a whole is
+     * not a consistent snapshot while the ring is in use.
+     *
+     * \return current counter values
+     */
+    EventRingStats stats() const
+    {
+        EventRingStats result;
+        result.capacity = m_capacity;
+        result.pushed = m_pushed.load(std::memory_order_relaxed);
+        result.read = m_read.load(std::memory_order_relaxed);
+        result.overflows = m_overflows.load(std::memory_order_relaxed);
+        result.dropped_oldest = m_dropped_oldest.load(std::memory_order_relaxed);
+        result.dropped_newest = m_dropped_newest.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    // Size of a cache line, used to keep the producer and reader positions
+    // from sharing one.
+    static constexpr size_t k_cache_line = 64;
+
+    struct alignas(k_cache_line) Slot
+    {
+        // Equals the slot's write position when it is free to be written
+        // and the write position + 1 once it holds an unread event.
+        std::atomic<size_t>             sequence;
+        T                               value;
+    };
+
+    static size_t round_up_capacity(size_t capacity)
+    {
+        // Rounding up any larger capacity would overflow.
+        if(capacity > k_max_capacity)
+        {
+            throw std::length_error("EventRing capacity too large");
+        }
+
+        size_t result = 2;
+        while(result < capacity)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    bool try_push(T const& value)
+    {
+        const size_t pos = m_write_pos.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[pos & m_mask];
+        if(slot.sequence.load(std::memory_order_acquire) != pos)
+        {
+            return false;
+        }
+
+        slot.value = value;
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        m_write_pos.store(pos + 1, std::memory_order_relaxed);
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool try_pop(T& value)
+    {
+        size_t pos = m_read_pos.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            Slot& slot = m_slots[pos & m_mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+            if(diff == 0)
+            {
+                if(m_read_pos.compare_exchange_weak(
+                    pos,
+                    pos + 1,
+                    std::memory_order_relaxed
+                ))
+                {
+                    value = slot.value;
+                    slot.sequence.store(
+                        pos + m_capacity,
+                        std::memory_order_release
+                    );
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_read_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    const size_t                        m_capacity;
+    const size_t                        m_mask;
+    const RingOverflowPolicy            m_policy;
+    std::unique_ptr<Slot[]>             m_slots;
+
+    alignas(k_cache_line) std::atomic<size_t> m_write_pos{0};
+    alignas(k_cache_line) std::atomic<size_t> m_read_pos{0};
+
+    alignas(k_cache_line) std::atomic<uint64_t> m_pushed{0};
+    std::atomic<uint64_t>               m_overflows{0};
+    std::atomic<uint64_t>               m_dropped_oldest{0};
+    std::atomic<uint64_t>               m_dropped_newest{0};
+    alignas(k_cache_line) std::atomic<uint64_t> m_read{0};
+};
@@ -0,0 +1,55 @@
+#include "event_timing.h"
+
+#include <chrono>
+
+
+uint64_t monotonic_time_ns()
+{
+    // steady_clock is backed by QueryPerformanceCounter on Windows.
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count()
+    );
+}
+
+JoystickInputEventEx make_input_event_ex(
+    JoystickInputData const&            data,
+    DWORD                               source_timestamp,
+    DWORD                               source_sequence,
+    uint64_t                            receive_time_ns
+)
+{
+    JoystickInputEventEx evt;
+    evt.struct_size = sizeof(JoystickInputEventEx);
+    evt.version = k_input_event_ex_version;
+    evt.data = data;
+    evt.source_timestamp = source_timestamp;
+    evt.source_sequence = source_sequence;
+    evt.receive_time_ns = receive_time_ns;
+    return evt;
+}
+
+void append_polled_events(
+    std::vector<JoystickInputData> const& changes,
+    uint64_t                            receive_time_ns,
+    std::vector<JoystickInputEventEx>&  events
+)
+{
+    for(auto const& change : changes)
+    {
+        events.push_back(make_input_event_ex(change, 0, 0, receive_time_ns));
+    }
+}
+
+void to_legacy_events(
+    std::vector<JoystickInputEventEx> const& events,
+    std::vector<JoystickInputData>&     legacy
+)
+{
+    legacy.clear();
+    for(auto const& evt : events)
+    {
+        legacy.push_back(evt.data);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "dill_types.h"
+
+
+/**
+ * \brief Returns the current time of DILL's monotonic clock.
+ *
+ * All receive timestamps of JoystickInputEventEx are taken from this clock,
+ * which never jumps and is shared by all devices.
+ *
+ * \return nanoseconds since an unspecified, fixed point in time
+ */
+uint64_t monotonic_time_ns();
+
+/**
+ * \brief Wraps an event with its timing information.
+ *
+ * \param data decoded event
+ * \param source_timestamp timestamp DirectInput reported for the event
+ * \param source_sequence sequence number DirectInput reported for the event
+ * \param receive_time_ns time at which the event was read
+ * \return extended event of the current layout version
+ */
+JoystickInputEventEx make_input_event_ex(
+    JoystickInputData const&            data,
+    DWORD                               source_timestamp,
+    DWORD                               source_sequence,
+    uint64_t                            receive_time_ns
+);
+
+/**
+ * \brief Appends the events produced from a single polled report.
+ *
+ * Polled reports carry no DirectInput timing, so all events share the
+ * time at which the report was read and have no source timestamp or
+ * sequence number.
+ *
+ * \param changes events produced by diffing the report
+ * \param receive_time_ns time at which the report was read
+ * \param events receives one extended event per change
+ */
+void append_polled_events(
+    std::vector<JoystickInputData> const& changes,
+    uint64_t                            receive_time_ns,
+    std::vector<JoystickInputEventEx>&  events
+);
+
+/**
+ * \brief Strips the timing information from extended events.
+ *
+ * \param events extended events to convert
+ * \param legacy replaced with the events' JoystickInputData, in order
+ */
+void to_legacy_events(
+    std::vector<JoystickInputEventEx> const& events,
+    std::vector<JoystickInputData>&     legacy
+);
@@ -0,0 +1,483 @@
+#include "input_dispatcher.h"
+
+#include <algorithm>
+
+#include "event_timing.h"
+
+
+namespace
+{
+    // Number of events read_events pops from the ring at once.
+    const size_t k_read_chunk_size = 64;
+}
+
+
+InputDispatcher::InputDispatcher()
+    :   m_device_latency(std::make_unique<DeviceLatencyTable>())
+{
+    for(auto& entry : *m_device_latency)
+    {
+        entry.guid = GUID{};
+        entry.used = false;
+    }
+}
+
+InputDispatcher::~InputDispatcher()
+{
+    stop();
+}
+
+void InputDispatcher::set_event_callback(JoystickInputEventCallback cb)
+{
+    m_event_callback = cb;
+}
+
+void InputDispatcher::set_batch_callback(JoystickInputBatchCallback cb)
+{
+    m_batch_callback = cb;
+}
+
+void InputDispatcher::set_event_ex_callback(JoystickInputEventExCallback cb)
+{
+    m_event_ex_callback = cb;
+}
+
+void InputDispatcher::set_device_change_callback(DeviceChangeCallback cb)
+{
+    m_device_change_callback = cb;
+}
+
+void InputDispatcher::set_coalescing(bool enabled)
+{
+    m_coalescing = enabled;
+}
+
+CoalescingStats InputDispatcher::coalescing_stats() const
+{
+    CoalescingStats result;
+    result.received = m_coalescing_received.load(std::memory_order_relaxed);
+    result.coalesced_axis = m_coalesced_axis.load(std::memory_order_relaxed);
+    result.coalesced_hat = m_coalesced_hat.load(std::memory_order_relaxed);
+    return result;
+}
+
+LatencySummary InputDispatcher::callback_latency(LatencyStage stage) const
+{
+    switch(stage)
+    {
+        case LatencyStage::CallbackEntry:
+            return m_entry_latency.summary();
+        case LatencyStage::CallbackExit:
+            return m_exit_latency.summary();
+        default:
+            return LatencySummary{};
+    }
+}
+
+bool InputDispatcher::device_latency(
+    GUID const&                         guid,
+    LatencySummary&                     summary
+) const
+{
+    std::lock_guard<std::mutex> lock(m_device_latency_mutex);
+    for(auto const& entry : *m_device_latency)
+    {
+        if(entry.used && entry.guid == guid)
+        {
+            summary = entry.exit.summary();
+            return true;
+        }
+    }
+    return false;
+}
+
+CallbackStats InputDispatcher::callback_stats() const
+{
+    CallbackStats result;
+    result.invocations = m_callback_invocations.load(
+        std::memory_order_relaxed
+    );
+    result.total_time_ns = m_callback_time_ns.load(std::memory_order_relaxed);
+    return result;
+}
+
+void InputDispatcher::configure_ring(size_t capacity, RingOverflowPolicy policy)
+{
+    if(capacity == 0)
+    {
+        m_ring.reset();
+    }
+    else
+    {
+        m_ring = std::make_unique<EventRing<JoystickInputEventEx>>(
+            capacity,
+            policy
+        );
+    }
+}
+
+size_t InputDispatcher::ring_capacity() const
+{
+    return m_ring != nullptr ? m_ring->capacity() : 0;
+}
+
+size_t InputDispatcher::read_events(JoystickInputData* out, size_t max)
+{
+    if(m_ring == nullptr || out == nullptr)
+    {
+        return 0;
+    }
+
+    // Pop in chunks so that the timing information can be dropped without
+    // allocating.
+    JoystickInputEventEx chunk[k_read_chunk_size];
+    size_t count = 0;
+    while(count < max)
+    {
+        const size_t requested = std::min(max - count, k_read_chunk_size);
+        const size_t popped = m_ring->pop(chunk, requested);
+        for(size_t i=0; i<popped; ++i)
+        {
+            out[count + i] = chunk[i].data;
+        }
+        count += popped;
+        if(popped < requested)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+size_t InputDispatcher::read_events_ex(JoystickInputEventEx* out, size_t max)
+{
+    if(m_ring == nullptr || out == nullptr)
+    {
+        return 0;
+    }
+    return m_ring->pop(out, max);
+}
+
+EventRingStats InputDispatcher::ring_stats() const
+{
+    if(m_ring == nullptr)
+    {
+        return EventRingStats{};
+    }
+    return m_ring->stats();
+}
+
+void InputDispatcher::configure_thread(size_t capacity, DispatchPolicy policy)
+{
+    m_thread_capacity = capacity;
+    m_thread_policy = policy;
+}
+
+void InputDispatcher::configure_watchdog(
+    uint64_t                            budget_ns,
+    CallbackStallHook                   hook
+)
+{
+    m_watchdog.configure(budget_ns, hook);
+}
+
+void InputDispatcher::start()
+{
+    m_watchdog.start();
+    if(m_threaded || m_thread_capacity == 0)
+    {
+        return;
+    }
+
+    m_queue = std::make_unique<DispatchQueue>(
+        m_thread_capacity,
+        m_thread_policy
+    );
+    m_thread = std::thread(&InputDispatcher::thread_main, this);
+    m_threaded = true;
+}
+
+void InputDispatcher::stop()
+{
+    if(!m_threaded)
+    {
+        m_watchdog.stop();
+        return;
+    }
+
+    // The thread drains the queue before pop() reports it closed.
+    m_queue->close();
+    m_thread.join();
+    m_threaded = false;
+    m_watchdog.stop();
+}
+
+void InputDispatcher::set_trace_ring(TraceRing* ring)
+{
+    m_trace_ring = ring;
+}
+
+WatchdogStats InputDispatcher::watchdog_stats() const
+{
+    return m_watchdog.stats();
+}
+
+DispatchQueueStats InputDispatcher::queue_stats() const
+{
+    if(m_queue == nullptr)
+    {
+        return DispatchQueueStats{};
+    }
+    return m_queue->stats();
+}
+
+void InputDispatcher::dispatch(std::vector<JoystickInputEventEx> const& events)
+{
+    if(events.empty())
+    {
+        return;
+    }
+
+    if(m_coalescing.load(std::memory_order_relaxed))
+    {
+        // The copy reuses its capacity, coalescing does not allocate once
+        // the largest batch has been seen.
+        m_coalesced = events;
+        const auto stats = coalesce_input_events(m_coalesced);
+        m_coalescing_received.fetch_add(
+            stats.received,
+            std::memory_order_relaxed
+        );
+        m_coalesced_axis.fetch_add(
+            stats.coalesced_axis,
+            std::memory_order_relaxed
+        );
+        m_coalesced_hat.fetch_add(
+            stats.coalesced_hat,
+            std::memory_order_relaxed
+        );
+        if(m_threaded)
+        {
+            m_queue->push(m_coalesced);
+        }
+        else
+        {
+            deliver(m_coalesced);
+        }
+    }
+    else if(m_threaded)
+    {
+        m_queue->push(events);
+    }
+    else
+    {
+        deliver(events);
+    }
+}
+
+void InputDispatcher::device_changed(
+    DeviceSummary const&                info,
+    DeviceActionType                    action
+)
+{
+    if(m_threaded)
+    {
+        m_queue->push(info, action);
+        return;
+    }
+    deliver(info, action);
+}
+
+void InputDispatcher::deliver(std::vector<JoystickInputEventEx> const& events)
+{
+    if(m_ring != nullptr)
+    {
+        for(auto const& evt : events)
+        {
+            m_ring->push(evt);
+        }
+    }
+
+    auto ex_callback = m_event_ex_callback.load();
+    if(ex_callback != nullptr)
+    {
+        DILL_TRACE_SCOPE(
+            m_trace_ring,
+            InputCallback,
+            events.front().data.device_guid
+        );
+        const uint64_t start = monotonic_time_ns();
+        if(m_watchdog.active())
+        {
+            m_watchdog.enter(start, events.front().data);
+        }
+        ex_callback(events.data(), events.size());
+        record_callback(events, start, 1);
+        return;
+    }
+
+    auto batch_callback = m_batch_callback.load();
+    if(batch_callback != nullptr)
+    {
+        to_legacy_events(events, m_legacy_events);
+        DILL_TRACE_SCOPE(
+            m_trace_ring,
+            InputCallback,
+            events.front().data.device_guid
+        );
+        const uint64_t start = monotonic_time_ns();
+        if(m_watchdog.active())
+        {
+            m_watchdog.enter(start, events.front().data);
+        }
+        batch_callback(m_legacy_events.data(), m_legacy_events.size());
+        record_callback(events, start, 1);
+        return;
+    }
+
+    auto callback = m_event_callback.load();
+    if(callback != nullptr)
+    {
+        // Timed as a whole, a clock read per event would cost about as
+        // much as a cheap callback.
+        DILL_TRACE_SCOPE(
+            m_trace_ring,
+            InputCallback,
+            events.front().data.device_guid
+        );
+        const uint64_t start = monotonic_time_ns();
+        if(m_watchdog.active())
+        {
+            // The watchdog measures the whole loop as one delivery, while
+            // reporting the event being handled.
+            m_watchdog.enter(start, events.front().data);
+            for(auto const& evt : events)
+            {
+                m_watchdog.update(evt.data);
+                callback(evt.data);
+            }
+        }
+        else
+        {
+            for(auto const& evt : events)
+            {
+                callback(evt.data);
+            }
+        }
+        record_callback(events, start, events.size());
+    }
+}
+
+void InputDispatcher::deliver(
+    DeviceSummary const&                info,
+    DeviceActionType                    action
+)
+{
+    {
+        // Only the delivering thread modifies the table, the lock orders
+        // the modification with readers on other threads.
+        std::lock_guard<std::mutex> lock(m_device_latency_mutex);
+        if(action == DeviceActionType::Connected)
+        {
+            for(auto& entry : *m_device_latency)
+            {
+                if(!entry.used)
+                {
+                    entry.guid = info.device_guid;
+                    entry.exit.reset();
+                    entry.used = true;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            for(auto& entry : *m_device_latency)
+            {
+                if(entry.used && entry.guid == info.device_guid)
+                {
+                    entry.used = false;
+                }
+            }
+        }
+    }
+
+    auto callback = m_device_change_callback.load();
+    if(callback == nullptr)
+    {
+        return;
+    }
+    DILL_TRACE_SCOPE(m_trace_ring, DeviceChangeCallback, info.device_guid);
+    if(!m_watchdog.active())
+    {
+        callback(info, action);
+        return;
+    }
+    m_watchdog.enter(monotonic_time_ns(), info.device_guid, action);
+    callback(info, action);
+    m_watchdog.leave(monotonic_time_ns());
+}
+
+void InputDispatcher::record_callback(
+    std::vector<JoystickInputEventEx> const& events,
+    uint64_t                            start_ns,
+    uint64_t                            invocations
+)
+{
+    const uint64_t end = monotonic_time_ns();
+    if(m_watchdog.active())
+    {
+        m_watchdog.leave(end);
+    }
+    m_callback_invocations.fetch_add(invocations, std::memory_order_relaxed);
+    m_callback_time_ns.fetch_add(
+        end > start_ns ? end - start_ns : 0,
+        std::memory_order_relaxed
+    );
+
+    // Events without a receive time have no reference to measure from.
+    const uint64_t origin = events.front().receive_time_ns;
+    if(origin == 0 || origin > start_ns)
+    {
+        return;
+    }
+    m_entry_latency.record(start_ns - origin);
+    m_exit_latency.record(end - origin);
+
+    // Consecutive batches usually stem from the same device, check the
+    // previous entry before searching the table.
+    auto& table = *m_device_latency;
+    const GUID& guid = events.front().data.device_guid;
+    if(!table[m_device_latency_hint].used ||
+       table[m_device_latency_hint].guid != guid)
+    {
+        for(size_t i=0; i<table.size(); ++i)
+        {
+            if(table[i].used && table[i].guid == guid)
+            {
+                m_device_latency_hint = i;
+                break;
+            }
+        }
+    }
+    auto& entry = table[m_device_latency_hint];
+    if(entry.used && entry.guid == guid)
+    {
+        entry.exit.record(end - origin);
+    }
+}
+
+void InputDispatcher::thread_main()
+{
+    while(m_queue->pop(m_batch))
+    {
+        if(m_batch.is_device_change)
+        {
+            deliver(m_batch.device, m_batch.action);
+        }
+        else
+        {
+            deliver(m_batch.events);
+        }
+    }
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "callback_watchdog.h"
+#include "device_slot_table.h"
+#include "dill_types.h"
+#include "dispatch_queue.h"
+#include "event_coalescing.h"
+#include "event_ring.h"
+#include "latency_histogram.h"
+#include "trace_ring.h"
+
+
+/**
+ * \brief Counters describing the time spent in input callbacks.
+ */
+struct CallbackStats
+{
+    //! Number of input callback invocations.
+    uint64_t                            invocations;
+    //! Total time spent in input callbacks, in nanoseconds.
+    uint64_t                            total_time_ns;
+};
+
+
+/**
+ * \brief Delivers input events and device changes to the client.
+ *
+ * Holds the callbacks and the optional pull-mode event ring. Events are
+ * dispatched by a single thread, DILL's event loop thread, while the
+ * callbacks may be replaced and the ring read from any thread.
+ *
+ * With a dispatch thread configured, dispatch() and device_changed() only
+ * queue their work and a thread owned by the dispatcher invokes the
+ * callbacks and fills the ring, so slow callbacks no longer hold up the
+ * event loop.
+ */
+class InputDispatcher
+{
+public:
+    InputDispatcher();
+    InputDispatcher(InputDispatcher const&) = delete;
+    InputDispatcher& operator=(InputDispatcher const&) = delete;
+    ~InputDispatcher();
+
+    /**
+     * \brief Sets the callback invoked once per event.
+     *
+     * \param cb callback to use from now on
+     */
+    void set_event_callback(JoystickInputEventCallback cb);
+
+    /**
+     * \brief Sets the callback invoked once per batch of events.
+     *
+     * \param cb callback to use from now on, replaces the per-event
+     *        callback while set
+     */
+    void set_batch_callback(JoystickInputBatchCallback cb);
+
+    /**
+     * \brief Sets the callback invoked once per batch of timestamped
+     *        events.
+     *
+     * \param cb callback to use from now on, replaces the batch and
+     *        per-event callbacks while set
+     */
+    void set_event_ex_callback(JoystickInputEventExCallback cb);
+
+    /**
+     * \brief Sets the callback invoked for device changes.
+     *
+     * \param cb callback to use from now on
+     */
+    void set_device_change_callback(DeviceChangeCallback cb);
+
+    /**
+     * \brief Enables or disables coalescing of axis and hat events.
+     *
+     * While enabled, only the last event of each axis and hat within a
+     * batch is delivered, to callbacks and the ring alike. Button events
+     * are always delivered. Device state is unaffected, it is updated
+     * before dispatching.
+     *
+     * \param enabled whether to coalesce from the next batch on
+     */
+    void set_coalescing(bool enabled);
+
+    /**
+     * \brief Returns the counters of event coalescing.
+     *
+     * \return counters accumulated while coalescing was enabled
+     */
+    CoalescingStats coalescing_stats() const;
+
+    /**
+     * \brief Returns the time spent in input callbacks.
+     *
+     * \return counters covering every invocation of an input callback
+     */
+    CallbackStats callback_stats() const;
+
+    /**
+     * \brief Returns the latency until input callbacks ran.
+     *
+     * Measured from the receive time of each delivered batch's first
+     * event, batches without a receive time are not measured.
+     *
+     * \param stage CallbackEntry or CallbackExit
+     * \return distribution of the latencies, all zero for other stages
+     */
+    LatencySummary callback_latency(LatencyStage stage) const;
+
+    /**
+     * \brief Returns the latency until input callbacks of a device
+     *        returned.
+     *
+     * Devices are tracked from their connection until their
+     * disconnection as reported through device_changed().
+     *
+     * \param guid GUID of the device to query
+     * \param summary set to the distribution of the device's latencies
+     * \return true if the device is tracked, false otherwise
+     */
+    bool device_latency(GUID const& guid, LatencySummary& summary) const;
+
+    /**
+     * \brief Creates, replaces or removes the event ring.
+     *
+     * Must neither race with dispatch() nor with reading the ring.
+     *
+     * \param capacity minimum number of events the ring holds, 0 removes
+     *        the ring
+     * \param policy which event to drop when the ring is full
+     * \throws std::length_error if capacity exceeds
+     *         EventRing::k_max_capacity, the previous ring is kept
+     */
+    void configure_ring(size_t capacity, RingOverflowPolicy policy);
+
+    /**
+     * \brief Returns the number of slots of the event ring.
+     *
+     * \return number of slots, 0 if there is no ring
+     */
+    size_t ring_capacity() const;
+
+    /**
+     * \brief Reads pending events from the ring without their timing.
+     *
+     * \param out array receiving the events, oldest first
+     * \param max maximum number of events to write to out
+     * \return number of events written to out
+     */
+    size_t read_events(JoystickInputData* out, size_t max);
+
+    /**
+     * \brief Reads pending events from the ring.
+     *
+     * \param out array receiving the events, oldest first
+     * \param max maximum number of events to write to out
+     * \return number of events written to out
+     */
+    size_t read_events_ex(JoystickInputEventEx* out, size_t max);
+
+    /**
+     * \brief Returns the counters of the event ring.
+     *
+     * \return counters of the ring, all zero if there is no ring
+     */
+    EventRingStats ring_stats() const;
+
+    /**
+     * \brief Configures the dispatch thread used by the next start().
+     *
+     * Must not be called between start() and stop().
+     *
+     * \param capacity number of input events queued for the thread, 0
+     *        delivers on the dispatching thread instead
+     * \param policy behaviour when events arrive while the queue is full
+     */
+    void configure_thread(size_t capacity, DispatchPolicy policy);
+
+    /**
+     * \brief Configures the callback watchdog used by the next start().
+     *
+     * Must not be called between start() and stop().
+     *
+     * \param budget_ns time a single callback delivery may take, 0
+     *        disables the watchdog
+     * \param hook function invoked from the watchdog's thread whenever a
+     *        delivery exceeds the budget, may be nullptr
+     */
+    void configure_watchdog(uint64_t budget_ns, CallbackStallHook hook);
+
+    /**
+     * \brief Starts the dispatch thread and the callback watchdog, if they
+     *        are configured.
+     *
+     * Must neither race with dispatch() nor with device_changed().
+     */
+    void start();
+
+    /**
+     * \brief Delivers all queued work and stops the dispatch thread and the
+     *        callback watchdog.
+     *
+     * Must neither race with dispatch() nor with device_changed().
+     */
+    void stop();
+
+    /**
+     * \brief Sets the ring callback invocations are traced into.
+     *
+     * Spans are only recorded in builds with DILL_ENABLE_TRACE defined.
+     * Must neither race with dispatch() nor with device_changed().
+     *
+     * \param ring ring to record into, nullptr stops tracing
+     */
+    void set_trace_ring(TraceRing* ring);
+
+    /**
+     * \brief Returns the counters of the callback watchdog.
+     *
+     * \return counters of every delivery since the first start()
+     */
+    WatchdogStats watchdog_stats() const;
+
+    /**
+     * \brief Returns the counters of the dispatch thread's queue.
+     *
+     * \return counters of the queue used by the last start(), all zero if
+     *         there has been no dispatch thread
+     */
+    DispatchQueueStats queue_stats() const;
+
+    /**
+     * \brief Hands the events of a single device wakeup to the client.
+     *
+     * Coalesces the events if enabled. Then pushes every event into the
+     * ring, if there is one, and invokes the extended callback if one is
+     * set, the batch callback if one is set and the per-event callback
+     * otherwise. Only ever called by a single thread at a time. With a
+     * dispatch thread running, the coalesced events are queued instead and
+     * delivered by that thread.
+     *
+     * \param events events to deliver, in the order they occurred
+     */
+    void dispatch(std::vector<JoystickInputEventEx> const& events);
+
+    /**
+     * \brief Hands a device change to the client.
+     *
+     * Invokes the device change callback, or queues the change behind the
+     * events dispatched before it while a dispatch thread is running.
+     * Only ever called by the thread calling dispatch().
+     *
+     * \param info description of the device
+     * \param action how the device changed
+     */
+    void device_changed(DeviceSummary const& info, DeviceActionType action);
+
+private:
+    struct DeviceLatency
+    {
+        GUID                            guid;
+        bool                            used;
+        LatencyHistogram                exit;
+    };
+    using DeviceLatencyTable = std::array<DeviceLatency, k_max_devices>;
+
+    void deliver(std::vector<JoystickInputEventEx> const& events);
+    void deliver(DeviceSummary const& info, DeviceActionType action);
+    void record_callback(
+        std::vector<JoystickInputEventEx> const& events,
+        uint64_t                        start_ns,
+        uint64_t                        invocations
+    );
+    void thread_main();
+
+    std::atomic<JoystickInputEventCallback> m_event_callback{nullptr};
+    std::atomic<JoystickInputBatchCallback> m_batch_callback{nullptr};
+    std::atomic<JoystickInputEventExCallback> m_event_ex_callback{nullptr};
+    std::atomic<DeviceChangeCallback>   m_device_change_callback{nullptr};
+    std::unique_ptr<EventRing<JoystickInputEventEx>> m_ring;
+    std::atomic<bool>                   m_coalescing{false};
+    std::atomic<uint64_t>               m_coalescing_received{0};
+    std::atomic<uint64_t>               m_coalesced_axis{0};
+    std::atomic<uint64_t>               m_coalesced_hat{0};
+    std::atomic<uint64_t>               m_callback_invocations{0};
+    std::atomic<uint64_t>               m_callback_time_ns{0};
+    //! Latency histograms, only recorded into by the delivering thread.
+    LatencyHistogram                    m_entry_latency;
+    LatencyHistogram                    m_exit_latency;
+    std::unique_ptr<DeviceLatencyTable> m_device_latency;
+    //! Guards modifications of m_device_latency's entries and reads from
+    //! threads other than the delivering one.
+    mutable std::mutex                  m_device_latency_mutex;
+    //! Entry of m_device_latency used by the last batch.
+    size_t                              m_device_latency_hint = 0;
+    //! Copy of the dispatched events being coalesced.
+    std::vector<JoystickInputEventEx>   m_coalesced;
+    //! Timing-free copy of the events handed to the batch callback.
+    std::vector<JoystickInputData>      m_legacy_events;
+    size_t                              m_thread_capacity = 0;
+    DispatchPolicy                      m_thread_policy = DispatchPolicy::Block;
+    //! Queue of the running or last dispatch thread, kept for its stats.
+    std::unique_ptr<DispatchQueue>      m_queue;
+    std::thread                         m_thread;
+    //! Whether dispatching queues for m_thread.
+    bool                                m_threaded = false;
+    //! Work item being delivered, only used by m_thread.
+    DispatchBatch                       m_batch;
+    CallbackWatchdog                    m_watchdog;
+    TraceRing*                          m_trace_ring = nullptr;
+};
@@ -0,0 +1,63 @@
+#include "input_loop.h"
+
+
+namespace
+{
+    // Longest time the loop waits for input in one go. Stopping wakes the
+    // source, so this only bounds the wait should a wakeup get lost.
+    const std::chrono::milliseconds k_max_wait{1000};
+}
+
+
+InputLoop::InputLoop(InputSource& source, InputSink& sink)
+    :   m_source(source)
+      , m_sink(sink)
+{
+}
+
+InputLoop::~InputLoop()
+{
+    stop();
+}
+
+void InputLoop::start()
+{
+    if(m_thread.joinable())
+    {
+        if(m_running)
+        {
+            return;
+        }
+        // The source failed, the thread has ended or is about to.
+        m_thread.join();
+    }
+    m_running = true;
+    m_thread = std::thread(&InputLoop::run, this);
+}
+
+void InputLoop::stop()
+{
+    if(!m_thread.joinable())
+    {
+        return;
+    }
+    m_running = false;
+    m_source.wake();
+    m_thread.join();
+}
+
+bool InputLoop::is_running() const
+{
+    return m_running;
+}
+
+void InputLoop::run()
+{
+    while(m_running)
+    {
+        if(!m_source.process(m_sink, k_max_wait))
+        {
+            m_running = false;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "input_source.h"
+
+
+/**
+ * \brief Runs an InputSource on its own thread.
+ *
+ * The thread keeps handing the source's input to the sink until stopped or
+ * until the source fails.
+ */
+class InputLoop
+{
+public:
+    /**
+     * \brief Creates a stopped loop.
+     *
+     * \param source source to run, must outlive the loop
+     * \param sink sink receiving the source's input, must outlive the loop
+     */
+    InputLoop(InputSource& source, InputSink& sink);
+    ~InputLoop();
+    InputLoop(InputLoop const&) = delete;
+    InputLoop& operator=(InputLoop const&) = delete;
+
+    /**
+     * \brief Starts the loop's thread, does nothing if already running.
+     *
+     * A loop whose source failed is restarted.
+     */
+    void start();
+
+    /**
+     * \brief Stops and joins the loop's thread, does nothing if stopped.
+     */
+    void stop();
+
+    /**
+     * \brief Returns whether the loop is processing input.
+     *
+     * \return true if started and the source has not failed
+     */
+    bool is_running() const;
+
+private:
+    void run();
+
+    InputSource&                        m_source;
+    InputSink&                          m_sink;
+    std::thread                         m_thread;
+    std::atomic<bool>                   m_running{false};
+};
@@ -0,0 +1,79 @@
+#include "input_metrics.h"
+
+
+InputMetrics::InputMetrics()
+{
+    for(uint32_t slot=0; slot<m_devices.size(); ++slot)
+    {
+        reset(slot);
+    }
+    for(auto& counter : m_loop)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+void InputMetrics::record_drain(uint32_t slot, uint64_t count)
+{
+    auto& device = m_devices[slot];
+    increment(
+        device.counters[static_cast<size_t>(DeviceCounter::EventsDecoded)],
+        count
+    );
+    if(count > device.max_drain.load(std::memory_order_relaxed))
+    {
+        device.max_drain.store(count, std::memory_order_relaxed);
+    }
+}
+
+void InputMetrics::reset(uint32_t slot)
+{
+    auto& device = m_devices[slot];
+    for(auto& counter : device.counters)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    device.max_drain.store(0, std::memory_order_relaxed);
+}
+
+DeviceMetrics InputMetrics::device(uint32_t slot, GUID const& guid) const
+{
+    auto const& device = m_devices[slot];
+    auto get = [&device](DeviceCounter counter) {
+        return device.counters[static_cast<size_t>(counter)].load(
+            std::memory_order_relaxed
+        );
+    };
+
+    DeviceMetrics result;
+    result.device_guid = guid;
+    result.events_decoded = get(DeviceCounter::EventsDecoded);
+    result.events_emitted = get(DeviceCounter::EventsEmitted);
+    result.buffer_overflows = get(DeviceCounter::BufferOverflows);
+    result.notbuffered_demotions = get(DeviceCounter::NotBufferedDemotions);
+    result.poll_failures = get(DeviceCounter::PollFailures);
+    result.reacquire_attempts = get(DeviceCounter::ReacquireAttempts);
+    result.max_events_per_drain = device.max_drain.load(
+        std::memory_order_relaxed
+    );
+    return result;
+}
+
+LoopMetrics InputMetrics::loop() const
+{
+    auto get = [this](LoopCounter counter) {
+        return m_loop[static_cast<size_t>(counter)].load(
+            std::memory_order_relaxed
+        );
+    };
+
+    LoopMetrics result{};
+    result.device_wakeups = get(LoopCounter::DeviceWakeups);
+    result.poll_wakeups = get(LoopCounter::PollWakeups);
+    result.rebuild_wakeups = get(LoopCounter::RebuildWakeups);
+    result.hotplug_wakeups = get(LoopCounter::HotplugWakeups);
+    result.message_wakeups = get(LoopCounter::MessageWakeups);
+    result.hotplug_enumerations = get(LoopCounter::HotplugEnumerations);
+    result.wait_handle_rebuilds = get(LoopCounter::WaitHandleRebuilds);
+    return result;
+}
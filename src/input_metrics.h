@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "device_slot_table.h"
+#include "dill_types.h"
+
+
+/**
+ * \brief Counters describing the input handling of a single device.
+ *
+ * Counters start at zero when the device connects.
+ */
+struct DeviceMetrics
+{
+    GUID                                device_guid;
+    //! Number of events decoded from the device's reports.
+    uint64_t                            events_decoded;
+    //! Number of events handed to the client after filtering.
+    uint64_t                            events_emitted;
+    //! Number of reads reporting lost data due to a full device buffer.
+    uint64_t                            buffer_overflows;
+    //! Number of times the device was switched from buffered to polled.
+    uint64_t                            notbuffered_demotions;
+    //! Number of failed polls and device state reads.
+    uint64_t                            poll_failures;
+    //! Number of attempts to acquire the device again after a failure.
+    uint64_t                            reacquire_attempts;
+    //! Largest number of events decoded in a single wakeup.
+    uint64_t                            max_events_per_drain;
+};
+
+/**
+ * \brief Counters describing the event loop.
+ */
+struct LoopMetrics
+{
+    //! Number of wakeups due to a buffered device signaling input.
+    uint64_t                            device_wakeups;
+    //! Number of wakeups due to a polled device being due.
+    uint64_t                            poll_wakeups;
+    //! Number of wakeups requesting a rebuild of the wait handles.
+    uint64_t                            rebuild_wakeups;
+    //! Number of wakeups due to a hotplug notification.
+    uint64_t                            hotplug_wakeups;
+    //! Number of wakeups due to window messages.
+    uint64_t                            message_wakeups;
+    //! Number of device enumerations.
+    uint64_t                            hotplug_enumerations;
+    //! Number of rebuilds of the wait handles.
+    uint64_t                            wait_handle_rebuilds;
+    //! Number of input callback invocations.
+    uint64_t                            callback_invocations;
+    //! Total time spent in input callbacks, in nanoseconds.
+    uint64_t                            callback_time_ns;
+    //! Number of callback deliveries exceeding the watchdog's budget.
+    uint64_t                            callback_overruns;
+};
+
+/**
+ * \brief Per-device counters maintained by InputMetrics.
+ */
+enum class DeviceCounter : uint8_t
+{
+    EventsDecoded,
+    EventsEmitted,
+    BufferOverflows,
+    NotBufferedDemotions,
+    PollFailures,
+    ReacquireAttempts,
+    Count
+};
+
+/**
+ * \brief Event loop counters maintained by InputMetrics.
+ */
+enum class LoopCounter : uint8_t
+{
+    DeviceWakeups,
+    PollWakeups,
+    RebuildWakeups,
+    HotplugWakeups,
+    MessageWakeups,
+    HotplugEnumerations,
+    WaitHandleRebuilds,
+    Count
+};
+
+
+/**
+ * \brief Counters of the event loop and every device slot.
+ *
+ * Each counter is only ever modified by a single thread, DILL's event
+ * loop, so increments are plain relaxed loads and stores rather than
+ * locked read-modify-write instructions. Snapshots can be taken from any
+ * thread at any time; they read every counter once and never block the
+ * writer, so individual counters may be a few increments apart.
+ */
+class InputMetrics
+{
+public:
+    InputMetrics();
+    InputMetrics(InputMetrics const&) = delete;
+    InputMetrics& operator=(InputMetrics const&) = delete;
+
+    /**
+     * \brief Increments a counter of a device slot.
+     *
+     * \param slot slot of the device
+     * \param counter counter to increment
+     * \param count amount to add
+     */
+    void add(uint32_t slot, DeviceCounter counter, uint64_t count = 1)
+    {
+        auto& device = m_devices[slot];
+        increment(device.counters[static_cast<size_t>(counter)], count);
+    }
+
+    /**
+     * \brief Increments a counter of the event loop.
+     *
+     * \param counter counter to increment
+     * \param count amount to add
+     */
+    void add(LoopCounter counter, uint64_t count = 1)
+    {
+        increment(m_loop[static_cast<size_t>(counter)], count);
+    }
+
+    /**
+     * \brief Records the events decoded in a single wakeup of a device.
+     *
+     * Counts them as decoded and tracks the largest drain.
+     *
+     * \param slot slot of the device
+     * \param count number of events decoded
+     */
+    void record_drain(uint32_t slot, uint64_t count);
+
+    /**
+     * \brief Resets the counters of a device slot.
+     *
+     * \param slot slot being assigned to a newly connected device
+     */
+    void reset(uint32_t slot);
+
+    /**
+     * \brief Returns the counters of a device slot.
+     *
+     * \param slot slot of the device
+     * \param guid GUID of the device, copied into the result
+     * \return counters of the slot
+     */
+    DeviceMetrics device(uint32_t slot, GUID const& guid) const;
+
+    /**
+     * \brief Returns the counters of the event loop.
+     *
+     * \return counters of the event loop, callback fields are zero
+     */
+    LoopMetrics loop() const;
+
+private:
+    using Counter = std::atomic<uint64_t>;
+
+    static constexpr size_t k_device_counter_count =
+        static_cast<size_t>(DeviceCounter::Count);
+    static constexpr size_t k_loop_counter_count =
+        static_cast<size_t>(LoopCounter::Count);
+
+    static void increment(Counter& counter, uint64_t count)
+    {
+        counter.store(
+            counter.load(std::memory_order_relaxed) + count,
+            std::memory_order_relaxed
+        );
+    }
+
+    // Padded so that snapshot readers of one device do not contend with
+    // the writer of its neighbour.
+    struct alignas(64) Device
+    {
+        std::array<Counter, k_device_counter_count> counters;
+        Counter                         max_drain;
+    };
+
+    std::array<Device, k_max_devices>   m_devices;
+    std::array<Counter, k_loop_counter_count> m_loop;
+};
@@ -0,0 +1,172 @@
+#include "input_pipeline.h"
+
+#include "axis_mapping.h"
+
+
+InputPipeline::InputPipeline()
+    :   m_store(m_mutex, m_metrics, m_recorder, m_dispatcher)
+{
+}
+
+InputDispatcher& InputPipeline::dispatcher()
+{
+    return m_dispatcher;
+}
+
+void InputPipeline::set_device_change_callback(DeviceChangeCallback cb)
+{
+    m_dispatcher.set_device_change_callback(cb);
+}
+
+bool InputPipeline::start_recording(std::string const& path)
+{
+    return m_store.start_recording(path);
+}
+
+void InputPipeline::stop_recording()
+{
+    m_recorder.close();
+}
+
+RecorderStats InputPipeline::recording_stats() const
+{
+    return m_recorder.stats();
+}
+
+bool InputPipeline::set_axis_filter(
+    GUID const&                         guid,
+    DWORD                               axis_index,
+    AxisFilterConfig const&             config
+)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto slot = m_store.slots().find(guid);
+    if(slot == k_invalid_slot)
+    {
+        return false;
+    }
+    return m_store.set_axis_filter(slot, axis_index, config);
+}
+
+bool InputPipeline::set_subscription(
+    GUID const&                         guid,
+    DWORD                               type_mask,
+    uint64_t const*                     index_bitset
+)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto slot = m_store.slots().find(guid);
+    if(slot == k_invalid_slot)
+    {
+        return false;
+    }
+    return m_store.set_subscription(slot, type_mask, index_bitset);
+}
+
+bool InputPipeline::device_added(DeviceSummary const& info)
+{
+    return device_added_ex(extend_device_summary(info));
+}
+
+bool InputPipeline::device_added_ex(DeviceSummaryEx const& info)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // A second device with the same GUID would share the first one's
+        // slot, mixing their input and removing both with either.
+        if(m_store.slots().find(info.summary.device_guid) != k_invalid_slot)
+        {
+            return false;
+        }
+        if(m_store.add(info) == k_invalid_slot)
+        {
+            return false;
+        }
+    }
+
+    m_dispatcher.device_changed(info.summary, DeviceActionType::Connected);
+    return true;
+}
+
+void InputPipeline::device_removed(GUID const& guid)
+{
+    DeviceSummary info;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_store.remove(guid, info) == k_invalid_slot)
+        {
+            return;
+        }
+    }
+
+    m_dispatcher.device_changed(info, DeviceActionType::Disconnected);
+}
+
+void InputPipeline::input_events(
+    GUID const&                         guid,
+    std::vector<JoystickInputEventEx> const& events
+)
+{
+    m_store.input_events(guid, events);
+}
+
+size_t InputPipeline::device_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_store.slots().size();
+}
+
+bool InputPipeline::device_information(
+    GUID const&                         guid,
+    DeviceSummary&                      info
+) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto slot = m_store.slots().find(guid);
+    if(slot == k_invalid_slot)
+    {
+        return false;
+    }
+    info = m_store.info(slot).summary;
+    return true;
+}
+
+bool InputPipeline::device_information_ex(
+    GUID const&                         guid,
+    DeviceSummaryEx&                    info
+) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto slot = m_store.slots().find(guid);
+    if(slot == k_invalid_slot)
+    {
+        return false;
+    }
+    info = m_store.info(slot);
+    return true;
+}
+
+bool InputPipeline::device_metrics(
+    GUID const&                         guid,
+    DeviceMetrics&                      metrics
+) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto slot = m_store.slots().find(guid);
+    if(slot == k_invalid_slot)
+    {
+        return false;
+    }
+    metrics = m_metrics.device(slot, guid);
+    return true;
+}
+
+bool InputPipeline::load(GUID const& guid, DeviceState& state) const
+{
+    return m_store.state().load(guid, state);
+}
+
+bool InputPipeline::snapshot(GUID const& guid, DillDeviceSnapshot& snapshot) const
+{
+    return m_store.state().snapshot(guid, snapshot);
+}
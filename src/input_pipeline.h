@@ -0,0 +1,181 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "axis_filter.h"
+#include "device_store.h"
+#include "dill_types.h"
+#include "input_dispatcher.h"
+#include "input_metrics.h"
+#include "input_recorder.h"
+#include "input_source.h"
+
+
+/**
+ * \brief Tracks the devices of an InputSource and delivers their input.
+ *
+ * Keeps the devices in a DeviceStore, the same store DILL's DirectInput
+ * event loop uses: devices are assigned slots, every batch of events
+ * updates the device's state in a single publication and is then handed
+ * to the InputDispatcher without holding any lock.
+ *
+ * The InputSink methods are invoked by the thread running the source, all
+ * other methods are safe to call from any thread.
+ */
+class InputPipeline : public InputSink
+{
+public:
+    InputPipeline();
+    InputPipeline(InputPipeline const&) = delete;
+    InputPipeline& operator=(InputPipeline const&) = delete;
+
+    /**
+     * \brief Returns the dispatcher delivering input events.
+     *
+     * \return dispatcher holding the input callbacks and event ring
+     */
+    InputDispatcher& dispatcher();
+
+    /**
+     * \brief Sets the callback for device change events.
+     *
+     * \param cb callback to use from now on
+     */
+    void set_device_change_callback(DeviceChangeCallback cb);
+
+    /**
+     * \brief Starts recording device changes and input events to a file.
+     *
+     * The recording starts with the currently tracked devices. Must not be
+     * called concurrently with stop_recording.
+     *
+     * \param path path of the recording file to create
+     * \return true if recording started, false if the file could not be
+     *         created or a recording is already running
+     */
+    bool start_recording(std::string const& path);
+
+    /**
+     * \brief Stops recording and closes the recording file.
+     */
+    void stop_recording();
+
+    /**
+     * \brief Returns the counters of the recorder.
+     *
+     * \return counters of the recorder
+     */
+    RecorderStats recording_stats() const;
+
+    /**
+     * \brief Suppresses axis events caused by noise.
+     *
+     * Filtered events still update the device state. The filter applies
+     * until the device is removed.
+     *
+     * \param guid GUID of the device to filter
+     * \param axis_index 1-based index of the axis to filter
+     * \param config thresholds in axis counts, all zeros remove the filter
+     * \return true if the filter was set, false if the device is not
+     *         tracked or the arguments are out of range
+     */
+    bool set_axis_filter(
+        GUID const&                     guid,
+        DWORD                           axis_index,
+        AxisFilterConfig const&         config
+    );
+
+    /**
+     * \brief Selects the inputs of a device whose events are delivered.
+     *
+     * Events of unsubscribed inputs still update the device state. The
+     * subscription applies until the device is removed.
+     *
+     * \param guid GUID of the device to subscribe to
+     * \param type_mask input types whose subscription is replaced
+     * \param index_bitset two words with bit N-1 selecting input N,
+     *        nullptr selects every input
+     * \return true if the subscription was set, false if the device is not
+     *         tracked or the type mask is invalid
+     */
+    bool set_subscription(
+        GUID const&                     guid,
+        DWORD                           type_mask,
+        uint64_t const*                 index_bitset
+    );
+
+    bool device_added(DeviceSummary const& info) override;
+    bool device_added_ex(DeviceSummaryEx const& info) override;
+    void device_removed(GUID const& guid) override;
+    void input_events(
+        GUID const&                     guid,
+        std::vector<JoystickInputEventEx> const& events
+    ) override;
+
+    /**
+     * \brief Returns the number of tracked devices.
+     *
+     * \return number of tracked devices
+     */
+    size_t device_count() const;
+
+    /**
+     * \brief Returns the description of a tracked device.
+     *
+     * \param guid GUID of the device to query
+     * \param info set to the device's description if it is tracked
+     * \return true if the device is tracked, false otherwise
+     */
+    bool device_information(GUID const& guid, DeviceSummary& info) const;
+
+    /**
+     * \brief Returns the extended description of a tracked device.
+     *
+     * \param guid GUID of the device to query
+     * \param info set to the device's extended description if it is
+     *        tracked
+     * \return true if the device is tracked, false otherwise
+     */
+    bool device_information_ex(
+        GUID const&                     guid,
+        DeviceSummaryEx&                info
+    ) const;
+
+    /**
+     * \brief Returns the counters of a tracked device.
+     *
+     * \param guid GUID of the device to query
+     * \param metrics set to the device's counters if it is tracked
+     * \return true if the device is tracked, false otherwise
+     */
+    bool device_metrics(GUID const& guid, DeviceMetrics& metrics) const;
+
+    /**
+     * \brief Returns a consistent copy of a device's state.
+     *
+     * \param guid GUID of the device to query
+     * \param state set to the device's current state if it is tracked
+     * \return true if the device is tracked, false otherwise
+     */
+    bool load(GUID const& guid, DeviceState& state) const;
+
+    /**
+     * \brief Returns a consistent snapshot of a device's state.
+     *
+     * \param guid GUID of the device to query
+     * \param snapshot set to the device's current state if it is tracked
+     * \return true if the device is tracked, false otherwise
+     */
+    bool snapshot(GUID const& guid, DillDeviceSnapshot& snapshot) const;
+
+private:
+    //! Guards m_store.
+    mutable std::mutex                  m_mutex;
+    //! Per-device counters, only modified by the source's thread.
+    InputMetrics                        m_metrics;
+    InputDispatcher                     m_dispatcher;
+    InputRecorder                       m_recorder;
+    DeviceStore                         m_store;
+};
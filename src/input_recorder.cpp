@@ -0,0 +1,307 @@
+#include "input_recorder.h"
+
+#include <chrono>
+
+#include "device_slot_table.h"
+#include "event_timing.h"
+
+
+namespace
+{
+    // Time the writer thread sleeps once it found no pending records.
+    const std::chrono::milliseconds k_idle_wait{5};
+
+    // Number of encoded bytes collected before they are written.
+    const size_t k_flush_size = 64 * 1024;
+
+    // Number of records popped from the ring at once.
+    const size_t k_drain_chunk_size = 64;
+
+    JoystickInputEventEx make_device_event(GUID const& guid, uint64_t time_ns)
+    {
+        JoystickInputData data{};
+        data.device_guid = guid;
+        return make_input_event_ex(data, 0, 0, time_ns);
+    }
+}
+
+
+InputRecorder::InputRecorder(size_t capacity)
+    :   m_capacity(capacity)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+    close();
+}
+
+bool InputRecorder::open(std::string const& path)
+{
+    if(m_thread.joinable())
+    {
+        return false;
+    }
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if(m_file == nullptr)
+    {
+        return false;
+    }
+
+    // The rings are never freed, a producer racing with close may still
+    // push into them. Whatever it pushed is discarded here.
+    if(!m_entries)
+    {
+        m_entries = std::make_unique<EventRing<Entry>>(
+            m_capacity,
+            RingOverflowPolicy::DropNewest
+        );
+        m_summaries = std::make_unique<EventRing<DeviceSummaryEx>>(
+            k_max_devices,
+            RingOverflowPolicy::DropNewest
+        );
+    }
+    Entry entry;
+    while(m_entries->pop(&entry, 1) == 1) {}
+    DeviceSummaryEx info;
+    while(m_summaries->pop(&info, 1) == 1) {}
+
+    {
+        std::lock_guard<std::mutex> lock(m_start_mutex);
+        m_initial_devices.clear();
+    }
+    m_closing = false;
+    m_bytes_written = 0;
+    m_reported_drops = m_dropped.load();
+
+    std::vector<uint8_t> header;
+    m_encoder.header(monotonic_time_ns(), header);
+    write(header);
+
+    m_thread = std::thread(&InputRecorder::run, this);
+    return true;
+}
+
+void InputRecorder::start(std::vector<DeviceSummaryEx> const& devices)
+{
+    if(!m_thread.joinable() || m_recording)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_start_mutex);
+        m_initial_devices = devices;
+        m_start_time_ns = monotonic_time_ns();
+    }
+    m_recording = true;
+}
+
+void InputRecorder::close()
+{
+    if(!m_thread.joinable())
+    {
+        return;
+    }
+
+    m_recording = false;
+    m_closing = true;
+    m_thread.join();
+}
+
+bool InputRecorder::is_recording() const
+{
+    return m_recording;
+}
+
+RecorderStats InputRecorder::stats() const
+{
+    RecorderStats result;
+    result.recorded = m_recorded.load(std::memory_order_relaxed);
+    result.dropped = m_dropped.load(std::memory_order_relaxed);
+    result.rejected = m_rejected.load(std::memory_order_relaxed);
+    result.bytes_written = m_bytes_written.load(std::memory_order_relaxed);
+    return result;
+}
+
+void InputRecorder::device_added(DeviceSummaryEx const& info)
+{
+    if(!m_recording)
+    {
+        return;
+    }
+
+    // The writer pairs every DeviceAdded entry with the next summary, both
+    // are pushed or neither is. Room in the entry ring, once seen, stays.
+    if(!m_entries->can_push() || !m_summaries->push(info))
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    push({
+        RecordType::DeviceAdded,
+        make_device_event(info.summary.device_guid, monotonic_time_ns())
+    });
+}
+
+void InputRecorder::device_removed(GUID const& guid)
+{
+    if(!m_recording)
+    {
+        return;
+    }
+
+    push({
+        RecordType::DeviceRemoved,
+        make_device_event(guid, monotonic_time_ns())
+    });
+}
+
+void InputRecorder::input_events(
+    std::vector<JoystickInputEventEx> const& events
+)
+{
+    if(!m_recording)
+    {
+        return;
+    }
+
+    for(auto const& evt : events)
+    {
+        push({RecordType::Input, evt});
+    }
+}
+
+void InputRecorder::push(Entry const& entry)
+{
+    if(m_entries->push(entry))
+    {
+        m_recorded.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void InputRecorder::run()
+{
+    // The devices connected when recording started precede all other
+    // records, which are only pushed once m_recording is set.
+    while(!m_recording && !m_closing)
+    {
+        std::this_thread::sleep_for(k_idle_wait);
+    }
+
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_start_mutex);
+        for(auto const& info : m_initial_devices)
+        {
+            m_encoder.device_added(m_start_time_ns, info, buffer);
+        }
+        m_initial_devices.clear();
+    }
+
+    for(;;)
+    {
+        // Checked before draining so that the last drain happens after
+        // the producer stopped pushing.
+        const bool closing = m_closing;
+        const size_t count = drain(buffer);
+        if(count == 0)
+        {
+            write(buffer);
+            if(closing)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(k_idle_wait);
+        }
+    }
+
+    m_encoder.end(buffer);
+    write(buffer);
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+size_t InputRecorder::drain(std::vector<uint8_t>& buffer)
+{
+    Entry entries[k_drain_chunk_size];
+    size_t total = 0;
+    size_t count = 0;
+    while((count = m_entries->pop(entries, k_drain_chunk_size)) > 0)
+    {
+        for(size_t i=0; i<count; ++i)
+        {
+            auto const& entry = entries[i];
+            switch(entry.type)
+            {
+                case RecordType::DeviceAdded:
+                {
+                    DeviceSummaryEx info;
+                    if(m_summaries->pop(&info, 1) == 1)
+                    {
+                        m_encoder.device_added(
+                            entry.event.receive_time_ns,
+                            info,
+                            buffer
+                        );
+                    }
+                    break;
+                }
+                case RecordType::DeviceRemoved:
+                    m_encoder.device_removed(
+                        entry.event.receive_time_ns,
+                        entry.event.data.device_guid,
+                        buffer
+                    );
+                    break;
+                case RecordType::Input:
+                    // Events of a device whose DeviceAdded entry was
+                    // dropped or that was removed in the meantime, and
+                    // events with an invalid input index.
+                    if(!m_encoder.input(entry.event, buffer))
+                    {
+                        m_rejected.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        total += count;
+
+        if(buffer.size() >= k_flush_size)
+        {
+            write(buffer);
+        }
+    }
+
+    const uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if(dropped != m_reported_drops)
+    {
+        m_encoder.gap(monotonic_time_ns(), dropped - m_reported_drops, buffer);
+        m_reported_drops = dropped;
+    }
+    return total;
+}
+
+void InputRecorder::write(std::vector<uint8_t>& buffer)
+{
+    if(buffer.empty())
+    {
+        return;
+    }
+
+    const size_t written = std::fwrite(
+        buffer.data(),
+        1,
+        buffer.size(),
+        m_file
+    );
+    m_bytes_written.fetch_add(written, std::memory_order_relaxed);
+    buffer.clear();
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dill_types.h"
+#include "event_ring.h"
+#include "input_recording.h"
+
+
+/**
+ * \brief Counters describing the activity of an InputRecorder.
+ */
+struct RecorderStats
+{
+    //! Number of records handed to the writer thread.
+    uint64_t                            recorded;
+    //! Number of records lost because the writer thread fell behind.
+    uint64_t                            dropped;
+    //! Number of input events handed to the writer thread that could not
+    //! be encoded, as their device was not connected in the recording or
+    //! their input index was invalid.
+    uint64_t                            rejected;
+    //! Number of bytes written to the current or last recording.
+    uint64_t                            bytes_written;
+};
+
+
+/**
+ * \brief Streams device changes and input events into a recording file.
+ *
+ * The thread producing input, DILL's event loop or the thread running an
+ * InputSource, only pushes records into lock-free rings. A writer thread
+ * encodes them in the format described in input_recording.h and performs
+ * all file I/O, so recording never blocks the producer. Should the writer
+ * fall behind, records are dropped and a Gap record notes the loss.
+ *
+ * A recording is opened, then started with the devices connected at that
+ * moment and finally closed. The record methods are only ever called by
+ * the single producer thread. start has to be ordered with device_added
+ * and device_removed, e.g. by the lock that guards the device list,
+ * which hands the producer role from the starting thread over to the
+ * producer thread.
+ */
+class InputRecorder
+{
+public:
+    //! Default number of records buffered between producer and writer.
+    static constexpr size_t k_default_capacity = 16384;
+
+    /**
+     * \brief Creates a recorder without an open recording.
+     *
+     * \param capacity number of records buffered between the producer and
+     *        the writer thread, allocated when first opening a recording
+     */
+    explicit InputRecorder(size_t capacity = k_default_capacity);
+    ~InputRecorder();
+    InputRecorder(InputRecorder const&) = delete;
+    InputRecorder& operator=(InputRecorder const&) = delete;
+
+    /**
+     * \brief Creates a recording file and starts the writer thread.
+     *
+     * Nothing is recorded until start is called.
+     *
+     * \param path path of the file to create, replaced if it exists
+     * \return true if the file was created, false if it could not be
+     *         created or a recording is already open
+     */
+    bool open(std::string const& path);
+
+    /**
+     * \brief Starts recording.
+     *
+     * \param devices devices connected at this moment, recorded as
+     *        connected before any other record
+     */
+    void start(std::vector<DeviceSummaryEx> const& devices);
+
+    /**
+     * \brief Stops recording and closes the recording file.
+     *
+     * Blocks until the writer thread has written every pending record.
+     * Records pushed concurrently with closing may be lost.
+     */
+    void close();
+
+    /**
+     * \brief Returns whether records are currently accepted.
+     *
+     * \return true between start and close, false otherwise
+     */
+    bool is_recording() const;
+
+    /**
+     * \brief Returns the counters of the recorder.
+     *
+     * \return counters of the recorder since it was created
+     */
+    RecorderStats stats() const;
+
+    /**
+     * \brief Records the connection of a device.
+     *
+     * \param info extended description of the connected device
+     */
+    void device_added(DeviceSummaryEx const& info);
+
+    /**
+     * \brief Records the disconnection of a device.
+     *
+     * \param guid GUID of the disconnected device
+     */
+    void device_removed(GUID const& guid);
+
+    /**
+     * \brief Records the events of a single device wakeup.
+     *
+     * \param events events to record, in the order they occurred
+     */
+    void input_events(std::vector<JoystickInputEventEx> const& events);
+
+private:
+    struct Entry
+    {
+        RecordType                      type;
+        //! Event of Input entries, device and time of the others.
+        JoystickInputEventEx            event;
+    };
+
+    void push(Entry const& entry);
+    void run();
+    size_t drain(std::vector<uint8_t>& buffer);
+    void write(std::vector<uint8_t>& buffer);
+
+    const size_t                        m_capacity;
+    std::unique_ptr<EventRing<Entry>>   m_entries;
+    //! Summaries of DeviceAdded entries, in the same order.
+    std::unique_ptr<EventRing<DeviceSummaryEx>> m_summaries;
+    std::atomic<bool>                   m_recording{false};
+    std::atomic<bool>                   m_closing{false};
+    std::atomic<uint64_t>               m_recorded{0};
+    std::atomic<uint64_t>               m_dropped{0};
+    std::atomic<uint64_t>               m_rejected{0};
+    std::atomic<uint64_t>               m_bytes_written{0};
+
+    //! Guards m_initial_devices, handed from start to the writer thread.
+    std::mutex                          m_start_mutex;
+    std::vector<DeviceSummaryEx>        m_initial_devices;
+    uint64_t                            m_start_time_ns = 0;
+
+    // Only accessed by the writer thread while it runs.
+    std::FILE*                          m_file = nullptr;
+    RecordingEncoder                    m_encoder;
+    uint64_t                            m_reported_drops = 0;
+    std::thread                         m_thread;
+};
@@ -0,0 +1,556 @@
+#include "input_recording.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "axis_mapping.h"
+#include "event_timing.h"
+
+
+namespace
+{
+    const char k_magic[8] = {'D', 'I', 'L', 'L', 'R', 'E', 'C', '\0'};
+
+    void put_u16(uint16_t value, std::vector<uint8_t>& out)
+    {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    void put_u32(uint32_t value, std::vector<uint8_t>& out)
+    {
+        for(int shift=0; shift<32; shift+=8)
+        {
+            out.push_back(static_cast<uint8_t>(value >> shift));
+        }
+    }
+
+    void put_u64(uint64_t value, std::vector<uint8_t>& out)
+    {
+        for(int shift=0; shift<64; shift+=8)
+        {
+            out.push_back(static_cast<uint8_t>(value >> shift));
+        }
+    }
+
+    uint64_t get_le(uint8_t const* data, size_t size)
+    {
+        uint64_t value = 0;
+        for(size_t i=0; i<size; ++i)
+        {
+            value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    void put_varint(uint64_t value, std::vector<uint8_t>& out)
+    {
+        while(value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void put_svarint(int64_t value, std::vector<uint8_t>& out)
+    {
+        put_varint(
+            (static_cast<uint64_t>(value) << 1) ^
+                static_cast<uint64_t>(value >> 63),
+            out
+        );
+    }
+
+    // Signed difference of two 32 bit counters that may wrap around.
+    int32_t wrapping_delta(DWORD value, DWORD previous)
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(value - previous));
+    }
+
+    size_t type_slot(JoystickInputType type)
+    {
+        return static_cast<size_t>(type) - 1;
+    }
+
+    bool is_valid_type(uint64_t type)
+    {
+        return type >= static_cast<uint64_t>(JoystickInputType::Axis) &&
+            type <= static_cast<uint64_t>(JoystickInputType::Hat);
+    }
+
+    // Whether index names an input of the given type that DeviceState can
+    // hold.
+    bool is_valid_index(JoystickInputType type, uint64_t index)
+    {
+        switch(type)
+        {
+            case JoystickInputType::Axis:
+                return index >= 1 && index <= k_max_axes;
+            case JoystickInputType::Button:
+                return index >= 1 && index <= k_max_buttons;
+            case JoystickInputType::Hat:
+                return index >= 1 && index <= 4;
+        }
+        return false;
+    }
+
+    // Fills the previous values with the defaults of DeviceState.
+    void reset_values(std::array<std::array<LONG, 256>, 3>& value)
+    {
+        value[type_slot(JoystickInputType::Axis)].fill(0);
+        value[type_slot(JoystickInputType::Button)].fill(0);
+        value[type_slot(JoystickInputType::Hat)].fill(-1);
+    }
+}
+
+
+void RecordingEncoder::header(uint64_t base_time_ns, std::vector<uint8_t>& out)
+{
+    m_devices.clear();
+    m_next_id = 0;
+    m_time_ns = base_time_ns;
+
+    out.insert(out.end(), k_magic, k_magic + sizeof(k_magic));
+    put_u32(k_recording_version, out);
+    put_u32(0, out);
+    put_u64(base_time_ns, out);
+}
+
+void RecordingEncoder::device_added(
+    uint64_t                            time_ns,
+    DeviceSummaryEx const&              info_ex,
+    std::vector<uint8_t>&               out
+)
+{
+    auto const& info = info_ex.summary;
+    if(m_devices.find(info.device_guid) != m_devices.end())
+    {
+        return;
+    }
+
+    auto& device = m_devices[info.device_guid];
+    device.id = m_next_id++;
+    reset_values(device.value);
+    device.source_timestamp = 0;
+    device.source_sequence = 0;
+
+    record_start(RecordType::DeviceAdded, time_ns, out);
+    put_varint(device.id, out);
+    put_u32(info.device_guid.Data1, out);
+    put_u16(info.device_guid.Data2, out);
+    put_u16(info.device_guid.Data3, out);
+    out.insert(
+        out.end(),
+        info.device_guid.Data4,
+        info.device_guid.Data4 + sizeof(info.device_guid.Data4)
+    );
+    put_varint(info.vendor_id, out);
+    put_varint(info.product_id, out);
+    put_varint(info.joystick_id, out);
+    put_varint(info.axis_count, out);
+    put_varint(info.button_count, out);
+    put_varint(info.hat_count, out);
+    for(auto const& axis : info.axis_map)
+    {
+        put_varint(axis.linear_index, out);
+        put_varint(axis.axis_index, out);
+    }
+    const size_t name_length = strnlen(info.name, MAX_PATH - 1);
+    put_varint(name_length, out);
+    out.insert(out.end(), info.name, info.name + name_length);
+    const DWORD axis_count = std::min<DWORD>(info_ex.axis_count, k_max_axes);
+    put_varint(axis_count, out);
+    for(DWORD i=0; i<axis_count; ++i)
+    {
+        put_varint(info_ex.axis_map[i].linear_index, out);
+        put_varint(info_ex.axis_map[i].axis_index, out);
+    }
+}
+
+void RecordingEncoder::device_removed(
+    uint64_t                            time_ns,
+    GUID const&                         guid,
+    std::vector<uint8_t>&               out
+)
+{
+    auto it = m_devices.find(guid);
+    if(it == m_devices.end())
+    {
+        return;
+    }
+
+    record_start(RecordType::DeviceRemoved, time_ns, out);
+    put_varint(it->second.id, out);
+    m_devices.erase(it);
+}
+
+bool RecordingEncoder::input(
+    JoystickInputEventEx const&         evt,
+    std::vector<uint8_t>&               out
+)
+{
+    auto it = m_devices.find(evt.data.device_guid);
+    if(it == m_devices.end() || !is_valid_index(
+            evt.data.input_type, evt.data.input_index))
+    {
+        return false;
+    }
+    auto& device = it->second;
+    auto& previous =
+        device.value[type_slot(evt.data.input_type)][evt.data.input_index];
+
+    record_start(RecordType::Input, evt.receive_time_ns, out);
+    put_varint(device.id, out);
+    put_varint(
+        static_cast<uint64_t>(evt.data.input_index) << 2 |
+            static_cast<uint64_t>(evt.data.input_type),
+        out
+    );
+    put_svarint(static_cast<int64_t>(evt.data.value) - previous, out);
+    put_svarint(
+        wrapping_delta(evt.source_timestamp, device.source_timestamp),
+        out
+    );
+    put_svarint(
+        wrapping_delta(evt.source_sequence, device.source_sequence),
+        out
+    );
+
+    previous = evt.data.value;
+    device.source_timestamp = evt.source_timestamp;
+    device.source_sequence = evt.source_sequence;
+    return true;
+}
+
+void RecordingEncoder::gap(
+    uint64_t                            time_ns,
+    uint64_t                            count,
+    std::vector<uint8_t>&               out
+)
+{
+    record_start(RecordType::Gap, time_ns, out);
+    put_varint(count, out);
+}
+
+void RecordingEncoder::end(std::vector<uint8_t>& out)
+{
+    record_start(RecordType::End, m_time_ns, out);
+}
+
+void RecordingEncoder::record_start(
+    RecordType                          type,
+    uint64_t                            time_ns,
+    std::vector<uint8_t>&               out
+)
+{
+    out.push_back(static_cast<uint8_t>(type));
+    put_svarint(static_cast<int64_t>(time_ns - m_time_ns), out);
+    m_time_ns = time_ns;
+}
+
+
+RecordingReader::RecordingReader(uint8_t const* data, size_t size)
+    :   m_data(data)
+      , m_size(size)
+{
+    m_valid = size >= k_recording_header_size &&
+        memcmp(data, k_magic, sizeof(k_magic)) == 0;
+    if(m_valid)
+    {
+        m_version = static_cast<uint32_t>(get_le(data + 8, 4));
+        m_valid = m_version >= 1 && m_version <= k_recording_version;
+    }
+    if(m_valid)
+    {
+        m_base_time_ns = get_le(data + 16, 8);
+    }
+    rewind();
+}
+
+bool RecordingReader::valid() const
+{
+    return m_valid;
+}
+
+uint64_t RecordingReader::base_time_ns() const
+{
+    return m_base_time_ns;
+}
+
+bool RecordingReader::next(RecordingEntry& entry)
+{
+    if(!m_valid || m_complete || m_failed || m_offset == m_size)
+    {
+        return false;
+    }
+
+    const size_t start = m_offset;
+    const uint64_t start_time = m_time_ns;
+    if(!read_record(entry))
+    {
+        // Leave the reader at the start of the unreadable record.
+        m_offset = start;
+        m_time_ns = start_time;
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool RecordingReader::complete() const
+{
+    return m_complete;
+}
+
+bool RecordingReader::failed() const
+{
+    return m_failed;
+}
+
+DeviceSummary const& RecordingReader::device(uint32_t device_id) const
+{
+    return m_devices[device_id].info.summary;
+}
+
+DeviceSummaryEx const& RecordingReader::device_ex(uint32_t device_id) const
+{
+    return m_devices[device_id].info;
+}
+
+void RecordingReader::rewind()
+{
+    m_offset = k_recording_header_size;
+    m_time_ns = m_base_time_ns;
+    m_complete = false;
+    m_failed = false;
+    m_devices.clear();
+}
+
+bool RecordingReader::read_record(RecordingEntry& entry)
+{
+    uint8_t type = 0;
+    int64_t time_delta = 0;
+    if(!read_bytes(&type, 1) || !read_svarint(time_delta))
+    {
+        return false;
+    }
+    m_time_ns += static_cast<uint64_t>(time_delta);
+
+    entry = RecordingEntry{};
+    entry.type = static_cast<RecordType>(type);
+    entry.time_ns = m_time_ns;
+
+    uint64_t device_id = 0;
+    switch(entry.type)
+    {
+        case RecordType::DeviceAdded:
+        {
+            if(!read_varint(device_id) || device_id != m_devices.size())
+            {
+                return false;
+            }
+
+            Device device;
+            auto& info = device.info.summary;
+            info = DeviceSummary{};
+            uint8_t guid[16];
+            if(!read_bytes(guid, sizeof(guid)))
+            {
+                return false;
+            }
+            info.device_guid.Data1 = static_cast<DWORD>(get_le(guid, 4));
+            info.device_guid.Data2 =
+                static_cast<uint16_t>(get_le(guid + 4, 2));
+            info.device_guid.Data3 =
+                static_cast<uint16_t>(get_le(guid + 6, 2));
+            memcpy(info.device_guid.Data4, guid + 8, 8);
+
+            uint64_t fields[6 + 16];
+            for(auto& field : fields)
+            {
+                if(!read_varint(field))
+                {
+                    return false;
+                }
+            }
+            info.vendor_id = static_cast<DWORD>(fields[0]);
+            info.product_id = static_cast<DWORD>(fields[1]);
+            info.joystick_id = static_cast<DWORD>(fields[2]);
+            info.axis_count = static_cast<DWORD>(fields[3]);
+            info.button_count = static_cast<DWORD>(fields[4]);
+            info.hat_count = static_cast<DWORD>(fields[5]);
+            for(size_t i=0; i<8; ++i)
+            {
+                info.axis_map[i].linear_index =
+                    static_cast<DWORD>(fields[6 + 2 * i]);
+                info.axis_map[i].axis_index =
+                    static_cast<DWORD>(fields[7 + 2 * i]);
+            }
+
+            uint64_t name_length = 0;
+            if(!read_varint(name_length) || name_length >= MAX_PATH ||
+               !read_bytes(info.name, static_cast<size_t>(name_length)))
+            {
+                return false;
+            }
+
+            device.info = extend_device_summary(info);
+            if(m_version >= 2)
+            {
+                uint64_t axis_count = 0;
+                if(!read_varint(axis_count) || axis_count > k_max_axes)
+                {
+                    return false;
+                }
+                device.info.axis_count = static_cast<DWORD>(axis_count);
+                for(uint64_t i=0; i<axis_count; ++i)
+                {
+                    uint64_t linear_index = 0;
+                    uint64_t axis_index = 0;
+                    if(!read_varint(linear_index) || !read_varint(axis_index))
+                    {
+                        return false;
+                    }
+                    device.info.axis_map[i].linear_index =
+                        static_cast<DWORD>(linear_index);
+                    device.info.axis_map[i].axis_index =
+                        static_cast<DWORD>(axis_index);
+                }
+            }
+
+            reset_values(device.value);
+            device.source_timestamp = 0;
+            device.source_sequence = 0;
+            device.removed = false;
+            m_devices.push_back(device);
+
+            entry.device_id = static_cast<uint32_t>(device_id);
+            entry.device_guid = info.device_guid;
+            return true;
+        }
+
+        case RecordType::DeviceRemoved:
+            if(!read_varint(device_id) || device_id >= m_devices.size() ||
+               m_devices[device_id].removed)
+            {
+                return false;
+            }
+            m_devices[device_id].removed = true;
+            entry.device_id = static_cast<uint32_t>(device_id);
+            entry.device_guid =
+                m_devices[device_id].info.summary.device_guid;
+            return true;
+
+        case RecordType::Input:
+        {
+            uint64_t input = 0;
+            int64_t value = 0;
+            int64_t timestamp = 0;
+            int64_t sequence = 0;
+            if(!read_varint(device_id) || device_id >= m_devices.size() ||
+               m_devices[device_id].removed ||
+               !read_varint(input) || !read_svarint(value) ||
+               !read_svarint(timestamp) || !read_svarint(sequence))
+            {
+                return false;
+            }
+            const uint64_t input_type = input & 0x3;
+            const uint64_t input_index = input >> 2;
+            if(!is_valid_type(input_type) || !is_valid_index(
+                static_cast<JoystickInputType>(input_type),
+                input_index
+            ))
+            {
+                return false;
+            }
+
+            auto& device = m_devices[device_id];
+            JoystickInputData data;
+            data.device_guid = device.info.summary.device_guid;
+            data.input_type = static_cast<JoystickInputType>(input_type);
+            data.input_index = static_cast<UINT8>(input_index);
+            auto& previous = device.value[type_slot(data.input_type)][
+                data.input_index
+            ];
+
+            // The difference of two LONG values, checked before adding so
+            // crafted deltas can neither overflow nor leave LONG's range.
+            const int64_t limit = int64_t(1) << 32;
+            if(value <= -limit || value >= limit)
+            {
+                return false;
+            }
+            const int64_t current = previous + value;
+            if(current < std::numeric_limits<LONG>::min() ||
+               current > std::numeric_limits<LONG>::max())
+            {
+                return false;
+            }
+            data.value = static_cast<LONG>(current);
+            previous = data.value;
+            device.source_timestamp += static_cast<DWORD>(timestamp);
+            device.source_sequence += static_cast<DWORD>(sequence);
+
+            entry.device_id = static_cast<uint32_t>(device_id);
+            entry.device_guid = data.device_guid;
+            entry.event = make_input_event_ex(
+                data,
+                device.source_timestamp,
+                device.source_sequence,
+                m_time_ns
+            );
+            return true;
+        }
+
+        case RecordType::Gap:
+            return read_varint(entry.lost);
+
+        case RecordType::End:
+            m_complete = true;
+            return true;
+    }
+    return false;
+}
+
+bool RecordingReader::read_varint(uint64_t& value)
+{
+    value = 0;
+    for(int shift=0; shift<64; shift+=7)
+    {
+        if(m_offset == m_size)
+        {
+            return false;
+        }
+        const uint8_t byte = m_data[m_offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RecordingReader::read_svarint(int64_t& value)
+{
+    uint64_t raw = 0;
+    if(!read_varint(raw))
+    {
+        return false;
+    }
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+bool RecordingReader::read_bytes(void* out, size_t count)
+{
+    if(m_size - m_offset < count)
+    {
+        return false;
+    }
+    memcpy(out, m_data + m_offset, count);
+    m_offset += count;
+    return true;
+}
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "dill_types.h"
+
+
+/*
+ * Recording file format, version 2
+ * ================================
+ *
+ * A recording is a 24 byte file header followed by a stream of records.
+ * All fixed size integers are little endian. "varint" denotes an unsigned
+ * LEB128 integer: seven bits per byte, least significant group first, the
+ * high bit set on every byte but the last. "svarint" denotes a signed
+ * integer zig-zag mapped onto an unsigned one, (n << 1) ^ (n >> 63), and
+ * then stored as a varint, so small magnitudes of either sign are short.
+ *
+ * File header
+ *   8 bytes    magic "DILLREC\0"
+ *   u32        format version, k_recording_version
+ *   u32        reserved, 0
+ *   u64        base time, nanoseconds of monotonic_time_ns()
+ *
+ * Every record starts with a RecordType byte and the time of the record
+ * as svarint nanoseconds relative to the previous record, respectively the
+ * base time for the first record. The remaining fields depend on the type:
+ *
+ * DeviceAdded
+ *   varint     device id, assigned in increasing order from 0
+ *   16 bytes   GUID: u32 Data1, u16 Data2, u16 Data3, 8 bytes Data4
+ *   varint     vendor_id, product_id, joystick_id
+ *   varint     axis_count, button_count, hat_count
+ *   8 x        varint linear_index, varint axis_index of axis_map
+ *   varint     length of the name, followed by that many bytes
+ *   varint     axis_count of DeviceSummaryEx, at most 32, followed by
+ *              that many varint linear_index, varint axis_index pairs of
+ *              its axis_map, covering the axes with axis_index 9-32 too
+ *
+ * DeviceRemoved
+ *   varint     device id, which is never reused
+ *
+ * Input
+ *   varint     device id
+ *   varint     input_index << 2 | input_type
+ *   svarint    value minus the previous value of the same input
+ *   svarint    source_timestamp minus that of the device's previous event
+ *   svarint    source_sequence minus that of the device's previous event
+ *
+ * Gap
+ *   varint     number of records lost because the writer fell behind
+ *
+ * End
+ *   no fields, written when a recording is closed cleanly
+ *
+ * Previous values start out as the defaults of DeviceState, i.e. 0 for
+ * axes and buttons and -1 for hats, and previous source timestamps and
+ * sequence numbers as 0. Timestamp and sequence differences are taken
+ * modulo 2^32 and stored as the signed 32 bit difference. A recording
+ * lacking an End record was cut short, everything up to the last complete
+ * record is still valid.
+ *
+ * Readers treat a record as malformed if it refers to an unknown or
+ * removed device, an input index outside 1-32 for axes, 1-128 for buttons
+ * or 1-4 for hats, or a value outside the range of LONG.
+ *
+ * Version 1 lacks the extended axis map of DeviceAdded records. Readers
+ * still accept it and derive the map from the 8 axis one, as
+ * extend_device_summary does.
+ */
+
+
+//! Version of the recording format written by RecordingEncoder.
+constexpr uint32_t k_recording_version = 2;
+
+//! Size of the file header preceding the records.
+constexpr size_t k_recording_header_size = 24;
+
+/**
+ * \brief Kinds of records stored in a recording.
+ */
+enum class RecordType : uint8_t
+{
+    DeviceAdded = 1,
+    DeviceRemoved = 2,
+    Input = 3,
+    Gap = 4,
+    End = 5
+};
+
+
+/**
+ * \brief Serializes device changes and input events into the recording
+ *        format.
+ *
+ * Tracks the state needed for the delta encoding, records have to be
+ * encoded in the order they are meant to be read back.
+ */
+class RecordingEncoder
+{
+public:
+    RecordingEncoder() = default;
+
+    /**
+     * \brief Starts a new recording, discarding all delta state.
+     *
+     * \param base_time_ns time the first record's time is relative to
+     * \param out receives the file header
+     */
+    void header(uint64_t base_time_ns, std::vector<uint8_t>& out);
+
+    /**
+     * \brief Encodes the connection of a device.
+     *
+     * Encoding an already connected device again does nothing.
+     *
+     * \param time_ns time of the connection
+     * \param info extended description of the device
+     * \param out receives the record
+     */
+    void device_added(
+        uint64_t                        time_ns,
+        DeviceSummaryEx const&          info,
+        std::vector<uint8_t>&           out
+    );
+
+    /**
+     * \brief Encodes the disconnection of a device.
+     *
+     * \param time_ns time of the disconnection
+     * \param guid GUID of the device
+     * \param out receives the record, nothing if the device is not
+     *        connected
+     */
+    void device_removed(
+        uint64_t                        time_ns,
+        GUID const&                     guid,
+        std::vector<uint8_t>&           out
+    );
+
+    /**
+     * \brief Encodes an input event, timed by its receive time.
+     *
+     * \param evt event to encode
+     * \param out receives the record
+     * \return true if the event was encoded, false if its device is not
+     *         connected or its input index is invalid for its type
+     */
+    bool input(JoystickInputEventEx const& evt, std::vector<uint8_t>& out);
+
+    /**
+     * \brief Encodes the loss of records.
+     *
+     * \param time_ns time at which the loss was noticed
+     * \param count number of lost records
+     * \param out receives the record
+     */
+    void gap(uint64_t time_ns, uint64_t count, std::vector<uint8_t>& out);
+
+    /**
+     * \brief Encodes the end of the recording.
+     *
+     * \param out receives the record
+     */
+    void end(std::vector<uint8_t>& out);
+
+private:
+    struct Device
+    {
+        uint32_t                        id;
+        //! Previous value per input type and index.
+        std::array<std::array<LONG, 256>, 3> value;
+        DWORD                           source_timestamp;
+        DWORD                           source_sequence;
+    };
+
+    void record_start(
+        RecordType                      type,
+        uint64_t                        time_ns,
+        std::vector<uint8_t>&           out
+    );
+
+    std::unordered_map<GUID, Device>    m_devices;
+    uint32_t                            m_next_id = 0;
+    uint64_t                            m_time_ns = 0;
+};
+
+
+/**
+ * \brief A single record read from a recording.
+ */
+struct RecordingEntry
+{
+    RecordType                          type;
+    //! Absolute time of the record, on the clock of the recording process.
+    uint64_t                            time_ns;
+    //! Id of the device of DeviceAdded, DeviceRemoved and Input records.
+    uint32_t                            device_id;
+    //! GUID of the device of DeviceAdded, DeviceRemoved and Input records.
+    GUID                                device_guid;
+    //! Decoded event of Input records, receive_time_ns equals time_ns.
+    JoystickInputEventEx                event;
+    //! Number of lost records of Gap records.
+    uint64_t                            lost;
+};
+
+
+/**
+ * \brief Decodes a recording held in memory.
+ *
+ * The reader does not copy the recording, which has to outlive it. It can
+ * therefore decode memory mapped files in place.
+ */
+class RecordingReader
+{
+public:
+    /**
+     * \brief Creates a reader over a recording.
+     *
+     * \param data first byte of the recording, including the file header
+     * \param size size of the recording in bytes
+     */
+    RecordingReader(uint8_t const* data, size_t size);
+
+    /**
+     * \brief Returns whether the file header is valid and supported.
+     *
+     * \return true if records can be read, false otherwise
+     */
+    bool valid() const;
+
+    /**
+     * \brief Returns the time the first record is relative to.
+     *
+     * \return base time of the recording in nanoseconds
+     */
+    uint64_t base_time_ns() const;
+
+    /**
+     * \brief Decodes the next record.
+     *
+     * \param entry set to the decoded record
+     * \return true if a record was decoded, false at the end of the
+     *         recording or on a malformed or truncated record
+     */
+    bool next(RecordingEntry& entry);
+
+    /**
+     * \brief Returns whether the End record has been read.
+     *
+     * \return true if the recording was closed cleanly and read completely
+     */
+    bool complete() const;
+
+    /**
+     * \brief Returns whether reading stopped at a malformed record.
+     *
+     * A recording cut short in the middle of a record counts as malformed.
+     *
+     * \return true if the remaining data could not be decoded
+     */
+    bool failed() const;
+
+    /**
+     * \brief Returns the description of a device.
+     *
+     * \param device_id id of a device whose DeviceAdded record was read
+     * \return description of the device
+     */
+    DeviceSummary const& device(uint32_t device_id) const;
+
+    /**
+     * \brief Returns the extended description of a device.
+     *
+     * \param device_id id of a device whose DeviceAdded record was read
+     * \return extended description of the device, including every axis
+     */
+    DeviceSummaryEx const& device_ex(uint32_t device_id) const;
+
+    /**
+     * \brief Restarts reading at the first record.
+     */
+    void rewind();
+
+private:
+    struct Device
+    {
+        DeviceSummaryEx                 info;
+        std::array<std::array<LONG, 256>, 3> value;
+        DWORD                           source_timestamp;
+        DWORD                           source_sequence;
+        //! Whether the DeviceRemoved record of the device was read.
+        bool                            removed;
+    };
+
+    bool read_record(RecordingEntry& entry);
+    bool read_varint(uint64_t& value);
+    bool read_svarint(int64_t& value);
+    bool read_bytes(void* out, size_t count);
+
+    uint8_t const*                      m_data;
+    size_t                              m_size;
+    size_t                              m_offset = 0;
+    bool                                m_valid = false;
+    uint32_t                            m_version = 0;
+    bool                                m_complete = false;
+    bool                                m_failed = false;
+    uint64_t                            m_base_time_ns = 0;
+    uint64_t                            m_time_ns = 0;
+    std::vector<Device>                 m_devices;
+};
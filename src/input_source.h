@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "dill_types.h"
+
+
+/**
+ * \brief Receives devices and their input from an InputSource.
+ *
+ * All methods are invoked from the thread running InputSource::process.
+ */
+class InputSink
+{
+public:
+    virtual ~InputSink() = default;
+
+    /**
+     * \brief Announces a newly available device.
+     *
+     * \param info description of the device
+     * \return true if the device is tracked, false if its input is to be
+     *         ignored, for example because a device with the same GUID is
+     *         already tracked
+     */
+    virtual bool device_added(DeviceSummary const& info) = 0;
+
+    /**
+     * \brief Announces a newly available device described with all axes.
+     *
+     * Used by sources knowing the axes with axis_index 9-32 of a device,
+     * such as ReplaySource. By default the extended axis map is ignored.
+     *
+     * \param info extended description of the device
+     * \return true if the device is tracked, false if its input is to be
+     *         ignored
+     */
+    virtual bool device_added_ex(DeviceSummaryEx const& info)
+    {
+        return device_added(info.summary);
+    }
+
+    /**
+     * \brief Announces that a device is no longer available.
+     *
+     * \param guid GUID of the removed device
+     */
+    virtual void device_removed(GUID const& guid) = 0;
+
+    /**
+     * \brief Hands over the input read from a single device in one go.
+     *
+     * \param guid GUID of the device the events belong to
+     * \param events events in the order they occurred
+     */
+    virtual void input_events(
+        GUID const&                     guid,
+        std::vector<JoystickInputEventEx> const& events
+    ) = 0;
+};
+
+
+/**
+ * \brief Platform specific provider of devices and their input.
+ *
+ * A source detects devices and reads their input, translating both into
+ * DILL's device and 1-based axis, button and hat model. Everything else,
+ * tracking device state and delivering events to the client, is shared by
+ * all sources and happens in the InputSink.
+ */
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+
+    /**
+     * \brief Waits for input and hands everything pending to a sink.
+     *
+     * Only ever called by a single thread at a time.
+     *
+     * \param sink receives device changes and input events
+     * \param timeout maximum time to wait if nothing is pending
+     * \return false if the source failed and cannot continue, true
+     *         otherwise
+     */
+    virtual bool process(InputSink& sink, std::chrono::milliseconds timeout) = 0;
+
+    /**
+     * \brief Makes a pending or the next process call return promptly.
+     *
+     * Safe to call from any thread.
+     */
+    virtual void wake() = 0;
+};
@@ -0,0 +1,93 @@
+#include "input_subscription.h"
+
+#include <algorithm>
+
+
+namespace
+{
+    const ButtonMask k_every_index = ButtonMask::first(k_max_buttons);
+}
+
+
+InputSubscription::InputSubscription()
+{
+    reset();
+}
+
+bool InputSubscription::set(DWORD type_mask, uint64_t const* index_bitset)
+{
+    const DWORD valid = k_subscribe_axes | k_subscribe_buttons |
+        k_subscribe_hats;
+    if(type_mask == 0 || (type_mask & ~valid) != 0)
+    {
+        return false;
+    }
+
+    ButtonMask indices = k_every_index;
+    if(index_bitset != nullptr)
+    {
+        indices.bits = {index_bitset[0], index_bitset[1]};
+    }
+    if(type_mask & k_subscribe_axes)
+    {
+        m_indices[static_cast<size_t>(JoystickInputType::Axis)] = indices;
+    }
+    if(type_mask & k_subscribe_buttons)
+    {
+        m_indices[static_cast<size_t>(JoystickInputType::Button)] = indices;
+    }
+    if(type_mask & k_subscribe_hats)
+    {
+        m_indices[static_cast<size_t>(JoystickInputType::Hat)] = indices;
+    }
+
+    m_all = true;
+    for(size_t type=1; type<m_indices.size(); ++type)
+    {
+        m_all = m_all && m_indices[type] == k_every_index;
+    }
+    return true;
+}
+
+void InputSubscription::reset()
+{
+    m_indices.fill(k_every_index);
+    m_all = true;
+}
+
+bool InputSubscription::all() const
+{
+    return m_all;
+}
+
+bool InputSubscription::subscribed(JoystickInputData const& evt) const
+{
+    const auto type = static_cast<size_t>(evt.input_type);
+    if(type == 0 || type >= m_indices.size() ||
+       evt.input_index == 0 || evt.input_index > k_max_buttons)
+    {
+        return true;
+    }
+    return m_indices[type].test(evt.input_index);
+}
+
+size_t InputSubscription::filter(
+    std::vector<JoystickInputEventEx>&  events
+) const
+{
+    if(m_all)
+    {
+        return 0;
+    }
+
+    const auto end = std::remove_if(
+        events.begin(),
+        events.end(),
+        [this](JoystickInputEventEx const& evt) {
+            return !subscribed(evt.data);
+        }
+    );
+    const auto removed = static_cast<size_t>(events.end() - end);
+    events.erase(end, events.end());
+    return removed;
+}
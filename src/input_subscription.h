@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "button_mask.h"
+#include "dill_types.h"
+
+
+/**
+ * \brief Inputs of a device whose events are delivered to the client.
+ *
+ * Holds one 128 bit ButtonMask per input type with bit N-1 selecting the
+ * input with index N, so deciding on an event is a single bit test. An
+ * empty mask mutes every input of its type. Initially every mask is full,
+ * and while they all are filter() returns without looking at the events.
+ * Events of unknown types or out of range indices are always delivered.
+ */
+class InputSubscription
+{
+public:
+    InputSubscription();
+
+    /**
+     * \brief Replaces the subscribed inputs of one or more input types.
+     *
+     * Types not selected by the type mask keep their subscription.
+     *
+     * \param type_mask combination of k_subscribe_axes, k_subscribe_buttons
+     *        and k_subscribe_hats
+     * \param index_bitset two words with bit N-1 selecting input N, nullptr
+     *        subscribes to every input of the selected types
+     * \return true if the subscription was changed, false if the type mask
+     *         is invalid
+     */
+    bool set(DWORD type_mask, uint64_t const* index_bitset);
+
+    /**
+     * \brief Subscribes to every input again.
+     */
+    void reset();
+
+    /**
+     * \brief Returns whether every input is subscribed.
+     *
+     * \return true if no event is filtered
+     */
+    bool all() const;
+
+    /**
+     * \brief Returns whether the event of an input is delivered.
+     *
+     * \param evt event to check
+     * \return true if the event's input is subscribed
+     */
+    bool subscribed(JoystickInputData const& evt) const;
+
+    /**
+     * \brief Removes the events of unsubscribed inputs.
+     *
+     * \param events events of the device, filtered in place
+     * \return number of removed events
+     */
+    size_t filter(std::vector<JoystickInputEventEx>& events) const;
+
+private:
+    // Indexed by JoystickInputType, index 0 is unused.
+    std::array<ButtonMask, 4>           m_indices;
+    bool                                m_all;
+};
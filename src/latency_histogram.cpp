@@ -0,0 +1,153 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+    const size_t k_sub_bucket_count = size_t(1) <<
+        LatencyHistogram::k_sub_bucket_bits;
+
+    // Index of the highest set bit of a non-zero value.
+    size_t highest_bit(uint64_t value)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long bit;
+        _BitScanReverse64(&bit, value);
+        return bit;
+#elif defined(_MSC_VER)
+        unsigned long bit;
+        if(_BitScanReverse(&bit, static_cast<unsigned long>(value >> 32)))
+        {
+            return bit + 32;
+        }
+        _BitScanReverse(&bit, static_cast<unsigned long>(value));
+        return bit;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    // Smallest bucket value whose cumulative count reaches the quantile.
+    uint64_t percentile(
+        std::array<uint64_t, LatencyHistogram::k_bucket_count> const& counts,
+        uint64_t                        total,
+        double                          quantile
+    )
+    {
+        const uint64_t target = std::max<uint64_t>(
+            1,
+            static_cast<uint64_t>(quantile * total + 0.999999)
+        );
+        uint64_t cumulative = 0;
+        for(size_t i=0; i<counts.size(); ++i)
+        {
+            cumulative += counts[i];
+            if(cumulative >= target)
+            {
+                return LatencyHistogram::bucket_upper_bound(i);
+            }
+        }
+        return LatencyHistogram::bucket_upper_bound(counts.size() - 1);
+    }
+}
+
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(uint64_t value_ns)
+{
+    increment(m_buckets[bucket_index(value_ns)], 1);
+    increment(m_count, 1);
+    increment(m_sum, value_ns);
+    if(value_ns < m_min.load(std::memory_order_relaxed))
+    {
+        m_min.store(value_ns, std::memory_order_relaxed);
+    }
+    if(value_ns > m_max.load(std::memory_order_relaxed))
+    {
+        m_max.store(value_ns, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for(auto& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(
+        std::numeric_limits<uint64_t>::max(),
+        std::memory_order_relaxed
+    );
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::summary() const
+{
+    // Percentiles are computed from one copy of the buckets, so they are
+    // consistent with each other even while values are being recorded.
+    std::array<uint64_t, k_bucket_count> counts;
+    uint64_t total = 0;
+    for(size_t i=0; i<counts.size(); ++i)
+    {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    LatencySummary result{};
+    if(total == 0)
+    {
+        return result;
+    }
+    result.count = total;
+    result.min_ns = m_min.load(std::memory_order_relaxed);
+    result.max_ns = m_max.load(std::memory_order_relaxed);
+    result.mean_ns = m_sum.load(std::memory_order_relaxed) /
+        std::max<uint64_t>(m_count.load(std::memory_order_relaxed), 1);
+    result.p50_ns = std::min(percentile(counts, total, 0.5), result.max_ns);
+    result.p90_ns = std::min(percentile(counts, total, 0.9), result.max_ns);
+    result.p99_ns = std::min(percentile(counts, total, 0.99), result.max_ns);
+    result.p999_ns = std::min(
+        percentile(counts, total, 0.999),
+        result.max_ns
+    );
+    return result;
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t value_ns)
+{
+    const uint64_t value = std::min(value_ns, k_max_value);
+    if(value < k_sub_bucket_count)
+    {
+        return static_cast<size_t>(value);
+    }
+    const size_t shift = highest_bit(value) - k_sub_bucket_bits;
+    return shift * k_sub_bucket_count + static_cast<size_t>(value >> shift);
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index)
+{
+    if(index < 2 * k_sub_bucket_count)
+    {
+        return index;
+    }
+    const size_t shift = index / k_sub_bucket_count - 1;
+    const uint64_t sub_bucket = index - shift * k_sub_bucket_count;
+    return ((sub_bucket + 1) << shift) - 1;
+}
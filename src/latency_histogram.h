@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * \brief Points along the input path whose latency is tracked.
+ *
+ * Apart from Report, every stage is measured from the moment DILL read the
+ * events of a wakeup, the receive_time_ns of the batch's first event.
+ */
+enum class LatencyStage : uint8_t
+{
+    //! From the DirectInput report timestamp until DILL read the event,
+    //! buffered devices only, millisecond resolution.
+    Report = 1,
+    //! Until the events of the wakeup were decoded.
+    Decode = 2,
+    //! Until the device state reflected the events.
+    StateUpdate = 3,
+    //! Until an input callback was invoked with the events.
+    CallbackEntry = 4,
+    //! Until the input callback returned.
+    CallbackExit = 5
+};
+
+/**
+ * \brief Distribution of the latencies recorded in a LatencyHistogram.
+ *
+ * Percentiles report the highest value of the bucket they fall into, so
+ * they overestimate the true value by at most 1/16th.
+ */
+struct LatencySummary
+{
+    //! Number of recorded latencies.
+    uint64_t                            count;
+    uint64_t                            min_ns;
+    uint64_t                            max_ns;
+    uint64_t                            mean_ns;
+    uint64_t                            p50_ns;
+    uint64_t                            p90_ns;
+    uint64_t                            p99_ns;
+    uint64_t                            p999_ns;
+};
+
+
+/**
+ * \brief Fixed size log-linear histogram of latencies.
+ *
+ * Values are grouped HDR histogram style: each power of two range is split
+ * into 16 linear buckets, bounding the relative error to 1/16th from 16ns
+ * up to 2^36ns (about 69 seconds), larger values are counted in the last
+ * bucket. Recording never allocates and costs a bit scan plus a few
+ * relaxed loads and stores.
+ *
+ * Only a single thread may record into a histogram, any number of threads
+ * may read a summary concurrently. A summary taken while values are being
+ * recorded can be off by the values recorded during the read.
+ */
+class LatencyHistogram
+{
+public:
+    //! Number of linear buckets per power of two is 2^k_sub_bucket_bits.
+    static constexpr size_t k_sub_bucket_bits = 4;
+    //! Largest value tracked with full precision.
+    static constexpr uint64_t k_max_value = (uint64_t(1) << 36) - 1;
+    //! Number of buckets covering 0 to k_max_value.
+    static constexpr size_t k_bucket_count =
+        (36 - k_sub_bucket_bits + 1) << k_sub_bucket_bits;
+
+    LatencyHistogram();
+    LatencyHistogram(LatencyHistogram const&) = delete;
+    LatencyHistogram& operator=(LatencyHistogram const&) = delete;
+
+    /**
+     * \brief Adds a latency to the histogram.
+     *
+     * \param value_ns latency in nanoseconds
+     */
+    void record(uint64_t value_ns);
+
+    /**
+     * \brief Removes all recorded latencies.
+     *
+     * Must only be called by the recording thread.
+     */
+    void reset();
+
+    /**
+     * \brief Returns the number of recorded latencies.
+     *
+     * \return number of recorded latencies
+     */
+    uint64_t count() const;
+
+    /**
+     * \brief Returns the distribution of the recorded latencies.
+     *
+     * \return summary of the recorded latencies, all zero if none exist
+     */
+    LatencySummary summary() const;
+
+    /**
+     * \brief Returns the bucket a value is counted in.
+     *
+     * \param value_ns latency in nanoseconds
+     * \return index of the bucket
+     */
+    static size_t bucket_index(uint64_t value_ns);
+
+    /**
+     * \brief Returns the highest value counted in a bucket.
+     *
+     * \param index index of the bucket
+     * \return highest value of the bucket in nanoseconds
+     */
+    static uint64_t bucket_upper_bound(size_t index);
+
+private:
+    using Counter = std::atomic<uint64_t>;
+
+    static void increment(Counter& counter, uint64_t value)
+    {
+        counter.store(
+            counter.load(std::memory_order_relaxed) + value,
+            std::memory_order_relaxed
+        );
+    }
+
+    std::array<Counter, k_bucket_count> m_buckets;
+    Counter                             m_count;
+    Counter                             m_sum;
+    Counter                             m_min;
+    Counter                             m_max;
+};
@@ -0,0 +1,137 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <system_error>
+
+#ifdef _WIN32
+#include "platform.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(std::string const& path)
+{
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        throw std::system_error(
+            GetLastError(), std::system_category(), "CreateFile"
+        );
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size))
+    {
+        const auto error = GetLastError();
+        CloseHandle(file);
+        throw std::system_error(error, std::system_category(), "GetFileSizeEx");
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    if(m_size == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    // The view keeps the mapping alive, neither handle is needed past it.
+    HANDLE mapping = CreateFileMappingA(
+        file, nullptr, PAGE_READONLY, 0, 0, nullptr
+    );
+    const auto mapping_error = GetLastError();
+    CloseHandle(file);
+    if(mapping == nullptr)
+    {
+        throw std::system_error(
+            mapping_error, std::system_category(), "CreateFileMapping"
+        );
+    }
+    m_data = static_cast<uint8_t const*>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+    );
+    const auto view_error = GetLastError();
+    CloseHandle(mapping);
+    if(m_data == nullptr)
+    {
+        throw std::system_error(
+            view_error, std::system_category(), "MapViewOfFile"
+        );
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if(m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(std::string const& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "open");
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "fstat");
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    if(m_size == 0)
+    {
+        ::close(fd);
+        return;
+    }
+
+    // The mapping stays valid after closing the descriptor.
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if(data == MAP_FAILED)
+    {
+        throw std::system_error(error, std::generic_category(), "mmap");
+    }
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<uint8_t const*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    if(m_data != nullptr)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+#endif
+
+uint8_t const* MappedFile::data() const
+{
+    return m_data;
+}
+
+size_t MappedFile::size() const
+{
+    return m_size;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/**
+ * \brief Read-only memory mapping of an entire file.
+ *
+ * Pages are only loaded as they are accessed, which allows sequentially
+ * reading files much larger than the available memory.
+ */
+class MappedFile
+{
+public:
+    /**
+     * \brief Maps a file into memory.
+     *
+     * \param path path of the file to map
+     * \throws std::system_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(std::string const& path);
+    ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    /**
+     * \brief Returns the first byte of the file.
+     *
+     * \return first byte of the mapping, nullptr for an empty file
+     */
+    uint8_t const* data() const;
+
+    /**
+     * \brief Returns the size of the file.
+     *
+     * \return size of the file in bytes
+     */
+    size_t size() const;
+
+private:
+    uint8_t const*                      m_data = nullptr;
+    size_t                              m_size = 0;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "dill_types.h"
+
+
+/**
+ * \brief Input a DIJOYSTATE2 byte offset refers to.
+ */
+struct DecodedOffset
+{
+    //! Type of the input, 0 if the offset is not decoded by DILL.
+    JoystickInputType                   input_type;
+    //! 1-based index of the input, axis_index for axes.
+    UINT8                               input_index;
+};
+
+/**
+ * \brief DIJOYSTATE2 byte offset of every axis, indexed by axis_index - 1.
+ *
+ * X, Y, Z, Rx, Ry, Rz and the two sliders, followed by the velocity,
+ * acceleration and force groups in the same order. Uses offsetof instead
+ * of the DIJOFS macros, the Windows definition of FIELD_OFFSET is not a
+ * constant expression.
+ */
+constexpr std::array<DWORD, k_max_axes> k_axis_offsets = {
+    offsetof(DIJOYSTATE2, lX),
+    offsetof(DIJOYSTATE2, lY),
+    offsetof(DIJOYSTATE2, lZ),
+    offsetof(DIJOYSTATE2, lRx),
+    offsetof(DIJOYSTATE2, lRy),
+    offsetof(DIJOYSTATE2, lRz),
+    offsetof(DIJOYSTATE2, rglSlider),
+    offsetof(DIJOYSTATE2, rglSlider) + sizeof(LONG),
+    offsetof(DIJOYSTATE2, lVX),
+    offsetof(DIJOYSTATE2, lVY),
+    offsetof(DIJOYSTATE2, lVZ),
+    offsetof(DIJOYSTATE2, lVRx),
+    offsetof(DIJOYSTATE2, lVRy),
+    offsetof(DIJOYSTATE2, lVRz),
+    offsetof(DIJOYSTATE2, rglVSlider),
+    offsetof(DIJOYSTATE2, rglVSlider) + sizeof(LONG),
+    offsetof(DIJOYSTATE2, lAX),
+    offsetof(DIJOYSTATE2, lAY),
+    offsetof(DIJOYSTATE2, lAZ),
+    offsetof(DIJOYSTATE2, lARx),
+    offsetof(DIJOYSTATE2, lARy),
+    offsetof(DIJOYSTATE2, lARz),
+    offsetof(DIJOYSTATE2, rglASlider),
+    offsetof(DIJOYSTATE2, rglASlider) + sizeof(LONG),
+    offsetof(DIJOYSTATE2, lFX),
+    offsetof(DIJOYSTATE2, lFY),
+    offsetof(DIJOYSTATE2, lFZ),
+    offsetof(DIJOYSTATE2, lFRx),
+    offsetof(DIJOYSTATE2, lFRy),
+    offsetof(DIJOYSTATE2, lFRz),
+    offsetof(DIJOYSTATE2, rglFSlider),
+    offsetof(DIJOYSTATE2, rglFSlider) + sizeof(LONG)
+};
+
+namespace detail
+{
+    constexpr std::array<DecodedOffset, sizeof(DIJOYSTATE2)>
+        build_offset_table()
+    {
+        std::array<DecodedOffset, sizeof(DIJOYSTATE2)> table{};
+
+        for(size_t i=0; i<k_axis_offsets.size(); ++i)
+        {
+            table[k_axis_offsets[i]] = {
+                JoystickInputType::Axis,
+                static_cast<UINT8>(i + 1)
+            };
+        }
+        for(size_t i=0; i<4; ++i)
+        {
+            table[offsetof(DIJOYSTATE2, rgdwPOV) + i * sizeof(DWORD)] = {
+                JoystickInputType::Hat,
+                static_cast<UINT8>(i + 1)
+            };
+        }
+        for(size_t i=0; i<128; ++i)
+        {
+            table[offsetof(DIJOYSTATE2, rgbButtons) + i] = {
+                JoystickInputType::Button,
+                static_cast<UINT8>(i + 1)
+            };
+        }
+        return table;
+    }
+}
+
+/**
+ * \brief Input referred to by every byte offset of a DIJOYSTATE2 report.
+ *
+ * Offsets that do not start an axis, hat or button, i.e. the bytes within
+ * a LONG or DWORD member, map to an entry with input type 0.
+ */
+constexpr std::array<DecodedOffset, sizeof(DIJOYSTATE2)> k_offset_table =
+    detail::build_offset_table();
+
+/**
+ * \brief Returns the input a DIDEVICEOBJECTDATA::dwOfs value refers to.
+ *
+ * \param offset DIJOYSTATE2 byte offset reported by DirectInput
+ * \return input at the offset, input type 0 if there is none
+ */
+constexpr DecodedOffset decode_offset(DWORD offset)
+{
+    return offset < k_offset_table.size()
+        ? k_offset_table[offset]
+        : DecodedOffset{};
+}
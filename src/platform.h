@@ -0,0 +1,121 @@
+#pragma once
+
+/**
+ * Provides the Windows and DirectInput types shared by DILL's platform
+ * independent components.
+ *
+ * On Windows this simply pulls in the system headers. Elsewhere it defines
+ * layout compatible equivalents of the handful of types and macros those
+ * components use, so they can be built and tested without DirectInput.
+ */
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef DIRECTINPUT_VERSION
+#define DIRECTINPUT_VERSION 0x0800
+#endif
+
+#include <windows.h>
+#include <dinput.h>
+
+#else
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+typedef uint8_t                         BYTE;
+typedef uint8_t                         UINT8;
+typedef uint32_t                        DWORD;
+typedef int32_t                         LONG;
+typedef int                             BOOL;
+typedef uintptr_t                       UINT_PTR;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define MAX_PATH 260
+#define FIELD_OFFSET(type, field) offsetof(type, field)
+
+struct GUID
+{
+    DWORD                               Data1;
+    uint16_t                            Data2;
+    uint16_t                            Data3;
+    BYTE                                Data4[8];
+};
+
+inline bool operator==(GUID const& lhs, GUID const& rhs)
+{
+    return memcmp(&lhs, &rhs, sizeof(GUID)) == 0;
+}
+
+inline bool operator!=(GUID const& lhs, GUID const& rhs)
+{
+    return !(lhs == rhs);
+}
+
+struct DIJOYSTATE2
+{
+    LONG                                lX;
+    LONG                                lY;
+    LONG                                lZ;
+    LONG                                lRx;
+    LONG                                lRy;
+    LONG                                lRz;
+    LONG                                rglSlider[2];
+    DWORD                               rgdwPOV[4];
+    BYTE                                rgbButtons[128];
+    LONG                                lVX;
+    LONG                                lVY;
+    LONG                                lVZ;
+    LONG                                lVRx;
+    LONG                                lVRy;
+    LONG                                lVRz;
+    LONG                                rglVSlider[2];
+    LONG                                lAX;
+    LONG                                lAY;
+    LONG                                lAZ;
+    LONG                                lARx;
+    LONG                                lARy;
+    LONG                                lARz;
+    LONG                                rglASlider[2];
+    LONG                                lFX;
+    LONG                                lFY;
+    LONG                                lFZ;
+    LONG                                lFRx;
+    LONG                                lFRy;
+    LONG                                lFRz;
+    LONG                                rglFSlider[2];
+};
+
+struct DIDEVICEOBJECTDATA
+{
+    DWORD                               dwOfs;
+    DWORD                               dwData;
+    DWORD                               dwTimeStamp;
+    DWORD                               dwSequence;
+    UINT_PTR                            uAppData;
+};
+
+#define DIJOFS_X            FIELD_OFFSET(DIJOYSTATE2, lX)
+#define DIJOFS_Y            FIELD_OFFSET(DIJOYSTATE2, lY)
+#define DIJOFS_Z            FIELD_OFFSET(DIJOYSTATE2, lZ)
+#define DIJOFS_RX           FIELD_OFFSET(DIJOYSTATE2, lRx)
+#define DIJOFS_RY           FIELD_OFFSET(DIJOYSTATE2, lRy)
+#define DIJOFS_RZ           FIELD_OFFSET(DIJOYSTATE2, lRz)
+#define DIJOFS_SLIDER(n)    (FIELD_OFFSET(DIJOYSTATE2, rglSlider) + (n) * sizeof(LONG))
+#define DIJOFS_POV(n)       (FIELD_OFFSET(DIJOYSTATE2, rgdwPOV) + (n) * sizeof(DWORD))
+#define DIJOFS_BUTTON(n)    (FIELD_OFFSET(DIJOYSTATE2, rgbButtons) + (n))
+
+static_assert(sizeof(GUID) == 16, "GUID layout mismatch");
+static_assert(sizeof(DIJOYSTATE2) == 272, "DIJOYSTATE2 layout mismatch");
+
+#endif
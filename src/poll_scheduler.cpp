@@ -0,0 +1,123 @@
+#include "poll_scheduler.h"
+
+#include <algorithm>
+
+
+constexpr std::chrono::microseconds PollScheduler::k_min_interval;
+constexpr std::chrono::microseconds PollScheduler::k_max_interval;
+constexpr uint32_t PollScheduler::k_idle_polls_per_step;
+
+
+void PollScheduler::sync(
+    std::vector<PolledDevice> const&    devices,
+    std::chrono::microseconds           now
+)
+{
+    std::vector<Entry> entries;
+    entries.reserve(devices.size());
+    for(auto const& device : devices)
+    {
+        const auto min_interval = std::max(device.min_interval, k_min_interval);
+
+        auto const* existing = find(device.ref);
+        if(existing != nullptr)
+        {
+            auto entry = *existing;
+            entry.min_interval = min_interval;
+            entry.interval = std::max(entry.interval, min_interval);
+            entries.push_back(entry);
+        }
+        else
+        {
+            entries.push_back({device.ref, min_interval, min_interval, now, 0});
+        }
+    }
+    m_entries = std::move(entries);
+}
+
+void PollScheduler::due(
+    std::chrono::microseconds           now,
+    std::vector<SlotRef>&               refs
+) const
+{
+    refs.clear();
+    for(auto const& entry : m_entries)
+    {
+        if(entry.next_poll <= now)
+        {
+            refs.push_back(entry.ref);
+        }
+    }
+}
+
+void PollScheduler::record(
+    SlotRef                             ref,
+    bool                                changed,
+    std::chrono::microseconds           now
+)
+{
+    auto* entry = find(ref);
+    if(entry == nullptr)
+    {
+        return;
+    }
+
+    if(changed)
+    {
+        entry->interval = entry->min_interval;
+        entry->idle_polls = 0;
+    }
+    else if(++entry->idle_polls >= k_idle_polls_per_step)
+    {
+        entry->interval = std::min(
+            entry->interval * 2,
+            std::max(k_max_interval, entry->min_interval)
+        );
+        entry->idle_polls = 0;
+    }
+    entry->next_poll = now + entry->interval;
+}
+
+std::chrono::microseconds PollScheduler::time_until_next(
+    std::chrono::microseconds           now
+) const
+{
+    auto result = std::chrono::microseconds::max();
+    for(auto const& entry : m_entries)
+    {
+        result = std::min(
+            result,
+            std::max(entry.next_poll - now, std::chrono::microseconds(0))
+        );
+    }
+    return result;
+}
+
+std::chrono::microseconds PollScheduler::interval(SlotRef ref) const
+{
+    for(auto const& entry : m_entries)
+    {
+        if(entry.ref == ref)
+        {
+            return entry.interval;
+        }
+    }
+    return std::chrono::microseconds(0);
+}
+
+bool PollScheduler::empty() const
+{
+    return m_entries.empty();
+}
+
+PollScheduler::Entry* PollScheduler::find(SlotRef ref)
+{
+    for(auto& entry : m_entries)
+    {
+        if(entry.ref == ref)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
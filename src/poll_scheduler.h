@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "device_slot_table.h"
+
+
+/**
+ * \brief A device to be serviced by polling rather than notifications.
+ */
+struct PolledDevice
+{
+    //! Slot of the device at its current generation.
+    SlotRef                             ref;
+    //! Shortest interval between two polls of the device.
+    std::chrono::microseconds           min_interval;
+};
+
+
+/**
+ * \brief Decides when each polled device is due to be polled.
+ *
+ * Every device starts out polled at its shortest interval. Each time a
+ * device returns the same report k_idle_polls_per_step times in a row its
+ * interval doubles, up to k_max_interval, so a device nobody touches costs
+ * a fraction of the wakeups. The first changed report snaps the device back
+ * to its shortest interval.
+ *
+ * The scheduler does not read any clock itself, all times are passed in as
+ * durations since an arbitrary fixed point, which allows driving it with a
+ * virtual clock. Not thread-safe, in DILL it is owned by the event loop
+ * thread.
+ */
+class PollScheduler
+{
+public:
+    //! Default and shortest interval between polls of a device.
+    static constexpr std::chrono::microseconds k_min_interval{1000};
+    //! Longest interval an idle device backs off to.
+    static constexpr std::chrono::microseconds k_max_interval{16000};
+    //! Number of unchanged reports after which the interval doubles.
+    static constexpr uint32_t k_idle_polls_per_step = 4;
+
+    /**
+     * \brief Replaces the set of devices to poll.
+     *
+     * Devices already known keep their current interval and due time,
+     * devices new to the scheduler are due immediately.
+     *
+     * \param devices all devices that are to be polled from now on
+     * \param now current time
+     */
+    void sync(
+        std::vector<PolledDevice> const& devices,
+        std::chrono::microseconds       now
+    );
+
+    /**
+     * \brief Returns the devices due to be polled.
+     *
+     * \param now current time
+     * \param refs receives the slot of every device due at now
+     */
+    void due(std::chrono::microseconds now, std::vector<SlotRef>& refs) const;
+
+    /**
+     * \brief Records the outcome of polling a device.
+     *
+     * \param ref slot of the polled device
+     * \param changed true if the device reported a change
+     * \param now time at which the device was polled
+     */
+    void record(SlotRef ref, bool changed, std::chrono::microseconds now);
+
+    /**
+     * \brief Returns the time until the next device is due.
+     *
+     * \param now current time
+     * \return time until the next poll, zero if a device is overdue, and
+     *         std::chrono::microseconds::max() if no device is polled
+     */
+    std::chrono::microseconds time_until_next(
+        std::chrono::microseconds       now
+    ) const;
+
+    /**
+     * \brief Returns the current polling interval of a device.
+     *
+     * \param ref slot of the device
+     * \return interval of the device, zero if it is not polled
+     */
+    std::chrono::microseconds interval(SlotRef ref) const;
+
+    /**
+     * \brief Returns whether any device is polled.
+     *
+     * \return true if no device is polled, false otherwise
+     */
+    bool empty() const;
+
+private:
+    struct Entry
+    {
+        SlotRef                         ref;
+        std::chrono::microseconds       min_interval;
+        std::chrono::microseconds       interval;
+        std::chrono::microseconds       next_poll;
+        uint32_t                        idle_polls;
+    };
+
+    Entry* find(SlotRef ref);
+
+    std::vector<Entry>                  m_entries;
+};
@@ -0,0 +1,179 @@
+#include "replay_source.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "event_timing.h"
+
+
+ReplaySource::ReplaySource(
+    std::string const&                  path,
+    ReplayConfig const&                 config
+)
+    :   m_config(config)
+      , m_file(path)
+      , m_reader(m_file.data(), m_file.size())
+{
+    if(!m_reader.valid())
+    {
+        throw std::runtime_error(path + " is not a supported DILL recording");
+    }
+
+    read_next();
+    if(m_has_next)
+    {
+        m_first_time_ns = m_next.time_ns;
+    }
+}
+
+size_t ReplaySource::advance(
+    InputSink&                          sink,
+    std::chrono::nanoseconds            elapsed
+)
+{
+    const int64_t due = recorded_elapsed(elapsed);
+
+    size_t count = 0;
+    while(m_has_next && count < k_max_records_per_call &&
+          static_cast<int64_t>(m_next.time_ns - m_first_time_ns) <= due)
+    {
+        switch(m_next.type)
+        {
+            case RecordType::Input:
+                // Events read in one wakeup share their receive time.
+                if(!m_events.empty() &&
+                   (m_events_guid != m_next.device_guid ||
+                    m_events_time_ns != m_next.time_ns))
+                {
+                    flush(sink);
+                }
+                m_events.push_back(m_next.event);
+                m_events_guid = m_next.device_guid;
+                m_events_time_ns = m_next.time_ns;
+                break;
+            case RecordType::DeviceAdded:
+                flush(sink);
+                sink.device_added_ex(m_reader.device_ex(m_next.device_id));
+                break;
+            case RecordType::DeviceRemoved:
+                flush(sink);
+                sink.device_removed(m_next.device_guid);
+                break;
+            default:
+                break;
+        }
+        ++count;
+        read_next();
+    }
+    flush(sink);
+    return count;
+}
+
+bool ReplaySource::finished() const
+{
+    return !m_has_next;
+}
+
+bool ReplaySource::truncated() const
+{
+    return m_reader.failed();
+}
+
+uint64_t ReplaySource::replayed() const
+{
+    return m_replayed;
+}
+
+bool ReplaySource::process(
+    InputSink&                          sink,
+    std::chrono::milliseconds           timeout
+)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if(!m_started)
+    {
+        m_start = now;
+        m_started = true;
+    }
+
+    if(m_config.mode == ReplayMode::AsFastAsPossible)
+    {
+        advance(sink, std::chrono::nanoseconds::max());
+        return !finished();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - m_start
+    );
+    advance(sink, elapsed);
+    if(finished())
+    {
+        return false;
+    }
+
+    // Sleep until the next record is due.
+    const int64_t delay = static_cast<int64_t>(
+        m_next.time_ns - m_first_time_ns
+    ) - recorded_elapsed(elapsed);
+    const auto wait = std::min<std::chrono::nanoseconds>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+        std::chrono::nanoseconds(static_cast<int64_t>(delay / speed()))
+    );
+
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    m_wake_condition.wait_for(lock, wait, [this] { return m_woken; });
+    m_woken = false;
+    return true;
+}
+
+void ReplaySource::wake()
+{
+    std::lock_guard<std::mutex> lock(m_wake_mutex);
+    m_woken = true;
+    m_wake_condition.notify_one();
+}
+
+void ReplaySource::read_next()
+{
+    m_has_next = m_reader.next(m_next);
+}
+
+void ReplaySource::flush(InputSink& sink)
+{
+    if(m_events.empty())
+    {
+        return;
+    }
+
+    if(m_config.restamp)
+    {
+        const uint64_t now = monotonic_time_ns();
+        for(auto& evt : m_events)
+        {
+            evt.receive_time_ns = now;
+        }
+    }
+    sink.input_events(m_events_guid, m_events);
+    m_replayed += m_events.size();
+    m_events.clear();
+}
+
+double ReplaySource::speed() const
+{
+    if(m_config.mode == ReplayMode::Accelerated && m_config.speed > 0.0)
+    {
+        return m_config.speed;
+    }
+    return 1.0;
+}
+
+int64_t ReplaySource::recorded_elapsed(std::chrono::nanoseconds elapsed) const
+{
+    const double scaled = static_cast<double>(elapsed.count()) * speed();
+    if(scaled >= static_cast<double>(std::numeric_limits<int64_t>::max()))
+    {
+        return std::numeric_limits<int64_t>::max();
+    }
+    return static_cast<int64_t>(scaled);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dill_types.h"
+#include "input_recording.h"
+#include "input_source.h"
+#include "mapped_file.h"
+
+
+/**
+ * \brief How fast a ReplaySource replays a recording.
+ */
+enum class ReplayMode : uint8_t
+{
+    //! Records are replayed with the delays they were recorded with.
+    RealTime = 1,
+    //! Delays between records are divided by ReplayConfig::speed.
+    Accelerated = 2,
+    //! Records are replayed without any delay.
+    AsFastAsPossible = 3
+};
+
+/**
+ * \brief Configuration of a ReplaySource.
+ */
+struct ReplayConfig
+{
+    ReplayMode                          mode = ReplayMode::RealTime;
+    //! Speedup of the Accelerated mode, e.g. 100 for a hundredfold speed.
+    double                              speed = 1.0;
+    //! Whether replayed events get the time of their replay as receive
+    //! time, rather than the one they were recorded with.
+    bool                                restamp = true;
+};
+
+
+/**
+ * \brief InputSource replaying a recording made by InputRecorder.
+ *
+ * Connections, disconnections and input events are handed to the sink in
+ * the order they were recorded, so the pipeline's state, callbacks and
+ * queries behave as they did with the recorded hardware. Consecutive
+ * events of one device sharing a receive time, i.e. read in the same
+ * wakeup, are replayed as one batch. The sequence of sink calls only
+ * depends on the recording, the mode only changes their timing.
+ *
+ * The recording is memory mapped and decoded as it is replayed, so its
+ * size is not limited by the available memory. process returns false once
+ * the whole recording has been replayed, which ends an InputLoop.
+ */
+class ReplaySource : public InputSource
+{
+public:
+    //! Maximum number of records replayed in one call, bounds the time
+    //! spent in process in the AsFastAsPossible mode.
+    static constexpr size_t k_max_records_per_call = 4096;
+
+    /**
+     * \brief Creates a source replaying a recording file.
+     *
+     * \param path path of the recording to replay
+     * \param config how to replay the recording
+     * \throws std::system_error if the file cannot be mapped
+     * \throws std::runtime_error if the file is no supported recording
+     */
+    ReplaySource(std::string const& path, ReplayConfig const& config);
+
+    /**
+     * \brief Replays all records due at a given time.
+     *
+     * Does not read any clock, which allows driving the source with a
+     * virtual clock. The mode is ignored, elapsed is scaled by the speed
+     * of the Accelerated mode only.
+     *
+     * \param sink receives the devices and events
+     * \param elapsed time since the replay started
+     * \return number of records replayed
+     */
+    size_t advance(InputSink& sink, std::chrono::nanoseconds elapsed);
+
+    /**
+     * \brief Returns whether every record has been replayed.
+     *
+     * \return true once the end of the recording has been reached
+     */
+    bool finished() const;
+
+    /**
+     * \brief Returns whether the recording ended in a malformed or cut
+     *        short record.
+     *
+     * \return true if replay stopped before the end of the file
+     */
+    bool truncated() const;
+
+    /**
+     * \brief Returns the number of input events replayed so far.
+     *
+     * Safe to call from any thread.
+     *
+     * \return number of input events handed to the sink
+     */
+    uint64_t replayed() const;
+
+    bool process(InputSink& sink, std::chrono::milliseconds timeout) override;
+    void wake() override;
+
+private:
+    void read_next();
+    void flush(InputSink& sink);
+    double speed() const;
+    int64_t recorded_elapsed(std::chrono::nanoseconds elapsed) const;
+
+    const ReplayConfig                  m_config;
+    MappedFile                          m_file;
+    RecordingReader                     m_reader;
+    //! Next record to replay, valid while m_has_next is set.
+    RecordingEntry                      m_next;
+    bool                                m_has_next = false;
+    //! Time of the first record, replay times are relative to it.
+    uint64_t                            m_first_time_ns = 0;
+    //! Batch of events of one device being collected.
+    std::vector<JoystickInputEventEx>   m_events;
+    GUID                                m_events_guid{};
+    //! Recorded receive time of the events in m_events.
+    uint64_t                            m_events_time_ns = 0;
+    std::atomic<uint64_t>               m_replayed{0};
+
+    bool                                m_started = false;
+    std::chrono::steady_clock::time_point m_start;
+    std::mutex                          m_wake_mutex;
+    std::condition_variable             m_wake_condition;
+    bool                                m_woken = false;
+};
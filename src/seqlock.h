@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+/**
+ * \brief Publishes a value from a single writer to any number of readers.
+ *
+ * Readers never take a lock and never make the writer wait. Instead a
+ * reader retries its copy if it overlapped with a write, detected via a
+ * sequence counter that is odd while a write is in progress. The value is
+ * held as an array of atomic words so that concurrent copies are well
+ * defined.
+ *
+ * Readers are lock-free, not wait-free: a writer storing back to back
+ * without pause can keep a reader retrying indefinitely. This suits
+ * values written at most a few thousand times a second, where a write
+ * takes a small fraction of the interval between writes.
+ *
+ * Only one thread may call store() at a time, callers are responsible for
+ * serializing writers.
+ *
+ * \tparam T trivially copyable type of the published value
+ */
+template<typename T>
+class Seqlock
+{
+    static_assert(
+        std::is_trivially_copyable<T>::value,
+        "Seqlock requires a trivially copyable value type"
+    );
+
+public:
+    Seqlock()
+    {
+        copy_in(T{});
+    }
+
+    Seqlock(Seqlock const&) = delete;
+    Seqlock& operator=(Seqlock const&) = delete;
+
+    /**
+     * \brief Returns a consistent copy of the current value.
+     *
+     * Spins while a store is in progress and retries if one overlapped the
+     * copy, so the number of attempts is unbounded under constant writes.
+     *
+     * \return copy of the most recently stored value
+     */
+    T load() const
+    {
+        T result;
+        for(;;)
+        {
+            const uint64_t before = m_sequence.load(std::memory_order_acquire);
+            if((before & 1) == 0)
+            {
+                copy_out(result);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(m_sequence.load(std::memory_order_relaxed) == before)
+                {
+                    return result;
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Replaces the current value.
+     *
+     * \param value new value to publish
+     */
+    void store(T const& value)
+    {
+        const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        copy_in(value);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * \brief Returns the number of completed stores.
+     *
+     * \return number of times store() has completed
+     */
+    uint64_t version() const
+    {
+        return m_sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t k_word_count = (sizeof(T) + 7) / 8;
+
+    void copy_out(T& value) const
+    {
+        uint64_t words[k_word_count];
+        for(size_t i=0; i<k_word_count; ++i)
+        {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        memcpy(&value, words, sizeof(T));
+    }
+
+    void copy_in(T const& value)
+    {
+        uint64_t words[k_word_count] = {};
+        memcpy(words, &value, sizeof(T));
+        for(size_t i=0; i<k_word_count; ++i)
+        {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::array<std::atomic<uint64_t>, k_word_count> m_words;
+    std::atomic<uint64_t>               m_sequence{0};
+};
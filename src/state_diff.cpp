@@ -0,0 +1,245 @@
+#include "state_diff.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "axis_mapping.h"
+
+#if defined(DILL_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(DILL_HAS_AVX2)
+#include <immintrin.h>
+#endif
+
+
+static_assert(
+    sizeof(DIJOYSTATE2) % 16 == 0,
+    "DIJOYSTATE2 must be a multiple of the SSE2 register size"
+);
+
+namespace
+{
+    // Diffs the axes of axis_map and the buttons and hats of info.
+    void diff_report(
+        DIJOYSTATE2 const&              report,
+        DeviceSummary const&            info,
+        AxisMap const*                  axis_map,
+        size_t                          axis_count,
+        DeviceState&                    state,
+        std::vector<JoystickInputData>& events
+    )
+    {
+        JoystickInputData evt;
+        evt.device_guid = info.device_guid;
+
+        // Detect axis state changes.
+        for(size_t i=0; i<axis_count; ++i)
+        {
+            const auto axis_index = axis_map[i].axis_index;
+            const auto offset = offset_for_axis_index(axis_index);
+            if(offset == static_cast<AxisOffset>(-1))
+            {
+                continue;
+            }
+            LONG value;
+            memcpy(
+                &value,
+                reinterpret_cast<char const*>(&report) + offset,
+                sizeof(value)
+            );
+
+            if(state.axis[axis_index] != value)
+            {
+                state.axis[axis_index] = value;
+
+                evt.input_type = JoystickInputType::Axis;
+                evt.input_index = static_cast<UINT8>(axis_index);
+                evt.value = value;
+                events.push_back(evt);
+            }
+        }
+
+        // Detect button state changes, only visiting the buttons that differ
+        // from the stored state.
+        const auto pressed = pack_buttons(report.rgbButtons);
+        const auto changed = (pressed ^ state.button) &
+            ButtonMask::first(info.button_count);
+        for_each_button(changed, [&](size_t button) {
+            const bool is_pressed = pressed.test(button);
+            state.button.set(button, is_pressed);
+
+            evt.input_type = JoystickInputType::Button;
+            evt.input_index = static_cast<UINT8>(button);
+            evt.value = is_pressed;
+            events.push_back(evt);
+        });
+
+        // Detect hat state changes.
+        for(size_t i=0; i<info.hat_count && i<4; ++i)
+        {
+            LONG direction = static_cast<LONG>(report.rgdwPOV[i]);
+            if(direction < 0 || direction > 36000)
+            {
+                direction = -1;
+            }
+            if(state.hat[i+1] != direction)
+            {
+                state.hat[i+1] = direction;
+
+                evt.input_type = JoystickInputType::Hat;
+                evt.input_index = static_cast<UINT8>(i+1);
+                evt.value = direction;
+                events.push_back(evt);
+            }
+        }
+    }
+}
+
+
+bool joystate_equal(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs)
+{
+#if defined(DILL_HAS_AVX2)
+    return joystate_equal_avx2(lhs, rhs);
+#elif defined(DILL_HAS_SSE2)
+    return joystate_equal_sse2(lhs, rhs);
+#else
+    return joystate_equal_scalar(lhs, rhs);
+#endif
+}
+
+bool joystate_equal_scalar(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs)
+{
+    return memcmp(&lhs, &rhs, sizeof(DIJOYSTATE2)) == 0;
+}
+
+#if defined(DILL_HAS_SSE2)
+bool joystate_equal_sse2(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs)
+{
+    // Accumulate the difference of all 17 blocks and test once at the end,
+    // which avoids a branch per block.
+    auto const* a = reinterpret_cast<__m128i const*>(&lhs);
+    auto const* b = reinterpret_cast<__m128i const*>(&rhs);
+    auto diff = _mm_setzero_si128();
+    for(size_t i=0; i<sizeof(DIJOYSTATE2) / 16; ++i)
+    {
+        diff = _mm_or_si128(
+            diff,
+            _mm_xor_si128(_mm_loadu_si128(a + i), _mm_loadu_si128(b + i))
+        );
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128()))
+        == 0xFFFF;
+}
+#endif
+
+#if defined(DILL_HAS_AVX2)
+bool joystate_equal_avx2(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs)
+{
+    constexpr size_t k_wide_blocks = sizeof(DIJOYSTATE2) / 32;
+
+    auto const* a = reinterpret_cast<__m256i const*>(&lhs);
+    auto const* b = reinterpret_cast<__m256i const*>(&rhs);
+    auto diff = _mm256_setzero_si256();
+    for(size_t i=0; i<k_wide_blocks; ++i)
+    {
+        diff = _mm256_or_si256(
+            diff,
+            _mm256_xor_si256(
+                _mm256_loadu_si256(a + i),
+                _mm256_loadu_si256(b + i)
+            )
+        );
+    }
+    bool equal = _mm256_testz_si256(diff, diff) != 0;
+
+    // The remaining 16 bytes.
+    if(sizeof(DIJOYSTATE2) % 32 != 0)
+    {
+        const auto tail = _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + k_wide_blocks)),
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + k_wide_blocks))
+        );
+        equal = equal && _mm_testz_si128(tail, tail) != 0;
+    }
+    return equal;
+}
+#endif
+
+void apply_input_event(DeviceState& state, JoystickInputData const& evt)
+{
+    // Sources only produce valid indices, the check keeps a faulty one
+    // from writing outside the state.
+    const size_t index = evt.input_index;
+    switch(evt.input_type)
+    {
+        case JoystickInputType::Axis:
+            if(index >= 1 && index < state.axis.size())
+            {
+                state.axis[index] = evt.value;
+            }
+            break;
+        case JoystickInputType::Button:
+            if(index >= 1 && index <= k_max_buttons)
+            {
+                state.button.set(index, evt.value != 0);
+            }
+            break;
+        case JoystickInputType::Hat:
+            if(index >= 1 && index < state.hat.size())
+            {
+                state.hat[index] = evt.value;
+            }
+            break;
+    }
+}
+
+void diff_joystate(
+    DIJOYSTATE2 const&                  report,
+    DeviceSummary const&                info,
+    DeviceState&                        state,
+    std::vector<JoystickInputData>&     events
+)
+{
+    diff_report(
+        report,
+        info,
+        info.axis_map,
+        std::min<size_t>(info.axis_count, k_summary_axes),
+        state,
+        events
+    );
+}
+
+void diff_joystate(
+    DIJOYSTATE2 const&                  report,
+    DeviceSummaryEx const&              info,
+    DeviceState&                        state,
+    std::vector<JoystickInputData>&     events
+)
+{
+    diff_report(
+        report,
+        info.summary,
+        info.axis_map,
+        std::min<size_t>(info.axis_count, k_max_axes),
+        state,
+        events
+    );
+}
+
+bool ReportFilter::changed(DIJOYSTATE2 const& report)
+{
+    if(m_has_previous && joystate_equal(m_previous, report))
+    {
+        return false;
+    }
+    m_previous = report;
+    m_has_previous = true;
+    return true;
+}
+
+void ReportFilter::reset()
+{
+    m_has_previous = false;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+
+#include "button_mask.h"
+#include "dill_types.h"
+
+
+/**
+ * \brief Returns whether two DirectInput reports are identical.
+ *
+ * Compares the reports as raw bytes using the widest instruction set
+ * available to the build.
+ *
+ * \param lhs first report to compare
+ * \param rhs second report to compare
+ * \return true if both reports hold the same bytes, false otherwise
+ */
+bool joystate_equal(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs);
+
+/**
+ * \brief Portable implementation of joystate_equal.
+ */
+bool joystate_equal_scalar(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs);
+
+#if defined(DILL_HAS_SSE2)
+/**
+ * \brief SSE2 implementation of joystate_equal.
+ */
+bool joystate_equal_sse2(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs);
+#endif
+
+#if defined(DILL_HAS_AVX2)
+/**
+ * \brief AVX2 implementation of joystate_equal.
+ */
+bool joystate_equal_avx2(DIJOYSTATE2 const& lhs, DIJOYSTATE2 const& rhs);
+#endif
+
+/**
+ * \brief Applies a single input event to a device's state.
+ *
+ * Events whose input index is out of range for their type are ignored.
+ *
+ * \param state state of the device the event belongs to
+ * \param evt event to apply
+ */
+void apply_input_event(DeviceState& state, JoystickInputData const& evt);
+
+/**
+ * \brief Applies a DirectInput report to a device's state.
+ *
+ * Only the inputs the device reports in its summary are considered. Every
+ * input whose value differs from the state is updated and produces one
+ * event, axes first, then buttons and hats, each in increasing index order.
+ *
+ * \param report report read from the device
+ * \param info summary of the device
+ * \param state last known state of the device, updated in place
+ * \param events receives one event per changed input
+ */
+void diff_joystate(
+    DIJOYSTATE2 const&                  report,
+    DeviceSummary const&                info,
+    DeviceState&                        state,
+    std::vector<JoystickInputData>&     events
+);
+
+/**
+ * \brief Applies a DirectInput report to a device's state, including the
+ *        axes with axis_index 9-32.
+ *
+ * \param report report read from the device
+ * \param info extended summary of the device
+ * \param state last known state of the device, updated in place
+ * \param events receives one event per changed input
+ */
+void diff_joystate(
+    DIJOYSTATE2 const&                  report,
+    DeviceSummaryEx const&              info,
+    DeviceState&                        state,
+    std::vector<JoystickInputData>&     events
+);
+
+
+/**
+ * \brief Remembers the last report of a polled device.
+ *
+ * Most reports of a polled device are identical to the previous one, as
+ * devices spend most of their time idle. Checking a report against the
+ * previous one as a whole is far cheaper than diffing every input against
+ * the device's state under the data store lock.
+ */
+class ReportFilter
+{
+public:
+    /**
+     * \brief Checks a report against the previous one and remembers it.
+     *
+     * \param report report read from the device
+     * \return true if the report differs from the previous one or there is
+     *         no previous one, false otherwise
+     */
+    bool changed(DIJOYSTATE2 const& report);
+
+    /**
+     * \brief Forgets the previous report.
+     */
+    void reset();
+
+private:
+    DIJOYSTATE2                         m_previous = {};
+    bool                                m_has_previous = false;
+};
@@ -0,0 +1,296 @@
+#include "synthetic_source.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+#include "event_timing.h"
+
+
+namespace
+{
+    // Hat directions visited by the Sweep pattern, centered last.
+    const LONG k_hat_directions[] = {
+        0, 4500, 9000, 13500, 18000, 22500, 27000, 31500, -1
+    };
+    const size_t k_hat_direction_count =
+        sizeof(k_hat_directions) / sizeof(k_hat_directions[0]);
+
+    // Largest deviation from the center produced by the Jitter pattern.
+    const LONG k_jitter_amplitude = 64;
+}
+
+
+SyntheticSource::SyntheticSource(SyntheticConfig const& config)
+    :   m_config(config)
+      , m_random_state(config.seed)
+{
+    m_devices.resize(config.device_count);
+    for(size_t i=0; i<m_devices.size(); ++i)
+    {
+        auto& info = m_devices[i].info;
+        info = DeviceSummary{};
+        info.device_guid = device_guid(i);
+        info.vendor_id = 0xD111;
+        info.product_id = static_cast<DWORD>(i + 1);
+        info.axis_count = std::min<DWORD>(config.axis_count, 8);
+        info.button_count = std::min<DWORD>(config.button_count, 128);
+        info.hat_count = std::min<DWORD>(config.hat_count, 4);
+        for(DWORD axis=0; axis<info.axis_count; ++axis)
+        {
+            info.axis_map[axis].linear_index = axis + 1;
+            info.axis_map[axis].axis_index = axis + 1;
+        }
+        snprintf(info.name, MAX_PATH, "DILL synthetic device %zu", i + 1);
+    }
+}
+
+GUID SyntheticSource::device_guid(size_t index)
+{
+    GUID guid{};
+    guid.Data1 = static_cast<DWORD>(index + 1);
+    guid.Data2 = 0xD111;
+    guid.Data3 = 0x5359;
+    memcpy(guid.Data4, "SYNTHDEV", sizeof(guid.Data4));
+    return guid;
+}
+
+size_t SyntheticSource::advance(
+    InputSink&                          sink,
+    std::chrono::nanoseconds            elapsed
+)
+{
+    announce_devices(sink);
+
+    const uint64_t due = due_events(elapsed);
+    const size_t batch_size = std::max<size_t>(m_config.batch_size, 1);
+    const DWORD timestamp = static_cast<DWORD>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+    );
+
+    size_t count = 0;
+    for(auto& device : m_devices)
+    {
+        if(!device.tracked)
+        {
+            continue;
+        }
+        for(size_t batch=0;
+            batch<k_max_batches_per_call && device.generated < due;
+            ++batch)
+        {
+            const size_t batch_count = static_cast<size_t>(
+                std::min<uint64_t>(due - device.generated, batch_size)
+            );
+            const uint64_t receive_time = monotonic_time_ns();
+            m_events.clear();
+            for(size_t i=0; i<batch_count; ++i)
+            {
+                m_events.push_back(make_input_event_ex(
+                    next_event(device),
+                    timestamp,
+                    ++m_sequence,
+                    receive_time
+                ));
+            }
+            device.generated += batch_count;
+            count += batch_count;
+            sink.input_events(device.info.device_guid, m_events);
+        }
+    }
+    m_generated += count;
+    return count;
+}
+
+uint64_t SyntheticSource::generated() const
+{
+    return m_generated;
+}
+
+bool SyntheticSource::process(
+    InputSink&                          sink,
+    std::chrono::milliseconds           timeout
+)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if(!m_started)
+    {
+        m_start = now;
+        m_started = true;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - m_start
+    );
+    if(advance(sink, elapsed) > 0 || m_config.events_per_second <= 0.0)
+    {
+        return true;
+    }
+
+    // Sleep until the device furthest behind has its next event due.
+    uint64_t next = std::numeric_limits<uint64_t>::max();
+    for(auto const& device : m_devices)
+    {
+        if(device.tracked)
+        {
+            next = std::min(next, device.generated + 1);
+        }
+    }
+    auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout);
+    if(next != std::numeric_limits<uint64_t>::max())
+    {
+        const auto next_due = std::chrono::nanoseconds(static_cast<int64_t>(
+            next * 1e9 / m_config.events_per_second
+        ));
+        wait = std::min(wait, next_due - elapsed);
+    }
+
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    m_wake_condition.wait_for(lock, wait, [this] { return m_woken; });
+    m_woken = false;
+    return true;
+}
+
+void SyntheticSource::wake()
+{
+    std::lock_guard<std::mutex> lock(m_wake_mutex);
+    m_woken = true;
+    m_wake_condition.notify_one();
+}
+
+void SyntheticSource::announce_devices(InputSink& sink)
+{
+    if(m_announced)
+    {
+        return;
+    }
+    m_announced = true;
+    for(auto& device : m_devices)
+    {
+        device.tracked = sink.device_added(device.info);
+    }
+}
+
+JoystickInputData SyntheticSource::next_event(Device& device)
+{
+    auto const& info = device.info;
+    const size_t input_count =
+        info.axis_count + info.button_count + info.hat_count;
+
+    JoystickInputData evt;
+    evt.device_guid = info.device_guid;
+    if(input_count == 0)
+    {
+        evt.input_type = JoystickInputType::Axis;
+        evt.input_index = 1;
+        evt.value = 0;
+        return evt;
+    }
+
+    auto pattern = m_config.pattern;
+    if(pattern == SyntheticPattern::Jitter && info.axis_count == 0)
+    {
+        pattern = SyntheticPattern::Sweep;
+    }
+
+    size_t input = 0;
+    switch(pattern)
+    {
+        case SyntheticPattern::Sweep:
+            input = device.cursor;
+            device.cursor = (device.cursor + 1) % input_count;
+            break;
+        case SyntheticPattern::Random:
+            input = next_random() % input_count;
+            break;
+        case SyntheticPattern::Jitter:
+            input = next_random() % info.axis_count;
+            break;
+    }
+
+    if(input < info.axis_count)
+    {
+        evt.input_type = JoystickInputType::Axis;
+        evt.input_index = static_cast<UINT8>(info.axis_map[input].axis_index);
+        switch(pattern)
+        {
+            case SyntheticPattern::Sweep:
+                // Step through the range in large, uneven increments so that
+                // every event changes the value.
+                evt.value = static_cast<LONG>(
+                    (device.step * 4099 + input * 8191) % 65536
+                ) - 32768;
+                break;
+            case SyntheticPattern::Random:
+                evt.value = static_cast<LONG>(next_random() % 65536) - 32768;
+                break;
+            case SyntheticPattern::Jitter:
+                evt.value = static_cast<LONG>(
+                    next_random() % (2 * k_jitter_amplitude + 1)
+                ) - k_jitter_amplitude;
+                break;
+        }
+        device.state.axis[evt.input_index] = evt.value;
+    }
+    else if(input < info.axis_count + info.button_count)
+    {
+        const size_t button = input - info.axis_count + 1;
+        const bool is_pressed = pattern == SyntheticPattern::Random
+            ? (next_random() & 1) == 1
+            : !device.state.button.test(button);
+        device.state.button.set(button, is_pressed);
+
+        evt.input_type = JoystickInputType::Button;
+        evt.input_index = static_cast<UINT8>(button);
+        evt.value = is_pressed;
+    }
+    else
+    {
+        const size_t hat = input - info.axis_count - info.button_count + 1;
+        if(pattern == SyntheticPattern::Random)
+        {
+            evt.value = k_hat_directions[next_random() % k_hat_direction_count];
+        }
+        else
+        {
+            const auto current = std::find(
+                std::begin(k_hat_directions),
+                std::end(k_hat_directions),
+                device.state.hat[hat]
+            );
+            const size_t position = current - std::begin(k_hat_directions);
+            evt.value =
+                k_hat_directions[(position + 1) % k_hat_direction_count];
+        }
+        device.state.hat[hat] = evt.value;
+
+        evt.input_type = JoystickInputType::Hat;
+        evt.input_index = static_cast<UINT8>(hat);
+    }
+
+    ++device.step;
+    return evt;
+}
+
+uint64_t SyntheticSource::next_random()
+{
+    // splitmix64, fast and good enough to spread inputs and values.
+    uint64_t x = (m_random_state += 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t SyntheticSource::due_events(std::chrono::nanoseconds elapsed) const
+{
+    if(m_config.events_per_second <= 0.0)
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    if(elapsed.count() <= 0)
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>(
+        elapsed.count() * m_config.events_per_second / 1e9
+    );
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "dill_types.h"
+#include "input_source.h"
+
+
+/**
+ * \brief How a SyntheticSource chooses the inputs and values of events.
+ */
+enum class SyntheticPattern : uint8_t
+{
+    //! Cycles through every input in turn, sweeping axes across their
+    //! range, toggling buttons and rotating hats.
+    Sweep = 1,
+    //! Picks a random input and a random value for every event.
+    Random = 2,
+    //! Only moves axes, by small random amounts around their center, like
+    //! the sensor noise of an untouched device. Devices without axes fall
+    //! back to Sweep.
+    Jitter = 3
+};
+
+/**
+ * \brief Configuration of a SyntheticSource.
+ */
+struct SyntheticConfig
+{
+    //! Number of simulated devices, at most k_max_devices are tracked.
+    size_t                              device_count = 1;
+    //! Number of axes per device, up to 8.
+    DWORD                               axis_count = 8;
+    //! Number of buttons per device, up to 128.
+    DWORD                               button_count = 32;
+    //! Number of hats per device, up to 4.
+    DWORD                               hat_count = 1;
+    //! Events generated per second and device, 0 generates as fast as the
+    //! sink consumes them.
+    double                              events_per_second = 1000.0;
+    //! Largest number of events handed to the sink at once per device,
+    //! comparable to the events of one DirectInput drain.
+    size_t                              batch_size = 64;
+    SyntheticPattern                    pattern = SyntheticPattern::Sweep;
+    //! Seed of the Random and Jitter patterns.
+    uint64_t                            seed = 1;
+};
+
+
+/**
+ * \brief InputSource simulating devices producing input at a fixed rate.
+ *
+ * Allows pushing load through an InputPipeline without any hardware. The
+ * pipeline shares its DeviceStore code with the DirectInput event loop,
+ * but synthetic devices only exist in the pipeline: they are not visible
+ * through the dill_* functions and do not reach DILL's callbacks, so the
+ * DirectInput decoding and its wait loop are not exercised.
+ *
+ * Events are due at evenly spaced times since the first call to process
+ * or advance. Devices are announced on the first call and never removed.
+ *
+ * The generated events carry the elapsed time in milliseconds as source
+ * timestamp and a sequence number counting the events of all devices.
+ */
+class SyntheticSource : public InputSource
+{
+public:
+    //! Maximum number of batches generated per device in one call, bounds
+    //! the time spent in process when the sink cannot keep up.
+    static constexpr size_t k_max_batches_per_call = 16;
+
+    /**
+     * \brief Creates a source simulating the configured devices.
+     *
+     * \param config devices to simulate and the load they generate
+     */
+    explicit SyntheticSource(SyntheticConfig const& config);
+
+    /**
+     * \brief Returns the GUID of a simulated device.
+     *
+     * \param index index of the device, less than device_count
+     * \return GUID of the device
+     */
+    static GUID device_guid(size_t index);
+
+    /**
+     * \brief Generates all events due at a given time.
+     *
+     * Does not read any clock, which allows driving the source with a
+     * virtual clock.
+     *
+     * \param sink receives the devices and events
+     * \param elapsed time since the source started
+     * \return number of events handed to the sink
+     */
+    size_t advance(InputSink& sink, std::chrono::nanoseconds elapsed);
+
+    /**
+     * \brief Returns the number of events generated so far.
+     *
+     * Safe to call from any thread.
+     *
+     * \return number of events handed to the sink
+     */
+    uint64_t generated() const;
+
+    bool process(InputSink& sink, std::chrono::milliseconds timeout) override;
+    void wake() override;
+
+private:
+    struct Device
+    {
+        DeviceSummary                   info;
+        //! Whether the sink accepted the device.
+        bool                            tracked = false;
+        //! Number of events generated for the device so far.
+        uint64_t                        generated = 0;
+        //! Next input visited by the Sweep pattern.
+        size_t                          cursor = 0;
+        //! Number of events produced by next_event, drives the axis sweep.
+        uint64_t                        step = 0;
+        DeviceState                     state;
+    };
+
+    void announce_devices(InputSink& sink);
+    JoystickInputData next_event(Device& device);
+    uint64_t next_random();
+    uint64_t due_events(std::chrono::nanoseconds elapsed) const;
+
+    const SyntheticConfig               m_config;
+    std::vector<Device>                 m_devices;
+    std::vector<JoystickInputEventEx>   m_events;
+    bool                                m_announced = false;
+    uint64_t                            m_random_state;
+    DWORD                               m_sequence = 0;
+    std::atomic<uint64_t>               m_generated{0};
+
+    bool                                m_started = false;
+    std::chrono::steady_clock::time_point m_start;
+    std::mutex                          m_wake_mutex;
+    std::condition_variable             m_wake_condition;
+    bool                                m_woken = false;
+};
@@ -0,0 +1,133 @@
+#include "trace_ring.h"
+
+#include <algorithm>
+
+
+namespace
+{
+    // Identifies the calling thread by the order in which threads first
+    // recorded a span, stable for the thread's lifetime.
+    uint32_t current_thread_id()
+    {
+        static std::atomic<uint32_t> next_id{1};
+        thread_local const uint32_t id = next_id.fetch_add(1);
+        return id;
+    }
+}
+
+
+char const* trace_span_name(TraceSpanType type)
+{
+    switch(type)
+    {
+        case TraceSpanType::Wait:
+            return "wait";
+        case TraceSpanType::EnumerateDevices:
+            return "enumerate_devices";
+        case TraceSpanType::RebuildWaitHandles:
+            return "rebuild_wait_handles";
+        case TraceSpanType::ProcessBufferedEvents:
+            return "process_buffered_events";
+        case TraceSpanType::PollDevice:
+            return "poll_device";
+        case TraceSpanType::InputCallback:
+            return "input_callback";
+        case TraceSpanType::DeviceChangeCallback:
+            return "device_change_callback";
+        default:
+            return "unknown";
+    }
+}
+
+TraceRing::TraceRing(size_t capacity)
+    :   m_capacity(std::max<size_t>(capacity, 1))
+      , m_slots(std::make_unique<Seqlock<Slot>[]>(m_capacity))
+{
+}
+
+void TraceRing::record(
+    TraceSpanType                       type,
+    uint64_t                            start_ns,
+    uint64_t                            end_ns,
+    GUID const&                         guid
+)
+{
+    const uint64_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+
+    Slot slot;
+    slot.index = index + 1;
+    slot.span.start_ns = start_ns;
+    slot.span.duration_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+    slot.span.device_guid = guid;
+    slot.span.thread_id = current_thread_id();
+    slot.span.type = type;
+    m_slots[index % m_capacity].store(slot);
+}
+
+size_t TraceRing::capacity() const
+{
+    return m_capacity;
+}
+
+uint64_t TraceRing::recorded() const
+{
+    return m_next.load(std::memory_order_relaxed);
+}
+
+void TraceRing::snapshot(std::vector<TraceSpan>& spans) const
+{
+    spans.clear();
+    const uint64_t end = m_next.load(std::memory_order_acquire);
+    const uint64_t begin = end > m_capacity ? end - m_capacity : 0;
+    spans.reserve(static_cast<size_t>(end - begin));
+    for(uint64_t index=begin; index<end; ++index)
+    {
+        // Slots still being written or already overwritten by a newer span
+        // carry a different index.
+        const Slot slot = m_slots[index % m_capacity].load();
+        if(slot.index == index + 1)
+        {
+            spans.push_back(slot.span);
+        }
+    }
+}
+
+bool TraceRing::write_chrome_trace(std::FILE* file) const
+{
+    if(file == nullptr)
+    {
+        return false;
+    }
+
+    std::vector<TraceSpan> spans;
+    snapshot(spans);
+
+    bool ok = std::fputs("{\"traceEvents\":[", file) >= 0;
+    for(size_t i=0; i<spans.size() && ok; ++i)
+    {
+        auto const& span = spans[i];
+        auto const& guid = span.device_guid;
+        // Timestamps and durations are in microseconds.
+        ok = std::fprintf(
+            file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"dill\",\"ph\":\"X\","
+            "\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"device\":\"{%08X-%04X-%04X-%02X%02X-"
+            "%02X%02X%02X%02X%02X%02X}\"}}",
+            i == 0 ? "" : ",",
+            trace_span_name(span.type),
+            static_cast<unsigned long long>(span.start_ns / 1000),
+            static_cast<unsigned>(span.start_ns % 1000),
+            static_cast<unsigned long long>(span.duration_ns / 1000),
+            static_cast<unsigned>(span.duration_ns % 1000),
+            static_cast<unsigned>(span.thread_id),
+            static_cast<unsigned>(guid.Data1),
+            static_cast<unsigned>(guid.Data2),
+            static_cast<unsigned>(guid.Data3),
+            guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+            guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]
+        ) > 0;
+    }
+    ok = ok && std::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", file) >= 0;
+    return ok && std::fflush(file) == 0;
+}
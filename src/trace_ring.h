@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "dill_types.h"
+#include "event_timing.h"
+#include "seqlock.h"
+
+
+/**
+ * \brief Activities of DILL recorded as trace spans.
+ */
+enum class TraceSpanType : uint8_t
+{
+    //! Event loop waiting for its next wakeup.
+    Wait = 1,
+    EnumerateDevices = 2,
+    RebuildWaitHandles = 3,
+    ProcessBufferedEvents = 4,
+    PollDevice = 5,
+    //! Invocation of an input callback.
+    InputCallback = 6,
+    //! Invocation of the device change callback.
+    DeviceChangeCallback = 7
+};
+
+/**
+ * \brief Single activity recorded in a TraceRing.
+ */
+struct TraceSpan
+{
+    //! Start of the activity in nanoseconds of the monotonic clock.
+    uint64_t                            start_ns;
+    uint64_t                            duration_ns;
+    //! Device the activity concerned, all zero if none.
+    GUID                                device_guid;
+    //! Small number identifying the recording thread.
+    uint32_t                            thread_id;
+    TraceSpanType                       type;
+};
+
+/**
+ * \brief Returns the name a span type is exported with.
+ *
+ * \param type type of the span
+ * \return name of the span, "unknown" for invalid types
+ */
+char const* trace_span_name(TraceSpanType type);
+
+
+/**
+ * \brief Fixed size ring of the most recent trace spans.
+ *
+ * All memory is allocated on construction. Any number of threads may
+ * record spans, each claims a slot with a single atomic increment and
+ * publishes the span through the slot's seqlock, overwriting the oldest
+ * span once the ring is full. Snapshots can be taken concurrently and
+ * skip slots overwritten while being read.
+ */
+class TraceRing
+{
+public:
+    /**
+     * \brief Creates a ring holding the given number of spans.
+     *
+     * \param capacity number of spans retained
+     */
+    explicit TraceRing(size_t capacity);
+    TraceRing(TraceRing const&) = delete;
+    TraceRing& operator=(TraceRing const&) = delete;
+
+    /**
+     * \brief Records a span, overwriting the oldest one if full.
+     *
+     * \param type activity of the span
+     * \param start_ns start of the activity
+     * \param end_ns end of the activity
+     * \param guid device the activity concerned
+     */
+    void record(
+        TraceSpanType                   type,
+        uint64_t                        start_ns,
+        uint64_t                        end_ns,
+        GUID const&                     guid
+    );
+
+    /**
+     * \brief Returns the number of spans the ring retains.
+     *
+     * \return capacity of the ring
+     */
+    size_t capacity() const;
+
+    /**
+     * \brief Returns the number of spans recorded so far.
+     *
+     * \return number of spans ever recorded, including overwritten ones
+     */
+    uint64_t recorded() const;
+
+    /**
+     * \brief Copies the retained spans, oldest first.
+     *
+     * \param spans replaced with the retained spans
+     */
+    void snapshot(std::vector<TraceSpan>& spans) const;
+
+    /**
+     * \brief Writes the retained spans in the Chrome trace event format.
+     *
+     * The output loads in chrome://tracing and Perfetto, with one track
+     * per recording thread and device GUIDs as span arguments.
+     *
+     * \param file file to write the JSON document to
+     * \return true if the document was written completely
+     */
+    bool write_chrome_trace(std::FILE* file) const;
+
+private:
+    //! Span published in a slot, index is 1 + its position in the
+    //! sequence of recorded spans, 0 for unused slots.
+    struct Slot
+    {
+        uint64_t                        index;
+        TraceSpan                       span;
+    };
+
+    size_t                              m_capacity;
+    std::unique_ptr<Seqlock<Slot>[]>    m_slots;
+    std::atomic<uint64_t>               m_next{0};
+};
+
+
+/**
+ * \brief Records a span covering its own lifetime.
+ */
+class TraceScope
+{
+public:
+    /**
+     * \brief Starts a span.
+     *
+     * \param ring ring to record the span into, nullptr records nothing
+     * \param type activity of the span
+     * \param guid device the activity concerns
+     */
+    TraceScope(TraceRing* ring, TraceSpanType type, GUID const& guid)
+        :   m_ring(ring)
+          , m_type(type)
+          , m_guid(guid)
+          , m_start_ns(ring != nullptr ? monotonic_time_ns() : 0)
+    {
+    }
+
+    TraceScope(TraceScope const&) = delete;
+    TraceScope& operator=(TraceScope const&) = delete;
+
+    ~TraceScope()
+    {
+        if(m_ring != nullptr)
+        {
+            m_ring->record(m_type, m_start_ns, monotonic_time_ns(), m_guid);
+        }
+    }
+
+private:
+    TraceRing*                          m_ring;
+    TraceSpanType                       m_type;
+    GUID                                m_guid;
+    uint64_t                            m_start_ns;
+};
+
+
+// Spans are only recorded in builds configured with DILL_ENABLE_TRACE,
+// otherwise the macro and its arguments compile to nothing.
+#if defined(DILL_ENABLE_TRACE)
+#define DILL_TRACE_SCOPE(ring, type, guid) \
+    TraceScope dill_trace_scope_(ring, TraceSpanType::type, guid)
+#else
+#define DILL_TRACE_SCOPE(ring, type, guid) ((void)0)
+#endif
@@ -0,0 +1,132 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <vector>
+
+#include "axis_filter.h"
+#include "event_timing.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    // Returns the values reported for a sequence of axis 1 values.
+    std::vector<LONG> reported(AxisFilter& filter, std::vector<LONG> values)
+    {
+        std::vector<LONG> result;
+        for(auto value : values)
+        {
+            auto evt = make_input(1, JoystickInputType::Axis, 1, value);
+            if(filter.apply(evt))
+            {
+                result.push_back(evt.value);
+            }
+        }
+        return result;
+    }
+}
+
+
+TEST_CASE("unconfigured axes report every change", "[axis_filter]")
+{
+    AxisFilter filter;
+    REQUIRE_FALSE(filter.active());
+    REQUIRE(reported(filter, {1, 2, 2, 3}) == std::vector<LONG>{1, 2, 2, 3});
+
+    // Thresholds of zero or one are the same as no filter.
+    REQUIRE(filter.configure(1, {1, 0, 0}, 0));
+    REQUIRE_FALSE(filter.active());
+}
+
+TEST_CASE("small changes are suppressed", "[axis_filter]")
+{
+    AxisFilter filter;
+    REQUIRE(filter.configure(1, {10, 0, 0}, 100));
+    REQUIRE(filter.active());
+    REQUIRE(filter.config(1).min_delta == 10);
+
+    // Distances are measured from the last reported value, so slow drift
+    // is reported once it adds up.
+    REQUIRE(reported(filter, {105, 109, 110, 115, 121, 100})
+        == std::vector<LONG>{110, 121, 100});
+}
+
+TEST_CASE("the deadzone reports the center once", "[axis_filter]")
+{
+    AxisFilter filter;
+    REQUIRE(filter.configure(1, {0, 50, 20}, 1000));
+
+    REQUIRE(reported(filter, {40, -30, 10, 60, 70, 200, 30})
+        == std::vector<LONG>{0, 200, 0});
+
+    // Leaving the deadzone takes the hysteresis in addition, then every
+    // change is reported again.
+    REQUIRE(reported(filter, {-71, -72}) == std::vector<LONG>{-71, -72});
+}
+
+TEST_CASE("reversing direction takes the hysteresis", "[axis_filter]")
+{
+    AxisFilter filter;
+    REQUIRE(filter.configure(1, {0, 0, 5}, 0));
+
+    REQUIRE(reported(filter, {10, 11, 8, 6, 5, 12})
+        == std::vector<LONG>{10, 11, 5, 12});
+}
+
+TEST_CASE("other inputs pass through", "[axis_filter]")
+{
+    AxisFilter filter;
+    REQUIRE(filter.configure(2, {1000, 0, 0}, 0));
+
+    auto button = make_input(1, JoystickInputType::Button, 2, 1);
+    auto hat = make_input(1, JoystickInputType::Hat, 2, 9000);
+    auto axis = make_input(1, JoystickInputType::Axis, 1, 1);
+    REQUIRE(filter.apply(button));
+    REQUIRE(filter.apply(hat));
+    REQUIRE(filter.apply(axis));
+
+    filter.reset();
+    REQUIRE_FALSE(filter.active());
+    REQUIRE(filter.config(2).min_delta == 0);
+}
+
+TEST_CASE("invalid configurations are rejected", "[axis_filter]")
+{
+    AxisFilter filter;
+    REQUIRE_FALSE(filter.configure(0, {10, 0, 0}, 0));
+    REQUIRE_FALSE(filter.configure(k_max_axes + 1, {10, 0, 0}, 0));
+    REQUIRE_FALSE(filter.configure(1, {-1, 0, 0}, 0));
+    REQUIRE_FALSE(filter.configure(1, {0, -1, 0}, 0));
+    REQUIRE_FALSE(filter.configure(1, {0, 0, -1}, 0));
+    REQUIRE_FALSE(filter.active());
+    REQUIRE(filter.configure(8, {10, 0, 0}, 0));
+    REQUIRE(filter.configure(k_max_axes, {10, 0, 0}, 0));
+}
+
+TEST_CASE("filtering removes suppressed events in place", "[axis_filter]")
+{
+    AxisFilter filter;
+    std::vector<JoystickInputEventEx> events;
+    for(LONG value : {1, 2, 20, 21})
+    {
+        events.push_back(make_input_event_ex(
+            make_input(1, JoystickInputType::Axis, 1, value),
+            0,
+            static_cast<DWORD>(value),
+            0
+        ));
+    }
+    events.push_back(make_input_event_ex(
+        make_input(1, JoystickInputType::Button, 1, 1), 0, 100, 0
+    ));
+
+    // Inactive filters leave the events untouched.
+    REQUIRE(filter.filter(events) == 0);
+    REQUIRE(events.size() == 5);
+
+    REQUIRE(filter.configure(1, {10, 0, 0}, 0));
+    REQUIRE(filter.filter(events) == 3);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].data.value == 20);
+    REQUIRE(events[0].source_sequence == 20);
+    REQUIRE(events[1].data.input_type == JoystickInputType::Button);
+}
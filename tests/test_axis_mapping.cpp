@@ -99,7 +99,7 @@ TEST_CASE(
     "[axis_mapping]"
 )
 {
-    for(DWORD axis_index = 1; axis_index <= 8; ++axis_index)
+    for(DWORD axis_index = 1; axis_index <= k_max_axes; ++axis_index)
     {
         AxisOffset offset = offset_for_axis_index(axis_index);
         REQUIRE(axis_index_for_offset(offset) == axis_index);
@@ -109,6 +109,49 @@ TEST_CASE(
 TEST_CASE("unknown axis_index/offset resolve to -1", "[axis_mapping]")
 {
     REQUIRE(offset_for_axis_index(0) == static_cast<AxisOffset>(-1));
-    REQUIRE(offset_for_axis_index(9) == static_cast<AxisOffset>(-1));
+    REQUIRE(offset_for_axis_index(33) == static_cast<AxisOffset>(-1));
     REQUIRE(axis_index_for_offset(0xDEADBEEF) == static_cast<DWORD>(-1));
 }
+
+TEST_CASE("extended axes only appear in the extended map", "[axis_mapping]")
+{
+    const std::vector<AxisOffset> detected = {
+        FIELD_OFFSET(DIJOYSTATE2, rglFSlider[1]),
+        DIJOFS_Y,
+        FIELD_OFFSET(DIJOYSTATE2, lVX)
+    };
+
+    DWORD axis_count;
+    AxisMap axis_map[k_summary_axes];
+    build_axis_map(detected, axis_count, axis_map);
+    REQUIRE(axis_count == 1);
+    REQUIRE(axis_map[0].axis_index == 2);
+
+    DWORD ex_axis_count;
+    AxisMap ex_axis_map[k_max_axes];
+    build_axis_map(detected, ex_axis_count, ex_axis_map);
+    REQUIRE(ex_axis_count == 3);
+    REQUIRE(ex_axis_map[0].linear_index == 1);
+    REQUIRE(ex_axis_map[0].axis_index == 2);
+    REQUIRE(ex_axis_map[1].linear_index == 2);
+    REQUIRE(ex_axis_map[1].axis_index == 9);
+    REQUIRE(ex_axis_map[2].linear_index == 3);
+    REQUIRE(ex_axis_map[2].axis_index == 32);
+    REQUIRE(ex_axis_map[3].axis_index == 0);
+}
+
+TEST_CASE("summaries extend to the same axes", "[axis_mapping]")
+{
+    DeviceSummary info = {};
+    info.button_count = 4;
+    build_axis_map({DIJOFS_X, DIJOFS_RZ}, info.axis_count, info.axis_map);
+
+    const auto info_ex = extend_device_summary(info);
+    REQUIRE(info_ex.struct_size == sizeof(DeviceSummaryEx));
+    REQUIRE(info_ex.version == k_device_summary_ex_version);
+    REQUIRE(info_ex.summary.button_count == 4);
+    REQUIRE(info_ex.axis_count == 2);
+    REQUIRE(info_ex.axis_map[0].axis_index == 1);
+    REQUIRE(info_ex.axis_map[1].axis_index == 6);
+    REQUIRE(info_ex.axis_map[2].axis_index == 0);
+}
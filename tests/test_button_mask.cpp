@@ -0,0 +1,131 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <random>
+#include <vector>
+
+#include "button_mask.h"
+
+
+namespace
+{
+    using PackFn = ButtonMask (*)(BYTE const (&)[k_max_buttons]);
+
+    // All compiled implementations, each has to agree with the scalar one.
+    std::vector<PackFn> pack_implementations()
+    {
+        std::vector<PackFn> result = {&pack_buttons, &pack_buttons_scalar};
+#if defined(DILL_HAS_SSE2)
+        result.push_back(&pack_buttons_sse2);
+#endif
+#if defined(DILL_HAS_AVX2)
+        result.push_back(&pack_buttons_avx2);
+#endif
+        return result;
+    }
+
+    std::vector<size_t> set_buttons(ButtonMask const& mask)
+    {
+        std::vector<size_t> result;
+        for_each_button(mask, [&result](size_t button) {
+            result.push_back(button);
+        });
+        return result;
+    }
+}
+
+
+TEST_CASE("buttons are set and tested 1-based", "[button_mask]")
+{
+    ButtonMask mask;
+    REQUIRE_FALSE(mask.any());
+
+    mask.set(1, true);
+    mask.set(64, true);
+    mask.set(65, true);
+    mask.set(128, true);
+    REQUIRE(mask.bits[0] == ((uint64_t(1) << 63) | 1));
+    REQUIRE(mask.bits[1] == ((uint64_t(1) << 63) | 1));
+    REQUIRE(mask.test(64));
+    REQUIRE_FALSE(mask.test(2));
+
+    mask.set(64, false);
+    REQUIRE_FALSE(mask.test(64));
+    REQUIRE(mask.test(65));
+}
+
+TEST_CASE("first covers exactly the leading buttons", "[button_mask]")
+{
+    REQUIRE_FALSE(ButtonMask::first(0).any());
+    REQUIRE(ButtonMask::first(1).bits[0] == 1);
+    REQUIRE(ButtonMask::first(1).bits[1] == 0);
+    REQUIRE(ButtonMask::first(64).bits[0] == ~uint64_t(0));
+    REQUIRE(ButtonMask::first(64).bits[1] == 0);
+    REQUIRE(ButtonMask::first(70).bits[1] == 0x3F);
+    REQUIRE(ButtonMask::first(128).bits[1] == ~uint64_t(0));
+    REQUIRE(ButtonMask::first(500) == ButtonMask::first(128));
+}
+
+TEST_CASE("set buttons are visited in order", "[button_mask]")
+{
+    ButtonMask mask;
+    REQUIRE(set_buttons(mask).empty());
+
+    for(size_t button : {128, 1, 65, 64, 7})
+    {
+        mask.set(button, true);
+    }
+    REQUIRE(set_buttons(mask) == std::vector<size_t>{1, 7, 64, 65, 128});
+    REQUIRE(set_buttons(ButtonMask::first(128)).size() == 128);
+}
+
+TEST_CASE("only the high bit of a button byte counts", "[button_mask]")
+{
+    BYTE buttons[k_max_buttons] = {};
+    buttons[0] = 0x80;
+    buttons[1] = 0x7F;
+    buttons[63] = 0xFF;
+    buttons[64] = 0x81;
+    buttons[127] = 0x80;
+
+    for(auto pack : pack_implementations())
+    {
+        const auto mask = pack(buttons);
+        REQUIRE(set_buttons(mask) == std::vector<size_t>{1, 64, 65, 128});
+    }
+}
+
+TEST_CASE("vectorized packing matches the scalar one", "[button_mask]")
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    BYTE buttons[k_max_buttons];
+    for(int round=0; round<1000; ++round)
+    {
+        for(auto& value : buttons)
+        {
+            value = static_cast<BYTE>(byte(rng));
+        }
+
+        const auto expected = pack_buttons_scalar(buttons);
+        for(auto pack : pack_implementations())
+        {
+            REQUIRE(pack(buttons) == expected);
+        }
+    }
+}
+
+TEST_CASE("changes are the XOR of two masks", "[button_mask]")
+{
+    BYTE previous[k_max_buttons] = {};
+    BYTE current[k_max_buttons] = {};
+    previous[4] = 0x80;
+    previous[99] = 0x80;
+    current[99] = 0x80;
+    current[100] = 0x80;
+    current[120] = 0x80;
+
+    const auto changed = (pack_buttons(previous) ^ pack_buttons(current)) &
+        ButtonMask::first(110);
+    REQUIRE(set_buttons(changed) == std::vector<size_t>{5, 101});
+}
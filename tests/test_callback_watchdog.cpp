@@ -0,0 +1,173 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "callback_watchdog.h"
+#include "event_timing.h"
+#include "input_loop.h"
+#include "input_pipeline.h"
+#include "synthetic_source.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    using std::chrono::milliseconds;
+
+    const uint64_t k_budget_ns = 20000000;
+
+    std::mutex g_stall_mutex;
+    std::vector<CallbackStall> g_stalls;
+    std::atomic<int> g_slow_callbacks{0};
+
+    void reset_stalls()
+    {
+        std::lock_guard<std::mutex> lock(g_stall_mutex);
+        g_stalls.clear();
+    }
+
+    std::vector<CallbackStall> stalls()
+    {
+        std::lock_guard<std::mutex> lock(g_stall_mutex);
+        return g_stalls;
+    }
+
+    void record_stall(CallbackStall const* stall)
+    {
+        std::lock_guard<std::mutex> lock(g_stall_mutex);
+        g_stalls.push_back(*stall);
+    }
+
+    // Blocks on the first button event it sees, as a slow client would.
+    void sleeping_callback(JoystickInputData evt)
+    {
+        if(evt.input_type == JoystickInputType::Button &&
+           g_slow_callbacks.fetch_sub(1) > 0)
+        {
+            std::this_thread::sleep_for(milliseconds(100));
+        }
+    }
+}
+
+
+TEST_CASE("an unconfigured watchdog stays inactive", "[callback_watchdog]")
+{
+    CallbackWatchdog watchdog;
+    watchdog.start();
+    REQUIRE_FALSE(watchdog.active());
+    watchdog.stop();
+
+    watchdog.configure(k_budget_ns, nullptr);
+    watchdog.start();
+    REQUIRE(watchdog.active());
+    watchdog.stop();
+    REQUIRE_FALSE(watchdog.active());
+    REQUIRE(watchdog.stats().budget_ns == k_budget_ns);
+}
+
+TEST_CASE("deliveries over budget are overruns", "[callback_watchdog]")
+{
+    CallbackWatchdog watchdog;
+    watchdog.configure(1000, nullptr);
+    watchdog.start();
+
+    const auto evt = make_input(1, JoystickInputType::Axis, 2, 0);
+    watchdog.enter(1000000, evt);
+    watchdog.leave(1000500);
+    watchdog.enter(2000000, evt);
+    watchdog.leave(2005000);
+    watchdog.enter(3000000, evt.device_guid, DeviceActionType::Connected);
+    watchdog.leave(3002000);
+    watchdog.stop();
+
+    const auto stats = watchdog.stats();
+    REQUIRE(stats.overruns == 2);
+    REQUIRE(stats.max_callback_ns == 5000);
+}
+
+TEST_CASE("running deliveries are flagged once", "[callback_watchdog]")
+{
+    reset_stalls();
+    CallbackWatchdog watchdog;
+    watchdog.configure(k_budget_ns, &record_stall);
+    watchdog.start();
+
+    watchdog.enter(
+        monotonic_time_ns(),
+        make_input(7, JoystickInputType::Axis, 1, 0)
+    );
+    watchdog.update(make_input(7, JoystickInputType::Hat, 2, 0));
+    REQUIRE(wait_until([] { return !stalls().empty(); }));
+    std::this_thread::sleep_for(milliseconds(60));
+    watchdog.leave(monotonic_time_ns());
+
+    watchdog.enter(
+        monotonic_time_ns(),
+        make_guid(8),
+        DeviceActionType::Disconnected
+    );
+    REQUIRE(wait_until([] { return stalls().size() == 2; }));
+    watchdog.leave(monotonic_time_ns());
+    watchdog.stop();
+
+    const auto flagged = stalls();
+    REQUIRE(flagged.size() == 2);
+    REQUIRE(flagged[0].device_guid == make_guid(7));
+    REQUIRE(flagged[0].input_type == JoystickInputType::Hat);
+    REQUIRE(flagged[0].input_index == 2);
+    REQUIRE(flagged[0].action == DeviceActionType{});
+    REQUIRE(flagged[0].elapsed_ns > k_budget_ns);
+    REQUIRE(flagged[1].device_guid == make_guid(8));
+    REQUIRE(flagged[1].action == DeviceActionType::Disconnected);
+
+    const auto stats = watchdog.stats();
+    REQUIRE(stats.stalls == 2);
+    REQUIRE(stats.overruns == 2);
+    REQUIRE(stats.last_stall.device_guid == make_guid(8));
+}
+
+TEST_CASE("a sleeping callback stalls the input loop", "[callback_watchdog]")
+{
+    reset_stalls();
+    g_slow_callbacks = 1;
+
+    SyntheticConfig config;
+    config.axis_count = 2;
+    config.button_count = 4;
+    config.hat_count = 0;
+    config.events_per_second = 2000.0;
+    config.batch_size = 8;
+    SyntheticSource source(config);
+
+    InputPipeline pipeline;
+    auto& dispatcher = pipeline.dispatcher();
+    dispatcher.set_event_callback(&sleeping_callback);
+    dispatcher.configure_watchdog(k_budget_ns, &record_stall);
+    dispatcher.start();
+
+    InputLoop loop(source, pipeline);
+    loop.start();
+    REQUIRE(wait_until([] { return !stalls().empty(); }));
+    REQUIRE(wait_until([&dispatcher] {
+        return dispatcher.watchdog_stats().overruns > 0;
+    }));
+    loop.stop();
+    dispatcher.stop();
+
+    const auto flagged = stalls();
+    REQUIRE(flagged.size() == 1);
+    REQUIRE(flagged[0].input_type == JoystickInputType::Button);
+    REQUIRE(flagged[0].elapsed_ns > k_budget_ns);
+
+    DeviceSummary info;
+    REQUIRE(pipeline.device_information(flagged[0].device_guid, info));
+
+    const auto stats = dispatcher.watchdog_stats();
+    REQUIRE(stats.stalls == 1);
+    REQUIRE(stats.overruns == 1);
+    REQUIRE(stats.max_callback_ns >= 100000000);
+}
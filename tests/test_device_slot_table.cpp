@@ -0,0 +1,157 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <unordered_set>
+
+#include "device_slot_table.h"
+#include "test_helpers.h"
+
+
+TEST_CASE("slots are assigned densely from zero", "[device_slot_table]")
+{
+    DeviceSlotTable table;
+    REQUIRE(table.size() == 0);
+    REQUIRE(table.find(make_guid(1)) == k_invalid_slot);
+
+    REQUIRE(table.acquire(make_guid(1)) == 0);
+    REQUIRE(table.acquire(make_guid(2)) == 1);
+    REQUIRE(table.acquire(make_guid(3)) == 2);
+    REQUIRE(table.size() == 3);
+
+    REQUIRE(table.find(make_guid(2)) == 1);
+    REQUIRE(table.guid(2) == make_guid(3));
+}
+
+TEST_CASE("acquiring a known device returns its slot", "[device_slot_table]")
+{
+    DeviceSlotTable table;
+    table.acquire(make_guid(1));
+    const auto slot = table.acquire(make_guid(2));
+
+    REQUIRE(table.acquire(make_guid(2)) == slot);
+    REQUIRE(table.size() == 2);
+}
+
+TEST_CASE("released slots are reused lowest first", "[device_slot_table]")
+{
+    DeviceSlotTable table;
+    for(DWORD i=1; i<=5; ++i)
+    {
+        table.acquire(make_guid(i));
+    }
+
+    REQUIRE(table.release(make_guid(4)) == 3);
+    REQUIRE(table.release(make_guid(2)) == 1);
+    REQUIRE(table.release(make_guid(2)) == k_invalid_slot);
+    REQUIRE(table.find(make_guid(2)) == k_invalid_slot);
+
+    REQUIRE(table.acquire(make_guid(10)) == 1);
+    REQUIRE(table.acquire(make_guid(11)) == 3);
+    REQUIRE(table.acquire(make_guid(12)) == 5);
+}
+
+TEST_CASE("active slots keep their acquisition order", "[device_slot_table]")
+{
+    DeviceSlotTable table;
+    for(DWORD i=1; i<=4; ++i)
+    {
+        table.acquire(make_guid(i));
+    }
+    table.release(make_guid(2));
+    table.acquire(make_guid(5));
+
+    REQUIRE(table.active() == std::vector<uint32_t>{0, 2, 3, 1});
+    REQUIRE(table.guid(table.active()[3]) == make_guid(5));
+}
+
+TEST_CASE("generations detect stale references", "[device_slot_table]")
+{
+    DeviceSlotTable table;
+    const auto slot = table.acquire(make_guid(1));
+    const auto ref = table.ref(slot);
+    REQUIRE(table.is_current(ref));
+
+    table.release(make_guid(1));
+    REQUIRE_FALSE(table.is_current(ref));
+
+    // The same slot handed to another device is still not the old device.
+    REQUIRE(table.acquire(make_guid(2)) == slot);
+    REQUIRE_FALSE(table.is_current(ref));
+    REQUIRE(table.is_current(table.ref(slot)));
+
+    REQUIRE_FALSE(table.is_current({k_max_devices, ref.generation}));
+}
+
+TEST_CASE("table holds at most k_max_devices devices", "[device_slot_table]")
+{
+    DeviceSlotTable table;
+    for(DWORD i=0; i<k_max_devices; ++i)
+    {
+        REQUIRE(table.acquire(make_guid(i + 1)) == i);
+    }
+    REQUIRE(table.acquire(make_guid(1000)) == k_invalid_slot);
+
+    const auto ref = table.ref(0);
+    table.clear();
+    REQUIRE(table.size() == 0);
+    REQUIRE_FALSE(table.is_current(ref));
+    REQUIRE(table.acquire(make_guid(1000)) == 0);
+}
+
+TEST_CASE("device handles round trip slot references", "[device_slot_table]")
+{
+    for(uint32_t slot : {0u, 1u, 17u, static_cast<uint32_t>(k_max_devices - 1)})
+    {
+        for(uint32_t generation : {1u, 2u, 0x1234u, k_max_generation})
+        {
+            const auto handle = encode_device_handle({slot, generation});
+            REQUIRE(handle != k_invalid_device_handle);
+
+            const auto ref = decode_device_handle(handle);
+            REQUIRE(ref.slot == slot);
+            REQUIRE(ref.generation == generation);
+        }
+    }
+
+    DeviceSlotTable table;
+    table.acquire(make_guid(1));
+    REQUIRE_FALSE(
+        table.is_current(decode_device_handle(k_invalid_device_handle))
+    );
+    REQUIRE(table.is_current(
+        decode_device_handle(encode_device_handle(table.ref(0)))
+    ));
+}
+
+TEST_CASE("handles of released devices become stale", "[device_slot_table]")
+{
+    DeviceSlotTable table;
+    const auto slot = table.acquire(make_guid(1));
+    const auto handle = encode_device_handle(table.ref(slot));
+
+    table.release(make_guid(1));
+    table.acquire(make_guid(2));
+    REQUIRE_FALSE(table.is_current(decode_device_handle(handle)));
+    REQUIRE(encode_device_handle(table.ref(0)) != handle);
+}
+
+TEST_CASE("GUID hash separates similar GUIDs", "[device_slot_table]")
+{
+    // These collide under a XOR fold of the GUID's 32 bit words.
+    GUID first{};
+    first.Data1 = 1;
+    GUID second{};
+    second.Data4[0] = 1;
+    REQUIRE(hash_guid(first) != hash_guid(second));
+
+    // Devices of one model typically only differ in Data1.
+    std::unordered_set<uint64_t> hashes;
+    std::unordered_set<uint64_t> low_bytes;
+    for(DWORD i=0; i<4096; ++i)
+    {
+        const auto hash = hash_guid(make_guid(i));
+        hashes.insert(hash);
+        low_bytes.insert(hash & 0xFF);
+    }
+    REQUIRE(hashes.size() == 4096);
+    REQUIRE(low_bytes.size() == 256);
+}
@@ -0,0 +1,235 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "device_state_table.h"
+#include "test_helpers.h"
+
+
+TEST_CASE("unknown devices are not found", "[device_state_table]")
+{
+    DeviceStateTable table;
+    DeviceState state;
+
+    REQUIRE_FALSE(table.load(make_guid(1), state));
+    REQUIRE_FALSE(table.load(GUID{}, state));
+
+    table.add({3, 1}, make_guid(1));
+    REQUIRE_FALSE(table.load(make_guid(2), state));
+    REQUIRE_FALSE(table.load(GUID{}, state));
+}
+
+TEST_CASE("added devices start with the default state", "[device_state_table]")
+{
+    DeviceStateTable table;
+    table.add({0, 1}, make_guid(1));
+
+    DeviceState state;
+    REQUIRE(table.load(make_guid(1), state));
+    REQUIRE(state.axis[1] == 0);
+    REQUIRE(state.button.test(128) == false);
+    REQUIRE(state.hat[4] == -1);
+}
+
+TEST_CASE("updates are isolated per device", "[device_state_table]")
+{
+    DeviceStateTable table;
+    table.add({0, 1}, make_guid(1));
+    table.add({1, 1}, make_guid(2));
+
+    table.update(0, [](DeviceState& state) {
+        state.axis[3] = 1000;
+        state.button.set(128, true);
+        state.hat[4] = 9000;
+    });
+
+    DeviceState first;
+    DeviceState second;
+    REQUIRE(table.load(make_guid(1), first));
+    REQUIRE(table.load(make_guid(2), second));
+    REQUIRE(first.axis[3] == 1000);
+    REQUIRE(first.button.test(128) == true);
+    REQUIRE(first.hat[4] == 9000);
+    REQUIRE(second.axis[3] == 0);
+    REQUIRE(second.button.test(128) == false);
+    REQUIRE(second.hat[4] == -1);
+}
+
+TEST_CASE("removed devices are no longer found", "[device_state_table]")
+{
+    DeviceStateTable table;
+    for(uint32_t slot=0; slot<k_max_devices; ++slot)
+    {
+        table.add({slot, 1}, make_guid(slot + 1));
+    }
+
+    table.update(4, [](DeviceState& state) { state.axis[1] = 5; });
+    table.remove(4);
+
+    DeviceState state;
+    REQUIRE_FALSE(table.load(make_guid(5), state));
+    REQUIRE(table.load(make_guid(k_max_devices), state));
+
+    // A reused slot starts with a fresh state.
+    table.add({4, 2}, make_guid(1000));
+    REQUIRE(table.load(make_guid(1000), state));
+    REQUIRE(state.axis[1] == 0);
+
+    table.clear();
+    REQUIRE_FALSE(table.load(make_guid(1000), state));
+    REQUIRE_FALSE(table.load(make_guid(1), state));
+}
+
+TEST_CASE("slot references only match their generation", "[device_state_table]")
+{
+    DeviceStateTable table;
+    DeviceState state;
+    REQUIRE_FALSE(table.load(SlotRef{0, 1}, state));
+
+    table.add({2, 7}, make_guid(1));
+    table.update(2, [](DeviceState& current) { current.axis[2] = 42; });
+
+    REQUIRE(table.load(SlotRef{2, 7}, state));
+    REQUIRE(state.axis[2] == 42);
+    REQUIRE_FALSE(table.load(SlotRef{2, 6}, state));
+    REQUIRE_FALSE(table.load(SlotRef{1, 7}, state));
+    REQUIRE_FALSE(table.load(SlotRef{k_invalid_slot, 7}, state));
+
+    // A removed or reused slot no longer matches the old reference.
+    table.remove(2);
+    REQUIRE_FALSE(table.load(SlotRef{2, 7}, state));
+    REQUIRE_FALSE(table.load(SlotRef{2, 0}, state));
+    table.add({2, 8}, make_guid(2));
+    REQUIRE_FALSE(table.load(SlotRef{2, 7}, state));
+    REQUIRE(table.load(SlotRef{2, 8}, state));
+    REQUIRE(state.axis[2] == 0);
+}
+
+TEST_CASE("snapshots pack the complete state", "[device_state_table]")
+{
+    DeviceStateTable table;
+    table.add({0, 1}, make_guid(1));
+    table.add({1, 3}, make_guid(2));
+    table.update(1, [](DeviceState& state) {
+        state.axis[1] = -7;
+        state.axis[8] = 32767;
+        state.button.set(1, true);
+        state.button.set(64, true);
+        state.button.set(65, true);
+        state.button.set(128, true);
+        state.hat[2] = 27000;
+    });
+
+    DillDeviceSnapshot snapshot;
+    REQUIRE(table.snapshot(make_guid(2), snapshot));
+    REQUIRE(snapshot.device_guid == make_guid(2));
+    REQUIRE(snapshot.button_mask[0] == ((uint64_t(1) << 63) | 1));
+    REQUIRE(snapshot.button_mask[1] == ((uint64_t(1) << 63) | 1));
+    REQUIRE(snapshot.axis[1] == -7);
+    REQUIRE(snapshot.axis[2] == 0);
+    REQUIRE(snapshot.axis[8] == 32767);
+    REQUIRE(snapshot.hat[1] == -1);
+    REQUIRE(snapshot.hat[2] == 27000);
+
+    DillDeviceSnapshot by_ref;
+    REQUIRE(table.snapshot(SlotRef{1, 3}, by_ref));
+    REQUIRE(by_ref.version == snapshot.version);
+    REQUIRE(by_ref.axis[8] == 32767);
+    REQUIRE_FALSE(table.snapshot(SlotRef{1, 2}, by_ref));
+    REQUIRE_FALSE(table.snapshot(make_guid(3), by_ref));
+}
+
+TEST_CASE("snapshot versions increase with every change", "[device_state_table]")
+{
+    DeviceStateTable table;
+    table.add({0, 1}, make_guid(1));
+    table.add({1, 1}, make_guid(2));
+
+    DillDeviceSnapshot first;
+    DillDeviceSnapshot second;
+    REQUIRE(table.snapshot(make_guid(1), first));
+    REQUIRE(table.snapshot(make_guid(1), second));
+    REQUIRE(second.version == first.version);
+
+    table.update(0, [](DeviceState& state) { state.axis[1] = 1; });
+    REQUIRE(table.snapshot(make_guid(1), second));
+    REQUIRE(second.version > first.version);
+
+    // Versions keep increasing across a reconnect.
+    const auto before = second.version;
+    table.update(1, [](DeviceState& state) { state.axis[1] = 1; });
+    table.remove(0);
+    table.add({0, 2}, make_guid(1));
+    REQUIRE(table.snapshot(make_guid(1), second));
+    REQUIRE(second.version > before);
+}
+
+TEST_CASE(
+    "readers observe consistent state while a writer updates it",
+    "[device_state_table]"
+)
+{
+    DeviceStateTable table;
+    table.add({0, 1}, make_guid(1));
+    table.add({1, 1}, make_guid(2));
+
+    auto write_state = [&table](LONG value) {
+        table.update(1, [value](DeviceState& state) {
+            state.axis.fill(value);
+            state.hat[4] = value;
+            state.button.set(128, (value & 1) == 1);
+        });
+    };
+    write_state(0);
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> inconsistent{0};
+
+    std::vector<std::thread> readers;
+    for(int i=0; i<3; ++i)
+    {
+        readers.emplace_back([&table, &done, &inconsistent]() {
+            DeviceState state;
+            while(!done.load())
+            {
+                if(!table.load(make_guid(2), state))
+                {
+                    ++inconsistent;
+                    continue;
+                }
+                for(size_t axis=2; axis<state.axis.size(); ++axis)
+                {
+                    if(state.axis[axis] != state.axis[1])
+                    {
+                        ++inconsistent;
+                    }
+                }
+                if(state.hat[4] != state.axis[1] ||
+                   state.button.test(128) != ((state.axis[1] & 1) == 1))
+                {
+                    ++inconsistent;
+                }
+            }
+        });
+    }
+
+    for(LONG value=1; value<=100000; ++value)
+    {
+        // Keep reassigning another block so the reader scan races with it.
+        if(value % 1000 == 0)
+        {
+            table.remove(0);
+            table.add({0, 1}, make_guid(1));
+        }
+        write_state(value);
+    }
+    done = true;
+    for(auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    REQUIRE(inconsistent == 0);
+}
@@ -0,0 +1,178 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <mutex>
+#include <vector>
+
+#include "axis_mapping.h"
+#include "device_store.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    // Callbacks are plain function pointers, so they record into globals.
+    std::vector<JoystickInputData> g_delivered;
+
+    void record_event(JoystickInputData evt)
+    {
+        g_delivered.push_back(evt);
+    }
+
+    // Store together with the components it feeds.
+    struct Fixture
+    {
+        Fixture()
+            :   store(mutex, metrics, recorder, dispatcher)
+        {
+            g_delivered.clear();
+            dispatcher.set_event_callback(&record_event);
+        }
+
+        uint32_t add(DWORD id)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return store.add(extend_device_summary(make_device(id)));
+        }
+
+        std::mutex                      mutex;
+        InputMetrics                    metrics;
+        InputRecorder                   recorder;
+        InputDispatcher                 dispatcher;
+        DeviceStore                     store;
+    };
+}
+
+
+TEST_CASE("devices keep their slot until removed", "[device_store]")
+{
+    Fixture fixture;
+    auto& store = fixture.store;
+
+    const auto first = fixture.add(1);
+    const auto second = fixture.add(2);
+    REQUIRE(first != k_invalid_slot);
+    REQUIRE(second != first);
+    REQUIRE(store.slots().find(make_guid(2)) == second);
+    REQUIRE(store.info(second).summary.button_count == 16);
+
+    DeviceSummary info;
+    REQUIRE(store.remove(make_guid(1), info) == first);
+    REQUIRE(info.device_guid == make_guid(1));
+    REQUIRE(store.slots().find(make_guid(1)) == k_invalid_slot);
+    DeviceState state;
+    REQUIRE_FALSE(store.state().load(make_guid(1), state));
+    REQUIRE(store.remove(make_guid(1), info) == k_invalid_slot);
+
+    store.clear();
+    REQUIRE(store.slots().size() == 0);
+    REQUIRE_FALSE(store.state().load(make_guid(2), state));
+}
+
+TEST_CASE("filters only affect delivered events", "[device_store]")
+{
+    Fixture fixture;
+    auto& store = fixture.store;
+    const auto slot = fixture.add(1);
+    {
+        std::lock_guard<std::mutex> lock(fixture.mutex);
+        const uint64_t none[2] = {0, 0};
+        REQUIRE(store.set_subscription(slot, k_subscribe_buttons, none));
+        REQUIRE(store.set_axis_filter(slot, 1, {100, 0, 0}));
+    }
+
+    store.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 50),
+        make_event(1, JoystickInputType::Button, 3, 1),
+        make_event(1, JoystickInputType::Axis, 1, 150)
+    });
+
+    REQUIRE(g_delivered.size() == 1);
+    REQUIRE(g_delivered[0].input_type == JoystickInputType::Axis);
+    REQUIRE(g_delivered[0].value == 150);
+
+    DeviceState state;
+    REQUIRE(store.state().load(make_guid(1), state));
+    REQUIRE(state.axis[1] == 150);
+    REQUIRE(state.button.test(3));
+
+    const auto metrics = fixture.metrics.device(slot, make_guid(1));
+    REQUIRE(metrics.events_decoded == 3);
+    REQUIRE(metrics.events_emitted == 1);
+
+    // A reconnected device starts out unfiltered.
+    DeviceSummary info;
+    {
+        std::lock_guard<std::mutex> lock(fixture.mutex);
+        store.remove(make_guid(1), info);
+    }
+    fixture.add(1);
+    g_delivered.clear();
+    store.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Button, 3, 1)
+    });
+    REQUIRE(g_delivered.size() == 1);
+}
+
+TEST_CASE("batches can be derived while updating the state", "[device_store]")
+{
+    Fixture fixture;
+    auto& store = fixture.store;
+    const auto slot = fixture.add(1);
+
+    std::vector<JoystickInputEventEx> events;
+    store.input_events(slot, events, [&events](DeviceState& state) {
+        state.hat[1] = 9000;
+        events.push_back(make_event(1, JoystickInputType::Hat, 1, 9000));
+    });
+
+    REQUIRE(g_delivered.size() == 1);
+    REQUIRE(g_delivered[0].value == 9000);
+    DeviceState state;
+    REQUIRE(store.state().load(make_guid(1), state));
+    REQUIRE(state.hat[1] == 9000);
+}
+
+TEST_CASE("events of unknown devices are ignored", "[device_store]")
+{
+    Fixture fixture;
+    fixture.add(1);
+
+    fixture.store.input_events(make_guid(2), {
+        make_event(2, JoystickInputType::Axis, 1, 10)
+    });
+    REQUIRE(g_delivered.empty());
+}
+
+TEST_CASE("extended axes are tracked even when not delivered", "[device_store]")
+{
+    Fixture fixture;
+    auto& store = fixture.store;
+    fixture.add(1);
+    {
+        std::lock_guard<std::mutex> lock(fixture.mutex);
+        store.set_extended_axes(false);
+    }
+
+    store.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 12, 300),
+        make_event(1, JoystickInputType::Axis, 2, 40)
+    });
+
+    REQUIRE(g_delivered.size() == 1);
+    REQUIRE(g_delivered[0].input_index == 2);
+    DeviceState state;
+    REQUIRE(store.state().load(make_guid(1), state));
+    REQUIRE(state.axis[12] == 300);
+    REQUIRE(state.axis[2] == 40);
+
+    {
+        std::lock_guard<std::mutex> lock(fixture.mutex);
+        store.set_extended_axes(true);
+    }
+    g_delivered.clear();
+    store.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 12, 310)
+    });
+    REQUIRE(g_delivered.size() == 1);
+    REQUIRE(g_delivered[0].value == 310);
+}
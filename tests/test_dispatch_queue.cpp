@@ -0,0 +1,178 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "dispatch_queue.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    std::vector<LONG> values(DispatchBatch const& batch)
+    {
+        std::vector<LONG> result;
+        for(auto const& evt : batch.events)
+        {
+            result.push_back(evt.data.value);
+        }
+        return result;
+    }
+}
+
+
+TEST_CASE("events are taken in runs of one device", "[dispatch_queue]")
+{
+    DispatchQueue queue(16, DispatchPolicy::Block);
+    queue.push({
+        make_event(1, JoystickInputType::Axis, 1, 1),
+        make_event(1, JoystickInputType::Axis, 1, 2)
+    });
+    queue.push({make_event(2, JoystickInputType::Axis, 1, 3)});
+    queue.push({make_event(1, JoystickInputType::Axis, 1, 4)});
+
+    auto stats = queue.stats();
+    REQUIRE(stats.capacity == 16);
+    REQUIRE(stats.depth == 4);
+    REQUIRE(stats.max_depth == 4);
+
+    DispatchBatch batch;
+    REQUIRE(queue.pop(batch));
+    REQUIRE_FALSE(batch.is_device_change);
+    REQUIRE(values(batch) == std::vector<LONG>{1, 2});
+    REQUIRE(queue.pop(batch));
+    REQUIRE(values(batch) == std::vector<LONG>{3});
+    REQUIRE(queue.pop(batch));
+    REQUIRE(values(batch) == std::vector<LONG>{4});
+
+    stats = queue.stats();
+    REQUIRE(stats.depth == 0);
+    REQUIRE(stats.enqueued == 4);
+    REQUIRE(stats.delivered == 4);
+
+    queue.close();
+    REQUIRE_FALSE(queue.pop(batch));
+}
+
+TEST_CASE("device changes keep their place among events", "[dispatch_queue]")
+{
+    DispatchQueue queue(16, DispatchPolicy::Block);
+    queue.push(make_device(1), DeviceActionType::Connected);
+    queue.push({
+        make_event(1, JoystickInputType::Button, 1, 1),
+        make_event(1, JoystickInputType::Button, 1, 0)
+    });
+    queue.push(make_device(1), DeviceActionType::Disconnected);
+    queue.push({make_event(2, JoystickInputType::Button, 1, 1)});
+    queue.close();
+
+    DispatchBatch batch;
+    REQUIRE(queue.pop(batch));
+    REQUIRE(batch.is_device_change);
+    REQUIRE(batch.action == DeviceActionType::Connected);
+    REQUIRE(queue.pop(batch));
+    REQUIRE(values(batch) == std::vector<LONG>{1, 0});
+    REQUIRE(queue.pop(batch));
+    REQUIRE(batch.is_device_change);
+    REQUIRE(batch.action == DeviceActionType::Disconnected);
+
+    // Closing lets the pending items drain.
+    REQUIRE(queue.pop(batch));
+    REQUIRE_FALSE(batch.is_device_change);
+    REQUIRE(batch.events[0].data.device_guid == make_guid(2));
+    REQUIRE_FALSE(queue.pop(batch));
+    REQUIRE(queue.stats().device_changes == 2);
+}
+
+TEST_CASE("drop oldest discards pending events only", "[dispatch_queue]")
+{
+    DispatchQueue queue(2, DispatchPolicy::DropOldest);
+    queue.push({make_event(1, JoystickInputType::Axis, 1, 1)});
+    queue.push(make_device(1), DeviceActionType::Disconnected);
+    queue.push({
+        make_event(1, JoystickInputType::Axis, 1, 2),
+        make_event(1, JoystickInputType::Axis, 1, 3),
+        make_event(1, JoystickInputType::Axis, 1, 4)
+    });
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.dropped == 2);
+    REQUIRE(stats.depth == 2);
+
+    DispatchBatch batch;
+    REQUIRE(queue.pop(batch));
+    REQUIRE(batch.is_device_change);
+    REQUIRE(queue.pop(batch));
+    REQUIRE(values(batch) == std::vector<LONG>{3, 4});
+}
+
+TEST_CASE("coalesce axis merges into the pending event", "[dispatch_queue]")
+{
+    DispatchQueue queue(3, DispatchPolicy::CoalesceAxis);
+    queue.push({
+        make_event(1, JoystickInputType::Axis, 1, 1),
+        make_event(1, JoystickInputType::Axis, 2, 10),
+        make_event(1, JoystickInputType::Button, 1, 1),
+        make_event(1, JoystickInputType::Axis, 1, 2),
+        make_event(1, JoystickInputType::Axis, 2, 20),
+        make_event(1, JoystickInputType::Axis, 1, 3)
+    });
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.coalesced == 3);
+    REQUIRE(stats.blocked == 0);
+
+    DispatchBatch batch;
+    REQUIRE(queue.pop(batch));
+    REQUIRE(values(batch) == std::vector<LONG>{3, 20, 1});
+}
+
+TEST_CASE("full queues make the producer wait", "[dispatch_queue]")
+{
+    for(auto policy : {DispatchPolicy::Block, DispatchPolicy::CoalesceAxis})
+    {
+        DispatchQueue queue(1, policy);
+        queue.push({make_event(1, JoystickInputType::Button, 1, 1)});
+
+        std::atomic<bool> pushed{false};
+        std::thread producer([&] {
+            queue.push({make_event(1, JoystickInputType::Button, 1, 0)});
+            pushed = true;
+        });
+        while(queue.stats().blocked == 0)
+        {
+            std::this_thread::yield();
+        }
+        REQUIRE_FALSE(pushed);
+
+        DispatchBatch batch;
+        REQUIRE(queue.pop(batch));
+        REQUIRE(values(batch) == std::vector<LONG>{1});
+        REQUIRE(queue.pop(batch));
+        REQUIRE(values(batch) == std::vector<LONG>{0});
+        producer.join();
+        REQUIRE(pushed);
+        REQUIRE(queue.stats().dropped == 0);
+    }
+}
+
+TEST_CASE("closing releases a waiting producer", "[dispatch_queue]")
+{
+    DispatchQueue queue(1, DispatchPolicy::Block);
+    queue.push({make_event(1, JoystickInputType::Button, 1, 1)});
+
+    std::thread producer([&] {
+        queue.push({make_event(1, JoystickInputType::Button, 1, 0)});
+    });
+    while(queue.stats().blocked == 0)
+    {
+        std::this_thread::yield();
+    }
+    queue.close();
+    producer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.dropped == 1);
+    REQUIRE(stats.depth == 1);
+}
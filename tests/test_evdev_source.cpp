@@ -0,0 +1,429 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/input.h>
+#include <unistd.h>
+
+#include "evdev_source.h"
+#include "input_pipeline.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    EvdevCapabilities make_capabilities(DWORD id)
+    {
+        EvdevCapabilities capabilities;
+        capabilities.guid = make_guid(id);
+        capabilities.name = "Synthetic stick";
+        capabilities.vendor_id = 0x1234;
+        capabilities.product_id = 0x5678;
+        capabilities.abs_axes = {
+            {ABS_X, -512, 511},
+            {ABS_Y, 0, 1023},
+            {ABS_RZ, 0, 255},
+            {ABS_BRAKE, 0, 255},
+            {ABS_THROTTLE, 0, 255},
+            {ABS_MISC, 0, 255},
+            {ABS_HAT0X, -1, 1},
+            {ABS_HAT0Y, -1, 1},
+            {ABS_HAT1X, -1, 1},
+            {ABS_HAT1Y, -1, 1}
+        };
+        capabilities.keys = {BTN_THUMB, BTN_TRIGGER, BTN_BASE, BTN_TRIGGER_HAPPY1};
+        return capabilities;
+    }
+
+    input_event make_record(uint16_t type, uint16_t code, int32_t value)
+    {
+        input_event record{};
+        record.input_event_sec = 12;
+        record.input_event_usec = 345678;
+        record.type = type;
+        record.code = code;
+        record.value = value;
+        return record;
+    }
+
+    input_event sync_record()
+    {
+        return make_record(EV_SYN, SYN_REPORT, 0);
+    }
+
+    // Pipe standing in for a device node, the source owns the read end.
+    struct FakeDevice
+    {
+        int write_fd = -1;
+
+        bool attach(EvdevSource& source, EvdevCapabilities const& capabilities)
+        {
+            int fds[2];
+            if(pipe2(fds, O_CLOEXEC) != 0)
+            {
+                return false;
+            }
+            write_fd = fds[1];
+            return source.add_device(fds[0], capabilities);
+        }
+
+        void send(std::vector<input_event> const& records)
+        {
+            const auto size = records.size() * sizeof(input_event);
+            REQUIRE(write(write_fd, records.data(), size) == ssize_t(size));
+        }
+
+        // Writes raw bytes, e.g. part of a record.
+        void send_bytes(void const* data, size_t size)
+        {
+            REQUIRE(write(write_fd, data, size) == ssize_t(size));
+        }
+
+        void disconnect()
+        {
+            if(write_fd != -1)
+            {
+                close(write_fd);
+                write_fd = -1;
+            }
+        }
+
+        ~FakeDevice()
+        {
+            disconnect();
+        }
+    };
+
+    struct RecordingSink : public InputSink
+    {
+        std::vector<DeviceSummary> added;
+        std::vector<GUID> removed;
+        std::vector<std::vector<JoystickInputEventEx>> batches;
+
+        bool device_added(DeviceSummary const& info) override
+        {
+            added.push_back(info);
+            return true;
+        }
+
+        void device_removed(GUID const& guid) override
+        {
+            removed.push_back(guid);
+        }
+
+        void input_events(
+            GUID const&,
+            std::vector<JoystickInputEventEx> const& events
+        ) override
+        {
+            batches.push_back(events);
+        }
+
+        std::vector<JoystickInputData> events() const
+        {
+            std::vector<JoystickInputData> result;
+            for(auto const& batch : batches)
+            {
+                for(auto const& evt : batch)
+                {
+                    result.push_back(evt.data);
+                }
+            }
+            return result;
+        }
+    };
+
+    const std::chrono::milliseconds k_timeout{1000};
+}
+
+
+TEST_CASE("evdev devices are described in DILL's model", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(1)));
+
+    RecordingSink sink;
+    REQUIRE(source.process(sink, std::chrono::milliseconds(0)));
+    REQUIRE(sink.added.size() == 1);
+
+    auto const& info = sink.added[0];
+    REQUIRE(info.device_guid == make_guid(1));
+    REQUIRE(std::string(info.name) == "Synthetic stick");
+    REQUIRE(info.vendor_id == 0x1234);
+    REQUIRE(info.product_id == 0x5678);
+    REQUIRE(info.button_count == 4);
+    REQUIRE(info.hat_count == 2);
+
+    // Main axes keep their index, the first two sliders by code follow.
+    REQUIRE(info.axis_count == 5);
+    const DWORD expected_axes[] = {1, 2, 6, 7, 8};
+    for(DWORD i=0; i<info.axis_count; ++i)
+    {
+        REQUIRE(info.axis_map[i].linear_index == i + 1);
+        REQUIRE(info.axis_map[i].axis_index == expected_axes[i]);
+    }
+}
+
+TEST_CASE("evdev axes are scaled onto DILL's range", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(1)));
+    RecordingSink sink;
+
+    device.send({
+        make_record(EV_ABS, ABS_X, -512),
+        make_record(EV_ABS, ABS_Y, 1023),
+        make_record(EV_ABS, ABS_THROTTLE, 255),
+        make_record(EV_ABS, ABS_BRAKE, 0),
+        make_record(EV_ABS, ABS_MISC, 128),
+        sync_record(),
+        make_record(EV_ABS, ABS_X, 600),
+        make_record(EV_ABS, ABS_Y, 1023),
+        sync_record()
+    });
+    REQUIRE(source.process(sink, k_timeout));
+
+    std::vector<std::pair<int, LONG>> axes;
+    for(auto const& evt : sink.events())
+    {
+        REQUIRE(evt.input_type == JoystickInputType::Axis);
+        axes.emplace_back(evt.input_index, evt.value);
+    }
+    // ABS_MISC has no slider left, out of range values are clamped and
+    // unchanged values are dropped.
+    REQUIRE(axes == std::vector<std::pair<int, LONG>>{
+        {1, -32768},
+        {2, 32767},
+        {7, 32767},
+        {8, -32768},
+        {1, 32767}
+    });
+}
+
+TEST_CASE("evdev keys map onto buttons in code order", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(1)));
+    RecordingSink sink;
+
+    device.send({
+        make_record(EV_KEY, BTN_TRIGGER, 1),
+        make_record(EV_KEY, BTN_TRIGGER_HAPPY1, 1),
+        make_record(EV_KEY, BTN_TRIGGER, 2),
+        make_record(EV_KEY, BTN_LEFT, 1),
+        sync_record(),
+        make_record(EV_KEY, BTN_TRIGGER, 0),
+        make_record(EV_KEY, BTN_BASE, 1),
+        sync_record()
+    });
+    REQUIRE(source.process(sink, k_timeout));
+
+    const auto events = sink.events();
+    REQUIRE(events.size() == 4);
+    for(auto const& evt : events)
+    {
+        REQUIRE(evt.input_type == JoystickInputType::Button);
+    }
+    REQUIRE(events[0].input_index == 1);
+    REQUIRE(events[0].value == 1);
+    REQUIRE(events[1].input_index == 4);
+    REQUIRE(events[1].value == 1);
+    REQUIRE(events[2].input_index == 1);
+    REQUIRE(events[2].value == 0);
+    REQUIRE(events[3].input_index == 3);
+    REQUIRE(events[3].value == 1);
+}
+
+TEST_CASE("evdev hat axes combine into POV directions", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(1)));
+    RecordingSink sink;
+
+    device.send({
+        make_record(EV_ABS, ABS_HAT0Y, -1),
+        sync_record(),
+        make_record(EV_ABS, ABS_HAT0X, 1),
+        sync_record(),
+        make_record(EV_ABS, ABS_HAT0Y, 0),
+        sync_record(),
+        make_record(EV_ABS, ABS_HAT0Y, 1),
+        make_record(EV_ABS, ABS_HAT0X, -1),
+        sync_record(),
+        make_record(EV_ABS, ABS_HAT1X, -1),
+        sync_record(),
+        make_record(EV_ABS, ABS_HAT0X, 0),
+        make_record(EV_ABS, ABS_HAT0Y, 0),
+        sync_record(),
+        // The device only reports two hats.
+        make_record(EV_ABS, ABS_HAT2X, 1),
+        sync_record()
+    });
+    REQUIRE(source.process(sink, k_timeout));
+
+    std::vector<std::pair<int, LONG>> hats;
+    for(auto const& evt : sink.events())
+    {
+        REQUIRE(evt.input_type == JoystickInputType::Hat);
+        hats.emplace_back(evt.input_index, evt.value);
+    }
+    REQUIRE(hats == std::vector<std::pair<int, LONG>>{
+        {1, 0},
+        {1, 4500},
+        {1, 9000},
+        {1, 13500},
+        {1, 22500},
+        {2, 27000},
+        {1, 18000},
+        {1, -1}
+    });
+}
+
+TEST_CASE("evdev events carry kernel time and a sequence", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice first;
+    FakeDevice second;
+    REQUIRE(first.attach(source, make_capabilities(1)));
+    REQUIRE(second.attach(source, make_capabilities(2)));
+    RecordingSink sink;
+    REQUIRE(source.process(sink, std::chrono::milliseconds(0)));
+    REQUIRE(sink.added.size() == 2);
+
+    first.send({make_record(EV_KEY, BTN_TRIGGER, 1), sync_record()});
+    second.send({make_record(EV_KEY, BTN_THUMB, 1), sync_record()});
+    while(sink.batches.size() < 2)
+    {
+        REQUIRE(source.process(sink, k_timeout));
+    }
+
+    REQUIRE(sink.batches[0].size() == 1);
+    REQUIRE(sink.batches[1].size() == 1);
+    auto const& a = sink.batches[0][0];
+    auto const& b = sink.batches[1][0];
+    REQUIRE(a.source_timestamp == 12345);
+    REQUIRE(a.struct_size == sizeof(JoystickInputEventEx));
+    REQUIRE(a.receive_time_ns > 0);
+    REQUIRE(a.data.device_guid != b.data.device_guid);
+    REQUIRE(std::min(a.source_sequence, b.source_sequence) + 1 ==
+        std::max(a.source_sequence, b.source_sequence));
+}
+
+TEST_CASE("events after a kernel drop are skipped up to the report", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(1)));
+    RecordingSink sink;
+
+    device.send({
+        make_record(EV_KEY, BTN_TRIGGER, 1),
+        make_record(EV_SYN, SYN_DROPPED, 0),
+        make_record(EV_KEY, BTN_THUMB, 1),
+        sync_record(),
+        make_record(EV_KEY, BTN_BASE, 1),
+        sync_record()
+    });
+    REQUIRE(source.process(sink, k_timeout));
+
+    const auto events = sink.events();
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].input_index == 1);
+    REQUIRE(events[1].input_index == 3);
+}
+
+TEST_CASE("records split across reads are reassembled", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(1)));
+    RecordingSink sink;
+
+    const std::vector<input_event> records = {
+        make_record(EV_KEY, BTN_TRIGGER, 1),
+        make_record(EV_KEY, BTN_THUMB, 1),
+        sync_record()
+    };
+    const auto* bytes = reinterpret_cast<char const*>(records.data());
+    const size_t split = sizeof(input_event) + sizeof(input_event) / 2;
+    device.send_bytes(bytes, split);
+    REQUIRE(source.process(sink, k_timeout));
+    REQUIRE(sink.events().size() == 1);
+
+    const size_t rest = records.size() * sizeof(input_event) - split;
+    device.send_bytes(bytes + split, rest);
+    REQUIRE(source.process(sink, k_timeout));
+
+    const auto events = sink.events();
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].input_index == 1);
+    REQUIRE(events[1].input_index == 2);
+    REQUIRE(events[1].value == 1);
+}
+
+TEST_CASE("closed evdev devices are removed", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(1)));
+    RecordingSink sink;
+
+    device.send({make_record(EV_KEY, BTN_TRIGGER, 1), sync_record()});
+    device.disconnect();
+    REQUIRE(source.process(sink, k_timeout));
+
+    // Input still pending when the device went away is delivered first.
+    REQUIRE(sink.events().size() == 1);
+    REQUIRE(sink.removed.size() == 1);
+    REQUIRE(sink.removed[0] == make_guid(1));
+}
+
+TEST_CASE("waking the evdev source interrupts its wait", "[evdev_source]")
+{
+    EvdevSource source;
+    RecordingSink sink;
+
+    std::thread waker([&source]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        source.wake();
+    });
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(source.process(sink, std::chrono::milliseconds(10000)));
+    waker.join();
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+TEST_CASE("evdev input flows through the input pipeline", "[evdev_source]")
+{
+    EvdevSource source;
+    FakeDevice device;
+    REQUIRE(device.attach(source, make_capabilities(7)));
+    InputPipeline pipeline;
+
+    device.send({
+        make_record(EV_ABS, ABS_RZ, 255),
+        make_record(EV_KEY, BTN_TRIGGER_HAPPY1, 1),
+        make_record(EV_ABS, ABS_HAT1Y, -1),
+        sync_record()
+    });
+    REQUIRE(source.process(pipeline, k_timeout));
+    REQUIRE(pipeline.device_count() == 1);
+
+    DeviceState state;
+    REQUIRE(pipeline.load(make_guid(7), state));
+    REQUIRE(state.axis[6] == 32767);
+    REQUIRE(state.button.test(4));
+    REQUIRE(state.hat[2] == 0);
+
+    device.disconnect();
+    REQUIRE(source.process(pipeline, k_timeout));
+    REQUIRE(pipeline.device_count() == 0);
+}
@@ -0,0 +1,86 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <vector>
+
+#include "event_coalescing.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    std::vector<LONG> values(std::vector<JoystickInputEventEx> const& events)
+    {
+        std::vector<LONG> result;
+        for(auto const& evt : events)
+        {
+            result.push_back(evt.data.value);
+        }
+        return result;
+    }
+}
+
+
+TEST_CASE("only the last value of an axis is kept", "[event_coalescing]")
+{
+    std::vector<JoystickInputEventEx> events = {
+        make_event(1, JoystickInputType::Axis, 1, 10, 0, 1),
+        make_event(1, JoystickInputType::Axis, 2, 20, 0, 2),
+        make_event(1, JoystickInputType::Axis, 1, 11, 0, 3),
+        make_event(1, JoystickInputType::Axis, 1, 12, 0, 4),
+        make_event(1, JoystickInputType::Axis, 3, 30, 0, 5)
+    };
+
+    const auto stats = coalesce_input_events(events);
+    REQUIRE(stats.received == 5);
+    REQUIRE(stats.coalesced_axis == 2);
+    REQUIRE(stats.coalesced_hat == 0);
+    // Survivors keep their relative order and timing.
+    REQUIRE(values(events) == std::vector<LONG>{20, 12, 30});
+    REQUIRE(events[1].source_sequence == 4);
+}
+
+TEST_CASE("button transitions are never coalesced", "[event_coalescing]")
+{
+    std::vector<JoystickInputEventEx> events = {
+        make_event(1, JoystickInputType::Button, 1, 1),
+        make_event(1, JoystickInputType::Hat, 1, 9000),
+        make_event(1, JoystickInputType::Button, 1, 0),
+        make_event(1, JoystickInputType::Hat, 1, 18000),
+        make_event(1, JoystickInputType::Hat, 2, 0),
+        make_event(1, JoystickInputType::Button, 1, 1),
+        make_event(1, JoystickInputType::Hat, 1, -1)
+    };
+
+    const auto stats = coalesce_input_events(events);
+    REQUIRE(stats.coalesced_axis == 0);
+    REQUIRE(stats.coalesced_hat == 2);
+    REQUIRE(values(events) == std::vector<LONG>{1, 0, 0, 1, -1});
+}
+
+TEST_CASE("axes and hats with equal indices are distinct", "[event_coalescing]")
+{
+    std::vector<JoystickInputEventEx> events = {
+        make_event(1, JoystickInputType::Axis, 1, 1),
+        make_event(1, JoystickInputType::Hat, 1, 2),
+        make_event(1, JoystickInputType::Axis, 1, 3),
+        make_event(1, JoystickInputType::Hat, 1, 4)
+    };
+    coalesce_input_events(events);
+    REQUIRE(values(events) == std::vector<LONG>{3, 4});
+}
+
+TEST_CASE("events of other devices are kept", "[event_coalescing]")
+{
+    std::vector<JoystickInputEventEx> events = {
+        make_event(1, JoystickInputType::Axis, 1, 1),
+        make_event(2, JoystickInputType::Axis, 1, 2),
+        make_event(2, JoystickInputType::Axis, 1, 3),
+        make_event(1, JoystickInputType::Axis, 1, 4)
+    };
+    const auto stats = coalesce_input_events(events);
+    REQUIRE(stats.coalesced_axis == 1);
+    REQUIRE(values(events) == std::vector<LONG>{2, 3, 4});
+
+    std::vector<JoystickInputEventEx> empty;
+    REQUIRE(coalesce_input_events(empty).received == 0);
+}
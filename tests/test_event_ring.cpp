@@ -0,0 +1,218 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "event_ring.h"
+
+
+namespace
+{
+    struct TestEvent
+    {
+        uint32_t                        sequence;
+        int32_t                         value;
+    };
+
+    std::vector<uint32_t> drain(EventRing<TestEvent>& ring)
+    {
+        std::vector<uint32_t> result;
+        TestEvent events[16];
+        size_t count;
+        while((count = ring.pop(events, 16)) > 0)
+        {
+            for(size_t i=0; i<count; ++i)
+            {
+                result.push_back(events[i].sequence);
+            }
+        }
+        return result;
+    }
+}
+
+
+TEST_CASE("capacity is rounded up to a power of two", "[event_ring]")
+{
+    REQUIRE(EventRing<TestEvent>(0, RingOverflowPolicy::DropNewest).capacity() == 2);
+    REQUIRE(EventRing<TestEvent>(8, RingOverflowPolicy::DropNewest).capacity() == 8);
+    REQUIRE(EventRing<TestEvent>(9, RingOverflowPolicy::DropNewest).capacity() == 16);
+}
+
+TEST_CASE("capacities that cannot be rounded up are rejected", "[event_ring]")
+{
+    using Ring = EventRing<TestEvent>;
+    const size_t too_large[] = {
+        Ring::k_max_capacity + 1,
+        std::numeric_limits<size_t>::max()
+    };
+    for(size_t capacity : too_large)
+    {
+        REQUIRE_THROWS_AS(
+            Ring(capacity, RingOverflowPolicy::DropNewest),
+            std::length_error
+        );
+    }
+}
+
+TEST_CASE("events are read in the order they were pushed", "[event_ring]")
+{
+    EventRing<TestEvent> ring(8, RingOverflowPolicy::DropNewest);
+
+    // Run several laps to exercise the slot sequence wrap around.
+    uint32_t next = 0;
+    for(int lap=0; lap<5; ++lap)
+    {
+        for(uint32_t i=0; i<6; ++i)
+        {
+            REQUIRE(ring.push({next + i, 0}));
+        }
+        auto events = drain(ring);
+        REQUIRE(events.size() == 6);
+        for(uint32_t i=0; i<6; ++i)
+        {
+            REQUIRE(events[i] == next + i);
+        }
+        next += 6;
+    }
+
+    auto stats = ring.stats();
+    REQUIRE(stats.pushed == 30);
+    REQUIRE(stats.read == 30);
+    REQUIRE(stats.overflows == 0);
+}
+
+TEST_CASE("pop respects the requested maximum", "[event_ring]")
+{
+    EventRing<TestEvent> ring(8, RingOverflowPolicy::DropNewest);
+    for(uint32_t i=0; i<5; ++i)
+    {
+        ring.push({i, 0});
+    }
+
+    TestEvent events[8];
+    REQUIRE(ring.pop(events, 2) == 2);
+    REQUIRE(events[0].sequence == 0);
+    REQUIRE(events[1].sequence == 1);
+    REQUIRE(ring.pop(events, 8) == 3);
+    REQUIRE(events[0].sequence == 2);
+    REQUIRE(ring.pop(events, 8) == 0);
+}
+
+TEST_CASE("drop newest keeps the unread events", "[event_ring]")
+{
+    EventRing<TestEvent> ring(4, RingOverflowPolicy::DropNewest);
+    for(uint32_t i=0; i<4; ++i)
+    {
+        REQUIRE(ring.can_push());
+        REQUIRE(ring.push({i, 0}));
+    }
+    REQUIRE_FALSE(ring.can_push());
+    REQUIRE_FALSE(ring.push({4, 0}));
+    REQUIRE_FALSE(ring.push({5, 0}));
+
+    auto events = drain(ring);
+    REQUIRE(events == std::vector<uint32_t>{0, 1, 2, 3});
+    REQUIRE(ring.can_push());
+
+    auto stats = ring.stats();
+    REQUIRE(stats.overflows == 2);
+    REQUIRE(stats.dropped_newest == 2);
+    REQUIRE(stats.dropped_oldest == 0);
+}
+
+TEST_CASE("drop oldest keeps the most recent events", "[event_ring]")
+{
+    EventRing<TestEvent> ring(4, RingOverflowPolicy::DropOldest);
+    for(uint32_t i=0; i<6; ++i)
+    {
+        REQUIRE(ring.push({i, 0}));
+    }
+
+    auto events = drain(ring);
+    REQUIRE(events == std::vector<uint32_t>{2, 3, 4, 5});
+
+    auto stats = ring.stats();
+    REQUIRE(stats.pushed == 6);
+    REQUIRE(stats.overflows == 2);
+    REQUIRE(stats.dropped_oldest == 2);
+    REQUIRE(stats.dropped_newest == 0);
+    REQUIRE(stats.read == 4);
+}
+
+TEST_CASE(
+    "concurrent readers receive every accepted event exactly once",
+    "[event_ring]"
+)
+{
+    const uint32_t event_count = 200000;
+    const size_t reader_count = 3;
+
+    for(auto policy : {RingOverflowPolicy::DropNewest, RingOverflowPolicy::DropOldest})
+    {
+        EventRing<TestEvent> ring(64, policy);
+        std::atomic<bool> done{false};
+        std::vector<std::vector<uint32_t>> received(reader_count);
+
+        std::vector<std::thread> readers;
+        for(size_t r=0; r<reader_count; ++r)
+        {
+            readers.emplace_back([&ring, &done, &received, r]() {
+                TestEvent events[32];
+                for(;;)
+                {
+                    const bool finished = done.load();
+                    size_t count = ring.pop(events, 32);
+                    for(size_t i=0; i<count; ++i)
+                    {
+                        received[r].push_back(events[i].sequence);
+                    }
+                    if(count == 0)
+                    {
+                        if(finished)
+                        {
+                            break;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        for(uint32_t i=0; i<event_count; ++i)
+        {
+            ring.push({i, static_cast<int32_t>(i)});
+        }
+        done = true;
+        for(auto& reader : readers)
+        {
+            reader.join();
+        }
+
+        std::vector<uint8_t> seen(event_count, 0);
+        uint64_t total = 0;
+        for(auto const& events : received)
+        {
+            // Each reader observes a strictly increasing subsequence.
+            for(size_t i=1; i<events.size(); ++i)
+            {
+                REQUIRE(events[i-1] < events[i]);
+            }
+            for(auto sequence : events)
+            {
+                REQUIRE(seen[sequence] == 0);
+                seen[sequence] = 1;
+            }
+            total += events.size();
+        }
+
+        auto stats = ring.stats();
+        REQUIRE(stats.read == total);
+        REQUIRE(stats.pushed == total + stats.dropped_oldest);
+        REQUIRE(
+            total + stats.dropped_oldest + stats.dropped_newest == event_count
+        );
+    }
+}
@@ -0,0 +1,102 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "event_ring.h"
+#include "event_timing.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    // Axis event of device 1.
+    JoystickInputData make_axis(UINT8 index, LONG value)
+    {
+        return make_input(1, JoystickInputType::Axis, index, value);
+    }
+}
+
+
+TEST_CASE("the monotonic clock never goes backwards", "[event_timing]")
+{
+    uint64_t previous = monotonic_time_ns();
+    for(int i=0; i<10000; ++i)
+    {
+        const uint64_t now = monotonic_time_ns();
+        REQUIRE(now >= previous);
+        previous = now;
+    }
+}
+
+TEST_CASE("extended events carry their layout and timing", "[event_timing]")
+{
+    const auto evt = make_input_event_ex(make_axis(3, -200), 1234, 17, 99);
+
+    REQUIRE(evt.struct_size == sizeof(JoystickInputEventEx));
+    REQUIRE(evt.version == k_input_event_ex_version);
+    REQUIRE(evt.data.device_guid == make_guid(1));
+    REQUIRE(evt.data.input_type == JoystickInputType::Axis);
+    REQUIRE(evt.data.input_index == 3);
+    REQUIRE(evt.data.value == -200);
+    REQUIRE(evt.source_timestamp == 1234);
+    REQUIRE(evt.source_sequence == 17);
+    REQUIRE(evt.receive_time_ns == 99);
+}
+
+TEST_CASE("polled events share the report's receive time", "[event_timing]")
+{
+    std::vector<JoystickInputEventEx> events;
+    events.push_back(make_input_event_ex(make_axis(1, 5), 10, 1, 50));
+
+    append_polled_events({make_axis(2, 7), make_axis(4, 9)}, 80, events);
+
+    REQUIRE(events.size() == 3);
+    REQUIRE(events[0].source_sequence == 1);
+    for(size_t i=1; i<events.size(); ++i)
+    {
+        REQUIRE(events[i].struct_size == sizeof(JoystickInputEventEx));
+        REQUIRE(events[i].source_timestamp == 0);
+        REQUIRE(events[i].source_sequence == 0);
+        REQUIRE(events[i].receive_time_ns == 80);
+    }
+    REQUIRE(events[1].data.input_index == 2);
+    REQUIRE(events[2].data.value == 9);
+}
+
+TEST_CASE("legacy events keep the original payload", "[event_timing]")
+{
+    std::vector<JoystickInputEventEx> events;
+    append_polled_events({make_axis(2, 7), make_axis(4, 9)}, 80, events);
+
+    std::vector<JoystickInputData> legacy = {make_axis(8, 1)};
+    to_legacy_events(events, legacy);
+
+    REQUIRE(legacy.size() == 2);
+    for(size_t i=0; i<legacy.size(); ++i)
+    {
+        REQUIRE(std::memcmp(
+            &legacy[i],
+            &events[i].data,
+            sizeof(JoystickInputData)
+        ) == 0);
+    }
+}
+
+TEST_CASE("extended events pass through the event ring", "[event_timing]")
+{
+    EventRing<JoystickInputEventEx> ring(4, RingOverflowPolicy::DropOldest);
+    for(DWORD i=1; i<=6; ++i)
+    {
+        ring.push(make_input_event_ex(make_axis(1, i), i * 10, i, i * 100));
+    }
+
+    JoystickInputEventEx out[8];
+    REQUIRE(ring.pop(out, 8) == 4);
+    for(DWORD i=0; i<4; ++i)
+    {
+        REQUIRE(out[i].data.value == LONG(i + 3));
+        REQUIRE(out[i].source_sequence == i + 3);
+        REQUIRE(out[i].receive_time_ns == (i + 3) * 100);
+    }
+}
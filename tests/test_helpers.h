@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "dill_types.h"
+#include "event_timing.h"
+
+
+/**
+ * \brief Returns the GUID of a fake device.
+ *
+ * \param id number distinguishing the device from other fake ones
+ * \return GUID unique to id
+ */
+inline GUID make_guid(DWORD id)
+{
+    GUID guid{};
+    guid.Data1 = id;
+    guid.Data4[7] = 0x42;
+    return guid;
+}
+
+/**
+ * \brief Describes a fake device with 2 axes, 16 buttons and 1 hat.
+ *
+ * \param id number distinguishing the device, see make_guid
+ * \return description of the device
+ */
+inline DeviceSummary make_device(DWORD id)
+{
+    DeviceSummary info{};
+    info.device_guid = make_guid(id);
+    info.axis_count = 2;
+    info.button_count = 16;
+    info.hat_count = 1;
+    return info;
+}
+
+/**
+ * \brief Creates an input event of a fake device.
+ *
+ * \param id number of the device, see make_guid
+ * \param type type of the input
+ * \param index 1-based index of the input
+ * \param value new value of the input
+ * \return decoded event
+ */
+inline JoystickInputData make_input(
+    DWORD                               id,
+    JoystickInputType                   type,
+    UINT8                               index,
+    LONG                                value
+)
+{
+    JoystickInputData data;
+    data.device_guid = make_guid(id);
+    data.input_type = type;
+    data.input_index = index;
+    data.value = value;
+    return data;
+}
+
+/**
+ * \brief Creates an input event of a fake device with its timing.
+ *
+ * \param id number of the device, see make_guid
+ * \param type type of the input
+ * \param index 1-based index of the input
+ * \param value new value of the input
+ * \param source_timestamp timestamp the source reported for the event
+ * \param source_sequence sequence number the source reported for the event
+ * \param receive_time_ns time at which the event was read
+ * \return extended event
+ */
+inline JoystickInputEventEx make_event(
+    DWORD                               id,
+    JoystickInputType                   type,
+    UINT8                               index,
+    LONG                                value,
+    DWORD                               source_timestamp = 0,
+    DWORD                               source_sequence = 0,
+    uint64_t                            receive_time_ns = 0
+)
+{
+    return make_input_event_ex(
+        make_input(id, type, index, value),
+        source_timestamp,
+        source_sequence,
+        receive_time_ns
+    );
+}
+
+/**
+ * \brief Polls a condition until it holds or five seconds passed.
+ *
+ * \param done condition set by another thread
+ * \return true if the condition holds, false if the wait timed out
+ */
+template<typename Predicate>
+bool wait_until(Predicate const& done)
+{
+    const auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::seconds(5);
+    while(!done() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+}
@@ -0,0 +1,85 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "input_metrics.h"
+#include "test_helpers.h"
+
+
+TEST_CASE("device counters accumulate per slot", "[input_metrics]")
+{
+    InputMetrics metrics;
+    metrics.add(3, DeviceCounter::PollFailures);
+    metrics.add(3, DeviceCounter::ReacquireAttempts, 2);
+    metrics.add(3, DeviceCounter::EventsEmitted, 5);
+    metrics.add(3, DeviceCounter::BufferOverflows);
+    metrics.add(3, DeviceCounter::NotBufferedDemotions);
+    metrics.record_drain(3, 10);
+    metrics.record_drain(3, 4);
+
+    auto device = metrics.device(3, make_guid(7));
+    REQUIRE(device.device_guid == make_guid(7));
+    REQUIRE(device.events_decoded == 14);
+    REQUIRE(device.events_emitted == 5);
+    REQUIRE(device.buffer_overflows == 1);
+    REQUIRE(device.notbuffered_demotions == 1);
+    REQUIRE(device.poll_failures == 1);
+    REQUIRE(device.reacquire_attempts == 2);
+    REQUIRE(device.max_events_per_drain == 10);
+
+    // Other slots are unaffected and reset slots start over.
+    REQUIRE(metrics.device(4, make_guid(8)).events_decoded == 0);
+    metrics.reset(3);
+    device = metrics.device(3, make_guid(7));
+    REQUIRE(device.events_decoded == 0);
+    REQUIRE(device.max_events_per_drain == 0);
+}
+
+TEST_CASE("loop counters accumulate", "[input_metrics]")
+{
+    InputMetrics metrics;
+    metrics.add(LoopCounter::DeviceWakeups, 3);
+    metrics.add(LoopCounter::PollWakeups);
+    metrics.add(LoopCounter::RebuildWakeups);
+    metrics.add(LoopCounter::HotplugWakeups);
+    metrics.add(LoopCounter::MessageWakeups, 2);
+    metrics.add(LoopCounter::HotplugEnumerations);
+    metrics.add(LoopCounter::WaitHandleRebuilds, 4);
+    metrics.reset(0);
+
+    const auto loop = metrics.loop();
+    REQUIRE(loop.device_wakeups == 3);
+    REQUIRE(loop.poll_wakeups == 1);
+    REQUIRE(loop.rebuild_wakeups == 1);
+    REQUIRE(loop.hotplug_wakeups == 1);
+    REQUIRE(loop.message_wakeups == 2);
+    REQUIRE(loop.hotplug_enumerations == 1);
+    REQUIRE(loop.wait_handle_rebuilds == 4);
+    REQUIRE(loop.callback_invocations == 0);
+}
+
+TEST_CASE("snapshots never see counters decrease", "[input_metrics]")
+{
+    InputMetrics metrics;
+    std::atomic<bool> done{false};
+    std::thread writer([&metrics, &done]() {
+        for(int i=0; i<100000; ++i)
+        {
+            metrics.record_drain(0, 1);
+            metrics.add(LoopCounter::DeviceWakeups);
+        }
+        done = true;
+    });
+
+    uint64_t last = 0;
+    while(!done)
+    {
+        const auto decoded = metrics.device(0, make_guid(1)).events_decoded;
+        REQUIRE(decoded >= last);
+        last = decoded;
+    }
+    writer.join();
+    REQUIRE(metrics.device(0, make_guid(1)).events_decoded == 100000);
+    REQUIRE(metrics.loop().device_wakeups == 100000);
+}
@@ -0,0 +1,504 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "event_timing.h"
+#include "input_loop.h"
+#include "input_pipeline.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    // Callbacks are plain function pointers, so they record into globals.
+    std::vector<JoystickInputData> g_events;
+    std::vector<size_t> g_batch_sizes;
+    std::vector<DeviceActionType> g_device_actions;
+
+    void reset_recording()
+    {
+        g_events.clear();
+        g_batch_sizes.clear();
+        g_device_actions.clear();
+    }
+
+    void record_event(JoystickInputData evt)
+    {
+        g_events.push_back(evt);
+    }
+
+    void record_batch(JoystickInputData const* events, size_t count)
+    {
+        g_batch_sizes.push_back(count);
+        g_events.insert(g_events.end(), events, events + count);
+    }
+
+    void record_event_ex(JoystickInputEventEx const* events, size_t count)
+    {
+        g_batch_sizes.push_back(count);
+        for(size_t i=0; i<count; ++i)
+        {
+            g_events.push_back(events[i].data);
+        }
+    }
+
+    void record_device_change(DeviceSummary, DeviceActionType action)
+    {
+        g_device_actions.push_back(action);
+    }
+
+    // Source replaying a fixed script, one step per process() call.
+    class ScriptedSource : public InputSource
+    {
+    public:
+        std::vector<std::vector<JoystickInputEventEx>> batches;
+        std::atomic<size_t> processed{0};
+
+        bool process(InputSink& sink, std::chrono::milliseconds timeout) override
+        {
+            if(processed == 0)
+            {
+                sink.device_added(make_device(1));
+            }
+            if(processed < batches.size())
+            {
+                sink.input_events(make_guid(1), batches[processed]);
+                ++processed;
+                return true;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait_for(lock, timeout, [this] { return m_woken; });
+            m_woken = false;
+            return true;
+        }
+
+        void wake() override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_woken = true;
+            m_condition.notify_one();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_woken = false;
+    };
+
+    // Source failing on every process() call.
+    class FailingSource : public InputSource
+    {
+    public:
+        std::atomic<size_t> processed{0};
+
+        bool process(InputSink&, std::chrono::milliseconds) override
+        {
+            ++processed;
+            return false;
+        }
+
+        void wake() override
+        {
+        }
+    };
+}
+
+
+TEST_CASE("devices are tracked between addition and removal", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    pipeline.set_device_change_callback(&record_device_change);
+
+    REQUIRE(pipeline.device_added(make_device(1)));
+    REQUIRE(pipeline.device_added(make_device(2)));
+    REQUIRE(pipeline.device_count() == 2);
+
+    DeviceSummary info;
+    REQUIRE(pipeline.device_information(make_guid(2), info));
+    REQUIRE(info.button_count == 16);
+
+    // A second device with a tracked GUID is rejected, so its input
+    // cannot mix with the tracked device's.
+    REQUIRE_FALSE(pipeline.device_added(make_device(1)));
+    REQUIRE(pipeline.device_count() == 2);
+
+    pipeline.device_removed(make_guid(1));
+    pipeline.device_removed(make_guid(3));
+    REQUIRE(pipeline.device_count() == 1);
+    REQUIRE_FALSE(pipeline.device_information(make_guid(1), info));
+
+    DeviceState state;
+    REQUIRE_FALSE(pipeline.load(make_guid(1), state));
+    REQUIRE(pipeline.load(make_guid(2), state));
+
+    REQUIRE(g_device_actions == std::vector<DeviceActionType>{
+        DeviceActionType::Connected,
+        DeviceActionType::Connected,
+        DeviceActionType::Disconnected
+    });
+}
+
+TEST_CASE("devices beyond the slot limit are rejected", "[input_pipeline]")
+{
+    InputPipeline pipeline;
+    for(DWORD i=0; i<k_max_devices; ++i)
+    {
+        REQUIRE(pipeline.device_added(make_device(i + 1)));
+    }
+    REQUIRE_FALSE(pipeline.device_added(make_device(k_max_devices + 1)));
+    REQUIRE(pipeline.device_count() == k_max_devices);
+}
+
+TEST_CASE("input events update the state and reach the client", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    pipeline.device_added(make_device(1));
+    pipeline.dispatcher().set_event_callback(&record_event);
+
+    const std::vector<JoystickInputEventEx> events = {
+        make_event(1, JoystickInputType::Axis, 2, 1234),
+        make_event(1, JoystickInputType::Button, 16, 1),
+        make_event(1, JoystickInputType::Hat, 1, 9000)
+    };
+    pipeline.input_events(make_guid(1), events);
+
+    DeviceState state;
+    REQUIRE(pipeline.load(make_guid(1), state));
+    REQUIRE(state.axis[2] == 1234);
+    REQUIRE(state.button.test(16));
+    REQUIRE(state.hat[1] == 9000);
+
+    DillDeviceSnapshot snapshot;
+    REQUIRE(pipeline.snapshot(make_guid(1), snapshot));
+    REQUIRE(snapshot.axis[2] == 1234);
+
+    REQUIRE(g_events.size() == 3);
+    REQUIRE(g_events[1].input_type == JoystickInputType::Button);
+    REQUIRE(g_events[2].value == 9000);
+
+    // Events of unknown devices are dropped.
+    pipeline.input_events(make_guid(2), events);
+    REQUIRE(g_events.size() == 3);
+}
+
+TEST_CASE("the most specific callback receives the events", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    pipeline.device_added(make_device(1));
+    auto& dispatcher = pipeline.dispatcher();
+    dispatcher.set_event_callback(&record_event);
+    dispatcher.set_batch_callback(&record_batch);
+    dispatcher.set_event_ex_callback(&record_event_ex);
+
+    const std::vector<JoystickInputEventEx> events = {
+        make_event(1, JoystickInputType::Axis, 1, 1),
+        make_event(1, JoystickInputType::Axis, 1, 2)
+    };
+    pipeline.input_events(make_guid(1), events);
+    REQUIRE(g_batch_sizes == std::vector<size_t>{2});
+
+    dispatcher.set_event_ex_callback(nullptr);
+    pipeline.input_events(make_guid(1), events);
+    REQUIRE(g_batch_sizes == std::vector<size_t>{2, 2});
+
+    dispatcher.set_batch_callback(nullptr);
+    pipeline.input_events(make_guid(1), events);
+    REQUIRE(g_batch_sizes == std::vector<size_t>{2, 2});
+    REQUIRE(g_events.size() == 6);
+}
+
+TEST_CASE("the event ring receives events in addition to callbacks", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    pipeline.device_added(make_device(1));
+    auto& dispatcher = pipeline.dispatcher();
+    dispatcher.set_event_callback(&record_event);
+    dispatcher.configure_ring(2, RingOverflowPolicy::DropOldest);
+
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 1),
+        make_event(1, JoystickInputType::Axis, 1, 2),
+        make_event(1, JoystickInputType::Axis, 1, 3)
+    });
+    REQUIRE(g_events.size() == 3);
+    REQUIRE(dispatcher.ring_stats().dropped_oldest == 1);
+
+    JoystickInputData out[4];
+    REQUIRE(dispatcher.read_events(out, 4) == 2);
+    REQUIRE(out[0].value == 2);
+    REQUIRE(out[1].value == 3);
+
+    // A capacity that cannot be rounded up keeps the current ring.
+    REQUIRE_THROWS_AS(
+        dispatcher.configure_ring(
+            std::numeric_limits<size_t>::max(),
+            RingOverflowPolicy::DropOldest
+        ),
+        std::length_error
+    );
+    REQUIRE(dispatcher.ring_capacity() == 2);
+
+    dispatcher.configure_ring(0, RingOverflowPolicy::DropOldest);
+    REQUIRE(dispatcher.ring_capacity() == 0);
+    REQUIRE(dispatcher.read_events(out, 4) == 0);
+}
+
+TEST_CASE("coalescing thins out delivered events only", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    pipeline.device_added(make_device(1));
+    auto& dispatcher = pipeline.dispatcher();
+    dispatcher.set_batch_callback(&record_batch);
+    dispatcher.configure_ring(16, RingOverflowPolicy::DropOldest);
+    dispatcher.set_coalescing(true);
+
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 1),
+        make_event(1, JoystickInputType::Button, 2, 1),
+        make_event(1, JoystickInputType::Axis, 1, 2),
+        make_event(1, JoystickInputType::Button, 2, 0),
+        make_event(1, JoystickInputType::Axis, 1, 3)
+    });
+    REQUIRE(g_batch_sizes == std::vector<size_t>{3});
+    REQUIRE(g_events.back().value == 3);
+    REQUIRE(dispatcher.ring_stats().pushed == 3);
+
+    const auto stats = dispatcher.coalescing_stats();
+    REQUIRE(stats.received == 5);
+    REQUIRE(stats.coalesced_axis == 2);
+
+    DeviceState state;
+    REQUIRE(pipeline.load(make_guid(1), state));
+    REQUIRE(state.axis[1] == 3);
+    REQUIRE_FALSE(state.button.test(2));
+
+    dispatcher.set_coalescing(false);
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 4),
+        make_event(1, JoystickInputType::Axis, 1, 5)
+    });
+    REQUIRE(g_batch_sizes == std::vector<size_t>{3, 2});
+    REQUIRE(dispatcher.coalescing_stats().received == 5);
+}
+
+TEST_CASE("axis filters suppress events but not state", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    pipeline.device_added(make_device(1));
+    pipeline.dispatcher().set_batch_callback(&record_batch);
+
+    REQUIRE_FALSE(pipeline.set_axis_filter(make_guid(2), 1, {10, 0, 0}));
+    REQUIRE_FALSE(pipeline.set_axis_filter(make_guid(1), 0, {10, 0, 0}));
+    REQUIRE(pipeline.set_axis_filter(make_guid(1), 1, {10, 0, 0}));
+
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 5),
+        make_event(1, JoystickInputType::Axis, 2, 5)
+    });
+    REQUIRE(g_batch_sizes == std::vector<size_t>{1});
+    REQUIRE(g_events.back().input_index == 2);
+
+    // A batch without any reported event does not invoke the callback.
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 8)
+    });
+    REQUIRE(g_batch_sizes.size() == 1);
+
+    DeviceState state;
+    REQUIRE(pipeline.load(make_guid(1), state));
+    REQUIRE(state.axis[1] == 8);
+
+    // Reconnecting clears the filter.
+    pipeline.device_removed(make_guid(1));
+    pipeline.device_added(make_device(1));
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 1)
+    });
+    REQUIRE(g_batch_sizes == std::vector<size_t>{1, 1});
+}
+
+TEST_CASE("subscriptions limit delivery but not state", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    pipeline.device_added(make_device(1));
+    pipeline.dispatcher().set_batch_callback(&record_batch);
+
+    // Button 2 only, axes and hats keep their subscription.
+    const uint64_t buttons[2] = {0x2, 0};
+    REQUIRE_FALSE(pipeline.set_subscription(
+        make_guid(2), k_subscribe_buttons, buttons
+    ));
+    REQUIRE_FALSE(pipeline.set_subscription(make_guid(1), 0, buttons));
+    REQUIRE(pipeline.set_subscription(
+        make_guid(1), k_subscribe_buttons, buttons
+    ));
+
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Button, 1, 1),
+        make_event(1, JoystickInputType::Button, 2, 1),
+        make_event(1, JoystickInputType::Axis, 1, 100)
+    });
+    REQUIRE(g_batch_sizes == std::vector<size_t>{2});
+    REQUIRE(g_events[0].input_index == 2);
+    REQUIRE(g_events[1].input_type == JoystickInputType::Axis);
+
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Button, 3, 1)
+    });
+    REQUIRE(g_batch_sizes.size() == 1);
+
+    DeviceState state;
+    REQUIRE(pipeline.load(make_guid(1), state));
+    REQUIRE(state.button.test(1));
+    REQUIRE(state.button.test(3));
+
+    DeviceMetrics metrics;
+    REQUIRE_FALSE(pipeline.device_metrics(make_guid(2), metrics));
+    REQUIRE(pipeline.device_metrics(make_guid(1), metrics));
+    REQUIRE(metrics.events_decoded == 4);
+    REQUIRE(metrics.events_emitted == 2);
+    REQUIRE(metrics.max_events_per_drain == 3);
+    REQUIRE(pipeline.dispatcher().callback_stats().invocations == 1);
+}
+
+TEST_CASE("a dispatch thread keeps device changes in order", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    auto& dispatcher = pipeline.dispatcher();
+    pipeline.set_device_change_callback(&record_device_change);
+    dispatcher.set_batch_callback(&record_batch);
+    dispatcher.configure_thread(64, DispatchPolicy::Block);
+    dispatcher.start();
+
+    pipeline.device_added(make_device(1));
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Button, 1, 1),
+        make_event(1, JoystickInputType::Button, 1, 0)
+    });
+    pipeline.device_removed(make_guid(1));
+    dispatcher.stop();
+
+    // Callbacks ran on the dispatch thread, stop() waited for all of them.
+    REQUIRE(g_device_actions == std::vector<DeviceActionType>{
+        DeviceActionType::Connected,
+        DeviceActionType::Disconnected
+    });
+    REQUIRE(g_batch_sizes == std::vector<size_t>{2});
+
+    const auto stats = dispatcher.queue_stats();
+    REQUIRE(stats.capacity == 64);
+    REQUIRE(stats.delivered == 2);
+    REQUIRE(stats.device_changes == 2);
+    REQUIRE(stats.depth == 0);
+
+    // Without a running thread delivery is immediate again.
+    pipeline.device_added(make_device(1));
+    REQUIRE(g_device_actions.size() == 3);
+}
+
+TEST_CASE("the input loop runs a source until stopped", "[input_pipeline]")
+{
+    InputPipeline pipeline;
+    ScriptedSource source;
+    for(LONG value=1; value<=10; ++value)
+    {
+        source.batches.push_back(
+            {make_event(1, JoystickInputType::Axis, 3, value)}
+        );
+    }
+
+    InputLoop loop(source, pipeline);
+    loop.start();
+    REQUIRE(loop.is_running());
+
+    const auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::seconds(5);
+    while(source.processed < source.batches.size() &&
+          std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    loop.stop();
+    REQUIRE_FALSE(loop.is_running());
+
+    DeviceState state;
+    REQUIRE(pipeline.load(make_guid(1), state));
+    REQUIRE(state.axis[3] == 10);
+}
+
+TEST_CASE("the input loop restarts after its source failed", "[input_pipeline]")
+{
+    InputPipeline pipeline;
+    FailingSource source;
+    InputLoop loop(source, pipeline);
+
+    loop.start();
+    REQUIRE(wait_until([&] { return !loop.is_running(); }));
+    REQUIRE(source.processed == 1);
+
+    loop.start();
+    REQUIRE(wait_until([&] { return source.processed == 2; }));
+    REQUIRE(wait_until([&] { return !loop.is_running(); }));
+    loop.stop();
+}
+
+TEST_CASE("callback latency is tracked per device", "[input_pipeline]")
+{
+    reset_recording();
+    InputPipeline pipeline;
+    auto& dispatcher = pipeline.dispatcher();
+    pipeline.device_added(make_device(1));
+    pipeline.device_added(make_device(2));
+    dispatcher.set_batch_callback(&record_batch);
+
+    // Events without a receive time are delivered but not measured.
+    pipeline.input_events(make_guid(1), {
+        make_event(1, JoystickInputType::Axis, 1, 1)
+    });
+    REQUIRE(dispatcher.callback_latency(LatencyStage::CallbackExit).count
+        == 0);
+
+    auto evt = make_event(1, JoystickInputType::Axis, 1, 2);
+    evt.receive_time_ns = monotonic_time_ns();
+    pipeline.input_events(make_guid(1), {evt, evt});
+    evt.data.device_guid = make_guid(2);
+    pipeline.input_events(make_guid(2), {evt});
+    evt.data.device_guid = make_guid(1);
+    pipeline.input_events(make_guid(1), {evt});
+
+    auto entry = dispatcher.callback_latency(LatencyStage::CallbackEntry);
+    auto exit = dispatcher.callback_latency(LatencyStage::CallbackExit);
+    REQUIRE(entry.count == 3);
+    REQUIRE(exit.count == 3);
+    REQUIRE(exit.max_ns >= entry.max_ns);
+    REQUIRE(dispatcher.callback_latency(LatencyStage::Decode).count == 0);
+
+    LatencySummary device;
+    REQUIRE(dispatcher.device_latency(make_guid(1), device));
+    REQUIRE(device.count == 2);
+    REQUIRE(dispatcher.device_latency(make_guid(2), device));
+    REQUIRE(device.count == 1);
+    REQUIRE_FALSE(dispatcher.device_latency(make_guid(3), device));
+
+    pipeline.device_removed(make_guid(2));
+    REQUIRE_FALSE(dispatcher.device_latency(make_guid(2), device));
+    pipeline.device_added(make_device(2));
+    REQUIRE(dispatcher.device_latency(make_guid(2), device));
+    REQUIRE(device.count == 0);
+}
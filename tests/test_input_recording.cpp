@@ -0,0 +1,539 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "axis_mapping.h"
+#include "input_pipeline.h"
+#include "input_recording.h"
+#include "synthetic_source.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    using std::chrono::milliseconds;
+
+    // Device with every description field set, so the recording has to
+    // carry all of them.
+    // Device with axes beyond the eight of the compatibility view.
+    DeviceSummaryEx make_recorded_device(DWORD id)
+    {
+        DeviceSummary info = make_device(id);
+        info.vendor_id = 0x044F;
+        info.product_id = 0xB10A;
+        info.joystick_id = id;
+        info.axis_count = 3;
+        info.button_count = 128;
+        info.hat_count = 4;
+        info.axis_map[0] = {1, 1};
+        info.axis_map[1] = {2, 2};
+        info.axis_map[2] = {3, 6};
+        snprintf(info.name, MAX_PATH, "Recorded device %u", id);
+
+        DeviceSummaryEx info_ex = extend_device_summary(info);
+        info_ex.axis_map[3] = {4, 12};
+        info_ex.axis_map[4] = {5, k_max_axes};
+        info_ex.axis_count = 5;
+        return info_ex;
+    }
+
+    void require_same_event(
+        JoystickInputEventEx const&     lhs,
+        JoystickInputEventEx const&     rhs
+    )
+    {
+        REQUIRE(lhs.data.device_guid == rhs.data.device_guid);
+        REQUIRE(lhs.data.input_type == rhs.data.input_type);
+        REQUIRE(lhs.data.input_index == rhs.data.input_index);
+        REQUIRE(lhs.data.value == rhs.data.value);
+        REQUIRE(lhs.source_timestamp == rhs.source_timestamp);
+        REQUIRE(lhs.source_sequence == rhs.source_sequence);
+        REQUIRE(lhs.receive_time_ns == rhs.receive_time_ns);
+    }
+
+    std::vector<uint8_t> read_file(std::string const& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        );
+    }
+
+    std::string temp_path(std::string const& name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // Events delivered to the client, compared against the recording.
+    std::vector<JoystickInputEventEx> g_delivered;
+
+    void record_delivered(JoystickInputEventEx const* events, size_t count)
+    {
+        g_delivered.insert(g_delivered.end(), events, events + count);
+    }
+}
+
+
+TEST_CASE("records survive encoding and decoding", "[input_recording]")
+{
+    const uint64_t base = 1000000000ULL;
+    std::vector<JoystickInputEventEx> events = {
+        make_event(1, JoystickInputType::Axis, 1, 32767, 10, 1, base + 500),
+        make_event(1, JoystickInputType::Axis, 1, -32768, 12, 2, base + 500),
+        make_event(1, JoystickInputType::Button, 128, 1, 0xFFFFFFF0, 3, base + 900),
+        // The tick count wraps around and the receive time goes backwards.
+        make_event(1, JoystickInputType::Button, 128, 0, 5, 4, base + 100),
+        make_event(1, JoystickInputType::Hat, 4, 27000, 6, 0, base + 200000),
+        make_event(
+            1,
+            JoystickInputType::Axis,
+            k_max_axes,
+            std::numeric_limits<LONG>::min(),
+            7,
+            0xFFFFFFFF,
+            base + 300000
+        )
+    };
+
+    RecordingEncoder encoder;
+    std::vector<uint8_t> data;
+    encoder.header(base, data);
+    encoder.device_added(base + 10, make_recorded_device(1), data);
+    for(auto const& evt : events)
+    {
+        REQUIRE(encoder.input(evt, data));
+    }
+    // Nor can inputs the device state has no room for.
+    REQUIRE_FALSE(encoder.input(
+        make_event(1, JoystickInputType::Hat, 5, 0, 0, 0, base),
+        data
+    ));
+    encoder.gap(base + 400000, 17, data);
+    encoder.device_removed(base + 500000, make_guid(1), data);
+    // Events of disconnected devices cannot be encoded.
+    REQUIRE_FALSE(encoder.input(events[0], data));
+
+    encoder.end(data);
+
+    RecordingReader reader(data.data(), data.size());
+    REQUIRE(reader.valid());
+    REQUIRE(reader.base_time_ns() == base);
+
+    RecordingEntry entry;
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.type == RecordType::DeviceAdded);
+    REQUIRE(entry.time_ns == base + 10);
+    REQUIRE(entry.device_id == 0);
+    auto const& info = reader.device(entry.device_id);
+    REQUIRE(info.device_guid == make_guid(1));
+    REQUIRE(info.vendor_id == 0x044F);
+    REQUIRE(info.product_id == 0xB10A);
+    REQUIRE(info.button_count == 128);
+    REQUIRE(info.axis_map[2].axis_index == 6);
+    REQUIRE(std::string(info.name) == "Recorded device 1");
+    auto const& info_ex = reader.device_ex(entry.device_id);
+    REQUIRE(info_ex.axis_count == 5);
+    REQUIRE(info_ex.axis_map[2].axis_index == 6);
+    REQUIRE(info_ex.axis_map[3].linear_index == 4);
+    REQUIRE(info_ex.axis_map[3].axis_index == 12);
+    REQUIRE(info_ex.axis_map[4].axis_index == k_max_axes);
+
+    for(auto const& evt : events)
+    {
+        REQUIRE(reader.next(entry));
+        REQUIRE(entry.type == RecordType::Input);
+        REQUIRE(entry.time_ns == evt.receive_time_ns);
+        require_same_event(entry.event, evt);
+    }
+
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.type == RecordType::Gap);
+    REQUIRE(entry.lost == 17);
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.type == RecordType::DeviceRemoved);
+    REQUIRE(entry.device_guid == make_guid(1));
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.type == RecordType::End);
+    REQUIRE_FALSE(reader.next(entry));
+    REQUIRE(reader.complete());
+    REQUIRE_FALSE(reader.failed());
+
+    reader.rewind();
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.type == RecordType::DeviceAdded);
+}
+
+TEST_CASE("small changes take few bytes", "[input_recording]")
+{
+    RecordingEncoder encoder;
+    std::vector<uint8_t> data;
+    encoder.header(0, data);
+    encoder.device_added(0, make_recorded_device(1), data);
+
+    const size_t before = data.size();
+    for(DWORD i=1; i<=100; ++i)
+    {
+        REQUIRE(encoder.input(
+            make_event(1, JoystickInputType::Axis, 1, i * 10, i, i, i * 1000),
+            data
+        ));
+    }
+    // Tag, time, device, input, value, timestamp and sequence.
+    REQUIRE(data.size() - before <= 100 * 8);
+}
+
+TEST_CASE("truncated recordings are read up to the cut", "[input_recording]")
+{
+    RecordingEncoder encoder;
+    std::vector<uint8_t> data;
+    encoder.header(0, data);
+    encoder.device_added(0, make_recorded_device(1), data);
+    encoder.input(
+        make_event(1, JoystickInputType::Axis, 2, 1000, 0, 0, 5),
+        data
+    );
+    const size_t complete_size = data.size();
+    encoder.input(
+        make_event(1, JoystickInputType::Axis, 2, 900000, 0, 0, 6),
+        data
+    );
+
+    RecordingReader reader(data.data(), data.size() - 1);
+    RecordingEntry entry;
+    REQUIRE(reader.next(entry));
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.event.data.value == 1000);
+    REQUIRE_FALSE(reader.next(entry));
+    REQUIRE(reader.failed());
+    REQUIRE_FALSE(reader.complete());
+
+    RecordingReader exact(data.data(), complete_size);
+    REQUIRE(exact.next(entry));
+    REQUIRE(exact.next(entry));
+    REQUIRE_FALSE(exact.next(entry));
+    REQUIRE_FALSE(exact.failed());
+    REQUIRE_FALSE(exact.complete());
+
+    data[0] = 'X';
+    RecordingReader invalid(data.data(), data.size());
+    REQUIRE_FALSE(invalid.valid());
+    REQUIRE_FALSE(invalid.next(entry));
+}
+
+TEST_CASE("malformed records are rejected", "[input_recording]")
+{
+    const auto rejected = [](std::vector<uint8_t> const& data)
+    {
+        RecordingReader reader(data.data(), data.size());
+        RecordingEntry entry;
+        while(reader.next(entry))
+        {
+        }
+        return reader.failed();
+    };
+    const auto recording = [](RecordingEncoder& encoder)
+    {
+        std::vector<uint8_t> data;
+        encoder.header(0, data);
+        encoder.device_added(0, make_recorded_device(1), data);
+        return data;
+    };
+
+    SECTION("input indices outside the device state")
+    {
+        // Encodes an input of device 1 and rewrites its index. Tag, time,
+        // device, input, value, timestamp and sequence take a byte each,
+        // the input is the varint of index << 2 | type.
+        const auto with_input = [&](JoystickInputType type, uint32_t index)
+        {
+            RecordingEncoder encoder;
+            auto data = recording(encoder);
+            encoder.input(make_event(1, type, 1, 1, 0, 0, 0), data);
+            const uint32_t key = index << 2 | static_cast<uint32_t>(type);
+            data.erase(data.end() - 4);
+            if(key >= 0x80)
+            {
+                data.insert(data.end() - 3, uint8_t(key >> 7));
+                data.insert(data.end() - 4, uint8_t(key | 0x80));
+            }
+            else
+            {
+                data.insert(data.end() - 3, uint8_t(key));
+            }
+            return data;
+        };
+
+        REQUIRE_FALSE(rejected(
+            with_input(JoystickInputType::Axis, k_max_axes)
+        ));
+        REQUIRE_FALSE(rejected(with_input(JoystickInputType::Button, 128)));
+        REQUIRE(rejected(with_input(JoystickInputType::Axis, 0)));
+        REQUIRE(rejected(
+            with_input(JoystickInputType::Axis, k_max_axes + 1)
+        ));
+        REQUIRE(rejected(with_input(JoystickInputType::Button, 0)));
+        REQUIRE(rejected(with_input(JoystickInputType::Button, 129)));
+        REQUIRE(rejected(with_input(JoystickInputType::Hat, 0)));
+        REQUIRE(rejected(with_input(JoystickInputType::Hat, 5)));
+    }
+
+    SECTION("values outside the range of LONG")
+    {
+        RecordingEncoder encoder;
+        auto data = recording(encoder);
+        const auto max = std::numeric_limits<LONG>::max();
+        encoder.input(
+            make_event(1, JoystickInputType::Axis, 1, max, 0, 0, 0),
+            data
+        );
+        REQUIRE_FALSE(rejected(data));
+
+        // Repeating the record adds the maximum to itself.
+        const auto record = std::vector<uint8_t>(data.end() - 11, data.end());
+        REQUIRE(record[0] == static_cast<uint8_t>(RecordType::Input));
+        data.insert(data.end(), record.begin(), record.end());
+        REQUIRE(rejected(data));
+    }
+
+    SECTION("deltas that overflow when added")
+    {
+        RecordingEncoder encoder;
+        auto data = recording(encoder);
+        encoder.input(
+            make_event(1, JoystickInputType::Axis, 1, 1, 0, 0, 0),
+            data
+        );
+        // Tag, time, device, input, value, timestamp and sequence, the
+        // value delta of 1 is the zigzag encoded byte 2.
+        REQUIRE(data[data.size() - 3] == 2);
+        const uint8_t largest[] = {
+            0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01
+        };
+        data.erase(data.end() - 3);
+        data.insert(data.end() - 2, std::begin(largest), std::end(largest));
+        REQUIRE(rejected(data));
+    }
+
+    SECTION("records of removed devices")
+    {
+        RecordingEncoder encoder;
+        auto data = recording(encoder);
+        encoder.input(
+            make_event(1, JoystickInputType::Button, 1, 1, 0, 0, 0),
+            data
+        );
+        const auto input = std::vector<uint8_t>(data.end() - 7, data.end());
+        REQUIRE(input[0] == static_cast<uint8_t>(RecordType::Input));
+        const size_t before = data.size();
+        encoder.device_removed(0, make_guid(1), data);
+        const auto removed = std::vector<uint8_t>(
+            data.begin() + before,
+            data.end()
+        );
+        REQUIRE_FALSE(rejected(data));
+
+        auto late_input = data;
+        late_input.insert(late_input.end(), input.begin(), input.end());
+        REQUIRE(rejected(late_input));
+
+        auto removed_twice = data;
+        removed_twice.insert(
+            removed_twice.end(),
+            removed.begin(),
+            removed.end()
+        );
+        REQUIRE(rejected(removed_twice));
+    }
+}
+
+TEST_CASE("a recorded session replays the delivered events", "[input_recording]")
+{
+    const auto path = temp_path("dill_test_recording.bin");
+    g_delivered.clear();
+
+    SyntheticConfig config;
+    config.device_count = 2;
+    config.events_per_second = 1000.0;
+    config.batch_size = 10;
+    config.pattern = SyntheticPattern::Random;
+    SyntheticSource source(config);
+
+    InputPipeline pipeline;
+    pipeline.dispatcher().set_event_ex_callback(&record_delivered);
+    // Connect one device before recording starts.
+    pipeline.device_added_ex(make_recorded_device(7));
+    REQUIRE(pipeline.start_recording(path));
+    REQUIRE_FALSE(pipeline.start_recording(path));
+
+    for(int ms=0; ms<=500; ms+=50)
+    {
+        source.advance(pipeline, milliseconds(ms));
+    }
+    pipeline.device_removed(SyntheticSource::device_guid(1));
+    pipeline.stop_recording();
+
+    const auto stats = pipeline.recording_stats();
+    REQUIRE(stats.dropped == 0);
+    REQUIRE(stats.recorded == g_delivered.size() + 3);
+
+    const auto data = read_file(path);
+    std::filesystem::remove(path);
+    REQUIRE(stats.bytes_written == data.size());
+    REQUIRE(data.size() < g_delivered.size() * sizeof(JoystickInputEventEx) / 3);
+
+    RecordingReader reader(data.data(), data.size());
+    REQUIRE(reader.valid());
+    std::vector<GUID> added;
+    std::vector<GUID> removed;
+    std::vector<JoystickInputEventEx> replayed;
+    RecordingEntry entry;
+    while(reader.next(entry))
+    {
+        switch(entry.type)
+        {
+            case RecordType::DeviceAdded:
+                added.push_back(reader.device(entry.device_id).device_guid);
+                break;
+            case RecordType::DeviceRemoved:
+                removed.push_back(entry.device_guid);
+                break;
+            case RecordType::Input:
+                replayed.push_back(entry.event);
+                break;
+            default:
+                break;
+        }
+    }
+    REQUIRE(reader.complete());
+    REQUIRE_FALSE(reader.failed());
+
+    REQUIRE(added == std::vector<GUID>{
+        make_guid(7),
+        SyntheticSource::device_guid(0),
+        SyntheticSource::device_guid(1)
+    });
+    REQUIRE(removed == std::vector<GUID>{SyntheticSource::device_guid(1)});
+    REQUIRE(replayed.size() == g_delivered.size());
+    for(size_t i=0; i<replayed.size(); ++i)
+    {
+        require_same_event(replayed[i], g_delivered[i]);
+    }
+}
+
+TEST_CASE("records the writer cannot keep up with are noted", "[input_recording]")
+{
+    const auto path = temp_path("dill_test_recording_gap.bin");
+
+    InputRecorder recorder(8);
+    REQUIRE(recorder.open(path));
+    recorder.start({make_recorded_device(1)});
+    REQUIRE(recorder.is_recording());
+
+    std::vector<JoystickInputEventEx> events;
+    for(LONG i=0; i<1000; ++i)
+    {
+        events.push_back(
+            make_event(1, JoystickInputType::Axis, 1, i, 0, 0, i)
+        );
+    }
+    recorder.input_events(events);
+    recorder.close();
+    REQUIRE_FALSE(recorder.is_recording());
+    // Recording stopped, events are ignored.
+    recorder.input_events(events);
+
+    const auto stats = recorder.stats();
+    REQUIRE(stats.recorded + stats.dropped == events.size());
+
+    const auto data = read_file(path);
+    std::filesystem::remove(path);
+    RecordingReader reader(data.data(), data.size());
+    uint64_t inputs = 0;
+    uint64_t lost = 0;
+    RecordingEntry entry;
+    while(reader.next(entry))
+    {
+        if(entry.type == RecordType::Input)
+        {
+            ++inputs;
+        }
+        else if(entry.type == RecordType::Gap)
+        {
+            lost += entry.lost;
+        }
+    }
+    REQUIRE(reader.complete());
+    REQUIRE(inputs == stats.recorded);
+    REQUIRE(lost == stats.dropped);
+    REQUIRE(inputs + lost == events.size());
+}
+
+TEST_CASE("dropped device connections keep the recording consistent", "[input_recording]")
+{
+    const auto path = temp_path("dill_test_recording_devices.bin");
+
+    InputRecorder recorder(8);
+    REQUIRE(recorder.open(path));
+    recorder.start({});
+
+    // Far more connections than the writer drains at once.
+    for(DWORD id=1; id<=1000; ++id)
+    {
+        recorder.device_added(make_recorded_device(id));
+        recorder.input_events(
+            {make_event(id, JoystickInputType::Button, 1, 1, 0, 0, id)}
+        );
+    }
+    std::this_thread::sleep_for(milliseconds(50));
+    recorder.device_added(make_recorded_device(2000));
+    recorder.input_events(
+        {make_event(2000, JoystickInputType::Axis, 1, 7, 0, 0, 2000)}
+    );
+    recorder.close();
+
+    const auto stats = recorder.stats();
+    REQUIRE(stats.dropped > 0);
+
+    const auto data = read_file(path);
+    std::filesystem::remove(path);
+    RecordingReader reader(data.data(), data.size());
+    uint64_t added = 0;
+    uint64_t inputs = 0;
+    uint64_t lost = 0;
+    GUID last_added{};
+    LONG last_value = 0;
+    RecordingEntry entry;
+    while(reader.next(entry))
+    {
+        if(entry.type == RecordType::DeviceAdded)
+        {
+            last_added = reader.device(entry.device_id).device_guid;
+            ++added;
+        }
+        else if(entry.type == RecordType::Input)
+        {
+            // Every input follows the connection of its own device.
+            REQUIRE(entry.event.data.device_guid == last_added);
+            last_value = entry.event.data.value;
+            ++inputs;
+        }
+        else if(entry.type == RecordType::Gap)
+        {
+            lost += entry.lost;
+        }
+    }
+    REQUIRE(reader.complete());
+    REQUIRE(last_added == make_guid(2000));
+    REQUIRE(last_value == 7);
+    REQUIRE(lost == stats.dropped);
+    REQUIRE(added + inputs + stats.rejected == stats.recorded);
+}
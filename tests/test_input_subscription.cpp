@@ -0,0 +1,117 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <vector>
+
+#include "event_timing.h"
+#include "input_subscription.h"
+
+
+namespace
+{
+    JoystickInputData make_data(
+        JoystickInputType               type,
+        UINT8                           index
+    )
+    {
+        JoystickInputData data;
+        data.input_type = type;
+        data.input_index = index;
+        data.value = 1;
+        return data;
+    }
+}
+
+
+TEST_CASE("every input is subscribed initially", "[input_subscription]")
+{
+    InputSubscription subscription;
+    REQUIRE(subscription.all());
+    REQUIRE(subscription.subscribed(make_data(JoystickInputType::Axis, 8)));
+    REQUIRE(subscription.subscribed(
+        make_data(JoystickInputType::Button, 128)
+    ));
+    REQUIRE(subscription.subscribed(make_data(JoystickInputType::Hat, 4)));
+}
+
+TEST_CASE("subscriptions select inputs per type", "[input_subscription]")
+{
+    InputSubscription subscription;
+
+    // Buttons 1, 3 and 65.
+    const uint64_t buttons[2] = {0x5, 0x1};
+    REQUIRE(subscription.set(k_subscribe_buttons, buttons));
+    REQUIRE_FALSE(subscription.all());
+    REQUIRE(subscription.subscribed(make_data(JoystickInputType::Button, 1)));
+    REQUIRE_FALSE(subscription.subscribed(
+        make_data(JoystickInputType::Button, 2)
+    ));
+    REQUIRE(subscription.subscribed(make_data(JoystickInputType::Button, 3)));
+    REQUIRE(subscription.subscribed(
+        make_data(JoystickInputType::Button, 65)
+    ));
+    REQUIRE_FALSE(subscription.subscribed(
+        make_data(JoystickInputType::Button, 128)
+    ));
+
+    // Other types keep their subscription.
+    REQUIRE(subscription.subscribed(make_data(JoystickInputType::Axis, 2)));
+
+    const uint64_t none[2] = {0, 0};
+    REQUIRE(subscription.set(k_subscribe_axes | k_subscribe_hats, none));
+    REQUIRE_FALSE(subscription.subscribed(
+        make_data(JoystickInputType::Axis, 2)
+    ));
+    REQUIRE_FALSE(subscription.subscribed(
+        make_data(JoystickInputType::Hat, 1)
+    ));
+    REQUIRE(subscription.subscribed(make_data(JoystickInputType::Button, 1)));
+
+    // Without an index bitset every input of the types is selected.
+    REQUIRE(subscription.set(
+        k_subscribe_axes | k_subscribe_buttons | k_subscribe_hats,
+        nullptr
+    ));
+    REQUIRE(subscription.all());
+}
+
+TEST_CASE("invalid type masks are rejected", "[input_subscription]")
+{
+    InputSubscription subscription;
+    const uint64_t none[2] = {0, 0};
+    REQUIRE_FALSE(subscription.set(0, none));
+    REQUIRE_FALSE(subscription.set(0x8, none));
+    REQUIRE_FALSE(subscription.set(k_subscribe_axes | 0x10, none));
+    REQUIRE(subscription.all());
+}
+
+TEST_CASE("filtering removes unsubscribed events", "[input_subscription]")
+{
+    std::vector<JoystickInputEventEx> events;
+    for(UINT8 index=1; index<=4; ++index)
+    {
+        events.push_back(make_input_event_ex(
+            make_data(JoystickInputType::Axis, index), 0, index, 0
+        ));
+        events.push_back(make_input_event_ex(
+            make_data(JoystickInputType::Button, index), 0, index, 0
+        ));
+    }
+
+    InputSubscription subscription;
+    REQUIRE(subscription.filter(events) == 0);
+    REQUIRE(events.size() == 8);
+
+    // Axes 2 and 4, no buttons.
+    const uint64_t axes[2] = {0xA, 0};
+    const uint64_t none[2] = {0, 0};
+    subscription.set(k_subscribe_axes, axes);
+    subscription.set(k_subscribe_buttons, none);
+    REQUIRE(subscription.filter(events) == 6);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].data.input_index == 2);
+    REQUIRE(events[1].data.input_index == 4);
+    REQUIRE(events[1].source_sequence == 4);
+
+    subscription.reset();
+    REQUIRE(subscription.all());
+}
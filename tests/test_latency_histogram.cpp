@@ -0,0 +1,124 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "latency_histogram.h"
+
+
+TEST_CASE("small values have exact buckets", "[latency_histogram]")
+{
+    for(uint64_t value=0; value<32; ++value)
+    {
+        const auto index = LatencyHistogram::bucket_index(value);
+        REQUIRE(index == value);
+        REQUIRE(LatencyHistogram::bucket_upper_bound(index) == value);
+    }
+}
+
+TEST_CASE("bucket bounds limit the relative error", "[latency_histogram]")
+{
+    const uint64_t max = LatencyHistogram::k_max_value;
+    size_t previous = 0;
+    for(uint64_t value=1; value<max; value=value*3/2+1)
+    {
+        const auto index = LatencyHistogram::bucket_index(value);
+        const auto upper = LatencyHistogram::bucket_upper_bound(index);
+        REQUIRE(index >= previous);
+        REQUIRE(index < LatencyHistogram::k_bucket_count);
+        REQUIRE(upper >= value);
+        REQUIRE(upper - value <= value / 16);
+        REQUIRE(LatencyHistogram::bucket_index(upper) == index);
+        REQUIRE(LatencyHistogram::bucket_index(upper + 1) == index + 1);
+        previous = index;
+    }
+
+    const auto last = LatencyHistogram::k_bucket_count - 1;
+    REQUIRE(LatencyHistogram::bucket_index(LatencyHistogram::k_max_value)
+        == last);
+    REQUIRE(LatencyHistogram::bucket_upper_bound(last)
+        == LatencyHistogram::k_max_value);
+}
+
+TEST_CASE("summaries report percentiles", "[latency_histogram]")
+{
+    LatencyHistogram histogram;
+    REQUIRE(histogram.summary().count == 0);
+    REQUIRE(histogram.summary().max_ns == 0);
+
+    for(uint64_t value=1; value<=1000; ++value)
+    {
+        histogram.record(value * 1000);
+    }
+    const auto summary = histogram.summary();
+    REQUIRE(summary.count == 1000);
+    REQUIRE(histogram.count() == 1000);
+    REQUIRE(summary.min_ns == 1000);
+    REQUIRE(summary.max_ns == 1000000);
+    REQUIRE(summary.mean_ns == 500500);
+    REQUIRE(summary.p50_ns >= 500000);
+    REQUIRE(summary.p50_ns <= 500000 + 500000 / 16);
+    REQUIRE(summary.p90_ns >= 900000);
+    REQUIRE(summary.p90_ns <= 900000 + 900000 / 16);
+    REQUIRE(summary.p99_ns >= 990000);
+    REQUIRE(summary.p99_ns <= summary.max_ns);
+    REQUIRE(summary.p999_ns == summary.max_ns);
+}
+
+TEST_CASE("large values are clamped to the last bucket", "[latency_histogram]")
+{
+    LatencyHistogram histogram;
+    histogram.record(uint64_t(1) << 40);
+    histogram.record(UINT64_MAX);
+
+    const auto summary = histogram.summary();
+    REQUIRE(summary.count == 2);
+    REQUIRE(summary.max_ns == UINT64_MAX);
+    REQUIRE(summary.p50_ns == LatencyHistogram::k_max_value);
+}
+
+TEST_CASE("reset removes all values", "[latency_histogram]")
+{
+    LatencyHistogram histogram;
+    histogram.record(100);
+    histogram.record(5);
+    histogram.reset();
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.summary().count == 0);
+
+    histogram.record(42);
+    const auto summary = histogram.summary();
+    REQUIRE(summary.count == 1);
+    REQUIRE(summary.min_ns == 42);
+    REQUIRE(summary.max_ns == 42);
+    REQUIRE(summary.p50_ns == 42);
+}
+
+TEST_CASE("summaries can be read while recording", "[latency_histogram]")
+{
+    LatencyHistogram histogram;
+    std::atomic<bool> done{false};
+    std::thread writer([&histogram, &done] {
+        for(uint64_t i=0; i<200000; ++i)
+        {
+            histogram.record(1000 + i % 5000);
+        }
+        done = true;
+    });
+
+    while(!done)
+    {
+        const auto summary = histogram.summary();
+        if(summary.count > 0)
+        {
+            REQUIRE(summary.p50_ns <= summary.p99_ns);
+            REQUIRE(summary.p99_ns <= summary.p999_ns);
+        }
+    }
+    writer.join();
+
+    const auto summary = histogram.summary();
+    REQUIRE(summary.count == 200000);
+    REQUIRE(summary.min_ns == 1000);
+    REQUIRE(summary.max_ns == 5999);
+}
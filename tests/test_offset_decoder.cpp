@@ -0,0 +1,95 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include "axis_mapping.h"
+#include "offset_decoder.h"
+
+
+// The table is built at compile time.
+static_assert(
+    decode_offset(8).input_type == JoystickInputType::Axis &&
+    decode_offset(8).input_index == 3,
+    "lZ decodes to axis 3"
+);
+static_assert(
+    decode_offset(sizeof(DIJOYSTATE2)).input_type == JoystickInputType{},
+    "offsets past the report are unrecognized"
+);
+
+
+TEST_CASE("every axis offset decodes to its axis_index", "[offset_decoder]")
+{
+    const DWORD summary_offsets[k_summary_axes] = {
+        DIJOFS_X, DIJOFS_Y, DIJOFS_Z, DIJOFS_RX,
+        DIJOFS_RY, DIJOFS_RZ, DIJOFS_SLIDER(0), DIJOFS_SLIDER(1)
+    };
+    for(size_t i=0; i<k_summary_axes; ++i)
+    {
+        REQUIRE(k_axis_offsets[i] == summary_offsets[i]);
+    }
+
+    // The velocity, acceleration and force groups follow in report order.
+    REQUIRE(k_axis_offsets[8] == FIELD_OFFSET(DIJOYSTATE2, lVX));
+    REQUIRE(k_axis_offsets[15]
+        == FIELD_OFFSET(DIJOYSTATE2, rglVSlider[1]));
+    REQUIRE(k_axis_offsets[16] == FIELD_OFFSET(DIJOYSTATE2, lAX));
+    REQUIRE(k_axis_offsets[24] == FIELD_OFFSET(DIJOYSTATE2, lFX));
+    REQUIRE(k_axis_offsets[31]
+        == FIELD_OFFSET(DIJOYSTATE2, rglFSlider[1]));
+
+    for(size_t i=0; i<k_axis_offsets.size(); ++i)
+    {
+        const auto decoded = decode_offset(k_axis_offsets[i]);
+        REQUIRE(decoded.input_type == JoystickInputType::Axis);
+        REQUIRE(decoded.input_index == i + 1);
+        REQUIRE(axis_index_for_offset(k_axis_offsets[i]) == i + 1);
+        REQUIRE(offset_for_axis_index(decoded.input_index)
+            == k_axis_offsets[i]);
+    }
+}
+
+TEST_CASE("every hat offset decodes to its hat", "[offset_decoder]")
+{
+    for(DWORD i=0; i<4; ++i)
+    {
+        const auto decoded = decode_offset(DIJOFS_POV(i));
+        REQUIRE(decoded.input_type == JoystickInputType::Hat);
+        REQUIRE(decoded.input_index == i + 1);
+        REQUIRE(axis_index_for_offset(DIJOFS_POV(i)) == (DWORD)-1);
+    }
+}
+
+TEST_CASE("every button offset decodes to its button", "[offset_decoder]")
+{
+    for(DWORD i=0; i<128; ++i)
+    {
+        const auto decoded = decode_offset(DIJOFS_BUTTON(i));
+        REQUIRE(decoded.input_type == JoystickInputType::Button);
+        REQUIRE(decoded.input_index == i + 1);
+    }
+}
+
+TEST_CASE("other offsets are unrecognized", "[offset_decoder]")
+{
+    size_t recognized = 0;
+    for(DWORD offset=0; offset<sizeof(DIJOYSTATE2); ++offset)
+    {
+        const auto decoded = decode_offset(offset);
+        if(decoded.input_type == JoystickInputType{})
+        {
+            REQUIRE(decoded.input_index == 0);
+        }
+        else
+        {
+            ++recognized;
+        }
+    }
+    REQUIRE(recognized == k_max_axes + 4 + 128);
+
+    // Bytes inside a LONG or DWORD member do not start an input.
+    REQUIRE(decode_offset(DIJOFS_X + 1).input_type == JoystickInputType{});
+    REQUIRE(decode_offset(DIJOFS_POV(0) + 2).input_type
+        == JoystickInputType{});
+    REQUIRE(decode_offset(FIELD_OFFSET(DIJOYSTATE2, lFRz) + 3).input_type
+        == JoystickInputType{});
+    REQUIRE(decode_offset(0xDEADBEEF).input_type == JoystickInputType{});
+}
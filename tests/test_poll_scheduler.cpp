@@ -0,0 +1,252 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "poll_scheduler.h"
+
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+
+namespace
+{
+    // A device that reports a change whenever the given function says so.
+    struct FakeDevice
+    {
+        SlotRef                         ref;
+        microseconds                    min_interval;
+        std::function<bool(microseconds)> changed_at;
+        uint64_t                        polls = 0;
+    };
+
+    // Runs the scheduler the way the event loop does, sleeping until the
+    // next device is due in whole milliseconds, and returns the number of
+    // wakeups.
+    uint64_t simulate(
+        std::vector<FakeDevice>&        devices,
+        microseconds                    duration
+    )
+    {
+        PollScheduler scheduler;
+        std::vector<PolledDevice> polled;
+        for(auto const& device : devices)
+        {
+            polled.push_back({device.ref, device.min_interval});
+        }
+
+        microseconds now(0);
+        scheduler.sync(polled, now);
+
+        uint64_t wakeups = 0;
+        std::vector<SlotRef> due;
+        while(now < duration)
+        {
+            ++wakeups;
+            scheduler.due(now, due);
+            for(auto const& ref : due)
+            {
+                for(auto& device : devices)
+                {
+                    if(device.ref == ref)
+                    {
+                        ++device.polls;
+                        scheduler.record(ref, device.changed_at(now), now);
+                    }
+                }
+            }
+
+            const auto wait = scheduler.time_until_next(now);
+            const auto wait_ms = (wait.count() + 999) / 1000;
+            now += milliseconds(wait_ms > 0 ? wait_ms : 1);
+        }
+        return wakeups;
+    }
+
+    bool never(microseconds)
+    {
+        return false;
+    }
+}
+
+
+TEST_CASE("idle devices back off to the maximum interval", "[poll_scheduler]")
+{
+    PollScheduler scheduler;
+    const SlotRef ref{0, 1};
+    scheduler.sync({{ref, microseconds(0)}}, microseconds(0));
+    REQUIRE(scheduler.interval(ref) == PollScheduler::k_min_interval);
+
+    std::vector<microseconds> intervals;
+    microseconds now(0);
+    for(int i=0; i<40; ++i)
+    {
+        scheduler.record(ref, false, now);
+        intervals.push_back(scheduler.interval(ref));
+        now += scheduler.interval(ref);
+    }
+
+    const auto steps = PollScheduler::k_idle_polls_per_step;
+    REQUIRE(intervals[steps - 2] == milliseconds(1));
+    REQUIRE(intervals[steps - 1] == milliseconds(2));
+    REQUIRE(intervals[2 * steps - 1] == milliseconds(4));
+    REQUIRE(intervals[3 * steps - 1] == milliseconds(8));
+    REQUIRE(intervals[4 * steps - 1] == milliseconds(16));
+    REQUIRE(intervals.back() == PollScheduler::k_max_interval);
+}
+
+TEST_CASE("a change snaps back to full rate", "[poll_scheduler]")
+{
+    PollScheduler scheduler;
+    const SlotRef ref{3, 2};
+    scheduler.sync({{ref, microseconds(0)}}, microseconds(0));
+
+    microseconds now(0);
+    for(int i=0; i<40; ++i)
+    {
+        scheduler.record(ref, false, now);
+        now += scheduler.interval(ref);
+    }
+    REQUIRE(scheduler.interval(ref) == PollScheduler::k_max_interval);
+
+    scheduler.record(ref, true, now);
+    REQUIRE(scheduler.interval(ref) == PollScheduler::k_min_interval);
+    REQUIRE(scheduler.time_until_next(now) == PollScheduler::k_min_interval);
+}
+
+TEST_CASE("devices are due according to their interval", "[poll_scheduler]")
+{
+    PollScheduler scheduler;
+    REQUIRE(scheduler.empty());
+    REQUIRE(scheduler.time_until_next(microseconds(0)) == microseconds::max());
+
+    const SlotRef first{0, 1};
+    const SlotRef second{1, 1};
+    scheduler.sync(
+        {{first, microseconds(0)}, {second, milliseconds(5)}},
+        microseconds(0)
+    );
+
+    std::vector<SlotRef> due;
+    scheduler.due(microseconds(0), due);
+    REQUIRE(due.size() == 2);
+    REQUIRE(scheduler.time_until_next(microseconds(0)) == microseconds(0));
+
+    scheduler.record(first, true, microseconds(0));
+    scheduler.record(second, true, microseconds(0));
+    scheduler.due(microseconds(500), due);
+    REQUIRE(due.empty());
+    REQUIRE(scheduler.time_until_next(microseconds(500)) == microseconds(500));
+
+    scheduler.due(milliseconds(1), due);
+    REQUIRE(due.size() == 1);
+    REQUIRE(due[0] == first);
+    scheduler.due(milliseconds(5), due);
+    REQUIRE(due.size() == 2);
+}
+
+TEST_CASE("the maximum rate of a device is honoured", "[poll_scheduler]")
+{
+    PollScheduler scheduler;
+    const SlotRef fast{0, 1};
+    const SlotRef slow{1, 1};
+    const SlotRef very_slow{2, 1};
+    scheduler.sync(
+        {
+            {fast, microseconds(10)},
+            {slow, milliseconds(4)},
+            {very_slow, milliseconds(50)}
+        },
+        microseconds(0)
+    );
+
+    REQUIRE(scheduler.interval(fast) == PollScheduler::k_min_interval);
+    scheduler.record(slow, true, microseconds(0));
+    REQUIRE(scheduler.interval(slow) == milliseconds(4));
+
+    microseconds now(0);
+    for(int i=0; i<40; ++i)
+    {
+        scheduler.record(slow, false, now);
+        scheduler.record(very_slow, false, now);
+        now += milliseconds(1);
+    }
+    REQUIRE(scheduler.interval(slow) == PollScheduler::k_max_interval);
+    REQUIRE(scheduler.interval(very_slow) == milliseconds(50));
+}
+
+TEST_CASE("sync keeps known devices and drops stale ones", "[poll_scheduler]")
+{
+    PollScheduler scheduler;
+    const SlotRef kept{0, 1};
+    const SlotRef dropped{1, 1};
+    scheduler.sync(
+        {{kept, microseconds(0)}, {dropped, microseconds(0)}},
+        microseconds(0)
+    );
+    for(int i=0; i<10; ++i)
+    {
+        scheduler.record(kept, false, milliseconds(10 + i));
+    }
+    const auto interval = scheduler.interval(kept);
+    REQUIRE(interval > PollScheduler::k_min_interval);
+
+    // The slot of the dropped device was reused by another device.
+    const SlotRef reused{1, 2};
+    scheduler.sync(
+        {{kept, microseconds(0)}, {reused, microseconds(0)}},
+        milliseconds(20)
+    );
+    REQUIRE(scheduler.interval(kept) == interval);
+    REQUIRE(scheduler.interval(dropped) == microseconds(0));
+    REQUIRE(scheduler.interval(reused) == PollScheduler::k_min_interval);
+
+    std::vector<SlotRef> due;
+    scheduler.due(milliseconds(20), due);
+    REQUIRE(due == std::vector<SlotRef>{reused});
+
+    scheduler.sync({}, milliseconds(21));
+    REQUIRE(scheduler.empty());
+}
+
+TEST_CASE("idle devices cause far fewer wakeups", "[poll_scheduler]")
+{
+    const microseconds duration = std::chrono::seconds(10);
+    const uint64_t fixed_rate_wakeups = duration / milliseconds(1);
+
+    SECTION("a single untouched device")
+    {
+        std::vector<FakeDevice> devices = {{{0, 1}, microseconds(0), never}};
+        const auto wakeups = simulate(devices, duration);
+
+        INFO(
+            "idle device: " << wakeups << " wakeups instead of " <<
+            fixed_rate_wakeups
+        );
+        REQUIRE(wakeups * 15 < fixed_rate_wakeups);
+    }
+
+    SECTION("an idle device next to one used one second in five")
+    {
+        // Moving constantly while in use, untouched otherwise.
+        auto in_use = [](microseconds now) {
+            return now % std::chrono::seconds(5) < std::chrono::seconds(1);
+        };
+        std::vector<FakeDevice> devices = {
+            {{0, 1}, microseconds(0), never},
+            {{1, 1}, microseconds(0), in_use}
+        };
+        const auto wakeups = simulate(devices, duration);
+
+        INFO(
+            "idle and intermittent device: " << wakeups <<
+            " wakeups instead of " << fixed_rate_wakeups
+        );
+        REQUIRE(wakeups * 3 < fixed_rate_wakeups);
+
+        // The used device is polled at full rate while in use.
+        REQUIRE(devices[1].polls >= 2 * 1000);
+    }
+}
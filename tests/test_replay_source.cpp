@@ -0,0 +1,270 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "axis_mapping.h"
+#include "event_timing.h"
+#include "input_loop.h"
+#include "input_pipeline.h"
+#include "input_recording.h"
+#include "replay_source.h"
+#include "synthetic_source.h"
+#include "test_helpers.h"
+
+
+namespace
+{
+    using std::chrono::milliseconds;
+    using std::chrono::nanoseconds;
+
+    const uint64_t k_ms = 1000000;
+
+    std::string temp_path(std::string const& name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void write_file(std::string const& path, std::vector<uint8_t> const& data)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<char const*>(data.data()), data.size());
+    }
+
+    // Two devices, device 1 reporting two wakeups and device 2 one before
+    // disconnecting, spread across 100ms.
+    std::vector<uint8_t> make_recording()
+    {
+        RecordingEncoder encoder;
+        std::vector<uint8_t> data;
+        encoder.header(0, data);
+        encoder.device_added(0, extend_device_summary(make_device(1)), data);
+        encoder.device_added(0, extend_device_summary(make_device(2)), data);
+        const std::vector<JoystickInputEventEx> events = {
+            make_event(1, JoystickInputType::Axis, 1, 100, 0, 0, 10 * k_ms),
+            make_event(1, JoystickInputType::Button, 3, 1, 0, 0, 10 * k_ms),
+            make_event(2, JoystickInputType::Hat, 1, 9000, 0, 0, 10 * k_ms),
+            make_event(1, JoystickInputType::Axis, 1, 200, 0, 0, 50 * k_ms)
+        };
+        for(auto const& evt : events)
+        {
+            encoder.input(evt, data);
+        }
+        encoder.device_removed(100 * k_ms, make_guid(2), data);
+        encoder.end(data);
+        return data;
+    }
+
+    // Records the sink calls as a readable trace.
+    struct TraceSink : public InputSink
+    {
+        std::vector<std::string> calls;
+        std::vector<JoystickInputEventEx> events;
+
+        bool device_added(DeviceSummary const& info) override
+        {
+            calls.push_back("added " + std::to_string(info.device_guid.Data1));
+            return true;
+        }
+
+        void device_removed(GUID const& guid) override
+        {
+            calls.push_back("removed " + std::to_string(guid.Data1));
+        }
+
+        void input_events(
+            GUID const&                 guid,
+            std::vector<JoystickInputEventEx> const& batch
+        ) override
+        {
+            calls.push_back(
+                "events " + std::to_string(guid.Data1) + " " +
+                std::to_string(batch.size())
+            );
+            events.insert(events.end(), batch.begin(), batch.end());
+        }
+    };
+
+    std::vector<JoystickInputEventEx> g_delivered;
+
+    void record_delivered(JoystickInputEventEx const* events, size_t count)
+    {
+        g_delivered.insert(g_delivered.end(), events, events + count);
+    }
+}
+
+
+TEST_CASE("records are replayed once due", "[replay_source]")
+{
+    const auto path = temp_path("dill_test_replay.bin");
+    write_file(path, make_recording());
+
+    ReplayConfig config;
+    config.restamp = false;
+    ReplaySource source(path, config);
+    TraceSink sink;
+
+    REQUIRE(source.advance(sink, nanoseconds(0)) == 2);
+    REQUIRE(sink.calls == std::vector<std::string>{"added 1", "added 2"});
+
+    REQUIRE(source.advance(sink, milliseconds(10)) == 3);
+    REQUIRE(source.advance(sink, milliseconds(49)) == 0);
+    REQUIRE(source.advance(sink, milliseconds(99)) == 1);
+    REQUIRE_FALSE(source.finished());
+    REQUIRE(source.advance(sink, milliseconds(100)) == 2);
+    REQUIRE(source.finished());
+    REQUIRE_FALSE(source.truncated());
+    REQUIRE(source.replayed() == 4);
+
+    // Events of one device and wakeup form one batch.
+    REQUIRE(sink.calls == std::vector<std::string>{
+        "added 1", "added 2", "events 1 2", "events 2 1", "events 1 1",
+        "removed 2"
+    });
+    REQUIRE(sink.events[3].data.value == 200);
+    REQUIRE(sink.events[3].receive_time_ns == 50 * k_ms);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("accelerated replay scales the recorded delays", "[replay_source]")
+{
+    const auto path = temp_path("dill_test_replay_accelerated.bin");
+    write_file(path, make_recording());
+
+    ReplayConfig config;
+    config.mode = ReplayMode::Accelerated;
+    config.speed = 100.0;
+    ReplaySource source(path, config);
+    TraceSink sink;
+
+    source.advance(sink, nanoseconds(0));
+    REQUIRE(source.advance(sink, std::chrono::microseconds(100)) == 3);
+    REQUIRE(source.advance(sink, std::chrono::microseconds(999)) == 1);
+    REQUIRE(source.advance(sink, milliseconds(1)) == 2);
+    REQUIRE(source.finished());
+
+    // Restamped events carry the time of their replay.
+    const uint64_t now = monotonic_time_ns();
+    for(auto const& evt : sink.events)
+    {
+        REQUIRE(evt.receive_time_ns <= now);
+        REQUIRE(evt.receive_time_ns > 50 * k_ms);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("replays stop at a cut short record", "[replay_source]")
+{
+    const auto path = temp_path("dill_test_replay_truncated.bin");
+    auto data = make_recording();
+    data.resize(data.size() - 3);
+    write_file(path, data);
+
+    ReplaySource source(path, ReplayConfig{});
+    TraceSink sink;
+    source.advance(sink, milliseconds(1000));
+    REQUIRE(source.finished());
+    REQUIRE(source.truncated());
+    // The cut falls into the disconnection of device 2.
+    REQUIRE(source.replayed() == 4);
+    REQUIRE(sink.calls.back() == "events 1 1");
+
+    write_file(path, {'n', 'o', 't', ' ', 'a', ' ', 'r', 'e', 'c'});
+    REQUIRE_THROWS_AS(ReplaySource(path, ReplayConfig{}), std::runtime_error);
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(ReplaySource(path, ReplayConfig{}), std::system_error);
+}
+
+TEST_CASE("a replayed session reproduces the recorded one", "[replay_source]")
+{
+    const auto path = temp_path("dill_test_replay_session.bin");
+
+    SyntheticConfig synthetic;
+    synthetic.device_count = 3;
+    synthetic.events_per_second = 2000.0;
+    synthetic.batch_size = 16;
+    synthetic.pattern = SyntheticPattern::Random;
+    SyntheticSource live_source(synthetic);
+
+    InputPipeline live;
+    live.dispatcher().set_event_ex_callback(&record_delivered);
+    g_delivered.clear();
+    REQUIRE(live.start_recording(path));
+    for(int ms=0; ms<=1000; ms+=20)
+    {
+        live_source.advance(live, milliseconds(ms));
+    }
+    live.stop_recording();
+    const auto recorded = g_delivered;
+    REQUIRE(recorded.size() == live_source.generated());
+
+    ReplayConfig config;
+    config.mode = ReplayMode::AsFastAsPossible;
+    config.restamp = false;
+    ReplaySource replay_source(path, config);
+    InputPipeline replayed;
+    replayed.dispatcher().set_event_ex_callback(&record_delivered);
+    g_delivered.clear();
+
+    // The loop ends by itself once the recording is exhausted.
+    InputLoop loop(replay_source, replayed);
+    loop.start();
+    const auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::seconds(5);
+    while(loop.is_running() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    REQUIRE_FALSE(loop.is_running());
+    loop.stop();
+    std::filesystem::remove(path);
+
+    REQUIRE(replay_source.replayed() == recorded.size());
+    REQUIRE(g_delivered.size() == recorded.size());
+    for(size_t i=0; i<recorded.size(); ++i)
+    {
+        REQUIRE(g_delivered[i].data.device_guid == recorded[i].data.device_guid);
+        REQUIRE(g_delivered[i].data.input_type == recorded[i].data.input_type);
+        REQUIRE(g_delivered[i].data.input_index == recorded[i].data.input_index);
+        REQUIRE(g_delivered[i].data.value == recorded[i].data.value);
+        REQUIRE(g_delivered[i].source_sequence == recorded[i].source_sequence);
+        REQUIRE(g_delivered[i].receive_time_ns == recorded[i].receive_time_ns);
+    }
+
+    REQUIRE(replayed.device_count() == 3);
+    for(size_t i=0; i<3; ++i)
+    {
+        const auto guid = SyntheticSource::device_guid(i);
+        DillDeviceSnapshot expected;
+        DillDeviceSnapshot actual;
+        REQUIRE(live.snapshot(guid, expected));
+        REQUIRE(replayed.snapshot(guid, actual));
+        REQUIRE(memcmp(expected.axis, actual.axis, sizeof(expected.axis)) == 0);
+        REQUIRE(memcmp(expected.hat, actual.hat, sizeof(expected.hat)) == 0);
+        REQUIRE(memcmp(
+            expected.button_mask,
+            actual.button_mask,
+            sizeof(expected.button_mask)
+        ) == 0);
+
+        DeviceSummaryEx expected_info;
+        DeviceSummaryEx actual_info;
+        REQUIRE(live.device_information_ex(guid, expected_info));
+        REQUIRE(replayed.device_information_ex(guid, actual_info));
+        REQUIRE(expected_info.axis_count == actual_info.axis_count);
+        REQUIRE(memcmp(
+            expected_info.axis_map,
+            actual_info.axis_map,
+            sizeof(AxisMap) * expected_info.axis_count
+        ) == 0);
+    }
+}
@@ -0,0 +1,95 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "seqlock.h"
+
+
+namespace
+{
+    // Odd size to exercise the padding of the last word.
+    struct Payload
+    {
+        int32_t                         values[7];
+        uint8_t                         tag;
+    };
+
+    Payload make_payload(int32_t value)
+    {
+        Payload payload;
+        for(auto& entry : payload.values)
+        {
+            entry = value;
+        }
+        payload.tag = static_cast<uint8_t>(value);
+        return payload;
+    }
+}
+
+
+TEST_CASE("default constructed value is returned initially", "[seqlock]")
+{
+    Seqlock<Payload> lock;
+    auto payload = lock.load();
+    for(auto entry : payload.values)
+    {
+        REQUIRE(entry == 0);
+    }
+    REQUIRE(lock.version() == 0);
+}
+
+TEST_CASE("stored value is returned and bumps the version", "[seqlock]")
+{
+    Seqlock<Payload> lock;
+    lock.store(make_payload(42));
+    lock.store(make_payload(-7));
+
+    auto payload = lock.load();
+    for(auto entry : payload.values)
+    {
+        REQUIRE(entry == -7);
+    }
+    REQUIRE(payload.tag == static_cast<uint8_t>(-7));
+    REQUIRE(lock.version() == 2);
+}
+
+TEST_CASE("readers never observe a torn value", "[seqlock]")
+{
+    Seqlock<Payload> lock;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn_reads{0};
+
+    std::vector<std::thread> readers;
+    for(int i=0; i<3; ++i)
+    {
+        readers.emplace_back([&lock, &done, &torn_reads]() {
+            while(!done.load())
+            {
+                auto payload = lock.load();
+                for(auto entry : payload.values)
+                {
+                    if(entry != payload.values[0] ||
+                       static_cast<uint8_t>(entry) != payload.tag)
+                    {
+                        ++torn_reads;
+                    }
+                }
+            }
+        });
+    }
+
+    for(int32_t value=1; value<=200000; ++value)
+    {
+        lock.store(make_payload(value));
+    }
+    done = true;
+    for(auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    REQUIRE(torn_reads == 0);
+    REQUIRE(lock.load().values[0] == 200000);
+}
@@ -0,0 +1,241 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <random>
+#include <vector>
+
+#include "axis_mapping.h"
+#include "state_diff.h"
+
+
+namespace
+{
+    using EqualFn = bool (*)(DIJOYSTATE2 const&, DIJOYSTATE2 const&);
+
+    // All compiled implementations, each has to agree with the scalar one.
+    std::vector<EqualFn> equal_implementations()
+    {
+        std::vector<EqualFn> result = {&joystate_equal, &joystate_equal_scalar};
+#if defined(DILL_HAS_SSE2)
+        result.push_back(&joystate_equal_sse2);
+#endif
+#if defined(DILL_HAS_AVX2)
+        result.push_back(&joystate_equal_avx2);
+#endif
+        return result;
+    }
+
+    // Device with X, Y, Rz and one slider, 12 buttons and one hat.
+    DeviceSummary make_summary()
+    {
+        DeviceSummary info;
+        info.device_guid.Data1 = 0x1234;
+        build_axis_map(
+            {DIJOFS_X, DIJOFS_Y, DIJOFS_RZ, DIJOFS_SLIDER(0)},
+            info.axis_count,
+            info.axis_map
+        );
+        info.button_count = 12;
+        info.hat_count = 1;
+        return info;
+    }
+
+    DIJOYSTATE2 make_report()
+    {
+        DIJOYSTATE2 report = {};
+        report.rgdwPOV[0] = 0xFFFFFFFF;
+        report.rgdwPOV[1] = 0xFFFFFFFF;
+        report.rgdwPOV[2] = 0xFFFFFFFF;
+        report.rgdwPOV[3] = 0xFFFFFFFF;
+        return report;
+    }
+}
+
+
+TEST_CASE("report comparison detects any differing byte", "[state_diff]")
+{
+    const auto reference = make_report();
+    for(auto equal : equal_implementations())
+    {
+        REQUIRE(equal(reference, reference));
+        for(size_t i=0; i<sizeof(DIJOYSTATE2); ++i)
+        {
+            auto changed = reference;
+            reinterpret_cast<BYTE*>(&changed)[i] ^= 0x01;
+            REQUIRE_FALSE(equal(reference, changed));
+        }
+    }
+}
+
+TEST_CASE("vectorized comparison matches the scalar one", "[state_diff]")
+{
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<size_t> byte(0, sizeof(DIJOYSTATE2) - 1);
+
+    auto lhs = make_report();
+    for(int round=0; round<1000; ++round)
+    {
+        auto rhs = lhs;
+        if(round % 2 == 0)
+        {
+            reinterpret_cast<BYTE*>(&rhs)[byte(rng)] += 1;
+        }
+        for(auto equal : equal_implementations())
+        {
+            REQUIRE(equal(lhs, rhs) == joystate_equal_scalar(lhs, rhs));
+        }
+        lhs = rhs;
+    }
+}
+
+TEST_CASE("identical reports produce no events", "[state_diff]")
+{
+    const auto info = make_summary();
+    DeviceState state;
+    std::vector<JoystickInputData> events;
+
+    diff_joystate(make_report(), info, state, events);
+    REQUIRE(events.empty());
+}
+
+TEST_CASE("changed inputs produce one event each", "[state_diff]")
+{
+    const auto info = make_summary();
+    DeviceState state;
+    std::vector<JoystickInputData> events;
+
+    auto report = make_report();
+    report.lY = 1000;
+    report.rglSlider[0] = -5;
+    report.rgbButtons[0] = 0x80;
+    report.rgbButtons[11] = 0x80;
+    report.rgdwPOV[0] = 9000;
+    diff_joystate(report, info, state, events);
+
+    REQUIRE(events.size() == 5);
+    REQUIRE(events[0].device_guid == info.device_guid);
+    REQUIRE(events[0].input_type == JoystickInputType::Axis);
+    REQUIRE(events[0].input_index == 2);
+    REQUIRE(events[0].value == 1000);
+    REQUIRE(events[1].input_type == JoystickInputType::Axis);
+    REQUIRE(events[1].input_index == 7);
+    REQUIRE(events[1].value == -5);
+    REQUIRE(events[2].input_type == JoystickInputType::Button);
+    REQUIRE(events[2].input_index == 1);
+    REQUIRE(events[2].value == 1);
+    REQUIRE(events[3].input_index == 12);
+    REQUIRE(events[4].input_type == JoystickInputType::Hat);
+    REQUIRE(events[4].input_index == 1);
+    REQUIRE(events[4].value == 9000);
+
+    REQUIRE(state.axis[2] == 1000);
+    REQUIRE(state.axis[7] == -5);
+    REQUIRE(state.button.test(12));
+    REQUIRE(state.hat[1] == 9000);
+
+    // Releasing a button and centering the hat again.
+    events.clear();
+    report.rgbButtons[0] = 0;
+    report.rgdwPOV[0] = 0xFFFFFFFF;
+    diff_joystate(report, info, state, events);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].input_index == 1);
+    REQUIRE(events[0].value == 0);
+    REQUIRE(events[1].value == -1);
+}
+
+TEST_CASE("inputs the device does not report are ignored", "[state_diff]")
+{
+    const auto info = make_summary();
+    DeviceState state;
+    std::vector<JoystickInputData> events;
+
+    auto report = make_report();
+    report.lZ = 100;
+    report.rgbButtons[12] = 0x80;
+    report.rgdwPOV[1] = 18000;
+    diff_joystate(report, info, state, events);
+
+    REQUIRE(events.empty());
+    REQUIRE(state.axis[3] == 0);
+    REQUIRE_FALSE(state.button.test(13));
+    REQUIRE(state.hat[2] == -1);
+}
+
+TEST_CASE("extended axes are diffed with the extended summary", "[state_diff]")
+{
+    DeviceSummaryEx info = extend_device_summary(make_summary());
+    build_axis_map(
+        {DIJOFS_X, FIELD_OFFSET(DIJOYSTATE2, lVX),
+         FIELD_OFFSET(DIJOYSTATE2, rglFSlider[1])},
+        info.axis_count,
+        info.axis_map
+    );
+    DeviceState state;
+    std::vector<JoystickInputData> events;
+
+    auto report = make_report();
+    report.lX = 1;
+    report.lVX = 200;
+    report.rglFSlider[1] = -300;
+    report.lAX = 400;
+
+    // The compatibility view only covers the axes 1-8.
+    diff_joystate(report, info.summary, state, events);
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].input_index == 1);
+    REQUIRE(state.axis[9] == 0);
+
+    events.clear();
+    diff_joystate(report, info, state, events);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].input_type == JoystickInputType::Axis);
+    REQUIRE(events[0].input_index == 9);
+    REQUIRE(events[0].value == 200);
+    REQUIRE(events[1].input_index == 32);
+    REQUIRE(events[1].value == -300);
+    REQUIRE(state.axis[9] == 200);
+    REQUIRE(state.axis[32] == -300);
+    REQUIRE(state.axis[17] == 0);
+}
+
+TEST_CASE("events with invalid indices leave the state alone", "[state_diff]")
+{
+    DeviceState state;
+    JoystickInputData evt{};
+    evt.value = 1;
+    for(auto type : {JoystickInputType::Axis, JoystickInputType::Button,
+                     JoystickInputType::Hat})
+    {
+        evt.input_type = type;
+        for(UINT8 index : {UINT8(0), UINT8(129), UINT8(255)})
+        {
+            evt.input_index = index;
+            apply_input_event(state, evt);
+        }
+    }
+    evt.input_type = JoystickInputType::Hat;
+    evt.input_index = 5;
+    apply_input_event(state, evt);
+
+    const DeviceState reference;
+    REQUIRE(state.axis == reference.axis);
+    REQUIRE(state.button == reference.button);
+    REQUIRE(state.hat == reference.hat);
+}
+
+TEST_CASE("report filter only passes changed reports", "[state_diff]")
+{
+    ReportFilter filter;
+    auto report = make_report();
+
+    REQUIRE(filter.changed(report));
+    REQUIRE_FALSE(filter.changed(report));
+    REQUIRE_FALSE(filter.changed(report));
+
+    report.lX = 1;
+    REQUIRE(filter.changed(report));
+    REQUIRE_FALSE(filter.changed(report));
+
+    filter.reset();
+    REQUIRE(filter.changed(report));
+}
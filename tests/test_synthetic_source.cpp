@@ -0,0 +1,240 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "input_loop.h"
+#include "input_pipeline.h"
+#include "synthetic_source.h"
+
+
+namespace
+{
+    using std::chrono::milliseconds;
+    using std::chrono::nanoseconds;
+    using std::chrono::seconds;
+
+    struct CountingSink : public InputSink
+    {
+        std::vector<DeviceSummary> added;
+        std::vector<size_t> batch_sizes;
+        std::vector<JoystickInputEventEx> events;
+        bool accept = true;
+
+        bool device_added(DeviceSummary const& info) override
+        {
+            added.push_back(info);
+            return accept;
+        }
+
+        void device_removed(GUID const&) override
+        {
+        }
+
+        void input_events(
+            GUID const&,
+            std::vector<JoystickInputEventEx> const& batch
+        ) override
+        {
+            batch_sizes.push_back(batch.size());
+            events.insert(events.end(), batch.begin(), batch.end());
+        }
+    };
+}
+
+
+TEST_CASE("synthetic devices are announced once", "[synthetic_source]")
+{
+    SyntheticConfig config;
+    config.device_count = 3;
+    config.axis_count = 4;
+    config.button_count = 200;
+    config.hat_count = 2;
+    SyntheticSource source(config);
+
+    CountingSink sink;
+    source.advance(sink, nanoseconds(0));
+    source.advance(sink, nanoseconds(0));
+
+    REQUIRE(sink.added.size() == 3);
+    std::unordered_set<GUID> guids;
+    for(size_t i=0; i<sink.added.size(); ++i)
+    {
+        auto const& info = sink.added[i];
+        REQUIRE(info.device_guid == SyntheticSource::device_guid(i));
+        REQUIRE(info.axis_count == 4);
+        REQUIRE(info.button_count == 128);
+        REQUIRE(info.hat_count == 2);
+        REQUIRE(info.axis_map[3].axis_index == 4);
+        guids.insert(info.device_guid);
+    }
+    REQUIRE(guids.size() == 3);
+}
+
+TEST_CASE("synthetic events follow the configured rate", "[synthetic_source]")
+{
+    SyntheticConfig config;
+    config.device_count = 2;
+    config.events_per_second = 1000.0;
+    config.batch_size = 8;
+    SyntheticSource source(config);
+
+    CountingSink sink;
+    REQUIRE(source.advance(sink, nanoseconds(0)) == 0);
+
+    // 20 events due per device, delivered in batches of at most 8.
+    REQUIRE(source.advance(sink, milliseconds(20)) == 40);
+    REQUIRE(sink.batch_sizes == std::vector<size_t>{8, 8, 4, 8, 8, 4});
+
+    REQUIRE(source.advance(sink, milliseconds(20)) == 0);
+    REQUIRE(source.advance(sink, std::chrono::microseconds(21500)) == 2);
+    REQUIRE(source.generated() == 42);
+
+    // Sequence numbers count the events of all devices.
+    for(size_t i=0; i<sink.events.size(); ++i)
+    {
+        REQUIRE(sink.events[i].source_sequence == i + 1);
+    }
+    REQUIRE(sink.events.back().source_timestamp == 21);
+}
+
+TEST_CASE("synthetic backlogs are bounded per call", "[synthetic_source]")
+{
+    SyntheticConfig config;
+    config.events_per_second = 1000000.0;
+    config.batch_size = 10;
+    SyntheticSource source(config);
+
+    CountingSink sink;
+    const size_t limit = SyntheticSource::k_max_batches_per_call * 10;
+    REQUIRE(source.advance(sink, seconds(1)) == limit);
+    REQUIRE(source.advance(sink, seconds(1)) == limit);
+}
+
+TEST_CASE("rejected synthetic devices generate nothing", "[synthetic_source]")
+{
+    SyntheticSource source(SyntheticConfig{});
+    CountingSink sink;
+    sink.accept = false;
+
+    REQUIRE(source.advance(sink, seconds(1)) == 0);
+    REQUIRE(sink.events.empty());
+}
+
+TEST_CASE("the sweep pattern visits every input", "[synthetic_source]")
+{
+    SyntheticConfig config;
+    config.axis_count = 3;
+    config.button_count = 2;
+    config.hat_count = 1;
+    config.events_per_second = 1000.0;
+    SyntheticSource source(config);
+
+    CountingSink sink;
+    source.advance(sink, milliseconds(12));
+    REQUIRE(sink.events.size() == 12);
+
+    for(size_t i=0; i<sink.events.size(); ++i)
+    {
+        auto const& evt = sink.events[i].data;
+        const size_t input = i % 6;
+        if(input < 3)
+        {
+            REQUIRE(evt.input_type == JoystickInputType::Axis);
+            REQUIRE(evt.input_index == input + 1);
+        }
+        else if(input < 5)
+        {
+            REQUIRE(evt.input_type == JoystickInputType::Button);
+            REQUIRE(evt.input_index == input - 2);
+            REQUIRE(evt.value == (i < 6 ? 1 : 0));
+        }
+        else
+        {
+            REQUIRE(evt.input_type == JoystickInputType::Hat);
+            REQUIRE(evt.value == (i < 6 ? 0 : 4500));
+        }
+    }
+    // Every sweep step moves the axes.
+    REQUIRE(sink.events[0].data.value != sink.events[6].data.value);
+}
+
+TEST_CASE("random and jitter patterns stay in range", "[synthetic_source]")
+{
+    for(auto pattern : {SyntheticPattern::Random, SyntheticPattern::Jitter})
+    {
+        SyntheticConfig config;
+        config.events_per_second = 0.0;
+        config.pattern = pattern;
+        config.seed = 42;
+        SyntheticSource source(config);
+
+        CountingSink sink;
+        source.advance(sink, nanoseconds(0));
+        REQUIRE(sink.events.size() ==
+            SyntheticSource::k_max_batches_per_call * config.batch_size);
+
+        std::set<int> types;
+        for(auto const& evt : sink.events)
+        {
+            auto const& data = evt.data;
+            types.insert(static_cast<int>(data.input_type));
+            switch(data.input_type)
+            {
+                case JoystickInputType::Axis:
+                    REQUIRE(data.input_index >= 1);
+                    REQUIRE(data.input_index <= 8);
+                    REQUIRE(data.value >= -32768);
+                    REQUIRE(data.value <= 32767);
+                    if(pattern == SyntheticPattern::Jitter)
+                    {
+                        REQUIRE(std::abs(data.value) <= 64);
+                    }
+                    break;
+                case JoystickInputType::Button:
+                    REQUIRE(data.input_index >= 1);
+                    REQUIRE(data.input_index <= 32);
+                    break;
+                case JoystickInputType::Hat:
+                    REQUIRE(data.input_index == 1);
+                    REQUIRE(data.value >= -1);
+                    REQUIRE(data.value <= 31500);
+                    break;
+            }
+        }
+        REQUIRE(types.size() == (pattern == SyntheticPattern::Random ? 3 : 1));
+    }
+}
+
+TEST_CASE("synthetic load flows through the input pipeline", "[synthetic_source]")
+{
+    SyntheticConfig config;
+    config.device_count = 4;
+    config.events_per_second = 0.0;
+    SyntheticSource source(config);
+    InputPipeline pipeline;
+    pipeline.dispatcher().configure_ring(1024, RingOverflowPolicy::DropOldest);
+
+    InputLoop loop(source, pipeline);
+    loop.start();
+    const auto deadline = std::chrono::steady_clock::now() + seconds(5);
+    while(source.generated() < 10000 &&
+          std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    loop.stop();
+
+    REQUIRE(pipeline.device_count() == 4);
+    const auto stats = pipeline.dispatcher().ring_stats();
+    REQUIRE(stats.pushed == source.generated());
+    REQUIRE(stats.dropped_oldest == stats.pushed - 1024);
+
+    DillDeviceSnapshot snapshot;
+    REQUIRE(pipeline.snapshot(SyntheticSource::device_guid(3), snapshot));
+    REQUIRE(snapshot.version > 0);
+}
@@ -0,0 +1,165 @@
+#include "catch2/catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "input_dispatcher.h"
+#include "test_helpers.h"
+#include "trace_ring.h"
+
+
+namespace
+{
+    std::string read_all(std::FILE* file)
+    {
+        std::string content;
+        std::rewind(file);
+        char buffer[256];
+        size_t count = 0;
+        while((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            content.append(buffer, count);
+        }
+        return content;
+    }
+
+    void ignore_batch(JoystickInputData const*, size_t)
+    {
+    }
+}
+
+
+TEST_CASE("spans are retained oldest first", "[trace_ring]")
+{
+    TraceRing ring(4);
+    REQUIRE(ring.capacity() == 4);
+
+    std::vector<TraceSpan> spans;
+    ring.snapshot(spans);
+    REQUIRE(spans.empty());
+
+    ring.record(TraceSpanType::Wait, 100, 250, GUID{});
+    ring.record(TraceSpanType::PollDevice, 300, 200, make_guid(1));
+    ring.snapshot(spans);
+    REQUIRE(spans.size() == 2);
+    REQUIRE(spans[0].type == TraceSpanType::Wait);
+    REQUIRE(spans[0].start_ns == 100);
+    REQUIRE(spans[0].duration_ns == 150);
+    REQUIRE(spans[1].type == TraceSpanType::PollDevice);
+    REQUIRE(spans[1].duration_ns == 0);
+    REQUIRE(spans[1].device_guid == make_guid(1));
+    REQUIRE(spans[0].thread_id == spans[1].thread_id);
+
+    for(uint64_t i=0; i<5; ++i)
+    {
+        ring.record(TraceSpanType::InputCallback, 1000 + i, 1001 + i, GUID{});
+    }
+    REQUIRE(ring.recorded() == 7);
+    ring.snapshot(spans);
+    REQUIRE(spans.size() == 4);
+    REQUIRE(spans.front().start_ns == 1001);
+    REQUIRE(spans.back().start_ns == 1004);
+}
+
+TEST_CASE("concurrent writers get their own slots", "[trace_ring]")
+{
+    TraceRing ring(4096);
+    std::thread other([&ring] {
+        for(uint64_t i=0; i<1000; ++i)
+        {
+            ring.record(TraceSpanType::InputCallback, i, i + 1, make_guid(2));
+        }
+    });
+    for(uint64_t i=0; i<1000; ++i)
+    {
+        ring.record(TraceSpanType::PollDevice, i, i + 1, make_guid(1));
+    }
+    other.join();
+
+    std::vector<TraceSpan> spans;
+    ring.snapshot(spans);
+    REQUIRE(spans.size() == 2000);
+    size_t polls = 0;
+    for(auto const& span : spans)
+    {
+        if(span.type == TraceSpanType::PollDevice)
+        {
+            REQUIRE(span.device_guid == make_guid(1));
+            ++polls;
+        }
+        else
+        {
+            REQUIRE(span.device_guid == make_guid(2));
+        }
+    }
+    REQUIRE(polls == 1000);
+}
+
+TEST_CASE("scopes record their lifetime", "[trace_ring]")
+{
+    TraceRing ring(8);
+    {
+        TraceScope scope(&ring, TraceSpanType::EnumerateDevices, GUID{});
+        TraceScope ignored(nullptr, TraceSpanType::Wait, GUID{});
+    }
+
+    std::vector<TraceSpan> spans;
+    ring.snapshot(spans);
+    REQUIRE(spans.size() == 1);
+    REQUIRE(spans[0].type == TraceSpanType::EnumerateDevices);
+    REQUIRE(spans[0].start_ns > 0);
+}
+
+TEST_CASE("traces are written as chrome trace events", "[trace_ring]")
+{
+    TraceRing ring(8);
+    ring.record(TraceSpanType::RebuildWaitHandles, 1500, 4250, GUID{});
+    ring.record(
+        TraceSpanType::ProcessBufferedEvents,
+        2000000,
+        2000001,
+        make_guid(0xABCD)
+    );
+
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    REQUIRE(ring.write_chrome_trace(file));
+    const auto json = read_all(file);
+    std::fclose(file);
+
+    REQUIRE(json.rfind("{\"traceEvents\":[", 0) == 0);
+    REQUIRE(json.find(
+        "{\"name\":\"rebuild_wait_handles\",\"cat\":\"dill\",\"ph\":\"X\","
+        "\"ts\":1.500,\"dur\":2.750,"
+    ) != std::string::npos);
+    REQUIRE(json.find("\"name\":\"process_buffered_events\"")
+        != std::string::npos);
+    REQUIRE(json.find("\"ts\":2000.000,\"dur\":0.001,")
+        != std::string::npos);
+    REQUIRE(json.find("{0000ABCD-0000-0000-0000-000000000042}")
+        != std::string::npos);
+    REQUIRE(json.find("\"displayTimeUnit\":\"ns\"}") != std::string::npos);
+    REQUIRE_FALSE(ring.write_chrome_trace(nullptr));
+}
+
+TEST_CASE("callbacks are traced in tracing builds", "[trace_ring]")
+{
+    TraceRing ring(8);
+    InputDispatcher dispatcher;
+    dispatcher.set_trace_ring(&ring);
+    dispatcher.set_batch_callback(&ignore_batch);
+
+    dispatcher.dispatch({make_event(3, JoystickInputType::Axis, 1, 0)});
+
+    std::vector<TraceSpan> spans;
+    ring.snapshot(spans);
+#if defined(DILL_ENABLE_TRACE)
+    REQUIRE(spans.size() == 1);
+    REQUIRE(spans[0].type == TraceSpanType::InputCallback);
+    REQUIRE(spans[0].device_guid == make_guid(3));
+#else
+    REQUIRE(spans.empty());
+#endif
+}